@@ -0,0 +1,109 @@
+#pragma once
+#include <switch.h>
+#include <mutex>
+#include <memory>
+#include <new>
+
+// Host stand-in for the (tiny) subset of Atmosphere's libstratosphere that the host-tested daemon code relies on
+// The allocator's free size is whatever the test says, since the host heap can't be measured like the daemon's static one
+// System events only count signals, nothing waits on them outside of the console
+
+namespace ams {
+
+    namespace os {
+
+        class Mutex {
+            private:
+                std::recursive_mutex impl;
+
+            public:
+                explicit Mutex(const bool recursive) {
+                    (void)recursive;
+                }
+
+                inline void lock() {
+                    this->impl.lock();
+                }
+
+                inline void unlock() {
+                    this->impl.unlock();
+                }
+        };
+
+        using NativeHandle = u32;
+
+        enum EventClearMode {
+            EventClearMode_ManualClear,
+            EventClearMode_AutoClear
+        };
+
+        class SystemEvent {
+            private:
+                u32 signal_count;
+
+            public:
+                SystemEvent(const EventClearMode clear_mode, const bool inter_process) : signal_count(0) {
+                    (void)clear_mode;
+                    (void)inter_process;
+                }
+
+                inline void Signal() {
+                    this->signal_count++;
+                }
+
+                inline NativeHandle GetReadableHandle() const {
+                    return 0;
+                }
+
+                // Host only
+                inline u32 GetSignalCount() const {
+                    return this->signal_count;
+                }
+        };
+
+    }
+
+    namespace util {
+
+        template<typename T>
+        struct TypedStorage {
+            alignas(T) u8 storage[sizeof(T)];
+        };
+
+        template<typename T, typename ...Args>
+        inline T *ConstructAt(TypedStorage<T> &storage, Args &&...args) {
+            return std::construct_at(reinterpret_cast<T*>(storage.storage), std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        inline T &GetReference(TypedStorage<T> &storage) {
+            return *std::launder(reinterpret_cast<T*>(storage.storage));
+        }
+
+    }
+
+    namespace init {
+
+        class Allocator {
+            private:
+                size_t total_free_size = 0;
+
+            public:
+                inline size_t GetTotalFreeSize() const {
+                    return this->total_free_size;
+                }
+
+                // Host only
+                inline void SetTotalFreeSize(const size_t size) {
+                    this->total_free_size = size;
+                }
+        };
+
+        inline Allocator *GetAllocator() {
+            static Allocator g_Allocator;
+            return &g_Allocator;
+        }
+
+    }
+
+}
@@ -0,0 +1,310 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <pthread.h>
+#include <unistd.h>
+
+// Host stand-in for the (tiny) subset of libnx that the host-tested code relies on
+// Only types and plain primitives live here: anything console-specific the tested code needs (storages, filesystem...) gets faked by each test
+
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using s8 = int8_t;
+using s16 = int16_t;
+using s32 = int32_t;
+using s64 = int64_t;
+using Result = u32;
+
+#define NORETURN __attribute__((noreturn))
+#define NX_INLINE static inline
+
+#ifndef BIT
+#define BIT(n) (1U << (n))
+#endif
+
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res) ((res) != 0)
+#define R_MODULE(res) ((res) & 0x1FF)
+#define R_DESCRIPTION(res) (((res) >> 9) & 0x1FFF)
+#define MAKERESULT(module, description) ((((module) & 0x1FF)) | ((description) & 0x1FFF) << 9)
+
+#define FS_MAX_PATH 0x301
+
+enum {
+    FsCreateOption_BigFile = BIT(0)
+};
+
+struct AccountUid {
+    u64 uid[2];
+};
+
+struct WebCommonConfig {
+    u8 arg[0x2000];
+    u32 version;
+};
+
+// Time: ticks are nanoseconds on the host
+
+NX_INLINE u64 armGetSystemTick() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1'000'000'000ul + ts.tv_nsec;
+}
+
+NX_INLINE u64 armTicksToNs(const u64 tick) {
+    return tick;
+}
+
+NX_INLINE u64 armNsToTicks(const u64 ns) {
+    return ns;
+}
+
+NX_INLINE void svcSleepThread(const s64 ns) {
+    const timespec ts = { .tv_sec = static_cast<time_t>(ns / 1'000'000'000), .tv_nsec = static_cast<long>(ns % 1'000'000'000) };
+    nanosleep(&ts, nullptr);
+}
+
+NX_INLINE void randomGet(void *buf, const size_t size) {
+    auto buf8 = reinterpret_cast<u8*>(buf);
+    for(size_t i = 0; i < size; i++) {
+        buf8[i] = static_cast<u8>(rand());
+    }
+}
+
+NORETURN NX_INLINE void fatalThrow(const Result rc) {
+    (void)rc;
+    abort();
+}
+
+// Crypto: plain SHA-256, so that hashes match the ones computed on the console
+
+#define SHA256_HASH_SIZE 0x20
+
+NX_INLINE u32 HostSha256RotateRight(const u32 v, const u32 n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+NX_INLINE void HostSha256ProcessBlock(u32 *state, const u8 *block) {
+    constexpr u32 RoundConstants[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    u32 w[64];
+    for(u32 i = 0; i < 16; i++) {
+        w[i] = (static_cast<u32>(block[i * 4]) << 24) | (static_cast<u32>(block[i * 4 + 1]) << 16) | (static_cast<u32>(block[i * 4 + 2]) << 8) | block[i * 4 + 3];
+    }
+    for(u32 i = 16; i < 64; i++) {
+        const auto s0 = HostSha256RotateRight(w[i - 15], 7) ^ HostSha256RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const auto s1 = HostSha256RotateRight(w[i - 2], 17) ^ HostSha256RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 v[8];
+    memcpy(v, state, sizeof(v));
+    for(u32 i = 0; i < 64; i++) {
+        const auto s1 = HostSha256RotateRight(v[4], 6) ^ HostSha256RotateRight(v[4], 11) ^ HostSha256RotateRight(v[4], 25);
+        const auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        const auto t1 = v[7] + s1 + ch + RoundConstants[i] + w[i];
+        const auto s0 = HostSha256RotateRight(v[0], 2) ^ HostSha256RotateRight(v[0], 13) ^ HostSha256RotateRight(v[0], 22);
+        const auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+        const auto t2 = s0 + maj;
+        memmove(v + 1, v, 7 * sizeof(u32));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for(u32 i = 0; i < 8; i++) {
+        state[i] += v[i];
+    }
+}
+
+NX_INLINE void sha256CalculateHash(void *dst, const void *src, const size_t size) {
+    u32 state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    auto src8 = reinterpret_cast<const u8*>(src);
+    size_t offset = 0;
+    for(; (offset + 64) <= size; offset += 64) {
+        HostSha256ProcessBlock(state, src8 + offset);
+    }
+
+    // Remaining data, 0x80 terminator and the big-endian bit length fill one or two last blocks
+    u8 tail[128] = {};
+    const auto rem_size = size - offset;
+    memcpy(tail, src8 + offset, rem_size);
+    tail[rem_size] = 0x80;
+    const size_t tail_size = ((rem_size + 1 + sizeof(u64)) <= 64) ? 64 : 128;
+    const u64 bit_size = static_cast<u64>(size) * 8;
+    for(u32 i = 0; i < sizeof(u64); i++) {
+        tail[tail_size - 1 - i] = static_cast<u8>(bit_size >> (i * 8));
+    }
+    for(size_t i = 0; i < tail_size; i += 64) {
+        HostSha256ProcessBlock(state, tail + i);
+    }
+
+    auto dst8 = reinterpret_cast<u8*>(dst);
+    for(u32 i = 0; i < 8; i++) {
+        dst8[i * 4] = static_cast<u8>(state[i] >> 24);
+        dst8[i * 4 + 1] = static_cast<u8>(state[i] >> 16);
+        dst8[i * 4 + 2] = static_cast<u8>(state[i] >> 8);
+        dst8[i * 4 + 3] = static_cast<u8>(state[i]);
+    }
+}
+
+// Synchronization and threads, over pthreads
+
+struct Mutex {
+    pthread_mutex_t impl = PTHREAD_MUTEX_INITIALIZER;
+};
+
+NX_INLINE void mutexInit(Mutex *m) {
+    pthread_mutex_init(&m->impl, nullptr);
+}
+
+NX_INLINE void mutexLock(Mutex *m) {
+    pthread_mutex_lock(&m->impl);
+}
+
+NX_INLINE void mutexUnlock(Mutex *m) {
+    pthread_mutex_unlock(&m->impl);
+}
+
+struct CondVar {
+    pthread_cond_t impl = PTHREAD_COND_INITIALIZER;
+};
+
+NX_INLINE void condvarInit(CondVar *c) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&c->impl, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+NX_INLINE Result condvarWait(CondVar *c, Mutex *m) {
+    pthread_cond_wait(&c->impl, &m->impl);
+    return 0;
+}
+
+NX_INLINE Result condvarWaitTimeout(CondVar *c, Mutex *m, const u64 timeout_ns) {
+    const auto deadline_ns = armGetSystemTick() + timeout_ns;
+    const timespec ts = { .tv_sec = static_cast<time_t>(deadline_ns / 1'000'000'000), .tv_nsec = static_cast<long>(deadline_ns % 1'000'000'000) };
+    pthread_cond_timedwait(&c->impl, &m->impl, &ts);
+    return 0;
+}
+
+NX_INLINE Result condvarWakeOne(CondVar *c) {
+    pthread_cond_signal(&c->impl);
+    return 0;
+}
+
+NX_INLINE Result condvarWakeAll(CondVar *c) {
+    pthread_cond_broadcast(&c->impl);
+    return 0;
+}
+
+typedef void (*ThreadFunc)(void*);
+
+struct Thread {
+    pthread_t impl;
+    ThreadFunc entry;
+    void *arg;
+};
+
+NX_INLINE void *HostThreadEntry(void *thread) {
+    auto t = reinterpret_cast<Thread*>(thread);
+    t->entry(t->arg);
+    return nullptr;
+}
+
+NX_INLINE Result threadCreate(Thread *t, ThreadFunc entry, void *arg, void *stack_mem, const size_t stack_sz, const int prio, const int cpuid) {
+    (void)stack_mem;
+    (void)stack_sz;
+    (void)prio;
+    (void)cpuid;
+    t->entry = entry;
+    t->arg = arg;
+    return 0;
+}
+
+NX_INLINE Result threadStart(Thread *t) {
+    return (pthread_create(&t->impl, nullptr, &HostThreadEntry, t) == 0) ? 0 : 1;
+}
+
+NX_INLINE Result threadWaitForExit(Thread *t) {
+    pthread_join(t->impl, nullptr);
+    return 0;
+}
+
+NX_INLINE Result threadClose(Thread *t) {
+    (void)t;
+    return 0;
+}
+
+// Applet storages: plain memory buffers, tests decide where they get pushed/popped to/from
+
+struct AppletStorage {
+    u8 *data;
+    s64 size;
+};
+
+NX_INLINE Result appletCreateStorage(AppletStorage *s, const s64 size) {
+    s->data = reinterpret_cast<u8*>(calloc(1, size));
+    s->size = size;
+    return (s->data != nullptr) ? 0 : 1;
+}
+
+NX_INLINE void appletStorageClose(AppletStorage *s) {
+    free(s->data);
+    s->data = nullptr;
+    s->size = 0;
+}
+
+NX_INLINE Result appletStorageGetSize(AppletStorage *s, s64 *out_size) {
+    *out_size = s->size;
+    return 0;
+}
+
+NX_INLINE Result appletStorageWrite(AppletStorage *s, const s64 offset, const void *buf, const size_t size) {
+    if((offset + static_cast<s64>(size)) > s->size) {
+        return 1;
+    }
+    memcpy(s->data + offset, buf, size);
+    return 0;
+}
+
+NX_INLINE Result appletStorageRead(AppletStorage *s, const s64 offset, void *buf, const size_t size) {
+    if((offset + static_cast<s64>(size)) > s->size) {
+        return 1;
+    }
+    memcpy(buf, s->data + offset, size);
+    return 0;
+}
+
+// Filesystem helpers only used by fs_Stdio.hpp
+
+NX_INLINE int fsdevCreateFile(const char *path, const size_t size, const u32 flags) {
+    (void)size;
+    (void)flags;
+    auto f = fopen(path, "wb");
+    if(f == nullptr) {
+        return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+NX_INLINE int fsdevDeleteDirectoryRecursively(const char *path) {
+    (void)path;
+    return -1;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstring>
+
+// Minimal stand-in for newlib's devoptab support: devices get registered, but the libc calls aren't routed to them
+// Tests reach a device's functions through GetDeviceOpTab()
+
+struct _reent {
+    int _errno;
+};
+
+typedef struct {
+    const char *name;
+    size_t structSize;
+    int (*open_r)(struct _reent *r, void *fileStruct, const char *path, int flags, int mode);
+    int (*close_r)(struct _reent *r, void *fd);
+    ssize_t (*write_r)(struct _reent *r, void *fd, const char *ptr, size_t len);
+    ssize_t (*read_r)(struct _reent *r, void *fd, char *ptr, size_t len);
+    off_t (*seek_r)(struct _reent *r, void *fd, off_t pos, int dir);
+    int (*fstat_r)(struct _reent *r, void *fd, struct stat *st);
+    int (*stat_r)(struct _reent *r, const char *file, struct stat *st);
+} devoptab_t;
+
+constexpr int MaxHostDeviceCount = 8;
+
+inline const devoptab_t *&GetHostDevice(const int index) {
+    static const devoptab_t *g_Devices[MaxHostDeviceCount] = {};
+    return g_Devices[index];
+}
+
+inline int AddDevice(const devoptab_t *device) {
+    for(int i = 0; i < MaxHostDeviceCount; i++) {
+        auto &cur_device = GetHostDevice(i);
+        if((cur_device == nullptr) || (strcmp(cur_device->name, device->name) == 0)) {
+            cur_device = device;
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline const devoptab_t *GetDeviceOpTab(const char *name) {
+    for(int i = 0; i < MaxHostDeviceCount; i++) {
+        const auto device = GetHostDevice(i);
+        if((device != nullptr) && (strcmp(device->name, name) == 0)) {
+            return device;
+        }
+    }
+    return nullptr;
+}
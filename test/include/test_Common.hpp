@@ -0,0 +1,44 @@
+#pragma once
+#include <switch.h>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal host test helpers: a failed check reports where it happened and makes the test binary fail
+
+namespace test {
+
+    inline int &GetFailureCount() {
+        static int g_FailureCount = 0;
+        return g_FailureCount;
+    }
+
+    inline int Finish(const char *test_name) {
+        const auto failure_count = GetFailureCount();
+        if(failure_count > 0) {
+            printf("[%s] %d check(s) failed\n", test_name, failure_count);
+            return EXIT_FAILURE;
+        }
+        printf("[%s] all checks passed\n", test_name);
+        return EXIT_SUCCESS;
+    }
+
+    inline u64 GetCurrentNs() {
+        return armTicksToNs(armGetSystemTick());
+    }
+
+}
+
+#define TEST_CHECK(expr) ({ \
+    if(!(expr)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+        test::GetFailureCount()++; \
+    } \
+})
+
+#define TEST_CHECK_RC(rc_expr) ({ \
+    const Result _tmp_rc = (rc_expr); \
+    if(R_FAILED(_tmp_rc)) { \
+        printf("%s:%d: %s failed with 0x%X\n", __FILE__, __LINE__, #rc_expr, _tmp_rc); \
+        test::GetFailureCount()++; \
+    } \
+})
@@ -0,0 +1,139 @@
+#include <test_Common.hpp>
+#include <cfg/cfg_Config.hpp>
+
+// NRO cache icon paths: names must match the previous stringstream-based implementation (icons already cached on the SD card depend on them), plus timings of both
+
+namespace {
+
+    constexpr u32 PathCount = 1500;
+    constexpr u32 BenchmarkIterationCount = 20;
+
+    // The implementation before memoization/hex encoding, kept verbatim (paths must be shorter than FS_MAX_PATH, it overflowed otherwise)
+    std::string GetPreviousNroCacheIconPath(const std::string &path) {
+        char path_copy[FS_MAX_PATH] = {};
+        strcpy(path_copy, path.c_str());
+        u8 hash[0x20] = {0};
+        sha256CalculateHash(hash, path_copy, FS_MAX_PATH);
+
+        std::stringstream strm;
+        strm << UL_NRO_CACHE_PATH "/";
+        // Use the first half of the hash, like N does with NCAs.
+        for(u32 i = 0; i < sizeof(hash) / 2; i++) {
+            strm << std::setw(2) << std::setfill('0') << std::hex << std::nouppercase << static_cast<u32>(hash[i]);
+        }
+        strm << ".jpg";
+        return strm.str();
+    }
+
+    std::vector<std::string> MakePaths() {
+        std::vector<std::string> paths = {
+            "",
+            "sdmc:/switch/hbmenu.nro",
+            "sdmc:/switch/ゲーム/テスト.nro",
+            "sdmc:/switch/Émulateurs/RetroArch ñ ü.nro",
+            "sdmc:/switch/\xF0\x9F\x8E\xAE/emoji.nro",
+            "sdmc:/" + std::string(FS_MAX_PATH - 1 - 6, 'a'),
+            "sdmc:/" + std::string(FS_MAX_PATH - 2 - 6, 'b') + "/"
+        };
+        // Every byte value shows up in some path
+        std::string all_bytes_path = "sdmc:/";
+        for(u32 i = 1; i < 0x100; i++) {
+            all_bytes_path.push_back(static_cast<char>(i));
+        }
+        paths.push_back(all_bytes_path);
+
+        // More distinct paths than the memo table holds, so that it gets cleared while they're looked up
+        for(u32 i = 0; paths.size() < PathCount; i++) {
+            paths.push_back("sdmc:/switch/homebrew_" + std::to_string(i) + "/app_" + std::to_string(i * 7919) + ".nro");
+        }
+        return paths;
+    }
+
+    void TestKnownNames() {
+        // Computed independently of both implementations, also checks the host SHA-256
+        u8 abc_hash[SHA256_HASH_SIZE] = {};
+        sha256CalculateHash(abc_hash, "abc", 3);
+        const u8 abc_expected_hash[SHA256_HASH_SIZE] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+        TEST_CHECK(memcmp(abc_hash, abc_expected_hash, sizeof(abc_hash)) == 0);
+
+        TEST_CHECK(cfg::GetNroCacheIconPath("sdmc:/switch/hbmenu.nro") == UL_NRO_CACHE_PATH "/4f6bc65f5d381e18fcc0ce14226f9797.jpg");
+        TEST_CHECK(cfg::GetNroCacheIconPath("") == UL_NRO_CACHE_PATH "/40c304d7194f12847904a6f6d3c98c3b.jpg");
+    }
+
+    void TestMatchesPreviousNames() {
+        const auto paths = MakePaths();
+
+        // Twice: first pass fills (and clears) the memo table, second one mixes memoized and evicted paths
+        for(u32 pass = 0; pass < 2; pass++) {
+            for(const auto &path: paths) {
+                TEST_CHECK(cfg::GetNroCacheIconPath(path) == GetPreviousNroCacheIconPath(path));
+            }
+        }
+
+        // Repeated lookups right after each other always hit the memo table
+        for(const auto &path: paths) {
+            const auto first_path = cfg::GetNroCacheIconPath(path);
+            TEST_CHECK(cfg::GetNroCacheIconPath(path) == first_path);
+        }
+    }
+
+    void TestOverlongPaths() {
+        // Overlong paths get truncated to what fits in the hashed buffer instead of overflowing it
+        const auto max_path = "sdmc:/" + std::string(FS_MAX_PATH - 1 - 6, 'c');
+        TEST_CHECK(cfg::GetNroCacheIconPath(max_path + "overflow.nro") == GetPreviousNroCacheIconPath(max_path));
+        TEST_CHECK(cfg::GetNroCacheIconPath(max_path + std::string(0x1000, 'd')) == GetPreviousNroCacheIconPath(max_path));
+    }
+
+    void BenchmarkNroCacheIconPath() {
+        const auto paths = MakePaths();
+        // What a menu with this many homebrew entries looks up: the same few hundred paths over and over
+        const std::vector<std::string> menu_paths(paths.begin(), paths.begin() + 500);
+
+        size_t total_length = 0;
+        auto start_ns = test::GetCurrentNs();
+        for(u32 i = 0; i < BenchmarkIterationCount; i++) {
+            for(const auto &path: menu_paths) {
+                total_length += GetPreviousNroCacheIconPath(path).length();
+            }
+        }
+        const auto previous_ns = test::GetCurrentNs() - start_ns;
+
+        start_ns = test::GetCurrentNs();
+        for(u32 i = 0; i < BenchmarkIterationCount; i++) {
+            for(const auto &path: menu_paths) {
+                total_length += cfg::GetNroCacheIconPath(path).length();
+            }
+        }
+        const auto memo_ns = test::GetCurrentNs() - start_ns;
+
+        // Every lookup a miss: more distinct paths (none looked up before) than the memo table holds, in order
+        std::vector<std::string> miss_paths;
+        for(u32 i = 0; i < PathCount; i++) {
+            miss_paths.push_back("sdmc:/switch/missed_" + std::to_string(i) + ".nro");
+        }
+        start_ns = test::GetCurrentNs();
+        for(const auto &path: miss_paths) {
+            total_length += cfg::GetNroCacheIconPath(path).length();
+        }
+        const auto miss_ns = test::GetCurrentNs() - start_ns;
+
+        start_ns = test::GetCurrentNs();
+        for(const auto &path: miss_paths) {
+            total_length += GetPreviousNroCacheIconPath(path).length();
+        }
+        const auto previous_miss_ns = test::GetCurrentNs() - start_ns;
+
+        const auto lookup_count = menu_paths.size() * BenchmarkIterationCount;
+        printf("%zu paths x %u: previous %.2f us/path, memoized %.2f us/path; %zu misses: previous %.2f us/path, current %.2f us/path (%zu chars)\n", menu_paths.size(), BenchmarkIterationCount, previous_ns / 1'000.0 / lookup_count, memo_ns / 1'000.0 / lookup_count, miss_paths.size(), previous_miss_ns / 1'000.0 / miss_paths.size(), miss_ns / 1'000.0 / miss_paths.size(), total_length);
+    }
+
+}
+
+int main() {
+    TestKnownNames();
+    TestMatchesPreviousNames();
+    TestOverlongPaths();
+    BenchmarkNroCacheIconPath();
+
+    return test::Finish("cfg_NroIconPathTest");
+}
@@ -0,0 +1,508 @@
+#include <test_Common.hpp>
+#include <cfg/cfg_RecordStore.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Record store journaling and deferred writer, driven through an in-memory filesystem and a fake clock
+// Commits get aborted at every single write boundary (as if the console lost power there), recovery must then leave either every old record or every new one
+// Plus a count of the file operations folder renames and multiselect moves take, batched versus written record by record
+
+namespace cfg {
+
+    // The real one (cfg_Config.cpp) stats homebrew NROs, test records always have a JSON name
+    std::string GetRecordJsonPath(const TitleRecord &record) {
+        return UL_ENTRIES_PATH "/" + record.json_name;
+    }
+
+}
+
+namespace {
+
+    struct FakePowerLoss {};
+
+    struct FakeFileSystem {
+        std::mutex lock;
+        std::map<std::string, std::string> files;
+        // Write boundaries (file writes and deletions) done so far, the one matching the abort index never completes
+        u32 boundary_count;
+        u32 abort_boundary;
+        bool abort_enabled;
+        u32 record_write_count;
+        u32 delete_count;
+        // While set, the first record/journal write blocks until it gets cleared
+        bool block_writes;
+        bool write_blocked;
+        std::atomic<u64> cur_ns;
+    };
+
+    FakeFileSystem g_FileSystem;
+
+    // Every abort point is taken before the boundary's effect: a write only gets half of its data there, a deletion doesn't happen
+    bool ReachBoundary() {
+        const auto boundary = g_FileSystem.boundary_count++;
+        return g_FileSystem.abort_enabled && (boundary == g_FileSystem.abort_boundary);
+    }
+
+    bool WriteFile(const std::string &path, const void *data, const size_t size) {
+        std::unique_lock lk(g_FileSystem.lock);
+        if(g_FileSystem.block_writes) {
+            g_FileSystem.write_blocked = true;
+            while(g_FileSystem.block_writes) {
+                lk.unlock();
+                std::this_thread::yield();
+                lk.lock();
+            }
+            g_FileSystem.write_blocked = false;
+        }
+
+        const auto data_str = reinterpret_cast<const char*>(data);
+        if(ReachBoundary()) {
+            g_FileSystem.files[path] = std::string(data_str, size / 2);
+            throw FakePowerLoss();
+        }
+        g_FileSystem.files[path] = std::string(data_str, size);
+        g_FileSystem.record_write_count++;
+        return true;
+    }
+
+    bool ReadFile(const std::string &path, std::string &out_data) {
+        std::scoped_lock lk(g_FileSystem.lock);
+        const auto find_file = g_FileSystem.files.find(path);
+        if(find_file == g_FileSystem.files.end()) {
+            return false;
+        }
+        out_data = find_file->second;
+        return true;
+    }
+
+    void DeleteFile(const std::string &path) {
+        std::scoped_lock lk(g_FileSystem.lock);
+        if(ReachBoundary()) {
+            throw FakePowerLoss();
+        }
+        g_FileSystem.files.erase(path);
+        g_FileSystem.delete_count++;
+    }
+
+    bool ExistsFile(const std::string &path) {
+        std::scoped_lock lk(g_FileSystem.lock);
+        return g_FileSystem.files.count(path) > 0;
+    }
+
+    u64 GetCurrentNs() {
+        return g_FileSystem.cur_ns;
+    }
+
+    // The fake clock only moves when tests say so: poll it with short real waits
+    void WaitTimeout(CondVar *condvar, Mutex *lock, const u64 timeout_ns) {
+        condvarWaitTimeout(condvar, lock, std::min(timeout_ns, 1'000'000ul));
+    }
+
+    void ResetFileSystem() {
+        std::scoped_lock lk(g_FileSystem.lock);
+        g_FileSystem.files.clear();
+        g_FileSystem.boundary_count = 0;
+        g_FileSystem.abort_boundary = 0;
+        g_FileSystem.abort_enabled = false;
+        g_FileSystem.record_write_count = 0;
+        g_FileSystem.delete_count = 0;
+        g_FileSystem.block_writes = false;
+        g_FileSystem.write_blocked = false;
+        g_FileSystem.cur_ns = 0;
+    }
+
+    cfg::TitleRecord MakeRecord(const u32 idx, const std::string &name) {
+        cfg::TitleRecord record = {};
+        record.json_name = "record" + std::to_string(idx) + ".json";
+        record.title_type = cfg::TitleType::Installed;
+        record.app_id = 0x0100000000010000 | (idx << 16);
+        record.name = name;
+        return record;
+    }
+
+    std::string GetRecordPath(const u32 idx) {
+        return cfg::GetRecordJsonPath(MakeRecord(idx, ""));
+    }
+
+    // Records 0-3 exist with their old contents, the transaction rewrites 0-2, removes 3 and creates 4
+    constexpr u32 OldRecordCount = 4;
+    constexpr u32 NewRecordCount = 5;
+    constexpr u32 RemovedRecordIndex = 3;
+
+    void WriteOldRecords() {
+        for(u32 i = 0; i < OldRecordCount; i++) {
+            const auto json = cfg::SerializeRecord(MakeRecord(i, "old"));
+            g_FileSystem.files[GetRecordPath(i)] = json;
+        }
+    }
+
+    cfg::RecordTransaction MakeNewTransaction() {
+        cfg::RecordTransaction tx;
+        for(u32 i = 0; i < NewRecordCount; i++) {
+            if(i == RemovedRecordIndex) {
+                tx.Remove(MakeRecord(i, ""));
+            }
+            else {
+                tx.Save(MakeRecord(i, "new"));
+            }
+        }
+        return tx;
+    }
+
+    bool HasOldRecords() {
+        for(u32 i = 0; i < NewRecordCount; i++) {
+            const auto find_file = g_FileSystem.files.find(GetRecordPath(i));
+            if(i < OldRecordCount) {
+                if((find_file == g_FileSystem.files.end()) || (find_file->second != cfg::SerializeRecord(MakeRecord(i, "old")))) {
+                    return false;
+                }
+            }
+            else if(find_file != g_FileSystem.files.end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool HasNewRecords() {
+        for(u32 i = 0; i < NewRecordCount; i++) {
+            const auto find_file = g_FileSystem.files.find(GetRecordPath(i));
+            if(i == RemovedRecordIndex) {
+                if(find_file != g_FileSystem.files.end()) {
+                    return false;
+                }
+            }
+            else if((find_file == g_FileSystem.files.end()) || (find_file->second != cfg::SerializeRecord(MakeRecord(i, "new")))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestCommitAbortedAtEveryBoundary() {
+        u32 abort_boundary = 0;
+        while(true) {
+            ResetFileSystem();
+            WriteOldRecords();
+            g_FileSystem.abort_boundary = abort_boundary;
+            g_FileSystem.abort_enabled = true;
+
+            auto tx = MakeNewTransaction();
+            auto aborted = false;
+            try {
+                TEST_CHECK(tx.Commit());
+            }
+            catch(FakePowerLoss&) {
+                aborted = true;
+            }
+            if(!aborted) {
+                // Past the last boundary of a whole commit
+                TEST_CHECK(abort_boundary > NewRecordCount);
+                TEST_CHECK(HasNewRecords());
+                TEST_CHECK(!ExistsFile(CFG_RECORD_JOURNAL_FILE));
+                break;
+            }
+
+            // Next boot
+            g_FileSystem.abort_enabled = false;
+            const auto journal_written = abort_boundary > 0;
+            cfg::RecoverRecordJournal();
+
+            const auto has_old = HasOldRecords();
+            const auto has_new = HasNewRecords();
+            if(!(has_old || has_new)) {
+                printf("Aborting at write boundary %u left a mix of old and new records\n", abort_boundary);
+            }
+            TEST_CHECK(has_old || has_new);
+            // Once the journal is complete, the commit must win
+            TEST_CHECK(has_new == journal_written);
+            TEST_CHECK(!ExistsFile(CFG_RECORD_JOURNAL_FILE));
+
+            // Recovering again changes nothing
+            cfg::RecoverRecordJournal();
+            TEST_CHECK(HasOldRecords() == has_old);
+            TEST_CHECK(HasNewRecords() == has_new);
+
+            abort_boundary++;
+        }
+    }
+
+    void TestRecoveryAbortedAtEveryBoundary() {
+        // Losing power again while replaying must still end up with the new records on the following boot
+        u32 abort_boundary = 0;
+        while(true) {
+            ResetFileSystem();
+            WriteOldRecords();
+            g_FileSystem.abort_boundary = 1;
+            g_FileSystem.abort_enabled = true;
+            auto tx = MakeNewTransaction();
+            try {
+                tx.Commit();
+            }
+            catch(FakePowerLoss&) {}
+
+            g_FileSystem.boundary_count = 0;
+            g_FileSystem.abort_boundary = abort_boundary;
+            auto aborted = false;
+            try {
+                cfg::RecoverRecordJournal();
+            }
+            catch(FakePowerLoss&) {
+                aborted = true;
+            }
+
+            g_FileSystem.abort_enabled = false;
+            cfg::RecoverRecordJournal();
+            TEST_CHECK(HasNewRecords());
+            TEST_CHECK(!ExistsFile(CFG_RECORD_JOURNAL_FILE));
+            if(!aborted) {
+                break;
+            }
+            abort_boundary++;
+        }
+    }
+
+    void TestFailedJournalWriteKeepsRecords() {
+        ResetFileSystem();
+        WriteOldRecords();
+
+        // A failing journal write never touches records, and the operations are kept for a retry
+        cfg::SetRecordStoreBackend({
+            .write_file = [](const std::string &path, const void *data, const size_t size) {
+                if(path == CFG_RECORD_JOURNAL_FILE) {
+                    g_FileSystem.files[path] = std::string(reinterpret_cast<const char*>(data), size / 2);
+                    return false;
+                }
+                return WriteFile(path, data, size);
+            },
+            .read_file = &ReadFile,
+            .delete_file = &DeleteFile,
+            .exists_file = &ExistsFile,
+            .get_current_ns = &GetCurrentNs,
+            .wait_timeout = &WaitTimeout
+        });
+
+        auto tx = MakeNewTransaction();
+        TEST_CHECK(!tx.Commit());
+        TEST_CHECK(tx.GetOperationCount() == NewRecordCount);
+        TEST_CHECK(HasOldRecords());
+        TEST_CHECK(!ExistsFile(CFG_RECORD_JOURNAL_FILE));
+
+        cfg::SetRecordStoreBackend({
+            .write_file = &WriteFile,
+            .read_file = &ReadFile,
+            .delete_file = &DeleteFile,
+            .exists_file = &ExistsFile,
+            .get_current_ns = &GetCurrentNs,
+            .wait_timeout = &WaitTimeout
+        });
+        TEST_CHECK(tx.Commit());
+        TEST_CHECK(tx.IsEmpty());
+        TEST_CHECK(HasNewRecords());
+    }
+
+    u32 GetRecordWriteCount() {
+        std::scoped_lock lk(g_FileSystem.lock);
+        return g_FileSystem.record_write_count;
+    }
+
+    void WaitForBlockedWrite() {
+        while(true) {
+            {
+                std::scoped_lock lk(g_FileSystem.lock);
+                if(g_FileSystem.write_blocked) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void TestFlushRacingWrittenBatch() {
+        ResetFileSystem();
+
+        // The worker takes the first batch once idle (no flush requested), and gets stuck writing it
+        auto tx = MakeNewTransaction();
+        tx.CommitDeferred();
+        g_FileSystem.block_writes = true;
+        g_FileSystem.cur_ns = cfg::RecordWriteIdleDelayNs;
+        WaitForBlockedWrite();
+
+        // A flush comes meanwhile, the batch being written already covers it
+        std::thread unblocker([]() {
+            svcSleepThread(50'000'000);
+            std::scoped_lock lk(g_FileSystem.lock);
+            g_FileSystem.block_writes = false;
+        });
+        cfg::FlushRecords();
+        unblocker.join();
+        TEST_CHECK(HasNewRecords());
+
+        // The flush is over: the next batch must wait for the menu to be idle again
+        const auto write_count = GetRecordWriteCount();
+        cfg::RecordTransaction next_tx;
+        next_tx.Save(MakeRecord(0, "next"));
+        next_tx.CommitDeferred();
+        svcSleepThread(50'000'000);
+        TEST_CHECK(GetRecordWriteCount() == write_count);
+
+        g_FileSystem.cur_ns += cfg::RecordWriteIdleDelayNs;
+        cfg::FlushRecords();
+        TEST_CHECK(GetRecordWriteCount() > write_count);
+        std::string json;
+        TEST_CHECK(ReadFile(GetRecordPath(0), json));
+        TEST_CHECK(json == cfg::SerializeRecord(MakeRecord(0, "next")));
+
+        cfg::ExitRecordWriter();
+    }
+
+    void TestDeferredDeadline() {
+        ResetFileSystem();
+
+        // Mutations keep coming before the idle delay expires, yet they get written by the deadline
+        u64 queue_ns = 0;
+        u32 i = 0;
+        while(queue_ns < cfg::RecordWriteDeadlineNs) {
+            cfg::RecordTransaction tx;
+            tx.Save(MakeRecord(i % NewRecordCount, "deadline"));
+            tx.CommitDeferred();
+            svcSleepThread(5'000'000);
+            TEST_CHECK(GetRecordWriteCount() == 0);
+
+            queue_ns += cfg::RecordWriteIdleDelayNs / 2;
+            g_FileSystem.cur_ns = queue_ns;
+            i++;
+        }
+
+        while(GetRecordWriteCount() == 0) {
+            std::this_thread::yield();
+        }
+        cfg::ExitRecordWriter();
+    }
+
+    // What the menu does with big folders and multiselection
+    constexpr u32 BenchmarkRecordCount = 300;
+
+    struct FileOperationCount {
+        u32 op_count;
+        u64 elapsed_ns;
+    };
+
+    u32 GetFileOperationCount() {
+        std::scoped_lock lk(g_FileSystem.lock);
+        return g_FileSystem.record_write_count + g_FileSystem.delete_count;
+    }
+
+    // Records start written on the SD card, each written mutation is then the same record rewritten
+    template<typename F>
+    FileOperationCount CountFileOperations(F fn) {
+        ResetFileSystem();
+        const auto start_ns = test::GetCurrentNs();
+        fn();
+        cfg::FlushRecords();
+        const auto elapsed_ns = test::GetCurrentNs() - start_ns;
+        return { GetFileOperationCount(), elapsed_ns };
+    }
+
+    cfg::TitleList MakeFolderList() {
+        cfg::TitleList list = {};
+        cfg::TitleFolder folder = { .name = "Folder" };
+        for(u32 i = 0; i < BenchmarkRecordCount; i++) {
+            auto record = MakeRecord(i, "title" + std::to_string(i));
+            record.sub_folder = folder.name;
+            folder.titles.push_back(record);
+        }
+        list.folders.push_back(folder);
+        return list;
+    }
+
+    cfg::TitleList MakeRootList() {
+        cfg::TitleList list = {};
+        for(u32 i = 0; i < BenchmarkRecordCount; i++) {
+            list.root.titles.push_back(MakeRecord(i, "title" + std::to_string(i)));
+        }
+        return list;
+    }
+
+    bool IsInFolder(const std::string &name, const u32 idx) {
+        std::string json;
+        return ReadFile(GetRecordPath(idx), json) && (json.find(name) != std::string::npos);
+    }
+
+    void BenchmarkFolderOperations() {
+        // Folder rename: one batch versus every record written on its own (flushed, like when the menu goes away in between)
+        auto list = MakeFolderList();
+        const auto rename_batched = CountFileOperations([&]() {
+            cfg::RenameFolder(list, "Folder", "Renamed");
+        });
+        TEST_CHECK(list.folders.front().name == "Renamed");
+        for(u32 i = 0; i < BenchmarkRecordCount; i++) {
+            TEST_CHECK(IsInFolder("Renamed", i));
+        }
+        // The journal write and its deletion, then every record
+        TEST_CHECK(rename_batched.op_count == (BenchmarkRecordCount + 2));
+
+        list = MakeFolderList();
+        const auto rename_per_record = CountFileOperations([&]() {
+            for(auto &title: list.folders.front().titles) {
+                title.sub_folder = "Renamed";
+                cfg::SaveRecord(title);
+                cfg::FlushRecords();
+            }
+        });
+        TEST_CHECK(rename_batched.op_count < rename_per_record.op_count);
+
+        // Multiselect move of every other root title: one pass versus a MoveRecordTo per title
+        std::vector<u32> selected_idxs;
+        for(u32 i = 0; i < BenchmarkRecordCount; i += 2) {
+            selected_idxs.push_back(i);
+        }
+
+        list = MakeRootList();
+        const auto move_batched = CountFileOperations([&]() {
+            TEST_CHECK(cfg::MoveRootRecordsTo(list, selected_idxs, "Folder") == selected_idxs.size());
+        });
+        TEST_CHECK(list.root.titles.size() == (BenchmarkRecordCount - selected_idxs.size()));
+        TEST_CHECK(list.folders.front().titles.size() == selected_idxs.size());
+        for(const auto idx: selected_idxs) {
+            TEST_CHECK(IsInFolder("Folder", idx));
+        }
+        TEST_CHECK(move_batched.op_count == (selected_idxs.size() + 2));
+
+        list = MakeRootList();
+        const auto selected_list = list;
+        const auto move_per_record = CountFileOperations([&]() {
+            for(const auto idx: selected_idxs) {
+                TEST_CHECK(cfg::MoveRecordTo(list, selected_list.root.titles.at(idx), "Folder"));
+                cfg::FlushRecords();
+            }
+        });
+        TEST_CHECK(move_batched.op_count < move_per_record.op_count);
+        cfg::ExitRecordWriter();
+
+        printf("Rename of a %u-title folder: batched %u file ops (%.2f ms), per record %u file ops (%.2f ms)\n", BenchmarkRecordCount, rename_batched.op_count, rename_batched.elapsed_ns / 1'000'000.0, rename_per_record.op_count, rename_per_record.elapsed_ns / 1'000'000.0);
+        printf("Move of %zu of %u root titles: batched %u file ops (%.2f ms), per record %u file ops (%.2f ms)\n", selected_idxs.size(), BenchmarkRecordCount, move_batched.op_count, move_batched.elapsed_ns / 1'000'000.0, move_per_record.op_count, move_per_record.elapsed_ns / 1'000'000.0);
+    }
+
+}
+
+int main() {
+    cfg::SetRecordStoreBackend({
+        .write_file = &WriteFile,
+        .read_file = &ReadFile,
+        .delete_file = &DeleteFile,
+        .exists_file = &ExistsFile,
+        .get_current_ns = &GetCurrentNs,
+        .wait_timeout = &WaitTimeout
+    });
+
+    TestCommitAbortedAtEveryBoundary();
+    TestRecoveryAbortedAtEveryBoundary();
+    TestFailedJournalWriteKeepsRecords();
+    TestFlushRacingWrittenBatch();
+    TestDeferredDeadline();
+    BenchmarkFolderOperations();
+
+    return test::Finish("cfg_RecordStoreTest");
+}
@@ -0,0 +1,267 @@
+#include <test_Common.hpp>
+#include <cfg/cfg_ThemePack.hpp>
+#include <sys/iosupport.h>
+#include <filesystem>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Theme packs: loaded data correctness plus a load time benchmark of a pack versus the same theme as a directory
+// Runs inside a temporary directory, where "sdmc:/ulaunch/themes" is just a relative path
+
+namespace {
+
+    struct TestAsset {
+        std::string path;
+        std::vector<u8> data;
+    };
+
+    constexpr const char TestThemeName[] = "BenchTheme";
+    constexpr const char TestPackName[] = "BenchTheme" CFG_THEME_PACK_EXTENSION;
+    constexpr const char TestDuplicatePackName[] = "DuplicateTheme" CFG_THEME_PACK_EXTENSION;
+    constexpr size_t BenchmarkIterationCount = 20;
+
+    std::vector<u8> MakeRandomData(std::mt19937 &rng, const size_t size) {
+        std::vector<u8> data(size);
+        for(auto &byte: data) {
+            byte = static_cast<u8>(rng());
+        }
+        return data;
+    }
+
+    // Roughly what a full theme has: a background, plenty of icons, sounds and the UI/manifest JSONs
+    std::vector<TestAsset> MakeThemeAssets() {
+        std::mt19937 rng(0x554C);
+        std::vector<TestAsset> assets;
+        assets.push_back({ "theme/Manifest.json", MakeRandomData(rng, 0x200) });
+        assets.push_back({ "ui/UI.json", MakeRandomData(rng, 0x1000) });
+        assets.push_back({ "ui/Background.png", MakeRandomData(rng, 1200_KB) });
+        for(u32 i = 0; i < 30; i++) {
+            assets.push_back({ "ui/Icon" + std::to_string(i) + ".png", MakeRandomData(rng, 20_KB + (rng() % 60_KB)) });
+        }
+        assets.push_back({ "sound/BGM.mp3", MakeRandomData(rng, 2_MB) });
+        for(u32 i = 0; i < 8; i++) {
+            assets.push_back({ "sound/Sfx" + std::to_string(i) + ".wav", MakeRandomData(rng, 50_KB) });
+        }
+
+        std::sort(assets.begin(), assets.end(), [](const TestAsset &a, const TestAsset &b) {
+            return strcmp(a.path.c_str(), b.path.c_str()) < 0;
+        });
+        return assets;
+    }
+
+    inline size_t Align(const size_t value) {
+        return (value + cfg::ThemePackAlignment - 1) & ~(cfg::ThemePackAlignment - 1);
+    }
+
+    // Same layout as uViewer's packer
+    void WritePack(const std::string &pack_name, const std::vector<TestAsset> &assets) {
+        const std::string manifest = "{\"name\":\"Bench\"}";
+        const auto asset_table_offset = sizeof(cfg::ThemePackHeader);
+        const auto manifest_offset = asset_table_offset + assets.size() * sizeof(cfg::ThemePackAsset);
+        std::vector<cfg::ThemePackAsset> table(assets.size());
+        auto cur_offset = Align(manifest_offset + manifest.length());
+        size_t file_size = manifest_offset + manifest.length();
+        for(size_t i = 0; i < assets.size(); i++) {
+            strcpy(table[i].path, assets[i].path.c_str());
+            table[i].offset = cur_offset;
+            table[i].size = assets[i].data.size();
+            file_size = cur_offset + assets[i].data.size();
+            cur_offset = Align(file_size);
+        }
+
+        const cfg::ThemePackHeader header = {
+            .magic = cfg::ThemePackMagic,
+            .version = cfg::CurrentThemePackVersion,
+            .asset_count = static_cast<u32>(assets.size()),
+            .asset_table_offset = static_cast<u32>(asset_table_offset),
+            .manifest_offset = static_cast<u32>(manifest_offset),
+            .manifest_size = static_cast<u32>(manifest.length()),
+            .file_size = static_cast<u32>(file_size)
+        };
+        std::vector<u8> pack_data(file_size);
+        memcpy(pack_data.data(), &header, sizeof(header));
+        memcpy(pack_data.data() + asset_table_offset, table.data(), table.size() * sizeof(cfg::ThemePackAsset));
+        memcpy(pack_data.data() + manifest_offset, manifest.data(), manifest.length());
+        for(size_t i = 0; i < assets.size(); i++) {
+            memcpy(pack_data.data() + table[i].offset, assets[i].data.data(), assets[i].data.size());
+        }
+
+        auto f = fopen((UL_THEMES_PATH "/" + pack_name).c_str(), "wb");
+        TEST_CHECK(f != nullptr);
+        TEST_CHECK(fwrite(pack_data.data(), 1, pack_data.size(), f) == pack_data.size());
+        fclose(f);
+    }
+
+    void WriteThemeDirectory(const std::vector<TestAsset> &assets) {
+        for(const auto &asset: assets) {
+            const std::filesystem::path path = UL_THEMES_PATH "/" + std::string(TestThemeName) + "/" + asset.path;
+            std::filesystem::create_directories(path.parent_path());
+            auto f = fopen(path.c_str(), "wb");
+            TEST_CHECK(f != nullptr);
+            TEST_CHECK(fwrite(asset.data.data(), 1, asset.data.size(), f) == asset.data.size());
+            fclose(f);
+        }
+    }
+
+    // Reads an asset like any path-based code would, through the pack's device
+    bool ReadDeviceAsset(const std::string &pack_name, const std::string &asset_path, std::vector<u8> &out_data) {
+        const auto device = GetDeviceOpTab(CFG_THEME_PACK_DEVICE);
+        if(device == nullptr) {
+            return false;
+        }
+
+        const auto path = cfg::GetThemePackMountPath(pack_name) + "/" + asset_path;
+        struct _reent r = {};
+        std::vector<u8> file_struct(device->structSize);
+        if(device->open_r(&r, file_struct.data(), path.c_str(), O_RDONLY, 0) != 0) {
+            return false;
+        }
+
+        struct stat st;
+        auto ok = device->fstat_r(&r, file_struct.data(), &st) == 0;
+        if(ok) {
+            out_data.resize(st.st_size);
+            ok = device->read_r(&r, file_struct.data(), reinterpret_cast<char*>(out_data.data()), out_data.size()) == static_cast<ssize_t>(out_data.size());
+        }
+        device->close_r(&r, file_struct.data());
+        return ok;
+    }
+
+    bool ReadDirectoryAsset(const std::string &asset_path, std::vector<u8> &out_data) {
+        auto f = fopen((UL_THEMES_PATH "/" + std::string(TestThemeName) + "/" + asset_path).c_str(), "rb");
+        if(f == nullptr) {
+            return false;
+        }
+
+        fseek(f, 0, SEEK_END);
+        out_data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        const auto ok = fread(out_data.data(), 1, out_data.size(), f) == out_data.size();
+        fclose(f);
+        return ok;
+    }
+
+    void TestLoadedPack(const std::vector<TestAsset> &assets) {
+        std::string manifest;
+        TEST_CHECK(cfg::OpenThemePack(TestPackName, manifest));
+        TEST_CHECK(manifest == "{\"name\":\"Bench\"}");
+
+        // Assets are readable from the file before hot assets are loaded
+        std::vector<u8> data;
+        for(const auto &asset: assets) {
+            TEST_CHECK(ReadDeviceAsset(TestPackName, asset.path, data) && (data == asset.data));
+        }
+        TEST_CHECK(cfg::LoadThemePackHotAssets(TestPackName));
+
+        // Afterwards only hot assets are served from memory, the rest still comes from the file (thus fails without it)
+        const auto pack_path = UL_THEMES_PATH "/" + std::string(TestPackName);
+        const auto moved_pack_path = pack_path + ".moved";
+        std::filesystem::rename(pack_path, moved_pack_path);
+        size_t hot_asset_count = 0;
+        for(const auto &asset: assets) {
+            cfg::ThemePackAsset pack_asset = {};
+            strcpy(pack_asset.path, asset.path.c_str());
+            pack_asset.size = asset.data.size();
+            const auto is_hot = cfg::IsThemePackHotAsset(pack_asset);
+            if(is_hot) {
+                hot_asset_count++;
+                TEST_CHECK(ReadDeviceAsset(TestPackName, asset.path, data) && (data == asset.data));
+            }
+            else {
+                TEST_CHECK(!ReadDeviceAsset(TestPackName, asset.path, data));
+            }
+        }
+        TEST_CHECK((hot_asset_count > 0) && (hot_asset_count < assets.size()));
+        std::filesystem::rename(moved_pack_path, pack_path);
+
+        for(const auto &asset: assets) {
+            TEST_CHECK(ReadDeviceAsset(TestPackName, asset.path, data) && (data == asset.data));
+        }
+        TEST_CHECK(!ReadDeviceAsset(TestPackName, "ui/Missing.png", data));
+
+        std::vector<std::string> names;
+        TEST_CHECK(cfg::ListThemePackAssets(TestPackName, "ui", names));
+        TEST_CHECK(names.size() == 32);
+
+        cfg::CloseThemePack(TestPackName);
+        TEST_CHECK(!cfg::IsThemePackOpen(TestPackName));
+    }
+
+    void TestDuplicateAssetPack(const std::vector<TestAsset> &assets) {
+        // Packs with several assets under the same path (like the ones holding pre-decoded image copies) are rejected
+        auto dup_assets = assets;
+        dup_assets.insert(dup_assets.begin() + 1, assets.front());
+        WritePack(TestDuplicatePackName, dup_assets);
+
+        std::string manifest;
+        TEST_CHECK(!cfg::OpenThemePack(TestDuplicatePackName, manifest));
+        TEST_CHECK(!cfg::IsThemePackOpen(TestDuplicatePackName));
+    }
+
+    void BenchmarkThemeLoad(const std::vector<TestAsset> &assets, const size_t pack_size) {
+        std::vector<u8> data;
+        auto read_ok = true;
+
+        // Directory: every asset is its own file
+        auto start_ns = test::GetCurrentNs();
+        for(size_t i = 0; i < BenchmarkIterationCount; i++) {
+            for(const auto &asset: assets) {
+                read_ok &= ReadDirectoryAsset(asset.path, data);
+            }
+        }
+        const auto dir_ns = (test::GetCurrentNs() - start_ns) / BenchmarkIterationCount;
+
+        // Pack, assets read from the file on demand
+        start_ns = test::GetCurrentNs();
+        for(size_t i = 0; i < BenchmarkIterationCount; i++) {
+            std::string manifest;
+            read_ok &= cfg::OpenThemePack(TestPackName, manifest);
+            for(const auto &asset: assets) {
+                read_ok &= ReadDeviceAsset(TestPackName, asset.path, data);
+            }
+            cfg::CloseThemePack(TestPackName);
+        }
+        const auto pack_on_demand_ns = (test::GetCurrentNs() - start_ns) / BenchmarkIterationCount;
+
+        // Pack with its hot assets loaded (what uMenu does for the active theme), only those then copied from memory
+        start_ns = test::GetCurrentNs();
+        for(size_t i = 0; i < BenchmarkIterationCount; i++) {
+            std::string manifest;
+            read_ok &= cfg::OpenThemePack(TestPackName, manifest) && cfg::LoadThemePackHotAssets(TestPackName);
+            for(const auto &asset: assets) {
+                read_ok &= ReadDeviceAsset(TestPackName, asset.path, data);
+            }
+            cfg::CloseThemePack(TestPackName);
+        }
+        const auto pack_hot_ns = (test::GetCurrentNs() - start_ns) / BenchmarkIterationCount;
+        TEST_CHECK(read_ok);
+
+        // Host file system (page cache), so the file count matters more than these times on the console's SD card
+        printf("Theme load, %zu assets: directory %.2f ms (%zu files), pack on demand %.2f ms, pack with hot assets %.2f ms (0x%zX bytes)\n", assets.size(), dir_ns / 1'000'000.0, assets.size(), pack_on_demand_ns / 1'000'000.0, pack_hot_ns / 1'000'000.0, pack_size);
+    }
+
+}
+
+int main() {
+    char tmp_dir[] = "/tmp/ul_theme_pack_test_XXXXXX";
+    if(mkdtemp(tmp_dir) == nullptr) {
+        printf("Unable to create a temporary directory\n");
+        return EXIT_FAILURE;
+    }
+    const auto prev_dir = std::filesystem::current_path();
+    std::filesystem::current_path(tmp_dir);
+    std::filesystem::create_directories(UL_THEMES_PATH);
+
+    const auto assets = MakeThemeAssets();
+    WritePack(TestPackName, assets);
+    WriteThemeDirectory(assets);
+
+    TestLoadedPack(assets);
+    TestDuplicateAssetPack(assets);
+    BenchmarkThemeLoad(assets, std::filesystem::file_size(UL_THEMES_PATH "/" + std::string(TestPackName)));
+
+    std::filesystem::current_path(prev_dir);
+    std::filesystem::remove_all(tmp_dir);
+    return test::Finish("cfg_ThemePackTest");
+}
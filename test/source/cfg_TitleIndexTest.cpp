@@ -0,0 +1,244 @@
+#include <test_Common.hpp>
+#include <cfg/cfg_TitleIndex.hpp>
+#include <algorithm>
+#include <random>
+
+// Title search index: matches versus a plain substring scan (case folding, short queries, removed and replaced entries), plus build and query timings over a big library
+
+namespace cfg {
+
+    // The real one (cfg_Config.cpp) falls back to NACPs, test records always have a name
+    std::string GetRecordName(const TitleRecord &record) {
+        return record.name;
+    }
+
+}
+
+namespace {
+
+    constexpr u32 BenchmarkTitleCount = 10'000;
+    constexpr u32 BenchmarkQueryIterationCount = 20;
+
+    cfg::TitleRecord MakeInstalledRecord(const u64 app_id, const std::string &name) {
+        cfg::TitleRecord record = {};
+        record.title_type = cfg::TitleType::Installed;
+        record.app_id = app_id;
+        record.name = name;
+        return record;
+    }
+
+    cfg::TitleRecord MakeHomebrewRecord(const std::string &nro_path, const std::string &name) {
+        cfg::TitleRecord record = {};
+        record.title_type = cfg::TitleType::Homebrew;
+        strncpy(record.nro_target.nro_path, nro_path.c_str(), sizeof(record.nro_target.nro_path) - 1);
+        record.name = name;
+        return record;
+    }
+
+    std::vector<std::string> Sorted(std::vector<std::string> keys) {
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    std::string ToLower(std::string str) {
+        for(auto &ch: str) {
+            if((ch >= 'A') && (ch <= 'Z')) {
+                ch += 'a' - 'A';
+            }
+        }
+        return str;
+    }
+
+    // What the index must match: every record whose name holds the query, ignoring ASCII case
+    std::vector<std::string> ScanRecords(const std::vector<cfg::TitleRecord> &records, const std::string &query) {
+        std::vector<std::string> keys;
+        if(query.empty()) {
+            return keys;
+        }
+        const auto lower_query = ToLower(query);
+        for(const auto &record: records) {
+            if(ToLower(record.name).find(lower_query) != std::string::npos) {
+                keys.push_back(cfg::GetRecordKey(record));
+            }
+        }
+        return Sorted(keys);
+    }
+
+    void TestFind() {
+        const std::vector<cfg::TitleRecord> records = {
+            MakeInstalledRecord(0x0100000000010000, "Super Mario Odyssey"),
+            MakeInstalledRecord(0x0100000000020000, "Mario Kart 8 Deluxe"),
+            MakeInstalledRecord(0x0100000000030000, "The Legend of Zelda: Breath of the Wild"),
+            MakeInstalledRecord(0x0100000000040000, "Pokémon Sword"),
+            MakeHomebrewRecord("sdmc:/switch/Checkpoint.nro", "Checkpoint"),
+            MakeHomebrewRecord("sdmc:/switch/hbmenu.nro", "nx-hbmenu"),
+            MakeHomebrewRecord("sdmc:/switch/aaa.nro", "AAAA")
+        };
+
+        cfg::TitleIndex index;
+        for(const auto &record: records) {
+            index.Add(record);
+        }
+        TEST_CHECK(index.GetCount() == records.size());
+
+        // Installed titles are keyed by application ID, homebrew by NRO path
+        TEST_CHECK(cfg::GetRecordKey(records.at(0)) == "0100000000010000");
+        TEST_CHECK(cfg::GetRecordKey(records.at(4)) == "sdmc:/switch/Checkpoint.nro");
+
+        const char *queries[] = {
+            "mario", "MARIO", "MaRiO kart", "zelda:", "of the", "o", "e", "ma", "Od", "aa", "aaa", "aaaa", "aaaaa",
+            "pokémon", "POKéMON", "émon", "hbmenu", "nx-", "8", "checkpoint", "missing", "xyz", " ", ""
+        };
+        for(const auto query: queries) {
+            const auto keys = Sorted(index.Find(query));
+            const auto expected_keys = ScanRecords(records, query);
+            if(keys != expected_keys) {
+                printf("Query \"%s\": %zu matches, %zu expected\n", query, keys.size(), expected_keys.size());
+            }
+            TEST_CHECK(keys == expected_keys);
+        }
+
+        // Case folding only covers ASCII
+        TEST_CHECK(index.Find("POKÉMON").empty());
+        TEST_CHECK(index.Find("Mario").size() == 2);
+        // Short queries scan every name
+        TEST_CHECK(index.Find("Z").size() == 1);
+        TEST_CHECK(index.Find("of").size() == 1);
+    }
+
+    void TestRemoveAndReplace() {
+        cfg::TitleIndex index;
+        const auto mario = MakeInstalledRecord(0x0100000000010000, "Super Mario Odyssey");
+        const auto kart = MakeInstalledRecord(0x0100000000020000, "Mario Kart 8 Deluxe");
+        index.Add(mario);
+        index.Add(kart);
+
+        // Removed entries never match, neither through trigrams nor through scans
+        index.Remove(mario);
+        TEST_CHECK(index.GetCount() == 1);
+        TEST_CHECK(Sorted(index.Find("mario")) == std::vector<std::string>{ cfg::GetRecordKey(kart) });
+        TEST_CHECK(index.Find("odyssey").empty());
+        TEST_CHECK(index.Find("od").empty());
+        TEST_CHECK(index.Find("o").size() == 1);
+
+        // Removing something not indexed does nothing
+        index.Remove(mario);
+        index.Remove(MakeInstalledRecord(0x0100000000990000, "Missing"));
+        TEST_CHECK(index.GetCount() == 1);
+
+        // Added again
+        index.Add(mario);
+        TEST_CHECK(index.Find("odyssey").size() == 1);
+
+        // Same record with a new name (the same key) replaces the old entry
+        auto renamed_kart = kart;
+        renamed_kart.name = "Kart Racing";
+        index.Add(renamed_kart);
+        TEST_CHECK(index.GetCount() == 2);
+        TEST_CHECK(index.Find("deluxe").empty());
+        TEST_CHECK(index.Find("racing") == std::vector<std::string>{ cfg::GetRecordKey(kart) });
+        TEST_CHECK(index.Find("mario") == std::vector<std::string>{ cfg::GetRecordKey(mario) });
+
+        index.Clear();
+        TEST_CHECK(index.GetCount() == 0);
+        TEST_CHECK(index.Find("mario").empty());
+    }
+
+    void TestBuildFromList() {
+        cfg::TitleList list = {};
+        list.root.titles.push_back(MakeInstalledRecord(0x0100000000010000, "Root Game"));
+        list.folders.push_back({ .name = "Homebrew", .titles = { MakeHomebrewRecord("sdmc:/switch/a.nro", "Folder App") } });
+        list.folders.push_back({ .name = "Games", .titles = { MakeInstalledRecord(0x0100000000020000, "Folder Game") } });
+
+        cfg::TitleIndex index;
+        index.Add(MakeInstalledRecord(0x0100000000990000, "Stale"));
+        cfg::BuildTitleIndex(list, index);
+        TEST_CHECK(index.GetCount() == 3);
+        TEST_CHECK(index.Find("stale").empty());
+        TEST_CHECK(index.Find("game").size() == 2);
+        TEST_CHECK(index.Find("folder").size() == 2);
+    }
+
+    // Two or three words out of a vocabulary, like title names
+    std::vector<cfg::TitleRecord> MakeBenchmarkRecords() {
+        const char *words[] = {
+            "Super", "Mario", "Legend", "Zelda", "Kart", "Deluxe", "Party", "Adventure", "Quest", "Dragon", "Fantasy", "Tales",
+            "Racing", "Soccer", "Puzzle", "Dungeon", "Knight", "Shadow", "Crystal", "Ninja", "Pirate", "Galaxy", "Island", "World",
+            "Hero", "Chronicles", "Arena", "Tactics", "Odyssey", "Frontier", "Rhythm", "Farm", "Station", "Legends", "Origins", "Edition"
+        };
+        std::mt19937 rng(0x5449);
+        std::vector<cfg::TitleRecord> records;
+        records.reserve(BenchmarkTitleCount);
+        for(u32 i = 0; i < BenchmarkTitleCount; i++) {
+            std::string name;
+            const auto word_count = 2 + (rng() % 2);
+            for(u32 j = 0; j < word_count; j++) {
+                name += std::string(words[rng() % std::size(words)]) + " ";
+            }
+            name += std::to_string(i);
+            records.push_back(MakeInstalledRecord(0x0100000000000000 | (static_cast<u64>(i) << 16), name));
+        }
+        return records;
+    }
+
+    void BenchmarkTitleIndex() {
+        const auto records = MakeBenchmarkRecords();
+
+        const auto build_start_ns = test::GetCurrentNs();
+        cfg::TitleIndex index;
+        for(const auto &record: records) {
+            index.Add(record);
+        }
+        const auto build_ns = test::GetCurrentNs() - build_start_ns;
+        TEST_CHECK(index.GetCount() == BenchmarkTitleCount);
+
+        std::vector<std::string> lower_names;
+        for(const auto &record: records) {
+            lower_names.push_back(ToLower(record.name));
+        }
+
+        const char *queries[] = { "zelda", "dragon quest", "ninja", "odyssey 12", "9999", "crystal island", "missing", "ma", "z" };
+        u64 index_ns = 0;
+        u64 scan_ns = 0;
+        size_t match_count = 0;
+        for(const auto query: queries) {
+            std::vector<std::string> keys;
+            auto start_ns = test::GetCurrentNs();
+            for(u32 i = 0; i < BenchmarkQueryIterationCount; i++) {
+                keys = index.Find(query);
+            }
+            index_ns += test::GetCurrentNs() - start_ns;
+
+            // Names already lowercase, like the index keeps them
+            const auto lower_query = ToLower(query);
+            size_t scan_match_count = 0;
+            start_ns = test::GetCurrentNs();
+            for(u32 i = 0; i < BenchmarkQueryIterationCount; i++) {
+                scan_match_count = 0;
+                for(const auto &name: lower_names) {
+                    if(name.find(lower_query) != std::string::npos) {
+                        scan_match_count++;
+                    }
+                }
+            }
+            scan_ns += test::GetCurrentNs() - start_ns;
+
+            TEST_CHECK(Sorted(keys) == ScanRecords(records, query));
+            TEST_CHECK(keys.size() == scan_match_count);
+            match_count += keys.size();
+        }
+
+        const auto query_count = std::size(queries) * BenchmarkQueryIterationCount;
+        printf("%u titles: index built in %.2f ms, %zu queries (%zu matches): index %.1f us/query, full scan %.1f us/query\n", BenchmarkTitleCount, build_ns / 1'000'000.0, std::size(queries), match_count, index_ns / 1'000.0 / query_count, scan_ns / 1'000.0 / query_count);
+    }
+
+}
+
+int main() {
+    TestFind();
+    TestRemoveAndReplace();
+    TestBuildFromList();
+    BenchmarkTitleIndex();
+
+    return test::Finish("cfg_TitleIndexTest");
+}
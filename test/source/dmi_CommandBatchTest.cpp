@@ -0,0 +1,343 @@
+#include <test_Common.hpp>
+#include <dmi/dmi_DaemonMenuInteraction.hpp>
+#include <deque>
+
+// Menu<->daemon round-trips (single and batched frames) over a fake in-memory storage transport, plus a round-trip benchmark
+
+namespace {
+
+    constexpr Result ResultNoStorage = 0xBEEF;
+    constexpr Result ResultInvalidApplicationId = 0xCAFE;
+    constexpr Result ResultPushFailed = 0xDEAD;
+
+    std::deque<AppletStorage> g_MenuToDaemonStorages;
+    std::deque<AppletStorage> g_DaemonToMenuStorages;
+    u32 g_StorageTransferCount = 0;
+    // Simulated IPC cost of each storage push/pop
+    u64 g_StorageTransferCostNs = 0;
+    bool g_FailMenuPushStorage = false;
+
+    struct DaemonState {
+        AccountUid selected_user;
+        u64 launched_app_id;
+        u32 launch_count;
+        std::vector<dmi::DaemonMessage> handled_msgs;
+    };
+
+    DaemonState g_DaemonState;
+
+    void SimulateTransfer() {
+        g_StorageTransferCount++;
+        if(g_StorageTransferCostNs > 0) {
+            const auto end_ns = test::GetCurrentNs() + g_StorageTransferCostNs;
+            while(test::GetCurrentNs() < end_ns) {}
+        }
+    }
+
+    Result PopStorageFrom(std::deque<AppletStorage> &storages, AppletStorage *st) {
+        if(storages.empty()) {
+            return ResultNoStorage;
+        }
+        *st = storages.front();
+        storages.pop_front();
+        SimulateTransfer();
+        return ResultSuccess;
+    }
+
+    void PushStorageTo(std::deque<AppletStorage> &storages, AppletStorage *st) {
+        SimulateTransfer();
+        storages.push_back(*st);
+        // The pushed storage now belongs to the other side, the writer closing it must not free it
+        *st = {};
+    }
+
+    // Mirrors what uDaemon does for these messages: requests are popped first, then replies pushed
+    Result HandleDaemonCommand() {
+        dmi::LaunchApplicationRequest launch_app_req = {};
+        return dmi::dmn::ReceiveCommand([&](const dmi::DaemonMessage msg, dmi::dmn::DaemonScopedStorageReader &reader) -> Result {
+            g_DaemonState.handled_msgs.push_back(msg);
+            switch(msg) {
+                case dmi::DaemonMessage::SetSelectedUser: {
+                    dmi::SetSelectedUserRequest req;
+                    UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::SetSelectedUser>(reader, req));
+                    g_DaemonState.selected_user = req.user_id;
+                    break;
+                }
+                case dmi::DaemonMessage::LaunchApplication: {
+                    UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::LaunchApplication>(reader, launch_app_req));
+                    if(launch_app_req.app_id == 0) {
+                        return ResultInvalidApplicationId;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            return ResultSuccess;
+        },
+        [&](const dmi::DaemonMessage msg, dmi::dmn::DaemonScopedStorageWriter &writer) -> Result {
+            (void)writer;
+            if(msg == dmi::DaemonMessage::LaunchApplication) {
+                if(g_DaemonState.selected_user.uid[0] == 0) {
+                    return dmn::ResultInvalidSelectedUser;
+                }
+                g_DaemonState.launched_app_id = launch_app_req.app_id;
+                g_DaemonState.launch_count++;
+            }
+            return ResultSuccess;
+        });
+    }
+
+    void ResetTransport() {
+        for(auto &st: g_MenuToDaemonStorages) {
+            appletStorageClose(&st);
+        }
+        g_MenuToDaemonStorages.clear();
+        for(auto &st: g_DaemonToMenuStorages) {
+            appletStorageClose(&st);
+        }
+        g_DaemonToMenuStorages.clear();
+        g_StorageTransferCount = 0;
+        g_FailMenuPushStorage = false;
+        g_DaemonState = {};
+    }
+
+    void TestSingleRoundTrip() {
+        ResetTransport();
+        const AccountUid uid = { { 0x1234, 0x5678 } };
+        TEST_CHECK_RC(dmi::menu::SendCommand<dmi::DaemonMessage::SetSelectedUser>({ uid }));
+        TEST_CHECK(g_DaemonState.selected_user.uid[0] == 0x1234);
+        TEST_CHECK(g_DaemonState.selected_user.uid[1] == 0x5678);
+        TEST_CHECK(g_StorageTransferCount == 4);
+
+        // Request handling failures get back to the sender
+        ResetTransport();
+        TEST_CHECK(dmi::menu::SendCommand<dmi::DaemonMessage::LaunchApplication>({ 0, {} }) == ResultInvalidApplicationId);
+        TEST_CHECK(g_DaemonState.launch_count == 0);
+        TEST_CHECK(g_StorageTransferCount == 4);
+    }
+
+    void TestBatchRoundTrip() {
+        ResetTransport();
+        const AccountUid uid = { { 0xAAAA, 0xBBBB } };
+        const dmi::SetSelectedUserRequest set_user_req = { uid };
+        const dmi::LaunchApplicationRequest launch_req = { 0x0100000000010000, {} };
+        dmi::menu::MenuBatchCommand cmds[] = {
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(set_user_req),
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::LaunchApplication>(launch_req)
+        };
+        TEST_CHECK_RC(dmi::menu::SendCommandBatch(cmds));
+
+        // One storage each way, messages handled in order (the launch sees the user set just before it)
+        TEST_CHECK(g_StorageTransferCount == 4);
+        TEST_CHECK(g_DaemonState.handled_msgs.size() == 2);
+        TEST_CHECK(g_DaemonState.handled_msgs.at(0) == dmi::DaemonMessage::SetSelectedUser);
+        TEST_CHECK(g_DaemonState.handled_msgs.at(1) == dmi::DaemonMessage::LaunchApplication);
+        TEST_CHECK(g_DaemonState.launched_app_id == 0x0100000000010000);
+        TEST_CHECK_RC(cmds[0].rc);
+        TEST_CHECK_RC(cmds[1].rc);
+
+        // Requests are sent as they are when the batch is sent, not when the command was made
+        ResetTransport();
+        dmi::SetSelectedUserRequest later_set_user_req = {};
+        auto later_cmd = dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(later_set_user_req);
+        later_set_user_req.user_id = { { 0xCCCC, 0xDDDD } };
+        TEST_CHECK_RC(dmi::menu::SendCommandBatch(&later_cmd, 1));
+        TEST_CHECK(g_DaemonState.selected_user.uid[0] == 0xCCCC);
+        TEST_CHECK(g_DaemonState.selected_user.uid[1] == 0xDDDD);
+    }
+
+    void TestBatchPerCommandResults() {
+        ResetTransport();
+        const dmi::LaunchApplicationRequest launch_req = { 0x0100000000010000, {} };
+        const dmi::SetSelectedUserRequest set_user_req = { { { 0xAAAA, 0xBBBB } } };
+        const dmi::LaunchApplicationRequest invalid_launch_req = { 0, {} };
+        const dmi::LaunchApplicationRequest other_launch_req = { 0x0100000000020000, {} };
+        dmi::menu::MenuBatchCommand cmds[] = {
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::LaunchApplication>(launch_req),
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(set_user_req),
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::LaunchApplication>(invalid_launch_req),
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::LaunchApplication>(other_launch_req)
+        };
+        TEST_CHECK_RC(dmi::menu::SendCommandBatch(cmds));
+
+        // A failing message doesn't stop the following ones, batched replies also carry the failures of their reply step
+        TEST_CHECK(cmds[0].rc == dmn::ResultInvalidSelectedUser);
+        TEST_CHECK_RC(cmds[1].rc);
+        TEST_CHECK(cmds[2].rc == ResultInvalidApplicationId);
+        TEST_CHECK_RC(cmds[3].rc);
+        TEST_CHECK(g_DaemonState.launch_count == 1);
+        TEST_CHECK(g_DaemonState.launched_app_id == 0x0100000000020000);
+    }
+
+    void TestBatchLimits() {
+        ResetTransport();
+        dmi::SetSelectedUserRequest reqs[dmi::MaxBatchCommandCount + 1] = {};
+        dmi::menu::MenuBatchCommand cmds[dmi::MaxBatchCommandCount + 1] = {};
+        TEST_CHECK(dmi::menu::SendCommandBatch(cmds, 0) == dmi::ResultInvalidBatchCount);
+
+        for(u32 i = 0; i < dmi::MaxBatchCommandCount + 1; i++) {
+            reqs[i].user_id = { { i + 1, 0 } };
+            cmds[i] = dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(reqs[i]);
+        }
+        TEST_CHECK(dmi::menu::SendCommandBatch(cmds, dmi::MaxBatchCommandCount + 1) == dmi::ResultInvalidBatchCount);
+        TEST_CHECK(g_StorageTransferCount == 0);
+
+        TEST_CHECK_RC(dmi::menu::SendCommandBatch(cmds, dmi::MaxBatchCommandCount));
+        TEST_CHECK(g_DaemonState.handled_msgs.size() == dmi::MaxBatchCommandCount);
+        TEST_CHECK(g_DaemonState.selected_user.uid[0] == dmi::MaxBatchCommandCount);
+    }
+
+    void TestStorageFailures() {
+        // Failing to send is reported back instead of aborting, and nothing is waited for
+        ResetTransport();
+        g_FailMenuPushStorage = true;
+        TEST_CHECK(dmi::menu::SendCommand<dmi::DaemonMessage::SetSelectedUser>({ { { 0x1234, 0 } } }) == ResultPushFailed);
+        const dmi::SetSelectedUserRequest set_user_req = { { { 0xAAAA, 0xBBBB } } };
+        dmi::menu::MenuBatchCommand cmds[] = {
+            dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(set_user_req)
+        };
+        TEST_CHECK(dmi::menu::SendCommandBatch(cmds) == ResultPushFailed);
+        TEST_CHECK(g_DaemonState.handled_msgs.empty());
+        TEST_CHECK(g_MenuToDaemonStorages.empty());
+
+        // Neither is anything sent if the payload doesn't fit
+        ResetTransport();
+        TEST_CHECK(dmi::menu::SendCommand(dmi::DaemonMessage::OpenWebPage, [](dmi::menu::MenuScopedStorageWriter &writer) {
+            const u8 big_data[dmi::CommandStorageSize] = {};
+            return writer.Push(big_data);
+        },
+        [](dmi::menu::MenuScopedStorageReader&) {
+            return ResultSuccess;
+        }) == dmi::ResultOutOfPushSpace);
+        TEST_CHECK(g_StorageTransferCount == 0);
+    }
+
+    void TestWireFormat() {
+        // Whole-struct pushes must lay out fields exactly as pushing each one after another did
+        ResetTransport();
+        const AccountUid uid = { { 0x1122334455667788, 0x99AABBCCDDEEFF00 } };
+        dmi::menu::MenuScopedStorageWriter writer;
+        TEST_CHECK_RC(dmi::impl::OpenStorageWriter(writer));
+        TEST_CHECK_RC(writer.Push(dmi::CommandCommonHeader { dmi::CommandMagic, static_cast<u32>(dmi::DaemonMessage::LaunchApplication) }));
+        const dmi::LaunchApplicationRequest req = {
+            .app_id = 0x0100000000010000,
+            .trace = {
+                .correlation_id = 0xABCD,
+                .reserved = 0,
+                .input_tick = 0x1111,
+                .send_tick = 0x2222
+            }
+        };
+        TEST_CHECK_RC(writer.Push(req));
+        TEST_CHECK_RC(writer.Push(dmi::SetSelectedUserRequest { uid }));
+        TEST_CHECK_RC(writer.Commit());
+        TEST_CHECK(g_MenuToDaemonStorages.size() == 1);
+
+        u8 expected[0x40] = {};
+        size_t expected_size = 0;
+        const auto push_field = [&](const auto field) {
+            memcpy(expected + expected_size, &field, sizeof(field));
+            expected_size += sizeof(field);
+        };
+        push_field(dmi::CommandMagic);
+        push_field(static_cast<u32>(dmi::DaemonMessage::LaunchApplication));
+        push_field(req.app_id);
+        push_field(static_cast<u32>(0xABCD));
+        push_field(static_cast<u32>(0));
+        push_field(static_cast<u64>(0x1111));
+        push_field(static_cast<u64>(0x2222));
+        push_field(uid.uid[0]);
+        push_field(uid.uid[1]);
+        TEST_CHECK(expected_size == sizeof(dmi::CommandCommonHeader) + sizeof(req) + sizeof(dmi::SetSelectedUserRequest));
+        TEST_CHECK(memcmp(g_MenuToDaemonStorages.front().data, expected, expected_size) == 0);
+    }
+
+    void BenchmarkRoundTrips(const u64 transfer_cost_ns) {
+        constexpr u32 IterationCount = 2000;
+        const AccountUid uid = { { 0xAAAA, 0xBBBB } };
+        g_StorageTransferCostNs = transfer_cost_ns;
+
+        ResetTransport();
+        const auto single_start_ns = test::GetCurrentNs();
+        for(u32 i = 0; i < IterationCount; i++) {
+            dmi::menu::SendCommand<dmi::DaemonMessage::SetSelectedUser>({ uid });
+            dmi::menu::SendCommand<dmi::DaemonMessage::LaunchApplication>({ 0x0100000000010000, {} });
+        }
+        const auto single_ns = test::GetCurrentNs() - single_start_ns;
+        const auto single_transfer_count = g_StorageTransferCount;
+
+        ResetTransport();
+        const auto batch_start_ns = test::GetCurrentNs();
+        const dmi::SetSelectedUserRequest set_user_req = { uid };
+        const dmi::LaunchApplicationRequest launch_req = { 0x0100000000010000, {} };
+        for(u32 i = 0; i < IterationCount; i++) {
+            dmi::menu::MenuBatchCommand cmds[] = {
+                dmi::menu::MakeBatchCommand<dmi::DaemonMessage::SetSelectedUser>(set_user_req),
+                dmi::menu::MakeBatchCommand<dmi::DaemonMessage::LaunchApplication>(launch_req)
+            };
+            dmi::menu::SendCommandBatch(cmds);
+        }
+        const auto batch_ns = test::GetCurrentNs() - batch_start_ns;
+        const auto batch_transfer_count = g_StorageTransferCount;
+
+        TEST_CHECK(batch_transfer_count * 2 == single_transfer_count);
+        printf("set-user + launch, %u iterations, %lu ns per transfer: single %.2f us/iter (%u transfers), batched %.2f us/iter (%u transfers)\n", IterationCount, transfer_cost_ns, static_cast<double>(single_ns) / IterationCount / 1000.0, single_transfer_count, static_cast<double>(batch_ns) / IterationCount / 1000.0, batch_transfer_count);
+        g_StorageTransferCostNs = 0;
+    }
+
+}
+
+namespace dmi {
+
+    namespace menu {
+
+        Result PushStorage(AppletStorage *st) {
+            if(g_FailMenuPushStorage) {
+                return ResultPushFailed;
+            }
+            PushStorageTo(g_MenuToDaemonStorages, st);
+            return ResultSuccess;
+        }
+
+        Result PopStorage(AppletStorage *st, const bool wait) {
+            // Waiting for the reply: let the daemon handle what was sent
+            if(wait && g_DaemonToMenuStorages.empty()) {
+                HandleDaemonCommand();
+            }
+            return PopStorageFrom(g_DaemonToMenuStorages, st);
+        }
+
+    }
+
+    namespace dmn {
+
+        Result PushStorage(AppletStorage *st) {
+            PushStorageTo(g_DaemonToMenuStorages, st);
+            return ResultSuccess;
+        }
+
+        Result PopStorage(AppletStorage *st, const bool wait) {
+            (void)wait;
+            return PopStorageFrom(g_MenuToDaemonStorages, st);
+        }
+
+    }
+
+}
+
+int main() {
+    TestSingleRoundTrip();
+    TestBatchRoundTrip();
+    TestBatchPerCommandResults();
+    TestBatchLimits();
+    TestStorageFailures();
+    TestWireFormat();
+
+    BenchmarkRoundTrips(0);
+    // Arbitrary per-transfer IPC cost, so that round-trip savings show up next to the (free) fake transport
+    BenchmarkRoundTrips(20'000);
+
+    ResetTransport();
+    return test::Finish("dmi_CommandBatchTest");
+}
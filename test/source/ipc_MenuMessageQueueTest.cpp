@@ -0,0 +1,150 @@
+#include <test_Common.hpp>
+#include <ipc/ipc_MenuMessageQueue.hpp>
+#include <vector>
+
+// uDaemon's queue of messages for uMenu: sequence numbers, drops once full, batched pops, and uMenu's gap counting over what it receives
+
+namespace {
+
+    dmi::MenuMessageContext MakeAppExitedMessage(const u64 app_id) {
+        dmi::MenuMessageContext msg_ctx = {
+            .msg = dmi::MenuMessage::ApplicationExited
+        };
+        msg_ctx.app_exited.app_id = app_id;
+        return msg_ctx;
+    }
+
+    // What uMenu's receiver thread does: pop in batches until a batch isn't full
+    std::vector<dmi::MenuMessageContext> ReceiveAll() {
+        std::vector<dmi::MenuMessageContext> msg_ctxs;
+        dmi::MenuMessageContext batch[dmi::MaxMenuMessageBatchCount];
+        while(true) {
+            const auto count = ipc::PopMenuMessages(batch, dmi::MaxMenuMessageBatchCount);
+            msg_ctxs.insert(msg_ctxs.end(), batch, batch + count);
+            if(count < dmi::MaxMenuMessageBatchCount) {
+                break;
+            }
+        }
+        return msg_ctxs;
+    }
+
+    u64 GetDroppedCount() {
+        dmi::MenuMessageStats stats = {};
+        ipc::GetMenuMessageStats(stats);
+        return stats.dropped_count;
+    }
+
+    void TestSequenceNumbers() {
+        ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
+        ipc::PushMenuMessage(dmi::MenuMessage::SdCardEjected);
+        ipc::PushMenuMessage(MakeAppExitedMessage(0x0100000000001000));
+
+        dmi::MenuMessageStats stats = {};
+        ipc::GetMenuMessageStats(stats);
+        TEST_CHECK(stats.queued_count == 3);
+
+        const auto msg_ctxs = ReceiveAll();
+        TEST_CHECK(msg_ctxs.size() == 3);
+        // Sequences start at 1, since 0 is what uMenu starts with
+        TEST_CHECK(msg_ctxs.at(0).seq == 1);
+        for(size_t i = 1; i < msg_ctxs.size(); i++) {
+            TEST_CHECK(msg_ctxs.at(i).seq == (msg_ctxs.at(i - 1).seq + 1));
+        }
+        TEST_CHECK(msg_ctxs.at(0).msg == dmi::MenuMessage::HomeRequest);
+        TEST_CHECK(msg_ctxs.at(1).msg == dmi::MenuMessage::SdCardEjected);
+        TEST_CHECK(msg_ctxs.at(2).msg == dmi::MenuMessage::ApplicationExited);
+        TEST_CHECK(msg_ctxs.at(2).app_exited.app_id == 0x0100000000001000);
+
+        // Nothing left
+        TEST_CHECK(ReceiveAll().empty());
+    }
+
+    void TestOverflowAndBatchedDrain() {
+        const auto start_dropped_count = GetDroppedCount();
+
+        // More than fit while uMenu isn't popping them
+        constexpr size_t PushCount = ipc::MenuMessageQueueCapacity + 10;
+        for(size_t i = 0; i < PushCount; i++) {
+            ipc::PushMenuMessage(MakeAppExitedMessage(i));
+        }
+        TEST_CHECK(GetDroppedCount() == (start_dropped_count + PushCount - ipc::MenuMessageQueueCapacity));
+
+        dmi::MenuMessageStats stats = {};
+        ipc::GetMenuMessageStats(stats);
+        TEST_CHECK(stats.queued_count == ipc::MenuMessageQueueCapacity);
+
+        // The queued ones are kept, the new ones are dropped
+        const auto msg_ctxs = ReceiveAll();
+        TEST_CHECK(msg_ctxs.size() == ipc::MenuMessageQueueCapacity);
+        for(size_t i = 0; i < msg_ctxs.size(); i++) {
+            TEST_CHECK(msg_ctxs.at(i).app_exited.app_id == i);
+            if(i > 0) {
+                TEST_CHECK(msg_ctxs.at(i).seq == (msg_ctxs.at(i - 1).seq + 1));
+            }
+        }
+
+        // Dropped messages still took their sequence numbers
+        ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
+        const auto next_msg_ctxs = ReceiveAll();
+        TEST_CHECK(next_msg_ctxs.size() == 1);
+        TEST_CHECK(next_msg_ctxs.at(0).seq == (msg_ctxs.back().seq + 1 + (PushCount - ipc::MenuMessageQueueCapacity)));
+    }
+
+    void TestReceiverGapCounting() {
+        // The receiver pops while the daemon pushes, a few times the queue fills up in between
+        const auto start_dropped_count = GetDroppedCount();
+        u32 last_seq = 0;
+        u32 missed_count = 0;
+        size_t received_count = 0;
+        size_t pushed_count = 0;
+        const size_t push_counts[] = { 5, ipc::MenuMessageQueueCapacity + 3, 1, ipc::MenuMessageQueueCapacity, ipc::MenuMessageQueueCapacity * 2 + 7, 2 };
+        for(const auto push_count: push_counts) {
+            for(size_t i = 0; i < push_count; i++) {
+                ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
+            }
+            pushed_count += push_count;
+
+            for(const auto &msg_ctx: ReceiveAll()) {
+                missed_count += dmi::GetMissedMenuMessageCount(last_seq, msg_ctx.seq);
+                last_seq = msg_ctx.seq;
+                received_count++;
+            }
+        }
+
+        const auto dropped_count = GetDroppedCount() - start_dropped_count;
+        TEST_CHECK(dropped_count == (3 + ipc::MenuMessageQueueCapacity + 7));
+        TEST_CHECK(missed_count == dropped_count);
+        TEST_CHECK((received_count + missed_count) == pushed_count);
+
+        // A new menu instance starts without a last sequence, whatever came before isn't a gap
+        TEST_CHECK(dmi::GetMissedMenuMessageCount(0, 1234) == 0);
+        TEST_CHECK(dmi::GetMissedMenuMessageCount(10, 11) == 0);
+        TEST_CHECK(dmi::GetMissedMenuMessageCount(10, 14) == 3);
+    }
+
+    void TestClear() {
+        // A new menu instance doesn't get the previous one's messages
+        ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
+        ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
+        ipc::ClearMenuMessages();
+        TEST_CHECK(ReceiveAll().empty());
+
+        // Sequences keep increasing
+        ipc::PushMenuMessage(dmi::MenuMessage::SdCardEjected);
+        const auto msg_ctxs = ReceiveAll();
+        TEST_CHECK(msg_ctxs.size() == 1);
+        TEST_CHECK(msg_ctxs.at(0).seq > 1);
+    }
+
+}
+
+int main() {
+    ipc::InitializeMenuMessageQueue();
+
+    TestSequenceNumbers();
+    TestOverflowAndBatchedDrain();
+    TestReceiverGapCounting();
+    TestClear();
+
+    return test::Finish("ipc_MenuMessageQueueTest");
+}
@@ -0,0 +1,294 @@
+#include <test_Common.hpp>
+#include <launch/launch_Queue.hpp>
+
+// uDaemon's launch queue state machine, driven through a fake system backend
+
+namespace {
+
+    constexpr Result ResultFakeLaunchFailure = 0xF00D;
+
+    // What the fake system is running: uMenu (or any other applet) and/or an application
+    struct FakeSystem {
+        bool applet_active;
+        u32 applet_instance_id;
+        bool app_active;
+        u64 tick;
+        Result next_launch_rc;
+        std::vector<launch::Request> launched_reqs;
+        std::vector<u32> active_notified_ids;
+    };
+
+    FakeSystem g_System;
+
+    bool IsAppletActive() {
+        return g_System.applet_active;
+    }
+
+    u32 GetAppletInstanceId() {
+        return g_System.applet_instance_id;
+    }
+
+    bool IsApplicationActive() {
+        return g_System.app_active;
+    }
+
+    // Every backend call moves time forward, so that each state transition gets a distinct tick
+    u64 GetTick() {
+        return ++g_System.tick;
+    }
+
+    Result Launch(const launch::Request &req) {
+        g_System.launched_reqs.push_back(req);
+        if(R_FAILED(g_System.next_launch_rc)) {
+            const auto rc = g_System.next_launch_rc;
+            g_System.next_launch_rc = ResultSuccess;
+            return rc;
+        }
+
+        if(req.IsApplication()) {
+            g_System.app_active = true;
+        }
+        else {
+            g_System.applet_active = true;
+            g_System.applet_instance_id++;
+        }
+        return ResultSuccess;
+    }
+
+    void OnTargetActive(const launch::Request &req) {
+        g_System.active_notified_ids.push_back(req.id);
+    }
+
+    // uMenu exits by itself right after sending a launch, and gets reopened by the daemon once the launched applet is gone
+    void OpenMenu() {
+        g_System.applet_active = true;
+        g_System.applet_instance_id++;
+    }
+
+    void CloseApplet() {
+        g_System.applet_active = false;
+    }
+
+    launch::LaunchQueue CreateQueue() {
+        g_System = {};
+        return launch::LaunchQueue({
+            .is_applet_active = &IsAppletActive,
+            .get_applet_instance_id = &GetAppletInstanceId,
+            .is_application_active = &IsApplicationActive,
+            .launch = &Launch,
+            .get_tick = &GetTick,
+            .on_target_active = &OnTargetActive
+        });
+    }
+
+    launch::RequestState GetState(const launch::LaunchQueue &queue, const u32 id) {
+        launch::Request req;
+        if(!queue.FindRequest(id, req)) {
+            return launch::RequestState::Count;
+        }
+        return req.state;
+    }
+
+    hb::HbTargetParams MakeHomebrewParams() {
+        return hb::HbTargetParams::Create("sdmc:/hbmenu.nro", "sdmc:/hbmenu.nro", false);
+    }
+
+    void TestApplicationLifecycle() {
+        auto queue = CreateQueue();
+        OpenMenu();
+
+        u32 id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeApplicationRequest(0x0100000000010000), &id));
+        TEST_CHECK(queue.HasPendingApplication());
+
+        // uMenu is still active: wait for it to exit
+        TEST_CHECK(!queue.Update());
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::WaitingForAppletExit);
+        TEST_CHECK(!queue.Update());
+        TEST_CHECK(g_System.launched_reqs.empty());
+
+        CloseApplet();
+        launch::Request launched_req;
+        TEST_CHECK(queue.Update(&launched_req));
+        TEST_CHECK(launched_req.id == id);
+        TEST_CHECK(launched_req.app_id == 0x0100000000010000);
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::Running);
+        TEST_CHECK(!queue.HasPendingApplication());
+        TEST_CHECK(queue.GetPendingCount() == 0);
+
+        // Seen active once, notified once
+        queue.Update();
+        queue.Update();
+        TEST_CHECK(g_System.active_notified_ids.size() == 1);
+        TEST_CHECK(g_System.active_notified_ids.at(0) == id);
+
+        // uMenu gets reopened while the application keeps running, that doesn't matter for applications
+        OpenMenu();
+        queue.Update();
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::Running);
+
+        g_System.app_active = false;
+        queue.Update();
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::Exited);
+
+        // Every transition got timestamped, in order
+        launch::Request req;
+        TEST_CHECK(queue.FindRequest(id, req));
+        const auto queued_tick = req.GetStateTick(launch::RequestState::Queued);
+        const auto waiting_tick = req.GetStateTick(launch::RequestState::WaitingForAppletExit);
+        const auto launching_tick = req.GetStateTick(launch::RequestState::Launching);
+        const auto running_tick = req.GetStateTick(launch::RequestState::Running);
+        const auto exited_tick = req.GetStateTick(launch::RequestState::Exited);
+        TEST_CHECK(queued_tick > 0);
+        TEST_CHECK(queued_tick < waiting_tick);
+        TEST_CHECK(waiting_tick < launching_tick);
+        TEST_CHECK(launching_tick < running_tick);
+        TEST_CHECK(running_tick < req.target_active_tick);
+        TEST_CHECK(req.target_active_tick < exited_tick);
+        TEST_CHECK(req.GetStateTick(launch::RequestState::Failed) == 0);
+    }
+
+    void TestAppletTrackedAcrossMenuRelaunch() {
+        // Launched applets must exit even though uMenu (another applet) is active again right after them
+        const launch::Request applet_reqs[] = {
+            launch::MakeHomebrewAppletRequest(MakeHomebrewParams()),
+            launch::MakeWebAppletRequest("https://example.com"),
+            launch::MakeAlbumAppletRequest()
+        };
+
+        for(const auto &applet_req: applet_reqs) {
+            auto queue = CreateQueue();
+
+            u32 id;
+            TEST_CHECK_RC(queue.Enqueue(applet_req, &id));
+            TEST_CHECK(queue.Update());
+            TEST_CHECK(GetState(queue, id) == launch::RequestState::Running);
+
+            queue.Update();
+            TEST_CHECK(g_System.active_notified_ids.size() == 1);
+
+            // The applet exits, and uMenu is reopened before the queue gets to see the applet gone
+            CloseApplet();
+            OpenMenu();
+            queue.Update();
+            TEST_CHECK(GetState(queue, id) == launch::RequestState::Exited);
+
+            launch::Request req;
+            TEST_CHECK(queue.FindRequest(id, req));
+            TEST_CHECK(req.GetStateTick(launch::RequestState::Exited) > req.target_active_tick);
+        }
+    }
+
+    void TestAppletReplacedBeforeSeenActive() {
+        // Replaced before the queue ever saw it active: it's over anyway, and no activity gets reported
+        auto queue = CreateQueue();
+        u32 id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeAlbumAppletRequest(), &id));
+        TEST_CHECK(queue.Update());
+
+        CloseApplet();
+        OpenMenu();
+        queue.Update();
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::Exited);
+        TEST_CHECK(g_System.active_notified_ids.empty());
+    }
+
+    void TestQueueOrderAndLimits() {
+        auto queue = CreateQueue();
+        OpenMenu();
+
+        u32 app_id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeApplicationRequest(0x0100000000010000), &app_id));
+        TEST_CHECK(queue.Enqueue(launch::MakeHomebrewApplicationRequest(0x0100000000020000, MakeHomebrewParams())) == dmn::ResultAlreadyQueued);
+
+        u32 web_id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeWebAppletRequest("https://example.com"), &web_id));
+        while(queue.GetPendingCount() < launch::MaxPendingRequestCount) {
+            TEST_CHECK_RC(queue.Enqueue(launch::MakeAlbumAppletRequest()));
+        }
+        TEST_CHECK(queue.Enqueue(launch::MakeAlbumAppletRequest()) == dmn::ResultLaunchQueueFull);
+
+        // One launch per update, in order, each one waiting for the previous applet to exit
+        CloseApplet();
+        launch::Request launched_req;
+        TEST_CHECK(queue.Update(&launched_req));
+        TEST_CHECK(launched_req.id == app_id);
+        TEST_CHECK(queue.Update(&launched_req));
+        TEST_CHECK(launched_req.id == web_id);
+        TEST_CHECK(!queue.Update());
+        TEST_CHECK(g_System.launched_reqs.size() == 2);
+
+        CloseApplet();
+        TEST_CHECK(queue.Update(&launched_req));
+        TEST_CHECK(launched_req.kind == launch::RequestKind::AlbumApplet);
+        TEST_CHECK(GetState(queue, web_id) == launch::RequestState::Exited);
+    }
+
+    void TestLaunchFailure() {
+        auto queue = CreateQueue();
+        g_System.next_launch_rc = ResultFakeLaunchFailure;
+
+        u32 id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeApplicationRequest(0x0100000000010000), &id));
+        launch::Request launched_req;
+        TEST_CHECK(queue.Update(&launched_req));
+        TEST_CHECK(launched_req.launch_rc == ResultFakeLaunchFailure);
+        TEST_CHECK(GetState(queue, id) == launch::RequestState::Failed);
+        TEST_CHECK(!queue.HasPendingApplication());
+
+        // A failed request is never reported as active
+        queue.Update();
+        TEST_CHECK(g_System.active_notified_ids.empty());
+
+        // Another application can be queued right away
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeApplicationRequest(0x0100000000020000)));
+    }
+
+    void TestTrackedEviction() {
+        auto queue = CreateQueue();
+        u32 first_id;
+        TEST_CHECK_RC(queue.Enqueue(launch::MakeAlbumAppletRequest(), &first_id));
+        TEST_CHECK(queue.Update());
+
+        u32 last_id = first_id;
+        for(size_t i = 0; i < launch::MaxTrackedRequestCount; i++) {
+            CloseApplet();
+            TEST_CHECK_RC(queue.Enqueue(launch::MakeAlbumAppletRequest(), &last_id));
+            TEST_CHECK(queue.Update());
+        }
+
+        // The oldest one got evicted, the newest ones are still there
+        launch::Request req;
+        TEST_CHECK(!queue.FindRequest(first_id, req));
+        TEST_CHECK(queue.FindRequest(last_id, req));
+        TEST_CHECK(queue.FindRequest(last_id - launch::MaxTrackedRequestCount + 1, req));
+    }
+
+    void TestWebRequestUrl() {
+        // Only the URL is stored, always terminated even if the menu sent an unterminated one
+        const auto req = launch::MakeWebAppletRequest("https://example.com/path");
+        TEST_CHECK(req.kind == launch::RequestKind::WebApplet);
+        TEST_CHECK(strcmp(req.web_url, "https://example.com/path") == 0);
+
+        char long_url[dmi::MaxWebPageUrlLength];
+        memset(long_url, 'a', sizeof(long_url));
+        auto long_url_req = launch::MakeWebAppletRequest(long_url);
+        TEST_CHECK(strlen(long_url_req.web_url) == (dmi::MaxWebPageUrlLength - 1));
+
+        // Requests get copied around (queue, tracking, launch results): a few KB at most, nothing like a whole web applet config
+        TEST_CHECK(sizeof(launch::Request) <= 3 * sizeof(hb::HbTargetParams));
+    }
+
+}
+
+int main() {
+    TestApplicationLifecycle();
+    TestAppletTrackedAcrossMenuRelaunch();
+    TestAppletReplacedBeforeSeenActive();
+    TestQueueOrderAndLimits();
+    TestLaunchFailure();
+    TestTrackedEviction();
+    TestWebRequestUrl();
+
+    return test::Finish("launch_QueueTest");
+}
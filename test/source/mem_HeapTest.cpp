@@ -0,0 +1,196 @@
+#include <test_Common.hpp>
+#include <mem/mem_Heap.hpp>
+#include <mem/mem_Pool.hpp>
+#include <stratosphere.hpp>
+#include <vector>
+
+// uDaemon's tracked allocations: per-tag accounting, heap allocation headers, the small block pool and heap attributions
+// The host allocator stand-in reports whatever free size the test sets, standing for the daemon's static heap
+
+namespace {
+
+    constexpr size_t FakeHeapSize = 10 * 1024 * 1024;
+
+    void SetFakeHeapUsedSize(const size_t used_size) {
+        ams::init::GetAllocator()->SetTotalFreeSize(FakeHeapSize - used_size);
+    }
+
+    dmi::DaemonHeapTagStats GetTagStats(const mem::Tag tag) {
+        dmi::DaemonHeapStats stats = {};
+        mem::GetHeapStats(stats);
+        return stats.tags[static_cast<size_t>(tag)];
+    }
+
+    void TestTagUsage() {
+        const auto start_stats = GetTagStats(mem::Tag::Usb);
+
+        // Heap allocations account their header too
+        auto big_ptr = mem::Allocate(mem::Tag::Usb, 0x1000);
+        TEST_CHECK(big_ptr != nullptr);
+        auto stats = GetTagStats(mem::Tag::Usb);
+        TEST_CHECK(stats.cur_size == (start_stats.cur_size + sizeof(mem::AllocationHeader) + 0x1000));
+        TEST_CHECK(stats.alloc_count == (start_stats.alloc_count + 1));
+
+        // Small ones take a whole pool block
+        auto small_ptr = mem::Allocate(mem::Tag::Usb, 0x20);
+        TEST_CHECK(small_ptr != nullptr);
+        stats = GetTagStats(mem::Tag::Usb);
+        TEST_CHECK(stats.cur_size == (start_stats.cur_size + sizeof(mem::AllocationHeader) + 0x1000 + mem::SmallBlockSize));
+        const auto peak_size = stats.cur_size;
+        TEST_CHECK(stats.peak_size >= peak_size);
+
+        // Other tags are left alone
+        const auto ipc_stats = GetTagStats(mem::Tag::Ipc);
+        TEST_CHECK(ipc_stats.alloc_count == 0);
+
+        mem::Free(big_ptr);
+        mem::Free(small_ptr);
+        stats = GetTagStats(mem::Tag::Usb);
+        TEST_CHECK(stats.cur_size == start_stats.cur_size);
+        TEST_CHECK(stats.peak_size >= peak_size);
+        TEST_CHECK(stats.free_count == (start_stats.free_count + 2));
+
+        // Freeing null does nothing
+        mem::Free(nullptr);
+        TEST_CHECK(GetTagStats(mem::Tag::Usb).free_count == stats.free_count);
+    }
+
+    void TestAlignedAllocationHeader() {
+        const size_t aligns[] = { alignof(std::max_align_t), 0x40, 0x1000 };
+        for(const auto align: aligns) {
+            auto ptr = mem::AllocateAligned(mem::Tag::Ecs, align, 0x300);
+            TEST_CHECK(ptr != nullptr);
+            TEST_CHECK((reinterpret_cast<uintptr_t>(ptr) % align) == 0);
+
+            // The header sits right before the pointer, telling how far back the actual allocation starts
+            mem::AllocationHeader header;
+            memcpy(&header, reinterpret_cast<u8*>(ptr) - sizeof(header), sizeof(header));
+            TEST_CHECK(header.magic == mem::AllocationHeader::Magic);
+            TEST_CHECK(header.tag == static_cast<u16>(mem::Tag::Ecs));
+            TEST_CHECK(header.size == 0x300);
+            TEST_CHECK(header.offset == std::max(align, sizeof(mem::AllocationHeader)));
+            TEST_CHECK((header.offset % align) == 0);
+
+            const auto stats = GetTagStats(mem::Tag::Ecs);
+            TEST_CHECK(stats.cur_size == (header.offset + header.size));
+
+            // Whole allocation is usable
+            memset(ptr, 0xAB, 0x300);
+            mem::Free(ptr);
+            TEST_CHECK(GetTagStats(mem::Tag::Ecs).cur_size == 0);
+        }
+
+        // Small but over-aligned allocations can't come from the pool
+        auto ptr = mem::AllocateAligned(mem::Tag::Ecs, 0x100, 0x10);
+        TEST_CHECK((reinterpret_cast<uintptr_t>(ptr) % 0x100) == 0);
+        TEST_CHECK(GetTagStats(mem::Tag::Ecs).cur_size == (0x100 + 0x10));
+        mem::Free(ptr);
+    }
+
+    void TestFixedPoolExhaustion() {
+        // The pool on its own
+        static mem::FixedPool<0x80, 0x80> pool;
+        std::vector<void*> blocks;
+        for(size_t i = 0; i < pool.GetBlockCount(); i++) {
+            auto block = pool.Allocate();
+            TEST_CHECK(block != nullptr);
+            TEST_CHECK(pool.Contains(block));
+            TEST_CHECK((reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t)) == 0);
+            blocks.push_back(block);
+        }
+        TEST_CHECK(pool.Allocate() == nullptr);
+        TEST_CHECK(pool.GetUsedCount() == pool.GetBlockCount());
+
+        // A freed block is the next one handed out
+        pool.Free(blocks.at(5));
+        TEST_CHECK(pool.Allocate() == blocks.at(5));
+        for(auto block: blocks) {
+            pool.Free(block);
+        }
+        TEST_CHECK(pool.GetUsedCount() == 0);
+        TEST_CHECK(pool.GetPeakUsedCount() == pool.GetBlockCount());
+
+        // Tracked allocations: once the daemon's pool is full, small allocations go to the heap (with a header)
+        std::vector<void*> ptrs;
+        for(size_t i = 0; i < mem::SmallBlockCount; i++) {
+            ptrs.push_back(mem::Allocate(mem::Tag::Ipc, 0x40));
+        }
+        dmi::DaemonHeapStats stats = {};
+        mem::GetHeapStats(stats);
+        TEST_CHECK(stats.pool_used_block_count == mem::SmallBlockCount);
+
+        auto fallback_ptr = mem::Allocate(mem::Tag::Ipc, 0x40);
+        TEST_CHECK(fallback_ptr != nullptr);
+        mem::AllocationHeader header;
+        memcpy(&header, reinterpret_cast<u8*>(fallback_ptr) - sizeof(header), sizeof(header));
+        TEST_CHECK(header.magic == mem::AllocationHeader::Magic);
+        TEST_CHECK(header.size == 0x40);
+
+        const auto ipc_stats = GetTagStats(mem::Tag::Ipc);
+        TEST_CHECK(ipc_stats.cur_size == (mem::SmallBlockCount * mem::SmallBlockSize + sizeof(mem::AllocationHeader) + 0x40));
+
+        mem::Free(fallback_ptr);
+        for(auto ptr: ptrs) {
+            mem::Free(ptr);
+        }
+        mem::GetHeapStats(stats);
+        TEST_CHECK(stats.pool_used_block_count == 0);
+        TEST_CHECK(stats.pool_peak_used_block_count == mem::SmallBlockCount);
+        TEST_CHECK(GetTagStats(mem::Tag::Ipc).cur_size == 0);
+    }
+
+    void TestScopedHeapAttributionNesting() {
+        size_t used_size = 0x10000;
+        SetFakeHeapUsedSize(used_size);
+        const auto start_config_size = GetTagStats(mem::Tag::Config).cur_size;
+        const auto start_ecs_size = GetTagStats(mem::Tag::Ecs).cur_size;
+
+        void *tracked_ptr;
+        {
+            mem::ScopedHeapAttribution config_attr(mem::Tag::Config);
+            used_size += 0x1000;
+            SetFakeHeapUsedSize(used_size);
+
+            {
+                mem::ScopedHeapAttribution ecs_attr(mem::Tag::Ecs);
+                used_size += 0x2000;
+                SetFakeHeapUsedSize(used_size);
+            }
+
+            // Already accounted to its own tag
+            tracked_ptr = mem::Allocate(mem::Tag::Usb, 0x3000);
+            used_size += sizeof(mem::AllocationHeader) + 0x3000;
+            SetFakeHeapUsedSize(used_size);
+
+            used_size += 0x500;
+            SetFakeHeapUsedSize(used_size);
+        }
+
+        // Each attribution only gets its own growth
+        TEST_CHECK(GetTagStats(mem::Tag::Ecs).cur_size == (start_ecs_size + 0x2000));
+        TEST_CHECK(GetTagStats(mem::Tag::Config).cur_size == (start_config_size + 0x1500));
+
+        // Shrinking gets attributed too
+        {
+            mem::ScopedHeapAttribution config_attr(mem::Tag::Config);
+            used_size -= 0x500;
+            SetFakeHeapUsedSize(used_size);
+        }
+        TEST_CHECK(GetTagStats(mem::Tag::Config).cur_size == (start_config_size + 0x1000));
+
+        mem::Free(tracked_ptr);
+    }
+
+}
+
+int main() {
+    SetFakeHeapUsedSize(0);
+    mem::Initialize(FakeHeapSize);
+
+    TestTagUsage();
+    TestAlignedAllocationHeader();
+    TestFixedPoolExhaustion();
+    TestScopedHeapAttributionNesting();
+
+    return test::Finish("mem_HeapTest");
+}
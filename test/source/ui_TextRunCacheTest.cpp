@@ -0,0 +1,433 @@
+#include <test_Common.hpp>
+#include <ui/ui_TextRunCache.hpp>
+
+// Glyph atlas layout/packing and the run LRU over a fake backend (glyph sizes from the codepoint, pages as plain records), plus a benchmark cycling selections over many labels
+
+namespace {
+
+    constexpr s32 GlyphHeight = 24;
+    constexpr u32 BenchmarkLabelCount = 1000;
+    constexpr u32 BenchmarkCycleCount = 5;
+    // Labels drawn per selection change: name, author and version in the banner
+    constexpr u32 BenchmarkLabelsPerSelection = 3;
+
+    struct FakeGlyph {
+        s32 width;
+        s32 height;
+    };
+
+    struct FakePage {
+        std::vector<ui::TextRect> glyph_rects;
+        bool deleted;
+    };
+
+    std::vector<FakePage*> g_Pages;
+    u32 g_LiveGlyphCount = 0;
+    u32 g_RasterizedCharCount = 0;
+    bool g_FailCreatePage = false;
+    // Simulated cost of rasterizing each character
+    u64 g_RasterCostNs = 0;
+
+    void SimulateRaster(const u32 char_count) {
+        g_RasterizedCharCount += char_count;
+        if(g_RasterCostNs > 0) {
+            const auto end_ns = test::GetCurrentNs() + g_RasterCostNs * char_count;
+            while(test::GetCurrentNs() < end_ns) {}
+        }
+    }
+
+    // Fonts named "big" have huge glyphs so that pages fill up quickly, otherwise widths depend on the codepoint (CJK ones being wider)
+    s32 GetGlyphWidth(const std::string &font_name, const u32 cp) {
+        if(font_name == "big") {
+            return 100;
+        }
+        return (cp >= 0x3000) ? 24 : 8 + static_cast<s32>(cp % 8);
+    }
+
+    // Glyph images have a pixel of padding on each side, past their advance, except CJK ones whose advance is unknown (the rendered width gets used)
+    bool FakeGetGlyphAdvance(const std::string &font_name, const u32 cp, s32 &out_advance) {
+        if(cp >= 0x3000) {
+            return false;
+        }
+        out_advance = GetGlyphWidth(font_name, cp) - 2;
+        return true;
+    }
+
+    constexpr s32 FakeKerning = -3;
+
+    // Only "a" followed by "b" is kerned
+    s32 FakeGetKerning(const std::string &font_name, const u32 prev_cp, const u32 cp) {
+        return ((prev_cp == 'a') && (cp == 'b')) ? FakeKerning : 0;
+    }
+
+    ui::TextGlyphImage FakeRenderGlyph(const std::string &font_name, const std::string &glyph_str, s32 &out_width, s32 &out_height) {
+        u32 cp = 0;
+        ui::DecodeUtf8Codepoint(glyph_str, 0, cp);
+        const auto height = (font_name == "big") ? 100 : GlyphHeight;
+        SimulateRaster(1);
+        g_LiveGlyphCount++;
+        out_width = GetGlyphWidth(font_name, cp);
+        out_height = height;
+        return new FakeGlyph { out_width, height };
+    }
+
+    void FakeDeleteGlyph(ui::TextGlyphImage glyph) {
+        g_LiveGlyphCount--;
+        delete static_cast<FakeGlyph*>(glyph);
+    }
+
+    ui::TextAtlasPage FakeCreatePage() {
+        if(g_FailCreatePage) {
+            return nullptr;
+        }
+        auto page = new FakePage();
+        g_Pages.push_back(page);
+        return page;
+    }
+
+    void FakeDeletePage(ui::TextAtlasPage page) {
+        static_cast<FakePage*>(page)->deleted = true;
+    }
+
+    void FakeCopyGlyph(ui::TextGlyphImage glyph, ui::TextAtlasPage page, const ui::TextRect &dst_rect) {
+        auto fake_glyph = static_cast<FakeGlyph*>(glyph);
+        TEST_CHECK(fake_glyph->width == dst_rect.w);
+        TEST_CHECK(fake_glyph->height == dst_rect.h);
+        auto fake_page = static_cast<FakePage*>(page);
+        TEST_CHECK(!fake_page->deleted);
+        fake_page->glyph_rects.push_back(dst_rect);
+    }
+
+    constexpr ui::TextAtlasBackend FakeBackend = {
+        .render_glyph = FakeRenderGlyph,
+        .delete_glyph = FakeDeleteGlyph,
+        .create_page = FakeCreatePage,
+        .delete_page = FakeDeletePage,
+        .copy_glyph = FakeCopyGlyph,
+        .get_glyph_advance = FakeGetGlyphAdvance,
+        .get_kerning = FakeGetKerning
+    };
+
+    constexpr ui::TextColor White = { 0xFF, 0xFF, 0xFF, 0xFF };
+    constexpr ui::TextColor Red = { 0xFF, 0, 0, 0xFF };
+
+    void ResetBackend() {
+        for(auto page: g_Pages) {
+            delete page;
+        }
+        g_Pages.clear();
+        g_RasterizedCharCount = 0;
+        g_FailCreatePage = false;
+        g_RasterCostNs = 0;
+    }
+
+    bool RectsOverlap(const ui::TextRect &a, const ui::TextRect &b) {
+        return (a.x < (b.x + b.w)) && (b.x < (a.x + a.w)) && (a.y < (b.y + b.h)) && (b.y < (a.y + a.h));
+    }
+
+    // Every glyph copied to a page lies inside it, without overlapping any other one
+    void CheckPageRects() {
+        for(const auto page: g_Pages) {
+            const auto &rects = page->glyph_rects;
+            for(size_t i = 0; i < rects.size(); i++) {
+                TEST_CHECK((rects[i].x >= 0) && ((rects[i].x + rects[i].w) <= ui::TextAtlasPageSize));
+                TEST_CHECK((rects[i].y >= 0) && ((rects[i].y + rects[i].h) <= ui::TextAtlasPageSize));
+                for(size_t j = i + 1; j < rects.size(); j++) {
+                    TEST_CHECK(!RectsOverlap(rects[i], rects[j]));
+                }
+            }
+        }
+    }
+
+    void TestPacker() {
+        ui::TextAtlasPacker packer;
+        ui::TextRect rect;
+        bool new_page = false;
+
+        TEST_CHECK(!packer.Pack(ui::TextAtlasPageSize + 1, 10, rect, new_page));
+        TEST_CHECK(!packer.Pack(10, ui::TextAtlasPageSize + 1, rect, new_page));
+
+        // 40x40 glyphs: 25 per row, 25 rows per page, then a new page
+        constexpr u32 PerRow = ui::TextAtlasPageSize / 40;
+        constexpr u32 PerPage = PerRow * PerRow;
+        for(u32 i = 0; i < PerPage * 2 + 1; i++) {
+            TEST_CHECK(packer.Pack(40, 40, rect, new_page));
+            const auto page_idx = i % PerPage;
+            TEST_CHECK(new_page == (page_idx == 0));
+            TEST_CHECK(rect.x == static_cast<s32>((page_idx % PerRow) * 40));
+            TEST_CHECK(rect.y == static_cast<s32>((page_idx / PerRow) * 40));
+        }
+
+        // Rows are as tall as their tallest glyph
+        packer.Reset();
+        TEST_CHECK(packer.Pack(ui::TextAtlasPageSize - 10, 30, rect, new_page));
+        TEST_CHECK(new_page);
+        TEST_CHECK(packer.Pack(10, 50, rect, new_page));
+        TEST_CHECK(!new_page && (rect.x == ui::TextAtlasPageSize - 10) && (rect.y == 0));
+        TEST_CHECK(packer.Pack(20, 10, rect, new_page));
+        TEST_CHECK(!new_page && (rect.x == 0) && (rect.y == 50));
+
+        // A glyph exactly as big as a page takes one of its own
+        TEST_CHECK(packer.Pack(ui::TextAtlasPageSize, ui::TextAtlasPageSize, rect, new_page));
+        TEST_CHECK(new_page && (rect.x == 0) && (rect.y == 0));
+        TEST_CHECK(packer.Pack(1, 1, rect, new_page));
+        TEST_CHECK(new_page);
+    }
+
+    void TestLayout() {
+        ResetBackend();
+        ui::TextRunCache cache(FakeBackend);
+
+        TEST_CHECK(cache.GetRun("font", "", White)->width == 0);
+        TEST_CHECK(cache.GetRun("font", "", White)->height == 0);
+
+        // Glyphs follow their advances and kerning, spaces advance without being drawn, new lines go down one line (without kerning across them) and the widest line sets the width
+        const auto run = cache.GetRun("font", "ab c\nbd", Red);
+        const auto b_w = GetGlyphWidth("font", 'b');
+        const auto c_w = GetGlyphWidth("font", 'c');
+        const auto a_adv = GetGlyphWidth("font", 'a') - 2;
+        const auto b_adv = b_w - 2;
+        const auto space_adv = GetGlyphWidth("font", ' ') - 2;
+        TEST_CHECK(run->glyphs.size() == 5);
+        TEST_CHECK((run->glyphs.at(0).x == 0) && (run->glyphs.at(0).y == 0));
+        TEST_CHECK(run->glyphs.at(1).x == a_adv + FakeKerning);
+        TEST_CHECK(run->glyphs.at(2).x == a_adv + FakeKerning + b_adv + space_adv);
+        TEST_CHECK((run->glyphs.at(3).x == 0) && (run->glyphs.at(3).y == GlyphHeight));
+        TEST_CHECK(run->glyphs.at(4).x == b_adv);
+        // The last glyph's image reaches past its advance
+        TEST_CHECK(run->width == a_adv + FakeKerning + b_adv + space_adv + c_w);
+        TEST_CHECK(run->height == GlyphHeight * 2);
+        TEST_CHECK((run->clr.r == Red.r) && (run->clr.g == Red.g));
+
+        // Not kerned the other way around
+        const auto ba_run = cache.GetRun("font", "ba", White);
+        TEST_CHECK(ba_run->glyphs.at(1).x == b_adv);
+
+        // Multi-byte codepoints are one glyph each, invalid bytes are taken one by one
+        const auto utf8_run = cache.GetRun("font", "ゲーム\xFF\xC3", White);
+        TEST_CHECK(utf8_run->glyphs.size() == 5);
+        TEST_CHECK(utf8_run->glyphs.at(3).x == 3 * 24);
+        TEST_CHECK(utf8_run->width == 3 * 24 + (GetGlyphWidth("font", 0xFF) - 2) + GetGlyphWidth("font", 0xC3));
+
+        // Glyphs are shared by every run of the same font, and every rasterized glyph image is freed
+        const auto rasterized_count = cache.GetStats().rasterized_glyphs;
+        cache.GetRun("font", "ba", White);
+        TEST_CHECK(cache.GetStats().rasterized_glyphs == rasterized_count);
+        cache.GetRun("other", "ba", White);
+        TEST_CHECK(cache.GetStats().rasterized_glyphs == rasterized_count + 2);
+        TEST_CHECK(g_LiveGlyphCount == 0);
+        TEST_CHECK(g_Pages.size() == 2);
+        cache.Clear();
+    }
+
+    void TestPageRollover() {
+        ResetBackend();
+        ui::TextRunCache cache(FakeBackend);
+
+        // 100x100 glyphs: 10 rows of 10 per page, 250 distinct ones (all printable ASCII, then 2-byte codepoints) take 3 pages
+        std::string ascii_text;
+        for(char c = 0x21; c < 0x7F; c++) {
+            ascii_text += c;
+        }
+        cache.GetRun("big", ascii_text, White);
+        for(u32 cp = 0x100; cache.GetStats().rasterized_glyphs < 250; cp++) {
+            const char utf8[] = { static_cast<char>(0xC0 | (cp >> 6)), static_cast<char>(0x80 | (cp & 0x3F)), 0 };
+            cache.GetRun("big", utf8, White);
+        }
+
+        TEST_CHECK(cache.GetStats().rasterized_glyphs == 250);
+        TEST_CHECK(cache.GetStats().page_count == 3);
+        TEST_CHECK(g_Pages.size() == 3);
+        TEST_CHECK(g_Pages.at(0)->glyph_rects.size() == 100);
+        TEST_CHECK(g_Pages.at(1)->glyph_rects.size() == 100);
+        TEST_CHECK(g_Pages.at(2)->glyph_rects.size() == 50);
+        CheckPageRects();
+
+        // A run spanning glyphs from several pages points to each one of them
+        const auto run = cache.GetRun("big", "!" "\xC4\x8A", White);
+        TEST_CHECK(run->glyphs.size() == 2);
+        TEST_CHECK(run->glyphs.at(0).page == g_Pages.at(0));
+        TEST_CHECK(run->glyphs.at(1).page != g_Pages.at(0));
+
+        // Once the last page is full, glyphs whose page can't be created are skipped (instead of ending up in the full page)
+        g_FailCreatePage = true;
+        const char missing_utf8[] = "\xE3\x81\x82";
+        for(u32 i = 0; i < 60; i++) {
+            const char utf8[] = { static_cast<char>(0xE3), static_cast<char>(0x82 + (i / 0x40)), static_cast<char>(0x80 + (i % 0x40)), 0 };
+            cache.GetRun("big", utf8, White);
+        }
+        TEST_CHECK(g_Pages.at(2)->glyph_rects.size() == 100);
+        TEST_CHECK(cache.GetRun("big", missing_utf8, White)->glyphs.empty());
+        g_FailCreatePage = false;
+        TEST_CHECK(cache.GetRun("big", missing_utf8, Red)->glyphs.size() == 1);
+        TEST_CHECK(g_Pages.size() == 4);
+        TEST_CHECK(g_Pages.at(3)->glyph_rects.size() == 1);
+        CheckPageRects();
+        cache.Clear();
+    }
+
+    void TestClearGeneration() {
+        ResetBackend();
+        ui::TextRunCache cache(FakeBackend);
+
+        const auto run = cache.GetRun("font", "Title", White);
+        TEST_CHECK(cache.IsRunValid(run));
+        TEST_CHECK(!cache.IsRunValid(nullptr));
+        TEST_CHECK(cache.GetRun("font", "Title", White) == run);
+
+        // Clearing deletes every page and invalidates every run obtained so far, the next lookup lays out a new one
+        cache.Clear();
+        TEST_CHECK(!cache.IsRunValid(run));
+        TEST_CHECK(cache.GetCachedRunCount() == 0);
+        TEST_CHECK(cache.GetStats().page_count == 0);
+        for(const auto page: g_Pages) {
+            TEST_CHECK(page->deleted);
+        }
+
+        const auto misses = cache.GetStats().run_misses;
+        const auto new_run = cache.GetRun("font", "Title", White);
+        TEST_CHECK(new_run != run);
+        TEST_CHECK(cache.IsRunValid(new_run));
+        TEST_CHECK(cache.GetStats().run_misses == misses + 1);
+        TEST_CHECK(!new_run->glyphs.empty() && !static_cast<FakePage*>(new_run->glyphs.front().page)->deleted);
+        cache.Clear();
+    }
+
+    void TestLruEviction() {
+        ResetBackend();
+        ui::TextRunCache cache(FakeBackend);
+
+        // Held the way a CachedTextBlock holds its run
+        const auto held_run = cache.GetRun("font", "Held title", White);
+        const auto touched_run = cache.GetRun("font", "Touched title", White);
+        for(u32 i = 0; i < ui::MaxCachedTextRunCount - 1; i++) {
+            cache.GetRun("font", "Label " + std::to_string(i), White);
+            // Recently used runs move to the front
+            if(i == ui::MaxCachedTextRunCount / 2) {
+                TEST_CHECK(cache.GetRun("font", "Touched title", White) == touched_run);
+            }
+        }
+        TEST_CHECK(cache.GetCachedRunCount() == ui::MaxCachedTextRunCount);
+
+        // The least recently used one got evicted, but the holder can still draw it: it's still valid and its pages are alive
+        TEST_CHECK(cache.IsRunValid(held_run));
+        TEST_CHECK(!static_cast<FakePage*>(held_run->glyphs.front().page)->deleted);
+        const auto hits = cache.GetStats().run_hits;
+        TEST_CHECK(cache.GetRun("font", "Touched title", White) == touched_run);
+        TEST_CHECK(cache.GetStats().run_hits == hits + 1);
+
+        // Asking for it again lays it out again (without rasterizing anything), identically
+        const auto rasterized_count = cache.GetStats().rasterized_glyphs;
+        const auto misses = cache.GetStats().run_misses;
+        const auto relaid_run = cache.GetRun("font", "Held title", White);
+        TEST_CHECK(relaid_run != held_run);
+        TEST_CHECK(cache.GetStats().run_misses == misses + 1);
+        TEST_CHECK(cache.GetStats().rasterized_glyphs == rasterized_count);
+        TEST_CHECK(cache.GetCachedRunCount() == ui::MaxCachedTextRunCount);
+        TEST_CHECK(relaid_run->width == held_run->width);
+        TEST_CHECK(relaid_run->glyphs.size() == held_run->glyphs.size());
+        for(size_t i = 0; i < held_run->glyphs.size(); i++) {
+            TEST_CHECK(relaid_run->glyphs[i].page == held_run->glyphs[i].page);
+            TEST_CHECK(relaid_run->glyphs[i].x == held_run->glyphs[i].x);
+            TEST_CHECK(relaid_run->glyphs[i].src_rect.x == held_run->glyphs[i].src_rect.x);
+            TEST_CHECK(relaid_run->glyphs[i].src_rect.y == held_run->glyphs[i].src_rect.y);
+        }
+
+        // Different colors are different runs
+        TEST_CHECK(cache.GetRun("font", "Held title", Red) != relaid_run);
+
+        // Only a clear invalidates it
+        cache.Clear();
+        TEST_CHECK(!cache.IsRunValid(held_run));
+    }
+
+    std::vector<std::string> MakeLabels() {
+        constexpr const char *Words[] = { "Super", "Legend", "Kart", "Quest", "Party", "Odyssey", "Tears", "Kingdom", "Wild", "Fire", "Emblem", "Xeno", "Blade", "Chronicles", "Splat", "Crossing" };
+        constexpr const char *CjkWords[] = { "ゲーム", "冒険", "伝説", "王国", "世界", "物語" };
+        std::vector<std::string> labels;
+        for(u32 i = 0; i < BenchmarkLabelCount; i++) {
+            auto label = std::string(Words[i % std::size(Words)]) + " " + Words[(i / 3) % std::size(Words)];
+            if((i % 7) == 0) {
+                label += " " + std::string(CjkWords[i % std::size(CjkWords)]);
+            }
+            label += " " + std::to_string(i);
+            labels.push_back(label);
+        }
+        return labels;
+    }
+
+    void BenchmarkSelectionCycling(const u64 raster_cost_ns) {
+        const auto labels = MakeLabels();
+
+        // Previous behavior: every label drawn again rasterizes all of its characters into a new texture
+        ResetBackend();
+        g_RasterCostNs = raster_cost_ns;
+        auto start_ns = test::GetCurrentNs();
+        for(u32 cycle = 0; cycle < BenchmarkCycleCount; cycle++) {
+            for(u32 i = 0; i < BenchmarkLabelCount; i++) {
+                for(u32 j = 0; j < BenchmarkLabelsPerSelection; j++) {
+                    const auto &label = labels.at((i + j * 17) % BenchmarkLabelCount);
+                    size_t offset = 0;
+                    u32 char_count = 0;
+                    while(offset < label.length()) {
+                        u32 cp;
+                        offset += ui::DecodeUtf8Codepoint(label, offset, cp);
+                        char_count++;
+                    }
+                    SimulateRaster(char_count);
+                }
+            }
+        }
+        const auto texture_ns = test::GetCurrentNs() - start_ns;
+        const auto texture_char_count = g_RasterizedCharCount;
+
+        // Atlas: more labels than cached runs, so cycling through all of them in order keeps evicting runs, but glyphs are rasterized only once
+        ResetBackend();
+        g_RasterCostNs = raster_cost_ns;
+        ui::TextRunCache cache(FakeBackend);
+        start_ns = test::GetCurrentNs();
+        for(u32 cycle = 0; cycle < BenchmarkCycleCount; cycle++) {
+            for(u32 i = 0; i < BenchmarkLabelCount; i++) {
+                for(u32 j = 0; j < BenchmarkLabelsPerSelection; j++) {
+                    const auto &label = labels.at((i + j * 17) % BenchmarkLabelCount);
+                    TEST_CHECK(cache.IsRunValid(cache.GetRun("font", label, White)));
+                }
+            }
+        }
+        const auto atlas_ns = test::GetCurrentNs() - start_ns;
+        const auto stats = cache.GetStats();
+
+        // Moving back and forth within a page of ~50 titles: everything is a hit after the first pass
+        const auto window_hits = stats.run_hits;
+        start_ns = test::GetCurrentNs();
+        for(u32 cycle = 0; cycle < BenchmarkCycleCount * 20; cycle++) {
+            for(u32 i = 0; i < 50; i++) {
+                const auto idx = (cycle % 2) ? (49 - i) : i;
+                cache.GetRun("font", labels.at(idx), White);
+            }
+        }
+        const auto window_ns = test::GetCurrentNs() - start_ns;
+        const auto window_lookup_count = BenchmarkCycleCount * 20 * 50;
+        const auto window_hit_count = cache.GetStats().run_hits - window_hits;
+        TEST_CHECK(window_hit_count >= window_lookup_count - 50);
+        cache.Clear();
+
+        const auto selection_count = BenchmarkCycleCount * BenchmarkLabelCount;
+        printf("%u labels x %u cycles, %lu ns per rasterized char: texture per label %.2f us/selection (%u chars), atlas %.2f us/selection (%lu glyphs, %u pages, %lu hits, %lu misses); back and forth over 50: %.3f us/lookup\n", BenchmarkLabelCount, BenchmarkCycleCount, raster_cost_ns, texture_ns / 1'000.0 / selection_count, texture_char_count, atlas_ns / 1'000.0 / selection_count, stats.rasterized_glyphs, stats.page_count, stats.run_hits, stats.run_misses, window_ns / 1'000.0 / window_lookup_count);
+        g_RasterCostNs = 0;
+    }
+
+}
+
+int main() {
+    TestPacker();
+    TestLayout();
+    TestPageRollover();
+    TestClearGeneration();
+    TestLruEviction();
+    BenchmarkSelectionCycling(0);
+    BenchmarkSelectionCycling(1000);
+    ResetBackend();
+
+    return test::Finish("ui_TextRunCacheTest");
+}
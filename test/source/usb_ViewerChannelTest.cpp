@@ -0,0 +1,326 @@
+#include <test_Common.hpp>
+#include <usb/usb_ViewerTelemetry.hpp>
+#include <mem/mem_Heap.hpp>
+#include <stratosphere.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// USB viewer multiplexed channel over an in-memory loopback: per-stream sequence numbers, CRC checks, stream demux and telemetry records
+
+namespace {
+
+    constexpr size_t FakeHeapSize = 10 * 1024 * 1024;
+
+    // Transfers written to it are read back in order, limited to a fixed amount of memory
+    class ViewerLoopback {
+        public:
+            static constexpr size_t BufferSize = 0x10000;
+            static constexpr size_t MaxTransferCount = 0x40;
+
+        private:
+            u8 buf[BufferSize];
+            size_t transfer_sizes[MaxTransferCount];
+            size_t read_transfer_idx;
+            size_t transfer_count;
+            size_t read_offset;
+            size_t write_offset;
+
+            static bool Write(void *user_data, const void *data, const size_t size) {
+                auto loopback = reinterpret_cast<ViewerLoopback*>(user_data);
+                if((loopback->transfer_count == MaxTransferCount) || ((loopback->write_offset + size) > BufferSize)) {
+                    return false;
+                }
+
+                memcpy(loopback->buf + loopback->write_offset, data, size);
+                loopback->write_offset += size;
+                loopback->transfer_sizes[loopback->transfer_count++] = size;
+                return true;
+            }
+
+        public:
+            ViewerLoopback() : buf(), transfer_sizes(), read_transfer_idx(0), transfer_count(0), read_offset(0), write_offset(0) {}
+
+            inline usb::ViewerTransport GetTransport() {
+                return { this, &Write };
+            }
+
+            // Returns the size of the transfer read, 0 on failure
+            size_t Read(void *data, const size_t max_size) {
+                if(this->read_transfer_idx == this->transfer_count) {
+                    return 0;
+                }
+
+                // Like USB, a transfer bigger than the read buffer is an error
+                const auto size = this->transfer_sizes[this->read_transfer_idx++];
+                if(size > max_size) {
+                    this->read_offset += size;
+                    return 0;
+                }
+
+                memcpy(data, this->buf + this->read_offset, size);
+                this->read_offset += size;
+
+                // Everything was consumed, start over
+                if(this->read_transfer_idx == this->transfer_count) {
+                    this->read_transfer_idx = 0;
+                    this->transfer_count = 0;
+                    this->read_offset = 0;
+                    this->write_offset = 0;
+                }
+                return size;
+            }
+
+            inline size_t GetPendingTransferCount() const {
+                return this->transfer_count - this->read_transfer_idx;
+            }
+
+            // Flips a bit of the stored data, for checking that corruption gets caught
+            inline void CorruptByte(const size_t offset) {
+                this->buf[offset % BufferSize] ^= 1;
+            }
+    };
+
+    enum class ReceiveResult {
+        Success,
+        TransportError,
+        InvalidHeader,
+        PayloadTooBig,
+        InvalidPayload
+    };
+
+    struct ReceivedPacket {
+        ReceiveResult result;
+        usb::ViewerPacketHeader header;
+        std::vector<u8> payload;
+    };
+
+    // Reading side, as the viewer does it: the header is validated before the payload is read
+    ReceiveResult ReceivePacketImpl(ViewerLoopback &loopback, usb::ViewerPacketHeader &out_header, void *out_payload, const size_t max_payload_size) {
+        if(loopback.Read(&out_header, sizeof(out_header)) != sizeof(out_header)) {
+            return ReceiveResult::TransportError;
+        }
+        if((out_header.magic != usb::ViewerPacketHeader::Magic) || (out_header.header_crc != usb::ComputeViewerHeaderCrc32(out_header)) || (out_header.stream_id >= usb::ViewerStreamCount)) {
+            return ReceiveResult::InvalidHeader;
+        }
+        if(out_header.payload_size > max_payload_size) {
+            return ReceiveResult::PayloadTooBig;
+        }
+
+        if(out_header.payload_size > 0) {
+            if(loopback.Read(out_payload, max_payload_size) != out_header.payload_size) {
+                return ReceiveResult::TransportError;
+            }
+        }
+        if(out_header.payload_crc != usb::ComputeCrc32(out_payload, out_header.payload_size)) {
+            return ReceiveResult::InvalidPayload;
+        }
+        return ReceiveResult::Success;
+    }
+
+    ReceivedPacket ReceivePacket(ViewerLoopback &loopback, const size_t max_payload_size = 0x1000) {
+        ReceivedPacket packet = {};
+        packet.payload.resize(max_payload_size);
+        packet.result = ReceivePacketImpl(loopback, packet.header, packet.payload.data(), max_payload_size);
+        if(packet.result == ReceiveResult::Success) {
+            packet.payload.resize(packet.header.payload_size);
+        }
+        return packet;
+    }
+
+    std::vector<u8> MakePayload(const size_t size, const u8 seed) {
+        std::vector<u8> payload(size);
+        for(size_t i = 0; i < size; i++) {
+            payload.at(i) = static_cast<u8>(seed + i * 7);
+        }
+        return payload;
+    }
+
+    void TestCrc32() {
+        // Check value of the standard CRC32, what the viewer (zlib) computes
+        TEST_CHECK(usb::ComputeCrc32("123456789", 9) == 0xCBF43926);
+        TEST_CHECK(usb::ComputeCrc32(nullptr, 0) == 0);
+
+        // Can be computed in parts
+        TEST_CHECK(usb::ComputeCrc32("6789", 4, usb::ComputeCrc32("12345", 5)) == 0xCBF43926);
+    }
+
+    void TestSequenceNumbers() {
+        auto loopback = std::make_unique<ViewerLoopback>();
+        usb::ViewerChannel channel(loopback->GetTransport());
+
+        // Each stream counts on its own
+        const usb::ViewerStreamId sent_streams[] = { usb::ViewerStreamId::Frame, usb::ViewerStreamId::Frame, usb::ViewerStreamId::Telemetry, usb::ViewerStreamId::Frame, usb::ViewerStreamId::Telemetry };
+        const u32 expected_seqs[] = { 0, 1, 0, 2, 1 };
+        for(const auto stream_id: sent_streams) {
+            TEST_CHECK(channel.Send(stream_id, 0, nullptr, 0));
+        }
+        // Empty payloads are a single transfer
+        TEST_CHECK(loopback->GetPendingTransferCount() == std::size(sent_streams));
+
+        for(size_t i = 0; i < std::size(sent_streams); i++) {
+            const auto packet = ReceivePacket(*loopback);
+            TEST_CHECK(packet.result == ReceiveResult::Success);
+            TEST_CHECK(packet.header.magic == usb::ViewerPacketHeader::Magic);
+            TEST_CHECK(packet.header.version == usb::ViewerMuxProtocolVersion);
+            TEST_CHECK(packet.header.stream_id == static_cast<u8>(sent_streams[i]));
+            TEST_CHECK(packet.header.seq == expected_seqs[i]);
+        }
+
+        // A new viewer starts over
+        channel.Reset();
+        TEST_CHECK(channel.Send(usb::ViewerStreamId::Frame, 0, nullptr, 0));
+        TEST_CHECK(ReceivePacket(*loopback).header.seq == 0);
+
+        // Unknown streams are never sent
+        TEST_CHECK(!channel.Send(usb::ViewerStreamId::Count, 0, nullptr, 0));
+        TEST_CHECK(loopback->GetPendingTransferCount() == 0);
+    }
+
+    void TestCorruptedByte() {
+        const auto payload = MakePayload(0x40, 0x10);
+        const auto packet_size = sizeof(usb::ViewerPacketHeader) + payload.size();
+
+        // Any flipped bit gets caught: header ones by the header CRC (or magic), payload ones by the payload CRC
+        for(size_t offset = 0; offset < packet_size; offset++) {
+            auto loopback = std::make_unique<ViewerLoopback>();
+            usb::ViewerChannel channel(loopback->GetTransport());
+            TEST_CHECK(channel.Send(usb::ViewerStreamId::Frame, 1, payload.data(), payload.size()));
+            loopback->CorruptByte(offset);
+
+            const auto packet = ReceivePacket(*loopback);
+            if(offset < sizeof(usb::ViewerPacketHeader)) {
+                TEST_CHECK(packet.result == ReceiveResult::InvalidHeader);
+            }
+            else {
+                TEST_CHECK(packet.result == ReceiveResult::InvalidPayload);
+            }
+        }
+
+        // Untouched, it goes through
+        auto loopback = std::make_unique<ViewerLoopback>();
+        usb::ViewerChannel channel(loopback->GetTransport());
+        TEST_CHECK(channel.Send(usb::ViewerStreamId::Frame, 1, payload.data(), payload.size()));
+        auto packet = ReceivePacket(*loopback);
+        TEST_CHECK(packet.result == ReceiveResult::Success);
+        TEST_CHECK(packet.payload == payload);
+
+        // Payloads which don't fit are rejected before being read
+        TEST_CHECK(channel.Send(usb::ViewerStreamId::Frame, 1, payload.data(), payload.size()));
+        packet = ReceivePacket(*loopback, payload.size() - 1);
+        TEST_CHECK(packet.result == ReceiveResult::PayloadTooBig);
+        TEST_CHECK(loopback->GetPendingTransferCount() == 1);
+
+        // Nothing left to read
+        ReceivePacket(*loopback);
+        TEST_CHECK(ReceivePacket(*loopback).result == ReceiveResult::TransportError);
+    }
+
+    void TestStreamDemux() {
+        auto loopback = std::make_unique<ViewerLoopback>();
+        usb::ViewerChannel channel(loopback->GetTransport());
+
+        // Frames and telemetry records interleaved, as the viewer thread sends them
+        std::vector<std::vector<u8>> sent_payloads[usb::ViewerStreamCount];
+        for(u8 i = 0; i < 12; i++) {
+            const auto stream_id = ((i % 3) == 2) ? usb::ViewerStreamId::Telemetry : usb::ViewerStreamId::Frame;
+            const auto payload = MakePayload((stream_id == usb::ViewerStreamId::Frame) ? (0x200 + i * 0x10) : 0x20, i);
+            TEST_CHECK(channel.Send(stream_id, i, payload.data(), payload.size()));
+            sent_payloads[static_cast<size_t>(stream_id)].push_back(payload);
+        }
+
+        std::vector<std::vector<u8>> recv_payloads[usb::ViewerStreamCount];
+        u32 next_seqs[usb::ViewerStreamCount] = {};
+        while(loopback->GetPendingTransferCount() > 0) {
+            const auto packet = ReceivePacket(*loopback);
+            TEST_CHECK(packet.result == ReceiveResult::Success);
+            TEST_CHECK(packet.header.stream_id < usb::ViewerStreamCount);
+            // No gaps within a stream
+            TEST_CHECK(packet.header.seq == next_seqs[packet.header.stream_id]++);
+            recv_payloads[packet.header.stream_id].push_back(packet.payload);
+        }
+
+        for(size_t i = 0; i < usb::ViewerStreamCount; i++) {
+            TEST_CHECK(recv_payloads[i] == sent_payloads[i]);
+        }
+        TEST_CHECK(recv_payloads[static_cast<size_t>(usb::ViewerStreamId::Frame)].size() == 8);
+        TEST_CHECK(recv_payloads[static_cast<size_t>(usb::ViewerStreamId::Telemetry)].size() == 4);
+    }
+
+    void TestTelemetryPackets() {
+        auto loopback = std::make_unique<ViewerLoopback>();
+        usb::ViewerChannel channel(loopback->GetTransport());
+
+        // Pending launch latencies get sent right away, the first flush only starts the snapshot interval
+        const os::LaunchLatencySample sample = {
+            .correlation_id = 0x1234,
+            .input_to_send_ms = 5,
+            .send_to_pickup_ms = 2,
+            .pickup_to_launch_ms = 600,
+            .launch_ms = 150,
+            .start_to_active_ms = 900,
+            .total_ms = 1657
+        };
+        usb::NotifyLaunchLatency(os::LaunchTitleType::HomebrewApplet, sample);
+        usb::FlushTelemetry(channel);
+
+        auto packet = ReceivePacket(*loopback);
+        TEST_CHECK(packet.result == ReceiveResult::Success);
+        TEST_CHECK(packet.header.stream_id == static_cast<u8>(usb::ViewerStreamId::Telemetry));
+        TEST_CHECK(packet.header.type == static_cast<u16>(usb::ViewerTelemetryType::LaunchLatency));
+        TEST_CHECK(packet.payload.size() == sizeof(usb::ViewerTelemetryLaunchLatency));
+        usb::ViewerTelemetryLaunchLatency latency;
+        memcpy(&latency, packet.payload.data(), sizeof(latency));
+        TEST_CHECK(latency.type == os::LaunchTitleType::HomebrewApplet);
+        TEST_CHECK(latency.sample.correlation_id == sample.correlation_id);
+        TEST_CHECK(latency.sample.total_ms == sample.total_ms);
+        TEST_CHECK(loopback->GetPendingTransferCount() == 0);
+
+        // Nothing else until the interval passes
+        usb::NotifyMainLoopWakeup();
+        usb::NotifyMainLoopWakeup();
+        usb::NotifyRgbaEncoderFallback(usb::ViewerRgbaEncoderFallback::Downscaled, 1);
+        usb::NotifyFrameTimings(2'000'000, 1'000'000, 0x10000);
+        usb::NotifyFrameTimings(4'000'000, 3'000'000, 0x20000);
+        usb::FlushTelemetry(channel);
+        TEST_CHECK(loopback->GetPendingTransferCount() == 0);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(usb::ViewerTelemetryIntervalMs));
+        usb::FlushTelemetry(channel);
+        packet = ReceivePacket(*loopback);
+        TEST_CHECK(packet.result == ReceiveResult::Success);
+        TEST_CHECK(packet.header.type == static_cast<u16>(usb::ViewerTelemetryType::Snapshot));
+        // Continues the telemetry stream's sequence
+        TEST_CHECK(packet.header.seq == 1);
+        TEST_CHECK(packet.payload.size() == sizeof(usb::ViewerTelemetrySnapshot));
+        usb::ViewerTelemetrySnapshot snapshot;
+        memcpy(&snapshot, packet.payload.data(), sizeof(snapshot));
+        TEST_CHECK(snapshot.interval_ms >= usb::ViewerTelemetryIntervalMs);
+        TEST_CHECK(snapshot.main_loop_wakeup_count == 2);
+        TEST_CHECK(snapshot.frame_count == 2);
+        TEST_CHECK(snapshot.frame_bytes == 0x30000);
+        // Host ticks are nanoseconds
+        TEST_CHECK(snapshot.avg_capture_us == 3'000);
+        TEST_CHECK(snapshot.max_capture_us == 4'000);
+        TEST_CHECK(snapshot.avg_encode_us == 2'000);
+        TEST_CHECK(snapshot.max_encode_us == 3'000);
+        TEST_CHECK(snapshot.dropped_launch_latency_count == 0);
+        TEST_CHECK(snapshot.rgba_encoder_fallback == usb::ViewerRgbaEncoderFallback::Downscaled);
+        TEST_CHECK(snapshot.rgba_downscale_shift == 1);
+        TEST_CHECK(loopback->GetPendingTransferCount() == 0);
+    }
+
+}
+
+int main() {
+    ams::init::GetAllocator()->SetTotalFreeSize(FakeHeapSize);
+    mem::Initialize(FakeHeapSize);
+
+    TestCrc32();
+    TestSequenceNumbers();
+    TestCorruptedByte();
+    TestStreamDemux();
+    TestTelemetryPackets();
+
+    return test::Finish("usb_ViewerChannelTest");
+}
@@ -0,0 +1,339 @@
+#include <test_Common.hpp>
+#include <usb/usb_ViewerEncoder.hpp>
+#include <mem/mem_Heap.hpp>
+#include <stratosphere.hpp>
+#include <png.h>
+#include <random>
+#include <vector>
+
+// RGBA USB viewer encoder: encode -> decode round trips (decoded the way uViewer does), keyframes, scalar/vector kernel equivalence
+// Plus an encoding benchmark over the repo's console screenshots (1280x720 uMenu captures)
+
+namespace {
+
+    constexpr size_t FakeHeapSize = 64 * 1024 * 1024;
+    constexpr u32 ScreenWidth = 1280;
+    constexpr u32 ScreenHeight = 720;
+    constexpr const char *ScreenshotPaths[] = {
+        "../Screenshots/s1.png", "../Screenshots/s2.png", "../Screenshots/s3.png",
+        "../Screenshots/s4.png", "../Screenshots/s5.png", "../Screenshots/s6.png"
+    };
+    // Menus mostly stay still between captures, every screenshot is sent a few times in a row
+    constexpr u32 BenchmarkFrameRepeatCount = 4;
+    constexpr u32 BenchmarkIterationCount = 5;
+
+    using Frame = std::vector<u32>;
+
+    Frame MakeRandomFrame(std::mt19937 &rng, const u32 width, const u32 height) {
+        Frame frame(width * height);
+        for(auto &px: frame) {
+            px = rng();
+        }
+        return frame;
+    }
+
+    // Flat areas and some noise, so that RLE has something to do either way
+    Frame MakeMenuLikeFrame(std::mt19937 &rng, const u32 width, const u32 height) {
+        Frame frame(width * height, 0xFF302010);
+        for(u32 y = height / 4; y < height / 2; y++) {
+            for(u32 x = width / 8; x < (width / 8) * 7; x++) {
+                frame.at(y * width + x) = ((x / 7) % 3) ? 0xFFE0E0E0 : rng();
+            }
+        }
+        return frame;
+    }
+
+    Frame DownscaleExpected(Frame frame, u32 width, u32 height, const u32 downscale_shift) {
+        for(u32 i = 0; i < downscale_shift; i++) {
+            usb::DownscaleHalfScalar(frame.data(), width, height);
+            width /= 2;
+            height /= 2;
+        }
+        frame.resize(width * height);
+        return frame;
+    }
+
+    // What uViewer does with each encoded frame: included tiles get written over the previous decoded frame
+    bool DecodeFrame(const u8 *data, const size_t size, Frame &frame, u32 &out_width, u32 &out_height, bool &out_keyframe, u32 &out_included_tile_count) {
+        usb::ViewerEncodedRgbaHeader header;
+        if(size < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        out_width = header.width;
+        out_height = header.height;
+        out_keyframe = header.flags & usb::ViewerEncodedRgbaFlags_Keyframe;
+        out_included_tile_count = header.included_tile_count;
+
+        const u32 tile_size = header.tile_size;
+        const auto tiles_x = (header.width + tile_size - 1) / tile_size;
+        const auto tiles_y = (header.height + tile_size - 1) / tile_size;
+        const auto tile_bitmap = data + sizeof(header);
+        const auto tile_bitmap_size = (tiles_x * tiles_y + 7) / 8;
+        auto tile_data = tile_bitmap + tile_bitmap_size;
+        const auto tile_data_end = tile_data + header.tile_data_size;
+        if((tile_data_end - data) != static_cast<ptrdiff_t>(size)) {
+            return false;
+        }
+        frame.resize(header.width * header.height);
+
+        std::vector<u32> tile_pixels(tile_size * tile_size);
+        u32 tile_idx = 0;
+        for(u32 tile_y = 0; tile_y < tiles_y; tile_y++) {
+            for(u32 tile_x = 0; tile_x < tiles_x; tile_x++, tile_idx++) {
+                if(!(tile_bitmap[tile_idx / 8] & BIT(tile_idx % 8))) {
+                    continue;
+                }
+
+                const auto x = tile_x * tile_size;
+                const auto y = tile_y * tile_size;
+                const auto tile_width = std::min(tile_size, header.width - x);
+                const auto tile_height = std::min(tile_size, header.height - y);
+                const size_t tile_pixel_count = tile_width * tile_height;
+                if(header.flags & usb::ViewerEncodedRgbaFlags_Rle) {
+                    // Each tile is compressed on its own, find where it ends by decoding control bytes
+                    size_t tile_rle_size = 0;
+                    size_t decoded_count = 0;
+                    while(decoded_count < tile_pixel_count) {
+                        const auto ctrl = tile_data[tile_rle_size];
+                        const size_t len = (ctrl & 0x7F) + 1;
+                        tile_rle_size += 1 + ((ctrl & 0x80) ? sizeof(u32) : len * sizeof(u32));
+                        decoded_count += len;
+                    }
+                    if(usb::DecodeRle(tile_data, tile_rle_size, tile_pixels.data(), tile_pixel_count) != tile_pixel_count) {
+                        return false;
+                    }
+                    tile_data += tile_rle_size;
+                }
+                else {
+                    memcpy(tile_pixels.data(), tile_data, tile_pixel_count * sizeof(u32));
+                    tile_data += tile_pixel_count * sizeof(u32);
+                }
+
+                for(u32 row = 0; row < tile_height; row++) {
+                    memcpy(frame.data() + (y + row) * header.width + x, tile_pixels.data() + row * tile_width, tile_width * sizeof(u32));
+                }
+            }
+        }
+        return tile_data == tile_data_end;
+    }
+
+    struct DecodedFrameInfo {
+        bool ok;
+        u32 width;
+        u32 height;
+        bool keyframe;
+        u32 included_tile_count;
+    };
+
+    // The encoder downscales in place, so it always gets a copy
+    DecodedFrameInfo EncodeDecode(usb::ViewerRgbaEncoder &encoder, const Frame &src_frame, Frame &decoded_frame) {
+        auto frame = src_frame;
+        const auto encoded_size = encoder.Encode(frame.data());
+        DecodedFrameInfo info = {};
+        info.ok = DecodeFrame(encoder.GetOutput(), encoded_size, decoded_frame, info.width, info.height, info.keyframe, info.included_tile_count);
+        return info;
+    }
+
+    void TestRoundTrip() {
+        std::mt19937 rng(0x554C);
+        // Odd sizes too, for clipped edge tiles
+        const std::pair<u32, u32> sizes[] = { { ScreenWidth, ScreenHeight }, { 200, 124 } };
+        for(const auto &[width, height]: sizes) {
+            for(u32 downscale_shift = 0; downscale_shift <= usb::ViewerRgbaMaxDownscaleShift; downscale_shift++) {
+                for(const auto rle_enabled: { false, true }) {
+                    usb::ViewerRgbaEncoder encoder;
+                    TEST_CHECK(encoder.Initialize({ .downscale_shift = downscale_shift, .delta_enabled = true, .rle_enabled = rle_enabled, .kernel = usb::ViewerRgbaKernel::Vector }, width, height));
+
+                    const auto first_frame = MakeMenuLikeFrame(rng, width, height);
+                    Frame decoded_frame;
+                    auto info = EncodeDecode(encoder, first_frame, decoded_frame);
+                    TEST_CHECK(info.ok);
+                    TEST_CHECK(info.keyframe);
+                    TEST_CHECK(info.width == (width >> downscale_shift));
+                    TEST_CHECK(info.height == (height >> downscale_shift));
+                    TEST_CHECK(decoded_frame == DownscaleExpected(first_frame, width, height, downscale_shift));
+
+                    // Only a small area changes: a delta frame with just those tiles
+                    auto second_frame = first_frame;
+                    for(u32 y = 0; y < 8; y++) {
+                        for(u32 x = 0; x < 8; x++) {
+                            second_frame.at((40 + y) * width + 60 + x) = rng();
+                        }
+                    }
+                    info = EncodeDecode(encoder, second_frame, decoded_frame);
+                    TEST_CHECK(info.ok);
+                    TEST_CHECK(!info.keyframe);
+                    TEST_CHECK((info.included_tile_count > 0) && (info.included_tile_count <= 4));
+                    TEST_CHECK(decoded_frame == DownscaleExpected(second_frame, width, height, downscale_shift));
+
+                    // Nothing changed at all
+                    info = EncodeDecode(encoder, second_frame, decoded_frame);
+                    TEST_CHECK(info.ok);
+                    TEST_CHECK(info.included_tile_count == 0);
+                    TEST_CHECK(decoded_frame == DownscaleExpected(second_frame, width, height, downscale_shift));
+                }
+            }
+        }
+    }
+
+    void TestKeyframeAfterRequest() {
+        std::mt19937 rng(0x4B46);
+        usb::ViewerRgbaEncoder encoder;
+        TEST_CHECK(encoder.Initialize({ .downscale_shift = 1, .delta_enabled = true, .rle_enabled = true, .kernel = usb::ViewerRgbaKernel::Scalar }, ScreenWidth, ScreenHeight));
+        const auto tile_count = ((ScreenWidth / 2 + usb::ViewerRgbaTileSize - 1) / usb::ViewerRgbaTileSize) * ((ScreenHeight / 2 + usb::ViewerRgbaTileSize - 1) / usb::ViewerRgbaTileSize);
+
+        const auto frame = MakeMenuLikeFrame(rng, ScreenWidth, ScreenHeight);
+        Frame decoded_frame;
+        TEST_CHECK(EncodeDecode(encoder, frame, decoded_frame).keyframe);
+        TEST_CHECK(EncodeDecode(encoder, frame, decoded_frame).included_tile_count == 0);
+
+        // A new viewer has no previous frame: everything gets sent again, even if nothing changed
+        encoder.RequestKeyframe();
+        Frame new_viewer_frame;
+        const auto info = EncodeDecode(encoder, frame, new_viewer_frame);
+        TEST_CHECK(info.keyframe);
+        TEST_CHECK(info.included_tile_count == tile_count);
+        TEST_CHECK(new_viewer_frame == DownscaleExpected(frame, ScreenWidth, ScreenHeight, 1));
+
+        // Then back to deltas
+        TEST_CHECK(!EncodeDecode(encoder, frame, decoded_frame).keyframe);
+
+        // Without delta frames, every frame is a keyframe
+        usb::ViewerRgbaEncoder plain_encoder;
+        TEST_CHECK(plain_encoder.Initialize({ .downscale_shift = 2, .delta_enabled = false, .rle_enabled = true, .kernel = usb::ViewerRgbaKernel::Scalar }, ScreenWidth, ScreenHeight));
+        TEST_CHECK(EncodeDecode(plain_encoder, frame, decoded_frame).keyframe);
+        TEST_CHECK(EncodeDecode(plain_encoder, frame, decoded_frame).keyframe);
+    }
+
+    void TestKernelEquivalence() {
+        std::mt19937 rng(0x4B4E);
+
+        // Widths which aren't a multiple of the vector width leave leftover pixels
+        const std::pair<u32, u32> sizes[] = { { ScreenWidth, ScreenHeight }, { 18, 6 }, { 34, 10 }, { 2, 2 } };
+        for(const auto &[width, height]: sizes) {
+            auto scalar_frame = MakeRandomFrame(rng, width, height);
+            auto vector_frame = scalar_frame;
+            usb::DownscaleHalfScalar(scalar_frame.data(), width, height);
+            usb::DownscaleHalfVector(vector_frame.data(), width, height);
+            TEST_CHECK(scalar_frame == vector_frame);
+        }
+
+        for(u32 count = 1; count <= usb::ViewerRgbaTileSize; count++) {
+            auto a = MakeRandomFrame(rng, count, 1);
+            auto b = a;
+            TEST_CHECK(usb::TileRowEqualsScalar(a.data(), b.data(), count) && usb::TileRowEqualsVector(a.data(), b.data(), count));
+            for(u32 i = 0; i < count; i++) {
+                b = a;
+                b.at(i) ^= 1 << (i % 32);
+                TEST_CHECK(!usb::TileRowEqualsScalar(a.data(), b.data(), count) && !usb::TileRowEqualsVector(a.data(), b.data(), count));
+            }
+        }
+
+        // Whole encoders, byte by byte
+        for(u32 downscale_shift = 0; downscale_shift <= usb::ViewerRgbaMaxDownscaleShift; downscale_shift++) {
+            usb::ViewerRgbaEncoder scalar_encoder;
+            usb::ViewerRgbaEncoder vector_encoder;
+            TEST_CHECK(scalar_encoder.Initialize({ .downscale_shift = downscale_shift, .delta_enabled = true, .rle_enabled = true, .kernel = usb::ViewerRgbaKernel::Scalar }, ScreenWidth, ScreenHeight));
+            TEST_CHECK(vector_encoder.Initialize({ .downscale_shift = downscale_shift, .delta_enabled = true, .rle_enabled = true, .kernel = usb::ViewerRgbaKernel::Vector }, ScreenWidth, ScreenHeight));
+            for(u32 i = 0; i < 3; i++) {
+                const auto frame = (i == 1) ? MakeRandomFrame(rng, ScreenWidth, ScreenHeight) : MakeMenuLikeFrame(rng, ScreenWidth, ScreenHeight);
+                auto scalar_frame = frame;
+                auto vector_frame = frame;
+                const auto scalar_size = scalar_encoder.Encode(scalar_frame.data());
+                const auto vector_size = vector_encoder.Encode(vector_frame.data());
+                TEST_CHECK(scalar_size == vector_size);
+                TEST_CHECK(memcmp(scalar_encoder.GetOutput(), vector_encoder.GetOutput(), std::min(scalar_size, vector_size)) == 0);
+            }
+        }
+    }
+
+    // Captures are RGB PNGs, the console hands out RGBA
+    bool LoadScreenshot(const char *path, Frame &out_frame) {
+        png_image image = {};
+        image.version = PNG_IMAGE_VERSION;
+        if(!png_image_begin_read_from_file(&image, path)) {
+            return false;
+        }
+        image.format = PNG_FORMAT_RGBA;
+        if((image.width != ScreenWidth) || (image.height != ScreenHeight)) {
+            png_image_free(&image);
+            return false;
+        }
+        out_frame.resize(ScreenWidth * ScreenHeight);
+        return png_image_finish_read(&image, nullptr, out_frame.data(), 0, nullptr) != 0;
+    }
+
+    void BenchmarkScreenshots() {
+        std::vector<Frame> frames;
+        for(const auto path: ScreenshotPaths) {
+            Frame frame;
+            if(!LoadScreenshot(path, frame)) {
+                printf("Unable to load %s, skipping the benchmark\n", path);
+                return;
+            }
+            for(u32 i = 0; i < BenchmarkFrameRepeatCount; i++) {
+                frames.push_back(frame);
+            }
+        }
+
+        struct BenchmarkConfig {
+            const char *name;
+            usb::ViewerRgbaEncoderConfig cfg;
+        };
+        const BenchmarkConfig configs[] = {
+            { "rle", { .downscale_shift = 0, .delta_enabled = false, .rle_enabled = true } },
+            { "delta", { .downscale_shift = 0, .delta_enabled = true, .rle_enabled = false } },
+            { "delta+rle", { .downscale_shift = 0, .delta_enabled = true, .rle_enabled = true } },
+            { "half+delta+rle", { .downscale_shift = 1, .delta_enabled = true, .rle_enabled = true } },
+            { "quarter+delta+rle", { .downscale_shift = 2, .delta_enabled = true, .rle_enabled = true } }
+        };
+
+        printf("%zu frames (%zu screenshots), plain RGBA 0x%zX bytes each:\n", frames.size(), std::size(ScreenshotPaths), PlainRgbaScreenBufferSize);
+        for(const auto &config: configs) {
+            for(const auto kernel: { usb::ViewerRgbaKernel::Scalar, usb::ViewerRgbaKernel::Vector }) {
+                auto cfg = config.cfg;
+                cfg.kernel = kernel;
+                usb::ViewerRgbaEncoder encoder;
+                TEST_CHECK(encoder.Initialize(cfg, ScreenWidth, ScreenHeight));
+
+                u64 total_size = 0;
+                u64 elapsed_ns = 0;
+                Frame decoded_frame;
+                for(u32 i = 0; i < BenchmarkIterationCount; i++) {
+                    encoder.RequestKeyframe();
+                    for(const auto &src_frame: frames) {
+                        // Copied beforehand, the console captures into the buffer the encoder works on
+                        auto frame = src_frame;
+                        const auto start_ns = test::GetCurrentNs();
+                        const auto encoded_size = encoder.Encode(frame.data());
+                        elapsed_ns += test::GetCurrentNs() - start_ns;
+                        total_size += encoded_size;
+
+                        if(i == 0) {
+                            u32 width, height, included_tile_count;
+                            bool keyframe;
+                            TEST_CHECK(DecodeFrame(encoder.GetOutput(), encoded_size, decoded_frame, width, height, keyframe, included_tile_count));
+                        }
+                    }
+                }
+
+                const auto frame_count = frames.size() * BenchmarkIterationCount;
+                printf("  %-18s %-6s %.2f ms/frame, avg 0x%lX bytes/frame (%.1f%% of plain)\n", config.name, (kernel == usb::ViewerRgbaKernel::Vector) ? "vector" : "scalar", elapsed_ns / 1'000'000.0 / frame_count, total_size / frame_count, 100.0 * total_size / frame_count / PlainRgbaScreenBufferSize);
+            }
+        }
+    }
+
+}
+
+int main() {
+    ams::init::GetAllocator()->SetTotalFreeSize(FakeHeapSize);
+    mem::Initialize(FakeHeapSize);
+
+    TestRoundTrip();
+    TestKeyframeAfterRequest();
+    TestKernelEquivalence();
+    BenchmarkScreenshots();
+
+    return test::Finish("usb_ViewerEncoderTest");
+}
@@ -0,0 +1,114 @@
+#include <test_Common.hpp>
+#include <usb/usb_ViewerProtocol.hpp>
+
+// USB viewer frame protocol: header layout (as uViewer parses it), version negotiation and the bytes sent per JPEG frame versus legacy packets
+
+namespace {
+
+    // JPEG mode, as uDaemon sends it
+    constexpr u16 JpegMode = 1;
+
+    // Console screenshot JPEGs: menus and 2D games stay small, detailed 3D scenes get much bigger
+    constexpr size_t SampleJpegSizes[] = { 0x14000, 0x1E000, 0x2A000, 0x38000, 0x4C000, 0x60000, 0x7A000 };
+    constexpr size_t SampleFrameCount = 600; // 10 seconds at 60 FPS
+
+    template<typename T>
+    inline T ReadLe(const u8 *data, const size_t offset) {
+        T val = 0;
+        for(size_t i = 0; i < sizeof(T); i++) {
+            val |= static_cast<T>(data[offset + i]) << (i * 8);
+        }
+        return val;
+    }
+
+    void TestFrameHeaderRoundTrip() {
+        const auto header = usb::MakeViewerFrameHeader(usb::ViewerFrameProtocolVersion, JpegMode, 0x12345678, 0x4C123);
+
+        // Sent as-is, uViewer reads the fields at these offsets
+        u8 wire[sizeof(header)];
+        memcpy(wire, &header, sizeof(header));
+        TEST_CHECK(ReadLe<u32>(wire, 0x0) == usb::ViewerFrameHeader::Magic);
+        TEST_CHECK(memcmp(wire, "ULVF", 4) == 0);
+        TEST_CHECK(ReadLe<u16>(wire, 0x4) == usb::ViewerFrameProtocolVersion);
+        TEST_CHECK(ReadLe<u16>(wire, 0x6) == JpegMode);
+        TEST_CHECK(ReadLe<u32>(wire, 0x8) == 0x12345678);
+        TEST_CHECK(ReadLe<u32>(wire, 0xC) == 0x4C123);
+
+        usb::ViewerFrameHeader read_header;
+        memcpy(&read_header, wire, sizeof(read_header));
+        TEST_CHECK(read_header.magic == header.magic);
+        TEST_CHECK(read_header.version == header.version);
+        TEST_CHECK(read_header.mode == header.mode);
+        TEST_CHECK(read_header.seq == header.seq);
+        TEST_CHECK(read_header.payload_size == header.payload_size);
+
+        // uViewer tells headers from legacy packets by transfer size
+        TEST_CHECK(sizeof(header) != usb::ViewerLegacyPacketSize);
+    }
+
+    void TestHandshakeLayout() {
+        const usb::ViewerHandshake handshake = {
+            .magic = usb::ViewerHandshake::Magic,
+            .version = usb::ViewerProtocolVersion
+        };
+        u8 wire[sizeof(handshake)];
+        memcpy(wire, &handshake, sizeof(handshake));
+        TEST_CHECK(memcmp(wire, "ULVW", 4) == 0);
+        TEST_CHECK(ReadLe<u32>(wire, 0x4) == usb::ViewerProtocolVersion);
+    }
+
+    void TestNegotiateVersion() {
+        const auto negotiate = [](const u32 magic, const u32 version) {
+            return usb::NegotiateViewerProtocolVersion({ .magic = magic, .version = version });
+        };
+
+        TEST_CHECK(negotiate(usb::ViewerHandshake::Magic, usb::ViewerFrameProtocolVersion) == usb::ViewerFrameProtocolVersion);
+        TEST_CHECK(negotiate(usb::ViewerHandshake::Magic, usb::ViewerMuxProtocolVersion) == usb::ViewerMuxProtocolVersion);
+        // Viewers newer than the daemon get the highest version the daemon knows
+        TEST_CHECK(negotiate(usb::ViewerHandshake::Magic, usb::ViewerProtocolVersion + 5) == usb::ViewerProtocolVersion);
+        // A viewer explicitly asking for legacy packets gets them
+        TEST_CHECK(negotiate(usb::ViewerHandshake::Magic, usb::ViewerLegacyProtocolVersion) == usb::ViewerLegacyProtocolVersion);
+        // Anything else is not a handshake
+        TEST_CHECK(negotiate(0, usb::ViewerProtocolVersion) == usb::ViewerLegacyProtocolVersion);
+        TEST_CHECK(negotiate(usb::ViewerFrameHeader::Magic, usb::ViewerProtocolVersion) == usb::ViewerLegacyProtocolVersion);
+    }
+
+    void TestTransferSizes() {
+        // Legacy packets never depend on the payload
+        TEST_CHECK(usb::GetViewerFrameTransferSize(usb::ViewerLegacyProtocolVersion, 0x1000) == usb::ViewerLegacyPacketSize);
+        TEST_CHECK(usb::GetViewerFrameTransferSize(usb::ViewerLegacyProtocolVersion, PlainRgbaScreenBufferSize) == usb::ViewerLegacyPacketSize);
+        TEST_CHECK(usb::GetViewerFrameTransferSize(usb::ViewerFrameProtocolVersion, 0x1000) == (sizeof(usb::ViewerFrameHeader) + 0x1000));
+        TEST_CHECK(usb::GetViewerFrameTransferSize(usb::ViewerMuxProtocolVersion, 0x1000) == (sizeof(usb::ViewerPacketHeader) + 0x1000));
+    }
+
+    void CompareJpegBandwidth() {
+        const u32 versions[] = { usb::ViewerLegacyProtocolVersion, usb::ViewerFrameProtocolVersion, usb::ViewerMuxProtocolVersion };
+        u64 total_sizes[std::size(versions)] = {};
+        u64 total_jpeg_size = 0;
+        for(size_t i = 0; i < SampleFrameCount; i++) {
+            const auto jpeg_size = SampleJpegSizes[i % std::size(SampleJpegSizes)];
+            total_jpeg_size += jpeg_size;
+            for(size_t j = 0; j < std::size(versions); j++) {
+                total_sizes[j] += usb::GetViewerFrameTransferSize(versions[j], jpeg_size);
+            }
+        }
+
+        // Framing only adds its header to each JPEG
+        TEST_CHECK(total_sizes[1] == (total_jpeg_size + SampleFrameCount * sizeof(usb::ViewerFrameHeader)));
+        TEST_CHECK(total_sizes[2] == (total_jpeg_size + SampleFrameCount * sizeof(usb::ViewerPacketHeader)));
+        TEST_CHECK(total_sizes[1] < total_sizes[0]);
+
+        printf("%zu JPEG frames (avg 0x%lX bytes): legacy %.1f MB, framed %.1f MB (%.1fx less), mux %.1f MB (%.1fx less)\n", SampleFrameCount, total_jpeg_size / SampleFrameCount, total_sizes[0] / 1'000'000.0, total_sizes[1] / 1'000'000.0, static_cast<double>(total_sizes[0]) / total_sizes[1], total_sizes[2] / 1'000'000.0, static_cast<double>(total_sizes[0]) / total_sizes[2]);
+    }
+
+}
+
+int main() {
+    TestFrameHeaderRoundTrip();
+    TestHandshakeLayout();
+    TestNegotiateVersion();
+    TestTransferSizes();
+    CompareJpegBandwidth();
+
+    return test::Finish("usb_ViewerProtocolTest");
+}
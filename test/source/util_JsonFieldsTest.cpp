@@ -0,0 +1,262 @@
+#include <test_Common.hpp>
+#include <util/util_JsonFields.hpp>
+
+// Top-level JSON field picking: values of every type, wrong-type and nested values, early stop once everything is found, non-object roots
+// Plus a benchmark against parsing whole JSON objects and reading them through value(), what entry and theme loading did before
+
+namespace {
+
+    constexpr u32 BenchmarkIterationCount = 20'000;
+
+    struct EntryFields {
+        u32 type = 0;
+        std::string folder;
+        std::string icon;
+        std::string app_id;
+        std::string nro_path;
+        std::string nro_argv;
+        std::string name;
+        std::string author;
+        std::string version;
+    };
+
+    // Same fields menu entries get loaded with
+    Result LoadEntryFields(const std::string &json, EntryFields &out_fields) {
+        const util::JsonField fields[] = {
+            util::MakeJsonField("type", out_fields.type),
+            util::MakeJsonField("folder", out_fields.folder),
+            util::MakeJsonField("icon", out_fields.icon),
+            util::MakeJsonField("application_id", out_fields.app_id),
+            util::MakeJsonField("nro_path", out_fields.nro_path),
+            util::MakeJsonField("nro_argv", out_fields.nro_argv),
+            util::MakeJsonField("name", out_fields.name),
+            util::MakeJsonField("author", out_fields.author),
+            util::MakeJsonField("version", out_fields.version)
+        };
+        return util::LoadJSONFieldsFromBuffer(json.data(), json.size(), fields, std::size(fields));
+    }
+
+    void LoadEntryFieldsWithObject(const std::string &json, EntryFields &out_fields) {
+        const auto entry = JSON::parse(json);
+        out_fields.type = entry.value("type", 0u);
+        out_fields.folder = entry.value("folder", "");
+        out_fields.icon = entry.value("icon", "");
+        out_fields.app_id = entry.value("application_id", "");
+        out_fields.nro_path = entry.value("nro_path", "");
+        out_fields.nro_argv = entry.value("nro_argv", "");
+        out_fields.name = entry.value("name", "");
+        out_fields.author = entry.value("author", "");
+        out_fields.version = entry.value("version", "");
+    }
+
+    bool operator==(const EntryFields &a, const EntryFields &b) {
+        return (a.type == b.type) && (a.folder == b.folder) && (a.icon == b.icon) && (a.app_id == b.app_id) && (a.nro_path == b.nro_path) && (a.nro_argv == b.nro_argv) && (a.name == b.name) && (a.author == b.author) && (a.version == b.version);
+    }
+
+    void TestFieldTypes() {
+        const std::string json = R"({ "str": "text", "small": 1234, "big": 18446744073709551615, "flag": true, "other": [1, 2, { "str": "nested" }], "obj": { "small": 5 } })";
+        std::string str;
+        u32 small = 0;
+        u64 big = 0;
+        bool flag = false;
+        std::string missing = "default";
+        const util::JsonField fields[] = {
+            util::MakeJsonField("str", str),
+            util::MakeJsonField("small", small),
+            util::MakeJsonField("big", big),
+            util::MakeJsonField("flag", flag),
+            util::MakeJsonField("missing", missing)
+        };
+        TEST_CHECK_RC(util::LoadJSONFieldsFromBuffer(json.data(), json.size(), fields, std::size(fields)));
+        TEST_CHECK(str == "text");
+        TEST_CHECK(small == 1234);
+        TEST_CHECK(big == UINT64_MAX);
+        TEST_CHECK(flag);
+        // Missing keys keep their defaults
+        TEST_CHECK(missing == "default");
+    }
+
+    void TestWrongTypeValues() {
+        // Values which don't fit their destination are skipped, the same key with a nested value too
+        const std::string json = R"({ "str": 12, "small": "12", "neg": -1, "huge": 4294967296, "frac": 1.5, "flag": "true", "nested": { "a": 1 }, "list": ["x"], "null": null })";
+        std::string str = "default";
+        u32 small = 7;
+        u32 neg = 7;
+        u32 huge = 7;
+        u64 frac = 7;
+        bool flag = false;
+        std::string nested = "default";
+        std::string list = "default";
+        std::string null_str = "default";
+        const util::JsonField fields[] = {
+            util::MakeJsonField("str", str),
+            util::MakeJsonField("small", small),
+            util::MakeJsonField("neg", neg),
+            util::MakeJsonField("huge", huge),
+            util::MakeJsonField("frac", frac),
+            util::MakeJsonField("flag", flag),
+            util::MakeJsonField("nested", nested),
+            util::MakeJsonField("list", list),
+            util::MakeJsonField("null", null_str)
+        };
+        TEST_CHECK_RC(util::LoadJSONFieldsFromBuffer(json.data(), json.size(), fields, std::size(fields)));
+        TEST_CHECK(str == "default");
+        TEST_CHECK(small == 7);
+        TEST_CHECK(neg == 7);
+        TEST_CHECK(huge == 7);
+        TEST_CHECK(frac == 7);
+        TEST_CHECK(!flag);
+        TEST_CHECK(nested == "default");
+        TEST_CHECK(list == "default");
+        TEST_CHECK(null_str == "default");
+
+        // Keys inside nested values are never picked
+        const std::string nested_json = R"({ "inner": { "name": "nested", "list": [{ "name": "deeper" }] }, "name": "root" })";
+        std::string name;
+        const util::JsonField name_fields[] = { util::MakeJsonField("name", name) };
+        TEST_CHECK_RC(util::LoadJSONFieldsFromBuffer(nested_json.data(), nested_json.size(), name_fields, std::size(name_fields)));
+        TEST_CHECK(name == "root");
+    }
+
+    void TestEarlyStop() {
+        // Once every field is found the rest isn't even parsed: broken data after that point doesn't matter
+        const std::string json = R"({ "name": "title", "version": "1.0", "this is": [ not valid JSON at all)";
+        std::string name;
+        std::string version;
+        const util::JsonField fields[] = {
+            util::MakeJsonField("name", name),
+            util::MakeJsonField("version", version)
+        };
+        TEST_CHECK_RC(util::LoadJSONFieldsFromBuffer(json.data(), json.size(), fields, std::size(fields)));
+        TEST_CHECK(name == "title");
+        TEST_CHECK(version == "1.0");
+
+        // Still looking for a field when the broken part comes: that's an invalid file
+        std::string author;
+        const util::JsonField more_fields[] = {
+            util::MakeJsonField("name", name),
+            util::MakeJsonField("author", author)
+        };
+        TEST_CHECK(util::LoadJSONFieldsFromBuffer(json.data(), json.size(), more_fields, std::size(more_fields)) == misc::ResultInvalidJsonFile);
+
+        // A field with a wrong-type value isn't found, thus the parse goes on to the end
+        const std::string wrong_type_json = R"({ "name": 5, "broken)";
+        const util::JsonField name_fields[] = { util::MakeJsonField("name", name) };
+        TEST_CHECK(util::LoadJSONFieldsFromBuffer(wrong_type_json.data(), wrong_type_json.size(), name_fields, std::size(name_fields)) == misc::ResultInvalidJsonFile);
+    }
+
+    void TestInvalidDocuments() {
+        std::string name;
+        const util::JsonField fields[] = { util::MakeJsonField("name", name) };
+        const char *invalid_jsons[] = {
+            R"(["name", "title"])",
+            R"("name")",
+            "1234",
+            "true",
+            "null",
+            "",
+            "   ",
+            // Truncated before the field (after it, the early stop accepts it)
+            R"({ "other": 1)",
+            R"({ "name" "title" })",
+            "{ name: \"title\" }"
+        };
+        for(const auto json: invalid_jsons) {
+            name = "default";
+            const auto rc = util::LoadJSONFieldsFromBuffer(json, strlen(json), fields, std::size(fields));
+            if(rc != misc::ResultInvalidJsonFile) {
+                printf("Invalid JSON loaded: %s\n", json);
+            }
+            TEST_CHECK(rc == misc::ResultInvalidJsonFile);
+        }
+
+        // An empty object is fine, nothing gets found
+        name = "default";
+        TEST_CHECK_RC(util::LoadJSONFieldsFromBuffer("{}", 2, fields, std::size(fields)));
+        TEST_CHECK(name == "default");
+
+        // More fields than the found mask holds
+        std::vector<util::JsonField> too_many_fields(util::MaxJsonFieldCount + 1, util::MakeJsonField("name", name));
+        TEST_CHECK(util::LoadJSONFieldsFromBuffer("{}", 2, too_many_fields.data(), too_many_fields.size()) == misc::ResultInvalidJsonFile);
+    }
+
+    // Theme-like document: the wanted keys come first, then a lot of unrelated data
+    std::string MakeBigDocument() {
+        auto doc = JSON::object();
+        doc["name"] = "Theme";
+        doc["author"] = "Someone";
+        doc["release"] = "1.0";
+        auto elements = JSON::array();
+        for(u32 i = 0; i < 300; i++) {
+            elements.push_back({ { "x", i }, { "y", i * 2 }, { "color", "#ffffffff" }, { "visible", (i % 2) == 0 }, { "name", "element" + std::to_string(i) } });
+        }
+        doc["zz_elements"] = elements;
+        return doc.dump();
+    }
+
+    template<typename F>
+    double TimeUs(F fn) {
+        const auto start_ns = test::GetCurrentNs();
+        for(u32 i = 0; i < BenchmarkIterationCount; i++) {
+            fn();
+        }
+        return (test::GetCurrentNs() - start_ns) / 1'000.0 / BenchmarkIterationCount;
+    }
+
+    void BenchmarkFieldPicking() {
+        const std::string entry_jsons[] = {
+            R"({"application_id":"0100000000010000","folder":"Games","type":1})",
+            R"({"author":"Someone","folder":"","name":"Homebrew App","nro_argv":"sdmc:/switch/app.nro","nro_path":"sdmc:/switch/app.nro","type":2,"version":"1.2.3"})"
+        };
+        for(const auto &json: entry_jsons) {
+            EntryFields fields;
+            EntryFields object_fields;
+            TEST_CHECK_RC(LoadEntryFields(json, fields));
+            LoadEntryFieldsWithObject(json, object_fields);
+            TEST_CHECK(fields == object_fields);
+        }
+
+        const auto entry_fields_us = TimeUs([&]() {
+            for(const auto &json: entry_jsons) {
+                EntryFields fields;
+                LoadEntryFields(json, fields);
+            }
+        }) / std::size(entry_jsons);
+        const auto entry_object_us = TimeUs([&]() {
+            for(const auto &json: entry_jsons) {
+                EntryFields fields;
+                LoadEntryFieldsWithObject(json, fields);
+            }
+        }) / std::size(entry_jsons);
+
+        const auto big_json = MakeBigDocument();
+        std::string name;
+        std::string author;
+        const util::JsonField manifest_fields[] = {
+            util::MakeJsonField("name", name),
+            util::MakeJsonField("author", author)
+        };
+        const auto big_fields_us = TimeUs([&]() {
+            util::LoadJSONFieldsFromBuffer(big_json.data(), big_json.size(), manifest_fields, std::size(manifest_fields));
+        });
+        TEST_CHECK((name == "Theme") && (author == "Someone"));
+        const auto big_object_us = TimeUs([&]() {
+            const auto doc = JSON::parse(big_json);
+            name = doc.value("name", "");
+            author = doc.value("author", "");
+        });
+
+        printf("Entry JSONs: fields %.2f us, whole object %.2f us; 0x%zX-byte document, 2 leading keys: fields %.2f us, whole object %.2f us\n", entry_fields_us, entry_object_us, big_json.size(), big_fields_us, big_object_us);
+    }
+
+}
+
+int main() {
+    TestFieldTypes();
+    TestWrongTypeValues();
+    TestEarlyStop();
+    TestInvalidDocuments();
+    BenchmarkFieldPicking();
+
+    return test::Finish("util_JsonFieldsTest");
+}
@@ -0,0 +1,156 @@
+#include <test_Common.hpp>
+#include <util/util_SpscRing.hpp>
+#include <dmi/dmi_DaemonMenuInteraction.hpp>
+#include <thread>
+
+// SpscRing stress test (one producer thread, one consumer thread) plus a throughput benchmark
+// Uses uDaemon's element type and capacity (menu messages, 32 slots)
+
+namespace {
+
+    constexpr size_t RingCapacity = 32;
+    using MessageRing = util::SpscRing<dmi::MenuMessageContext, RingCapacity>;
+
+    inline dmi::MenuMessageContext MakeMessage(const u32 seq) {
+        dmi::MenuMessageContext msg_ctx = {
+            .msg = dmi::MenuMessage::ApplicationExited,
+            .seq = seq
+        };
+        msg_ctx.app_exited.app_id = 0x0100000000000000 | seq;
+        return msg_ctx;
+    }
+
+    struct ConsumerResult {
+        u32 received_count;
+        u32 order_error_count;
+        u32 corrupt_count;
+    };
+
+    // Pops (in batches, like the IPC side does) until every message got received
+    ConsumerResult ConsumeMessages(MessageRing &ring, const u32 msg_count) {
+        ConsumerResult result = {};
+        dmi::MenuMessageContext msg_ctxs[dmi::MaxMenuMessageBatchCount];
+        u32 expected_seq = 0;
+        while(result.received_count < msg_count) {
+            const auto count = ring.PopMany(msg_ctxs, dmi::MaxMenuMessageBatchCount);
+            for(size_t i = 0; i < count; i++) {
+                const auto &msg_ctx = msg_ctxs[i];
+                if(msg_ctx.seq != expected_seq) {
+                    result.order_error_count++;
+                }
+                if((msg_ctx.msg != dmi::MenuMessage::ApplicationExited) || (msg_ctx.app_exited.app_id != (0x0100000000000000 | msg_ctx.seq))) {
+                    result.corrupt_count++;
+                }
+                expected_seq = msg_ctx.seq + 1;
+                result.received_count++;
+            }
+            if(count == 0) {
+                std::this_thread::yield();
+            }
+        }
+        return result;
+    }
+
+    void TestSingleThreadOverflow() {
+        MessageRing ring;
+        for(u32 i = 0; i < RingCapacity; i++) {
+            TEST_CHECK(ring.TryPush(MakeMessage(i)));
+        }
+        TEST_CHECK(ring.GetCount() == RingCapacity);
+
+        // Full: new messages get dropped and accounted, queued ones are kept
+        TEST_CHECK(!ring.TryPush(MakeMessage(1000)));
+        TEST_CHECK(!ring.TryPush(MakeMessage(1001)));
+        TEST_CHECK(ring.GetOverflowCount() == 2);
+
+        dmi::MenuMessageContext msg_ctx;
+        for(u32 i = 0; i < RingCapacity; i++) {
+            TEST_CHECK(ring.TryPop(msg_ctx));
+            TEST_CHECK(msg_ctx.seq == i);
+        }
+        TEST_CHECK(!ring.TryPop(msg_ctx));
+
+        // Indexes keep going past the capacity
+        TEST_CHECK(ring.TryPush(MakeMessage(5)));
+        TEST_CHECK(ring.GetCount() == 1);
+        ring.Clear();
+        TEST_CHECK(ring.GetCount() == 0);
+        TEST_CHECK(!ring.TryPop(msg_ctx));
+    }
+
+    void TestStressBelowCapacity() {
+        // The producer never pushes more than the consumer left room for, hence nothing may get dropped
+        constexpr u32 MessageCount = 2'000'000;
+        MessageRing ring;
+
+        std::thread producer([&]() {
+            for(u32 i = 0; i < MessageCount; i++) {
+                while(ring.GetCount() == RingCapacity) {
+                    std::this_thread::yield();
+                }
+                TEST_CHECK(ring.TryPush(MakeMessage(i)));
+            }
+        });
+        const auto result = ConsumeMessages(ring, MessageCount);
+        producer.join();
+
+        TEST_CHECK(result.received_count == MessageCount);
+        TEST_CHECK(result.order_error_count == 0);
+        TEST_CHECK(result.corrupt_count == 0);
+        TEST_CHECK(ring.GetOverflowCount() == 0);
+        TEST_CHECK(ring.GetCount() == 0);
+    }
+
+    void TestStressRetryOnOverflow() {
+        // Pushing blindly into a full ring: failed pushes are only accounted, retrying them still delivers everything in order
+        constexpr u32 MessageCount = 2'000'000;
+        MessageRing ring;
+
+        u64 failed_push_count = 0;
+        std::thread producer([&]() {
+            for(u32 i = 0; i < MessageCount; i++) {
+                while(!ring.TryPush(MakeMessage(i))) {
+                    failed_push_count++;
+                    std::this_thread::yield();
+                }
+            }
+        });
+        const auto result = ConsumeMessages(ring, MessageCount);
+        producer.join();
+
+        TEST_CHECK(result.received_count == MessageCount);
+        TEST_CHECK(result.order_error_count == 0);
+        TEST_CHECK(result.corrupt_count == 0);
+        TEST_CHECK(ring.GetOverflowCount() == failed_push_count);
+    }
+
+    void BenchmarkThroughput() {
+        constexpr u32 MessageCount = 10'000'000;
+        MessageRing ring;
+
+        const auto start_ns = test::GetCurrentNs();
+        std::thread producer([&]() {
+            for(u32 i = 0; i < MessageCount; i++) {
+                while(!ring.TryPush(MakeMessage(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        const auto result = ConsumeMessages(ring, MessageCount);
+        producer.join();
+        const auto elapsed_ns = test::GetCurrentNs() - start_ns;
+
+        TEST_CHECK(result.order_error_count == 0);
+        printf("%u messages (0x%zX bytes each) through a %zu-slot ring: %.1f M messages/s, %.1f ns per message\n", MessageCount, sizeof(dmi::MenuMessageContext), RingCapacity, static_cast<double>(MessageCount) * 1000.0 / elapsed_ns, static_cast<double>(elapsed_ns) / MessageCount);
+    }
+
+}
+
+int main() {
+    TestSingleThreadOverflow();
+    TestStressBelowCapacity();
+    TestStressRetryOnOverflow();
+    BenchmarkThroughput();
+
+    return test::Finish("util_SpscRingTest");
+}
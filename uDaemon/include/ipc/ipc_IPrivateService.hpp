@@ -6,7 +6,11 @@
 
 #define IPC_I_PRIVATE_SERVICE_INTERFACE_INFO(C, H) \
     AMS_SF_METHOD_INFO(C, H, 0, Result, Initialize, (const ClientProcessId &client_pid), (client_pid)) \
-    AMS_SF_METHOD_INFO(C, H, 1, Result, GetMessage, (Out<dmi::MenuMessage> out_msg), (out_msg))
+    AMS_SF_METHOD_INFO(C, H, 1, Result, GetMessage, (Out<dmi::MenuMessage> out_msg), (out_msg)) \
+    AMS_SF_METHOD_INFO(C, H, 2, Result, GetMessageEvent, (OutCopyHandle out_event_h), (out_event_h)) \
+    AMS_SF_METHOD_INFO(C, H, 3, Result, GetMessages, (const OutMapAliasArray<dmi::MenuMessageContext> &out_msg_ctxs, Out<u32> out_count), (out_msg_ctxs, out_count)) \
+    AMS_SF_METHOD_INFO(C, H, 4, Result, GetHeapStats, (Out<dmi::DaemonHeapStats> out_stats), (out_stats)) \
+    AMS_SF_METHOD_INFO(C, H, 5, Result, GetMenuMessageStats, (Out<dmi::MenuMessageStats> out_stats), (out_stats))
 
 AMS_SF_DEFINE_INTERFACE(ams::sf::ul, IPrivateService, IPC_I_PRIVATE_SERVICE_INTERFACE_INFO, 0xCAFEBABE)
 
@@ -20,6 +24,10 @@ namespace ipc {
 
             ams::Result Initialize(const ams::sf::ClientProcessId &client_pid);
             ams::Result GetMessage(ams::sf::Out<dmi::MenuMessage> out_msg);
+            ams::Result GetMessageEvent(ams::sf::OutCopyHandle out_event_h);
+            ams::Result GetMessages(const ams::sf::OutMapAliasArray<dmi::MenuMessageContext> &out_msg_ctxs, ams::sf::Out<u32> out_count);
+            ams::Result GetHeapStats(ams::sf::Out<dmi::DaemonHeapStats> out_stats);
+            ams::Result GetMenuMessageStats(ams::sf::Out<dmi::MenuMessageStats> out_stats);
     };
     static_assert(ams::sf::ul::IsIPrivateService<PrivateService>);
 
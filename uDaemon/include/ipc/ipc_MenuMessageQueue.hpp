@@ -0,0 +1,25 @@
+
+#pragma once
+#include <stratosphere.hpp>
+#include <dmi/dmi_DaemonMenuInteraction.hpp>
+#include <util/util_SpscRing.hpp>
+
+namespace ipc {
+
+    // Messages for uMenu are queued here by the main thread (the only producer), and popped by uMenu through the private service (from the IPC manager thread, the only consumer)
+
+    constexpr size_t MenuMessageQueueCapacity = 32;
+
+    void InitializeMenuMessageQueue();
+
+    // If the queue is full the new message gets dropped (the sequence number is still consumed, so uMenu can notice the gap)
+    void PushMenuMessage(const dmi::MenuMessage msg);
+    void PushMenuMessage(const dmi::MenuMessageContext &msg_ctx);
+
+    size_t PopMenuMessages(dmi::MenuMessageContext *out_msg_ctxs, const size_t max_count);
+    void ClearMenuMessages();
+
+    ams::os::NativeHandle GetMenuMessageEventHandle();
+    void GetMenuMessageStats(dmi::MenuMessageStats &out_stats);
+
+}
\ No newline at end of file
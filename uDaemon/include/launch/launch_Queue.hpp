@@ -0,0 +1,122 @@
+
+#pragma once
+#include <ul_Include.hpp>
+#include <dmi/dmi_DaemonMenuInteraction.hpp>
+
+namespace launch {
+
+    enum class RequestKind : u32 {
+        Application,
+        HomebrewApplication,
+        HomebrewApplet,
+        WebApplet,
+        AlbumApplet,
+        MenuRestart
+    };
+
+    // Queued -> WaitingForAppletExit -> Launching -> Running -> Exited, or Failed if the launch itself fails
+    enum class RequestState : u32 {
+        Queued,
+        WaitingForAppletExit,
+        Launching,
+        Running,
+        Exited,
+        Failed,
+
+        Count
+    };
+
+    constexpr size_t RequestStateCount = static_cast<size_t>(RequestState::Count);
+
+    struct Request {
+        u32 id;
+        RequestKind kind;
+        RequestState state;
+        u64 app_id;
+        hb::HbTargetParams hb_params;
+        // Only the URL: the whole web applet config is way bigger, and gets built right before launching
+        char web_url[dmi::MaxWebPageUrlLength];
+        // Tick at which each state was entered (0 if it was never reached)
+        u64 state_ticks[RequestStateCount];
+        // Tick at which the launched target was first seen active
+        u64 target_active_tick;
+        bool target_seen_active;
+        // Applet instance started by the launch (see Backend), to tell it apart from applets opened after it
+        u32 applet_instance_id;
+        dmi::LaunchTrace trace;
+        Result launch_rc;
+
+        inline bool IsApplication() const {
+            return (this->kind == RequestKind::Application) || (this->kind == RequestKind::HomebrewApplication);
+        }
+
+        inline bool IsPending() const {
+            return (this->state == RequestState::Queued) || (this->state == RequestState::WaitingForAppletExit) || (this->state == RequestState::Launching);
+        }
+
+        inline bool IsFinished() const {
+            return (this->state == RequestState::Exited) || (this->state == RequestState::Failed);
+        }
+
+        inline u64 GetStateTick(const RequestState state) const {
+            return this->state_ticks[static_cast<size_t>(state)];
+        }
+    };
+
+    Request MakeApplicationRequest(const u64 app_id);
+    Request MakeHomebrewApplicationRequest(const u64 app_id, const hb::HbTargetParams &params);
+    Request MakeHomebrewAppletRequest(const hb::HbTargetParams &params);
+    Request MakeWebAppletRequest(const char *url);
+    Request MakeAlbumAppletRequest();
+    Request MakeMenuRestartRequest();
+
+    // Everything the queue needs from the system goes through here, so that the state machine can be driven by fake backends outside of the console
+    struct Backend {
+        bool (*is_applet_active)();
+        // Identifies the last started applet (increasing with every start), since uMenu is reopened as soon as a launched applet exits and "some applet is active" isn't enough to track it
+        u32 (*get_applet_instance_id)();
+        bool (*is_application_active)();
+        Result (*launch)(const Request &req);
+        u64 (*get_tick)();
+        // Optional, called once when a launched request's target is first seen active
+        void (*on_target_active)(const Request &req);
+    };
+
+    constexpr size_t MaxPendingRequestCount = 8;
+    constexpr size_t MaxTrackedRequestCount = 8;
+
+    class LaunchQueue {
+        private:
+            Backend backend;
+            Request pending_reqs[MaxPendingRequestCount];
+            size_t pending_count;
+            // Launched requests stay here until they exit (or get evicted by newer ones), keeping their timestamps around
+            Request tracked_reqs[MaxTrackedRequestCount];
+            size_t tracked_count;
+            u32 next_id;
+
+            void SetState(Request &req, const RequestState state);
+            bool IsTargetActive(const Request &req);
+            bool IsTargetReplaced(const Request &req);
+            void Track(const Request &req);
+            void PopFront();
+
+        public:
+            LaunchQueue(const Backend &backend) : backend(backend), pending_reqs(), pending_count(0), tracked_reqs(), tracked_count(0), next_id(1) {}
+
+            // Only one application launch can be pending at a time, applets queue up behind each other
+            Result Enqueue(const Request &req, u32 *out_id = nullptr);
+
+            // Drives the transitions of the front request and of the launched ones, returns whether something got launched
+            bool Update(Request *out_launched_req = nullptr);
+
+            bool HasPendingApplication() const;
+
+            inline size_t GetPendingCount() const {
+                return this->pending_count;
+            }
+
+            bool FindRequest(const u32 id, Request &out_req) const;
+    };
+
+}
\ No newline at end of file
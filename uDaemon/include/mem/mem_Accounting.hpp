@@ -0,0 +1,39 @@
+
+#pragma once
+#include <dmi/dmi_DaemonMenuInteraction.hpp>
+#include <atomic>
+
+namespace mem {
+
+    using Tag = dmi::DaemonHeapTag;
+
+    // Current/peak sizes and allocation counts per tag, safe to update from any thread
+    // It only does the bookkeeping (no actual allocations), so that it can be checked on its own outside of the console
+
+    class HeapAccounting {
+        private:
+            struct TagCounters {
+                std::atomic<u64> cur_size;
+                std::atomic<u64> peak_size;
+                std::atomic<u32> alloc_count;
+                std::atomic<u32> free_count;
+            };
+
+            TagCounters tag_counters[dmi::DaemonHeapTagCount];
+
+            static void UpdatePeak(std::atomic<u64> &peak, const u64 value);
+
+        public:
+            constexpr HeapAccounting() : tag_counters() {}
+
+            void OnAllocate(const Tag tag, const size_t size);
+            void OnFree(const Tag tag, const size_t size);
+
+            // For memory we can't follow allocation by allocation (it's attributed as a whole, and can grow or shrink)
+            void OnExternalUsage(const Tag tag, const s64 size_delta);
+
+            u64 GetTotalSize() const;
+            void GetTagStats(dmi::DaemonHeapTagStats (&out_stats)[dmi::DaemonHeapTagCount]) const;
+    };
+
+}
\ No newline at end of file
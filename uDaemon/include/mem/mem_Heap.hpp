@@ -0,0 +1,88 @@
+
+#pragma once
+#include <mem/mem_Accounting.hpp>
+
+namespace mem {
+
+    // Tracked allocations on top of the global heap: small ones come from a fixed block pool, the rest from the heap itself (with a small header)
+
+    constexpr size_t SmallBlockSize = 0x80;
+    constexpr size_t SmallBlockCount = 0x80;
+
+    // Placed right before the returned pointer of heap allocations, the allocation itself starts offset bytes before that pointer
+    struct AllocationHeader {
+        static constexpr u16 Magic = 0x4C55; // "UL"
+
+        u32 size;
+        u32 offset; // From the actual allocation start
+        u16 magic;
+        u16 tag;
+        u32 reserved;
+    };
+    static_assert(sizeof(AllocationHeader) == alignof(std::max_align_t));
+
+    void Initialize(const size_t heap_size);
+
+    void *Allocate(const Tag tag, const size_t size);
+    void *AllocateAligned(const Tag tag, const size_t align, const size_t size);
+    void Free(void *ptr);
+
+    // Samples the actual usage of the whole heap, updating its peak
+    // It locks the allocator, so it's only done periodically (main loop, viewer frames, stats requests) instead of on every allocation
+    void UpdateHeapUsage();
+
+    void GetHeapStats(dmi::DaemonHeapStats &out_stats);
+
+    // Attributes whatever the heap grows/shrinks during its lifetime to the tag, for code we don't control the allocations of
+    // Tracked allocations (already accounted to their own tags) and nested attributions (accounted to theirs) are left out
+    // Only meaningful when no other thread is allocating meanwhile (like when loading things at startup)
+    class ScopedHeapAttribution {
+        private:
+            Tag tag;
+            u64 start_used_size;
+            u64 start_tracked_size;
+            s64 nested_size_delta;
+            ScopedHeapAttribution *parent;
+
+        public:
+            ScopedHeapAttribution(const Tag tag);
+            ~ScopedHeapAttribution();
+    };
+
+    // STL-compatible allocator (for containers, std::allocate_shared...) going through the tracked allocations
+    template<typename T, Tag AllocTag>
+    struct TaggedAllocator {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = TaggedAllocator<U, AllocTag>;
+        };
+
+        constexpr TaggedAllocator() = default;
+
+        template<typename U>
+        constexpr TaggedAllocator(const TaggedAllocator<U, AllocTag>&) {}
+
+        T *allocate(const size_t count) {
+            auto ptr = AllocateAligned(AllocTag, alignof(T), count * sizeof(T));
+            UL_ASSERT_TRUE(ptr != nullptr);
+            return reinterpret_cast<T*>(ptr);
+        }
+
+        void deallocate(T *ptr, const size_t) {
+            Free(ptr);
+        }
+
+        template<typename U>
+        constexpr bool operator==(const TaggedAllocator<U, AllocTag>&) const {
+            return true;
+        }
+
+        template<typename U>
+        constexpr bool operator!=(const TaggedAllocator<U, AllocTag>&) const {
+            return false;
+        }
+    };
+
+}
\ No newline at end of file
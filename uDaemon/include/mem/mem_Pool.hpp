@@ -0,0 +1,77 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace mem {
+
+    // Fixed-size block pool over static storage, for small objects which would otherwise be constantly allocated/freed from the heap
+    // Not synchronized, callers must lock if used from several threads
+
+    template<size_t BlockSize, size_t BlockCount>
+    class FixedPool {
+        static_assert((BlockSize > 0) && ((BlockSize % alignof(std::max_align_t)) == 0), "Blocks must keep the maximum alignment");
+        static_assert(BlockCount <= UINT16_MAX, "Block indexes must fit in a u16");
+
+        private:
+            static constexpr u16 InvalidIndex = UINT16_MAX;
+
+            alignas(std::max_align_t) u8 storage[BlockSize * BlockCount];
+            u16 next_free_idxs[BlockCount];
+            u16 free_head_idx;
+            size_t used_count;
+            size_t peak_used_count;
+
+        public:
+            constexpr FixedPool() : storage(), next_free_idxs(), free_head_idx(0), used_count(0), peak_used_count(0) {
+                for(size_t i = 0; i < BlockCount; i++) {
+                    this->next_free_idxs[i] = ((i + 1) < BlockCount) ? static_cast<u16>(i + 1) : InvalidIndex;
+                }
+            }
+
+            // Returns nullptr when all blocks are in use
+            void *Allocate() {
+                if(this->free_head_idx == InvalidIndex) {
+                    return nullptr;
+                }
+
+                const auto idx = this->free_head_idx;
+                this->free_head_idx = this->next_free_idxs[idx];
+                this->used_count++;
+                this->peak_used_count = std::max(this->peak_used_count, this->used_count);
+                return this->storage + idx * BlockSize;
+            }
+
+            void Free(void *ptr) {
+                const auto idx = static_cast<u16>(this->GetBlockIndex(ptr));
+                this->next_free_idxs[idx] = this->free_head_idx;
+                this->free_head_idx = idx;
+                this->used_count--;
+            }
+
+            inline bool Contains(const void *ptr) const {
+                const auto ptr_u8 = reinterpret_cast<const u8*>(ptr);
+                return (ptr_u8 >= this->storage) && (ptr_u8 < (this->storage + sizeof(this->storage)));
+            }
+
+            inline size_t GetBlockIndex(const void *ptr) const {
+                return static_cast<size_t>(reinterpret_cast<const u8*>(ptr) - this->storage) / BlockSize;
+            }
+
+            inline size_t GetUsedCount() const {
+                return this->used_count;
+            }
+
+            inline size_t GetPeakUsedCount() const {
+                return this->peak_used_count;
+            }
+
+            static constexpr size_t GetBlockSize() {
+                return BlockSize;
+            }
+
+            static constexpr size_t GetBlockCount() {
+                return BlockCount;
+            }
+    };
+
+}
\ No newline at end of file
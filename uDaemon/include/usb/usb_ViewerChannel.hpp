@@ -0,0 +1,38 @@
+
+#pragma once
+#include <usb/usb_ViewerProtocol.hpp>
+
+namespace usb {
+
+    u32 ComputeCrc32(const void *data, const size_t size, const u32 crc = 0);
+
+    // Covers every header field before the CRC itself
+    inline u32 ComputeViewerHeaderCrc32(const ViewerPacketHeader &header) {
+        return ComputeCrc32(&header, offsetof(ViewerPacketHeader, header_crc));
+    }
+
+    // Everything the channel needs from the link goes through here, so that it can also run outside of the console (like the host tests' loopback)
+    // The daemon only ever writes, reading (and validating) packets is up to the viewer
+    struct ViewerTransport {
+        void *user_data;
+        // Each call is a single transfer
+        bool (*write)(void *user_data, const void *data, const size_t size);
+    };
+
+    class ViewerChannel {
+        private:
+            ViewerTransport transport;
+            u32 next_seqs[ViewerStreamCount];
+
+        public:
+            ViewerChannel(const ViewerTransport &transport) : transport(transport), next_seqs() {}
+
+            // Sequence numbers start over for every new viewer
+            inline void Reset() {
+                memset(this->next_seqs, 0, sizeof(this->next_seqs));
+            }
+
+            bool Send(const ViewerStreamId stream_id, const u16 type, const void *payload, const size_t payload_size);
+    };
+
+}
\ No newline at end of file
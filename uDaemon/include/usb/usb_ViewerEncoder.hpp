@@ -0,0 +1,111 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace usb {
+
+    // Only available to viewers using protocol version 1 or later, legacy viewers always get the raw frame
+
+    enum class ViewerRgbaKernel : u32 {
+        Scalar,
+        Vector // GCC vector extensions (NEON on the console)
+    };
+
+    struct ViewerRgbaEncoderConfig {
+        u32 downscale_shift; // 0: full resolution, 1: half, 2: quarter
+        bool delta_enabled;
+        bool rle_enabled;
+        ViewerRgbaKernel kernel;
+    };
+
+    constexpr u32 ViewerRgbaMaxDownscaleShift = 2;
+
+    // What had to be given up for the encoder buffers to fit in the available memory
+    enum class ViewerRgbaEncoderFallback : u8 {
+        None,
+        Downscaled, // Downscale raised above the configured one
+        DeltaDisabled, // Even at the maximum downscale, delta frames didn't fit
+        PlainFrames // No encoder at all, plain RGBA frames are sent
+    };
+    constexpr u32 ViewerRgbaTileSize = 16;
+
+    enum ViewerEncodedRgbaFlags : u8 {
+        ViewerEncodedRgbaFlags_Keyframe = BIT(0),
+        ViewerEncodedRgbaFlags_Rle = BIT(1)
+    };
+
+    // Encoded frame payload: this header, a bitmap with a bit per tile (row-major, set if the tile is included) and the included tiles' pixels, in order
+    // Tiles on the right/bottom edges are clipped to the frame size
+    // With RLE, each tile's pixels are compressed on their own: a control byte with the high bit set is a run of ((ctrl & 0x7F) + 1) copies of the next pixel, otherwise ((ctrl & 0x7F) + 1) literal pixels follow
+    struct ViewerEncodedRgbaHeader {
+        u16 width;
+        u16 height;
+        u16 tile_size;
+        u8 flags;
+        u8 reserved;
+        u32 included_tile_count;
+        u32 tile_data_size;
+    };
+    static_assert(sizeof(ViewerEncodedRgbaHeader) == 0x10);
+
+    // Kernels, both variants must produce identical results
+
+    // Halves the frame dimensions in place, averaging 2x2 blocks
+    void DownscaleHalfScalar(u32 *pixels, const u32 width, const u32 height);
+    void DownscaleHalfVector(u32 *pixels, const u32 width, const u32 height);
+
+    bool TileRowEqualsScalar(const u32 *a, const u32 *b, const u32 count);
+    bool TileRowEqualsVector(const u32 *a, const u32 *b, const u32 count);
+
+    size_t EncodeRle(const u32 *pixels, const size_t count, u8 *out);
+    // Returns the decoded pixel count, or 0 if the data is malformed
+    size_t DecodeRle(const u8 *data, const size_t data_size, u32 *out_pixels, const size_t max_count);
+
+    class ViewerRgbaEncoder {
+        private:
+            ViewerRgbaEncoderConfig cfg;
+            u32 width;
+            u32 height;
+            u32 tiles_x;
+            u32 tiles_y;
+            u32 *prev_frame;
+            bool has_prev_frame;
+            u8 *out_buf;
+            size_t out_buf_size;
+            u32 tile_scratch[ViewerRgbaTileSize * ViewerRgbaTileSize];
+
+            bool IsTileChanged(const u32 *frame, const u32 tile_x, const u32 tile_y) const;
+            u32 GatherTile(const u32 *frame, const u32 tile_x, const u32 tile_y);
+            void StoreTile(const u32 *frame, const u32 tile_x, const u32 tile_y);
+
+        public:
+            ViewerRgbaEncoder() : cfg(), width(0), height(0), tiles_x(0), tiles_y(0), prev_frame(nullptr), has_prev_frame(false), out_buf(nullptr), out_buf_size(0), tile_scratch() {}
+
+            ~ViewerRgbaEncoder() {
+                this->Finalize();
+            }
+
+            // Memory the buffers take with the given configuration
+            static size_t GetRequiredMemorySize(const ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height);
+
+            // Adjusts the configuration (downscale first, then delta) until the buffers take at most the given size
+            static ViewerRgbaEncoderFallback FitConfigToMemory(ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height, const size_t available_size);
+
+            // Fails if the buffers can't be allocated
+            bool Initialize(const ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height);
+            void Finalize();
+
+            // Downscales the frame (in place) and encodes it into the output buffer, returning the encoded size
+            size_t Encode(u32 *frame);
+
+            inline const u8 *GetOutput() const {
+                return this->out_buf;
+            }
+
+            // Next frame gets sent whole (for instance, after a viewer reconnects)
+            inline void RequestKeyframe() {
+                this->has_prev_frame = false;
+            }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace usb {
+
+    // Legacy viewers (version 0) never send a handshake: every packet is the mode (u32) followed by a whole RGBA screen buffer, even for JPEG captures
+    // Newer viewers send a handshake with the highest version they support, after which every frame is sent as a header plus only the payload bytes
+    // From version 2 onwards, the link is multiplexed into streams (frames, telemetry...) of packets with their own sequence numbers and CRCs
+    // Every new USB connection starts over as legacy, since the viewer on the other end may not be the one which did the last handshake
+
+    constexpr u32 ViewerLegacyProtocolVersion = 0;
+    constexpr u32 ViewerFrameProtocolVersion = 1;
+    constexpr u32 ViewerMuxProtocolVersion = 2;
+    constexpr u32 ViewerProtocolVersion = ViewerMuxProtocolVersion;
+
+    // The mode (u32) plus a whole RGBA screen buffer, whatever the actual payload is
+    constexpr size_t ViewerLegacyPacketSize = sizeof(u32) + PlainRgbaScreenBufferSize;
+
+    struct ViewerHandshake {
+        static constexpr u32 Magic = 0x57564C55; // "ULVW"
+
+        u32 magic;
+        u32 version;
+    };
+    static_assert(sizeof(ViewerHandshake) == 0x8);
+
+    // Sent as its own transfer, the payload follows as a second one
+    struct ViewerFrameHeader {
+        static constexpr u32 Magic = 0x46564C55; // "ULVF"
+
+        u32 magic;
+        u16 version;
+        u16 mode;
+        u32 seq;
+        u32 payload_size;
+    };
+    static_assert(sizeof(ViewerFrameHeader) == 0x10);
+
+    inline constexpr ViewerFrameHeader MakeViewerFrameHeader(const u32 version, const u16 mode, const u32 seq, const size_t payload_size) {
+        return {
+            .magic = ViewerFrameHeader::Magic,
+            .version = static_cast<u16>(version),
+            .mode = mode,
+            .seq = seq,
+            .payload_size = static_cast<u32>(payload_size)
+        };
+    }
+
+    enum class ViewerStreamId : u8 {
+        Frame,
+        Telemetry,
+
+        Count
+    };
+
+    constexpr size_t ViewerStreamCount = static_cast<size_t>(ViewerStreamId::Count);
+
+    // Sent as its own transfer, the payload follows as a second one (if not empty)
+    struct ViewerPacketHeader {
+        static constexpr u32 Magic = 0x584D4C55; // "ULMX"
+
+        u32 magic;
+        u8 version;
+        u8 stream_id;
+        u16 type; // Frame stream: the frame mode, telemetry stream: the record type
+        u32 seq; // Increases per stream
+        u32 payload_size;
+        u32 payload_crc;
+        u32 header_crc; // Covers all the previous fields
+    };
+    static_assert(sizeof(ViewerPacketHeader) == 0x18);
+
+    inline constexpr u32 NegotiateViewerProtocolVersion(const ViewerHandshake &handshake) {
+        if(handshake.magic != ViewerHandshake::Magic) {
+            return ViewerLegacyProtocolVersion;
+        }
+        return std::min(handshake.version, ViewerProtocolVersion);
+    }
+
+    // Bytes a single frame takes on the link with the given protocol version
+    inline constexpr size_t GetViewerFrameTransferSize(const u32 version, const size_t payload_size) {
+        if(version == ViewerLegacyProtocolVersion) {
+            return ViewerLegacyPacketSize;
+        }
+        if(version >= ViewerMuxProtocolVersion) {
+            return sizeof(ViewerPacketHeader) + payload_size;
+        }
+        return sizeof(ViewerFrameHeader) + payload_size;
+    }
+
+}
\ No newline at end of file
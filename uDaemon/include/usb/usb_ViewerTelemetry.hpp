@@ -0,0 +1,58 @@
+
+#pragma once
+#include <usb/usb_ViewerChannel.hpp>
+#include <usb/usb_ViewerEncoder.hpp>
+#include <os/os_LaunchLatency.hpp>
+
+namespace usb {
+
+    // Record types of the telemetry stream
+
+    enum class ViewerTelemetryType : u16 {
+        Snapshot,
+        LaunchLatency
+    };
+
+    // Everything accumulated since the previous snapshot
+    struct ViewerTelemetrySnapshot {
+        u32 interval_ms;
+        u32 main_loop_wakeup_count;
+        u64 heap_used_size;
+        u64 heap_peak_used_size;
+        u32 frame_count;
+        u32 frame_bytes;
+        u32 avg_capture_us;
+        u32 max_capture_us;
+        u32 avg_encode_us;
+        u32 max_encode_us;
+        u32 dropped_launch_latency_count;
+        ViewerRgbaEncoderFallback rgba_encoder_fallback;
+        u8 rgba_downscale_shift; // The one actually in use
+        u8 reserved[2];
+    };
+    static_assert(sizeof(ViewerTelemetrySnapshot) == 0x38);
+
+    struct ViewerTelemetryLaunchLatency {
+        os::LaunchTitleType type;
+        os::LaunchLatencySample sample;
+    };
+    static_assert(sizeof(ViewerTelemetryLaunchLatency) == 0x20);
+
+    constexpr u64 ViewerTelemetryIntervalMs = 1000;
+
+    // Main thread side
+
+    void NotifyMainLoopWakeup();
+    void NotifyLaunchLatency(const os::LaunchTitleType type, const os::LaunchLatencySample &sample);
+
+    // Set once, before the viewer thread is started
+    void NotifyRgbaEncoderFallback(const ViewerRgbaEncoderFallback fallback, const u32 downscale_shift);
+
+    // Viewer thread side
+
+    void NotifyFrameTimings(const u64 capture_ticks, const u64 encode_ticks, const size_t frame_size);
+
+    // Sends any pending launch latencies, and a snapshot once every interval
+    void FlushTelemetry(ViewerChannel &channel);
+
+}
\ No newline at end of file
@@ -1,10 +1,17 @@
 #include <ecs/ecs_ExternalContent.hpp>
 #include <ipc/ipc_Manager.hpp>
+#include <ipc/ipc_MenuMessageQueue.hpp>
+#include <launch/launch_Queue.hpp>
+#include <mem/mem_Heap.hpp>
+#include <usb/usb_ViewerProtocol.hpp>
+#include <usb/usb_ViewerEncoder.hpp>
+#include <usb/usb_ViewerTelemetry.hpp>
 #include <db/db_Save.hpp>
 #include <os/os_Titles.hpp>
 #include <os/os_HomeMenu.hpp>
 #include <os/os_Account.hpp>
 #include <os/os_Misc.hpp>
+#include <os/os_LaunchLatency.hpp>
 #include <fs/fs_Stdio.hpp>
 #include <am/am_Application.hpp>
 #include <am/am_LibraryApplet.hpp>
@@ -23,42 +30,33 @@ extern "C" {
     // (by default that operator internally calls _memalign_r, which isn't redefined by ams either, so it leads to crashes)
 
     void *__libnx_alloc(size_t size) {
-        return malloc(size);
+        return mem::Allocate(mem::Tag::Other, size);
     }
 
     void *__libnx_aligned_alloc(size_t align, size_t size) {
-        return aligned_alloc(align, size);
+        return mem::AllocateAligned(mem::Tag::Other, align, size);
     }
 
     void __libnx_free(void *ptr) {
-        return free(ptr);
+        return mem::Free(ptr);
     }
 
 }
 
-// Note: these are placed outside of an anonymous namespace since they are accessed by IPC
-
-ams::os::Mutex g_LastMenuMessageLock(false);
-dmi::MenuMessage g_LastMenuMessage = dmi::MenuMessage::Invalid;
-
 namespace {
 
     enum class UsbMode : u32 {
         Invalid,
         PlainRgba,
-        Jpeg
+        Jpeg,
+        EncodedRgba // Only sent with protocol version 1 or later
     };
 
     AccountUid g_SelectedUser = {};
-    hb::HbTargetParams g_HbTargetLaunchFlag = {};
-    hb::HbTargetParams g_HbTargetApplicationLaunchFlag = {};
-    hb::HbTargetParams g_HbTargetApplicationLaunchFlagCopy = {};
-    u64 g_ApplicationLaunchFlag = 0;
-    WebCommonConfig g_WebAppletLaunchFlag = {};
-    bool g_AlbumAppletLaunchFlag = false;
-    bool g_MenuRestartFlag = false;
+    hb::HbTargetParams g_HbTargetApplicationParams = {};
     bool g_HbTargetOpenedAsApplication = false;
     bool g_AppletActive = false;
+    bool g_ApplicationActive = false;
     AppletOperationMode g_OperationMode;
     u8 *g_UsbViewerBuffer = nullptr;
     u8 *g_UsbViewerReadBuffer = nullptr;
@@ -67,15 +65,31 @@ namespace {
     constexpr size_t UsbViewerThreadStackSize = 16_KB;
     ams::os::ThreadType g_UsbViewerThread;
     alignas(ams::os::ThreadStackAlignment) u8 g_UsbViewerThreadStack[UsbViewerThreadStackSize];
+
+    constexpr size_t UsbViewerHandshakeThreadStackSize = 4_KB;
+    ams::os::ThreadType g_UsbViewerHandshakeThread;
+    alignas(ams::os::ThreadStackAlignment) u8 g_UsbViewerHandshakeThreadStack[UsbViewerHandshakeThreadStackSize];
     
     UsbMode g_UsbViewerMode = UsbMode::Invalid;
+    // Stays at the legacy version until a viewer sends a handshake
+    std::atomic<u32> g_UsbViewerProtocolVersion = usb::ViewerLegacyProtocolVersion;
+    std::atomic_bool g_UsbViewerHandshakeReceived = false;
+    bool g_UsbViewerConnected = false;
+    u32 g_UsbViewerFrameSequence = 0;
+    usb::ViewerRgbaEncoder g_UsbViewerRgbaEncoder;
+    bool g_UsbViewerRgbaEncodingEnabled = false;
     SetSysFirmwareVersion g_FwVersion = {};
 
     // In the USB packet, the first u32 stores the USB mode (plain RGBA or JPEG, depending on what the console supports)
 
     constexpr size_t UsbPacketSize = PlainRgbaScreenBufferSize + sizeof(UsbMode);
+    static_assert(UsbPacketSize == usb::ViewerLegacyPacketSize);
+    constexpr u32 UsbViewerScreenWidth = 1280;
+    constexpr u32 UsbViewerScreenHeight = 720;
 
     constexpr size_t HeapSize = 10_MB;
+    // Left free for the rest of the daemon when sizing the USB viewer encoder buffers
+    constexpr size_t UsbViewerHeapReserveSize = 1_MB;
     alignas(ams::os::MemoryPageSize) constinit u8 g_HeapBuffer[HeapSize];
 
 }
@@ -92,7 +106,7 @@ namespace {
         if(am::ApplicationIsActive()) {
             if(g_HbTargetOpenedAsApplication) {
                 // Homebrew
-                status.params = g_HbTargetApplicationLaunchFlagCopy;
+                status.params = g_HbTargetApplicationParams;
             }
             else {
                 // Regular title
@@ -111,6 +125,92 @@ namespace {
         return ecs::RegisterLaunchAsApplet(am::LibraryAppletGetMenuProgramId(), static_cast<u32>(st_mode), "/ulaunch/bin/uMenu", std::addressof(status), sizeof(status));
     }
 
+    Result LaunchRequest(const launch::Request &req) {
+        switch(req.kind) {
+            case launch::RequestKind::Application: {
+                return am::ApplicationStart(req.app_id, false, g_SelectedUser);
+            }
+            case launch::RequestKind::HomebrewApplication: {
+                const auto params = hb::HbTargetParams::Create(req.hb_params.nro_path, req.hb_params.nro_argv, false);
+                UL_RC_TRY(ecs::RegisterLaunchAsApplication(req.app_id, "/ulaunch/bin/uHbTarget/app", &params, sizeof(params), g_SelectedUser));
+
+                g_HbTargetApplicationParams = req.hb_params;
+                g_HbTargetOpenedAsApplication = true;
+                return ResultSuccess;
+            }
+            case launch::RequestKind::HomebrewApplet: {
+                const auto params = hb::HbTargetParams::Create(req.hb_params.nro_path, req.hb_params.nro_argv, false);
+                u64 homebrew_applet_program_id;
+                UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::HomebrewAppletTakeoverProgramId, homebrew_applet_program_id));
+                return ecs::RegisterLaunchAsApplet(homebrew_applet_program_id, 0, "/ulaunch/bin/uHbTarget/applet", &params, sizeof(params));
+            }
+            case launch::RequestKind::WebApplet: {
+                // TODO: applet startup sound?
+                WebCommonConfig web_cfg = {};
+                webPageCreate(&web_cfg, req.web_url);
+                webConfigSetWhitelist(&web_cfg, ".*");
+                return am::WebAppletStart(&web_cfg);
+            }
+            case launch::RequestKind::AlbumApplet: {
+                const struct {
+                    u8 album_arg;
+                } album_data = { AlbumLaArg_ShowAllAlbumFilesForHomeMenu };
+                // TODO: applet startup sound?
+                return am::LibraryAppletStart(AppletId_LibraryAppletPhotoViewer, 0x10000, &album_data, sizeof(album_data));
+            }
+            case launch::RequestKind::MenuRestart: {
+                return LaunchMenu(dmi::MenuStartMode::StartupScreen, CreateStatus());
+            }
+        }
+        return ResultSuccess;
+    }
+
+    void OnLaunchTargetActive(const launch::Request &req) {
+        // Only launches requested by uMenu carry a trace
+        if(req.trace.send_tick == 0) {
+            return;
+        }
+
+        auto type = os::LaunchTitleType::Count;
+        switch(req.kind) {
+            case launch::RequestKind::Application: {
+                type = os::LaunchTitleType::Installed;
+                break;
+            }
+            case launch::RequestKind::HomebrewApplet: {
+                type = os::LaunchTitleType::HomebrewApplet;
+                break;
+            }
+            case launch::RequestKind::HomebrewApplication: {
+                type = os::LaunchTitleType::HomebrewApplication;
+                break;
+            }
+            default:
+                return;
+        }
+
+        const os::LaunchCheckpoints checkpoints = {
+            .input_tick = req.trace.input_tick,
+            .send_tick = req.trace.send_tick,
+            .pickup_tick = req.GetStateTick(launch::RequestState::Queued),
+            .launch_tick = req.GetStateTick(launch::RequestState::Launching),
+            .start_tick = req.GetStateTick(launch::RequestState::Running),
+            .active_tick = req.target_active_tick
+        };
+        const auto sample = os::CreateLaunchLatencySample(req.trace.correlation_id, checkpoints);
+        os::RecordLaunchLatency(type, sample);
+        usb::NotifyLaunchLatency(type, sample);
+    }
+
+    launch::LaunchQueue g_LaunchQueue({
+        .is_applet_active = &am::LibraryAppletIsActive,
+        .get_applet_instance_id = &am::LibraryAppletGetInstanceId,
+        .is_application_active = &am::ApplicationIsActive,
+        .launch = &LaunchRequest,
+        .get_tick = &armGetSystemTick,
+        .on_target_active = &OnLaunchTargetActive
+    });
+
     void HandleHomeButton() {
         if(am::LibraryAppletIsActive() && !am::LibraryAppletIsMenu()) {
             // An applet is opened (which is not our menu), thus close it and reopen the menu
@@ -124,8 +224,7 @@ namespace {
         }
         else if(am::LibraryAppletIsMenu()) {
             // Send a message to our menu to handle itself the home press
-            std::scoped_lock lk(g_LastMenuMessageLock);
-            g_LastMenuMessage = dmi::MenuMessage::HomeRequest;
+            ipc::PushMenuMessage(dmi::MenuMessage::HomeRequest);
         }
     }
 
@@ -186,6 +285,7 @@ namespace {
                 break;
             }
             case os::AppletMessage::SdCardOut: {
+                ipc::PushMenuMessage(dmi::MenuMessage::SdCardEjected);
                 // Power off, since uMenu's UI relies on the SD card, so trying to use uMenu without the SD is quite risky...
                 // TODO: handle this in a better way?
                 appletStartShutdownSequence();
@@ -207,17 +307,20 @@ namespace {
 
     void HandleMenuMessage() {
         if(am::LibraryAppletIsMenu()) {
-            char web_url[500] = {};
-            u64 app_id = 0;
-            hb::HbTargetParams params = {};
+            dmi::LaunchApplicationRequest launch_app_req = {};
+            dmi::LaunchHomebrewLibraryAppletRequest launch_hb_applet_req = {};
+            dmi::LaunchHomebrewApplicationRequest launch_hb_app_req = {};
+            dmi::OpenWebPageRequest open_web_page_req = {};
             dmi::dmn::ReceiveCommand([&](const dmi::DaemonMessage msg, dmi::dmn::DaemonScopedStorageReader &reader) -> Result {
                 switch(msg) {
                     case dmi::DaemonMessage::SetSelectedUser: {
-                        UL_RC_TRY(reader.Pop(g_SelectedUser));
+                        dmi::SetSelectedUserRequest req;
+                        UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::SetSelectedUser>(reader, req));
+                        g_SelectedUser = req.user_id;
                         break;
                     }
                     case dmi::DaemonMessage::LaunchApplication: {
-                        UL_RC_TRY(reader.Pop(app_id));
+                        UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::LaunchApplication>(reader, launch_app_req));
                         break;
                     }
                     case dmi::DaemonMessage::ResumeApplication: {
@@ -229,16 +332,15 @@ namespace {
                         break;
                     }
                     case dmi::DaemonMessage::LaunchHomebrewLibraryApplet: {
-                        UL_RC_TRY(reader.Pop(g_HbTargetLaunchFlag));
+                        UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::LaunchHomebrewLibraryApplet>(reader, launch_hb_applet_req));
                         break;
                     }
                     case dmi::DaemonMessage::LaunchHomebrewApplication: {
-                        UL_RC_TRY(reader.Pop(app_id));
-                        UL_RC_TRY(reader.Pop(params));
+                        UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::LaunchHomebrewApplication>(reader, launch_hb_app_req));
                         break;
                     }
                     case dmi::DaemonMessage::OpenWebPage: {
-                        UL_RC_TRY(reader.PopData(web_url, sizeof(web_url)));
+                        UL_RC_TRY(dmi::dmn::PopRequest<dmi::DaemonMessage::OpenWebPage>(reader, open_web_page_req));
                         break;
                     }
                     case dmi::DaemonMessage::OpenAlbum: {
@@ -269,11 +371,10 @@ namespace {
                         else if(!accountUidIsValid(&g_SelectedUser)) {
                             return dmn::ResultInvalidSelectedUser;
                         }
-                        else if(g_ApplicationLaunchFlag > 0) {
-                            return dmn::ResultAlreadyQueued;
-                        }
 
-                        g_ApplicationLaunchFlag = app_id;
+                        auto launch_req = launch::MakeApplicationRequest(launch_app_req.app_id);
+                        launch_req.trace = launch_app_req.trace;
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch_req));
                         break;
                     }
                     case dmi::DaemonMessage::ResumeApplication: {
@@ -290,7 +391,9 @@ namespace {
                         break;
                     }
                     case dmi::DaemonMessage::LaunchHomebrewLibraryApplet: {
-                        // ...
+                        auto launch_req = launch::MakeHomebrewAppletRequest(launch_hb_applet_req.params);
+                        launch_req.trace = launch_hb_applet_req.trace;
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch_req));
                         break;
                     }
                     case dmi::DaemonMessage::LaunchHomebrewApplication: {
@@ -300,26 +403,22 @@ namespace {
                         else if(!accountUidIsValid(&g_SelectedUser)) {
                             return dmn::ResultInvalidSelectedUser;
                         }
-                        else if(g_ApplicationLaunchFlag > 0) {
-                            return dmn::ResultAlreadyQueued;
-                        }
-                        
-                        g_HbTargetApplicationLaunchFlag = params;
-                        g_HbTargetApplicationLaunchFlagCopy = params;
-                        g_ApplicationLaunchFlag = app_id;
+
+                        auto launch_req = launch::MakeHomebrewApplicationRequest(launch_hb_app_req.app_id, launch_hb_app_req.params);
+                        launch_req.trace = launch_hb_app_req.trace;
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch_req));
                         break;
                     }
                     case dmi::DaemonMessage::OpenWebPage: {
-                        webPageCreate(&g_WebAppletLaunchFlag, web_url);
-                        webConfigSetWhitelist(&g_WebAppletLaunchFlag, ".*");
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch::MakeWebAppletRequest(open_web_page_req.url)));
                         break;
                     }
                     case dmi::DaemonMessage::OpenAlbum: {
-                        g_AlbumAppletLaunchFlag = true;
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch::MakeAlbumAppletRequest()));
                         break;
                     }
                     case dmi::DaemonMessage::RestartMenu: {
-                        g_MenuRestartFlag = true;
+                        UL_RC_TRY(g_LaunchQueue.Enqueue(launch::MakeMenuRestartRequest()));
                         break;
                     }
                     default: {
@@ -332,25 +431,110 @@ namespace {
         }
     }
 
+    void UsbViewerHandshakeThread(void*) {
+        // Viewers may reconnect at any time, so keep listening
+        while(true) {
+            usb::ViewerHandshake handshake = {};
+            if(usbCommsRead(&handshake, sizeof(handshake)) == sizeof(handshake)) {
+                g_UsbViewerProtocolVersion = usb::NegotiateViewerProtocolVersion(handshake);
+                g_UsbViewerHandshakeReceived = true;
+            }
+        }
+    }
+
+    bool UsbViewerTransportWrite(void*, const void *data, const size_t size) {
+        return usbCommsWrite(data, size) == size;
+    }
+
+    usb::ViewerChannel g_UsbViewerChannel({
+        .user_data = nullptr,
+        .write = &UsbViewerTransportWrite
+    });
+
+    // Whoever gets connected next might be a legacy viewer, which never sends a handshake
+    void ResetUsbViewerProtocol() {
+        g_UsbViewerProtocolVersion = usb::ViewerLegacyProtocolVersion;
+    }
+
+    void HandleUsbViewerHandshake() {
+        UsbState state = UsbState_Detached;
+        const auto connected = R_SUCCEEDED(usbDsGetState(&state)) && (state == UsbState_Configured);
+        if(g_UsbViewerConnected && !connected) {
+            ResetUsbViewerProtocol();
+        }
+        g_UsbViewerConnected = connected;
+
+        if(g_UsbViewerHandshakeReceived.exchange(false)) {
+            // The new viewer has no previous frame to apply deltas to
+            g_UsbViewerRgbaEncoder.RequestKeyframe();
+            g_UsbViewerFrameSequence = 0;
+            g_UsbViewerChannel.Reset();
+        }
+    }
+
+    void SendUsbViewerFrame(const u32 version, const UsbMode mode, const void *payload, const size_t payload_size) {
+        if(version == usb::ViewerLegacyProtocolVersion) {
+            usbCommsWrite(g_UsbViewerBuffer, UsbPacketSize);
+            return;
+        }
+
+        // A failed write means that the viewer went away (a disconnection might be too short for the state to be seen as changed)
+        auto ok = true;
+        if(version >= usb::ViewerMuxProtocolVersion) {
+            ok = g_UsbViewerChannel.Send(usb::ViewerStreamId::Frame, static_cast<u16>(mode), payload, payload_size);
+            if(ok) {
+                usb::FlushTelemetry(g_UsbViewerChannel);
+            }
+        }
+        else {
+            const auto header = usb::MakeViewerFrameHeader(version, static_cast<u16>(mode), g_UsbViewerFrameSequence++, payload_size);
+            ok = (usbCommsWrite(&header, sizeof(header)) == sizeof(header)) && (usbCommsWrite(payload, payload_size) == payload_size);
+        }
+        if(!ok) {
+            ResetUsbViewerProtocol();
+        }
+    }
+
     void UsbViewerRgbaThread(void*) {
         while(true) {
+            HandleUsbViewerHandshake();
+
+            const auto capture_start_tick = armGetSystemTick();
             bool tmp_flag;
             appletGetLastForegroundCaptureImageEx(g_UsbViewerReadBuffer, PlainRgbaScreenBufferSize, &tmp_flag);
             appletUpdateLastForegroundCaptureImage();
-            usbCommsWrite(g_UsbViewerBuffer, UsbPacketSize);
+            const auto capture_end_tick = armGetSystemTick();
+
+            const auto version = g_UsbViewerProtocolVersion.load();
+            if(g_UsbViewerRgbaEncodingEnabled && (version != usb::ViewerLegacyProtocolVersion)) {
+                const auto encoded_size = g_UsbViewerRgbaEncoder.Encode(reinterpret_cast<u32*>(g_UsbViewerReadBuffer));
+                usb::NotifyFrameTimings(capture_end_tick - capture_start_tick, armGetSystemTick() - capture_end_tick, encoded_size);
+                SendUsbViewerFrame(version, UsbMode::EncodedRgba, g_UsbViewerRgbaEncoder.GetOutput(), encoded_size);
+            }
+            else {
+                usb::NotifyFrameTimings(capture_end_tick - capture_start_tick, 0, PlainRgbaScreenBufferSize);
+                SendUsbViewerFrame(version, g_UsbViewerMode, g_UsbViewerReadBuffer, PlainRgbaScreenBufferSize);
+            }
         }
     }
 
     void UsbViewerJPEGThread(void*) {
         while(true) {
-            u64 tmp_size;
-            capsscCaptureJpegScreenShot(&tmp_size, g_UsbViewerReadBuffer, PlainRgbaScreenBufferSize, ViLayerStack_Default, UINT64_MAX);
-            usbCommsWrite(g_UsbViewerBuffer, UsbPacketSize);
+            HandleUsbViewerHandshake();
+
+            // The capture call does the JPEG encoding itself, so it's all accounted as capture time
+            const auto capture_start_tick = armGetSystemTick();
+            u64 tmp_size = 0;
+            if(R_SUCCEEDED(capsscCaptureJpegScreenShot(&tmp_size, g_UsbViewerReadBuffer, PlainRgbaScreenBufferSize, ViLayerStack_Default, UINT64_MAX))) {
+                usb::NotifyFrameTimings(armGetSystemTick() - capture_start_tick, 0, tmp_size);
+                // Only the actual JPEG bytes are sent (unless the viewer is a legacy one)
+                SendUsbViewerFrame(g_UsbViewerProtocolVersion.load(), g_UsbViewerMode, g_UsbViewerReadBuffer, tmp_size);
+            }
         }
     }
 
     void PrepareUsbViewer() {
-        g_UsbViewerBuffer = reinterpret_cast<u8*>(__libnx_aligned_alloc(ams::os::MemoryPageSize, UsbPacketSize));
+        g_UsbViewerBuffer = reinterpret_cast<u8*>(mem::AllocateAligned(mem::Tag::Usb, ams::os::MemoryPageSize, UsbPacketSize));
         memset(g_UsbViewerBuffer, 0, UsbPacketSize);
 
         // Skip the first u32 of the buffer, since the mode is stored there
@@ -362,73 +546,57 @@ namespace {
         else {
             g_UsbViewerMode = UsbMode::PlainRgba;
             capsscExit();
+
+            u64 downscale_shift;
+            UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::ViewerUsbRgbaDownscaleShift, downscale_shift));
+            bool delta_enabled;
+            UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::ViewerUsbRgbaDeltaEnabled, delta_enabled));
+            bool rle_enabled;
+            UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::ViewerUsbRgbaRleEnabled, rle_enabled));
+            bool vector_kernels_enabled;
+            UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::ViewerUsbVectorKernelsEnabled, vector_kernels_enabled));
+
+            if((downscale_shift > 0) || delta_enabled || rle_enabled) {
+                usb::ViewerRgbaEncoderConfig encoder_cfg = {
+                    .downscale_shift = static_cast<u32>(downscale_shift),
+                    .delta_enabled = delta_enabled,
+                    .rle_enabled = rle_enabled,
+                    .kernel = vector_kernels_enabled ? usb::ViewerRgbaKernel::Vector : usb::ViewerRgbaKernel::Scalar
+                };
+
+                // Delta frames at full resolution don't fit next to the packet buffer, so the config gets reduced to whatever fits (and the viewer gets told)
+                dmi::DaemonHeapStats heap_stats = {};
+                mem::GetHeapStats(heap_stats);
+                const auto free_size = heap_stats.heap_size - std::min(heap_stats.heap_size, heap_stats.used_size);
+                const auto available_size = free_size - std::min(free_size, UsbViewerHeapReserveSize);
+                auto fallback = usb::ViewerRgbaEncoder::FitConfigToMemory(encoder_cfg, UsbViewerScreenWidth, UsbViewerScreenHeight, available_size);
+                if(fallback != usb::ViewerRgbaEncoderFallback::PlainFrames) {
+                    g_UsbViewerRgbaEncodingEnabled = g_UsbViewerRgbaEncoder.Initialize(encoder_cfg, UsbViewerScreenWidth, UsbViewerScreenHeight);
+                    if(!g_UsbViewerRgbaEncodingEnabled) {
+                        fallback = usb::ViewerRgbaEncoderFallback::PlainFrames;
+                    }
+                }
+                usb::NotifyRgbaEncoderFallback(fallback, g_UsbViewerRgbaEncodingEnabled ? encoder_cfg.downscale_shift : 0);
+            }
         }
         *reinterpret_cast<UsbMode*>(g_UsbViewerBuffer) = g_UsbViewerMode;
     }
 
     void MainLoop() {
+        usb::NotifyMainLoopWakeup();
+        mem::UpdateHeapUsage();
+
         HandleGeneralChannel();
         HandleAppletMessage();
         HandleMenuMessage();
 
-        auto sth_done = false;
-        // A valid version will always be >= 0x20000
-        if(g_WebAppletLaunchFlag.version > 0) {
-            if(!am::LibraryAppletIsActive()) {
-                // TODO: applet startup sound?
-                UL_RC_ASSERT(am::WebAppletStart(&g_WebAppletLaunchFlag));
-
-                sth_done = true;
-                g_WebAppletLaunchFlag = {};
-            }
+        // Queued launches wait for the current applet to exit, then get launched in order
+        launch::Request launched_req;
+        auto sth_done = g_LaunchQueue.Update(&launched_req);
+        if(sth_done) {
+            UL_RC_ASSERT(launched_req.launch_rc);
         }
-        if(g_MenuRestartFlag) {
-            if(!am::LibraryAppletIsActive()) {
-                UL_RC_ASSERT(LaunchMenu(dmi::MenuStartMode::StartupScreen, CreateStatus()));
-
-                sth_done = true;
-                g_MenuRestartFlag = false;
-            }
-        }
-        if(g_AlbumAppletLaunchFlag) {
-            if(!am::LibraryAppletIsActive()) {
-                const struct {
-                    u8 album_arg;
-                } album_data = { AlbumLaArg_ShowAllAlbumFilesForHomeMenu };
-                // TODO: applet startup sound?
-                UL_RC_ASSERT(am::LibraryAppletStart(AppletId_LibraryAppletPhotoViewer, 0x10000, &album_data, sizeof(album_data)));
 
-                sth_done = true;
-                g_AlbumAppletLaunchFlag = false;
-            }
-        }
-        if(g_ApplicationLaunchFlag > 0) {
-            if(!am::LibraryAppletIsActive()) {
-                if(strlen(g_HbTargetApplicationLaunchFlag.nro_path)) {
-                    const auto params = hb::HbTargetParams::Create(g_HbTargetApplicationLaunchFlag.nro_path, g_HbTargetApplicationLaunchFlag.nro_argv, false);
-                    UL_RC_ASSERT(ecs::RegisterLaunchAsApplication(g_ApplicationLaunchFlag, "/ulaunch/bin/uHbTarget/app", &params, sizeof(params), g_SelectedUser));
-                    
-                    g_HbTargetOpenedAsApplication = true;
-                    g_HbTargetApplicationLaunchFlag.nro_path[0] = '\0';
-                }
-                else {
-                    UL_RC_ASSERT(am::ApplicationStart(g_ApplicationLaunchFlag, false, g_SelectedUser));
-                }
-                sth_done = true;
-                g_ApplicationLaunchFlag = 0;
-            }
-        }
-        if(strlen(g_HbTargetLaunchFlag.nro_path)) {
-            if(!am::LibraryAppletIsActive()) {
-                const auto params = hb::HbTargetParams::Create(g_HbTargetLaunchFlag.nro_path, g_HbTargetLaunchFlag.nro_argv, false);
-                u64 homebrew_applet_program_id;
-                UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::HomebrewAppletTakeoverProgramId, homebrew_applet_program_id));
-                UL_RC_ASSERT(ecs::RegisterLaunchAsApplet(homebrew_applet_program_id, 0, "/ulaunch/bin/uHbTarget/applet", &params, sizeof(params)));
-                
-                sth_done = true;
-                g_HbTargetLaunchFlag.nro_path[0] = '\0';
-            }
-        }
         if(!am::LibraryAppletIsActive()) {
             const auto cur_id = am::LibraryAppletGetId();
             u64 homebrew_applet_program_id;
@@ -440,6 +608,16 @@ namespace {
             }
         }
 
+        const auto prev_app_active = g_ApplicationActive;
+        g_ApplicationActive = am::ApplicationIsActive();
+        if(prev_app_active && !g_ApplicationActive) {
+            dmi::MenuMessageContext msg_ctx = {
+                .msg = dmi::MenuMessage::ApplicationExited
+            };
+            msg_ctx.app_exited.app_id = am::ApplicationGetId();
+            ipc::PushMenuMessage(msg_ctx);
+        }
+
         const auto prev_applet_active = g_AppletActive;
         g_AppletActive = am::LibraryAppletIsActive();
         if(!sth_done && !prev_applet_active) {
@@ -476,7 +654,9 @@ namespace {
         }
 
         UL_RC_TRY(ams::os::CreateThread(&g_UsbViewerThread, thread_entry, nullptr, g_UsbViewerThreadStack, sizeof(g_UsbViewerThreadStack), 10));
+        UL_RC_TRY(ams::os::CreateThread(&g_UsbViewerHandshakeThread, &UsbViewerHandshakeThread, nullptr, g_UsbViewerHandshakeThreadStack, sizeof(g_UsbViewerHandshakeThreadStack), 10));
         ams::os::StartThread(&g_UsbViewerThread);
+        ams::os::StartThread(&g_UsbViewerHandshakeThread);
 
         return ResultSuccess;
     }
@@ -507,7 +687,10 @@ namespace {
         fs::CreateDirectory(UL_BASE_SD_DIR "/nro");
         fs::CreateDirectory(UL_BASE_SD_DIR "/lang");
 
-        g_Config = cfg::LoadConfig();
+        {
+            mem::ScopedHeapAttribution attr(mem::Tag::Config);
+            g_Config = cfg::LoadConfig();
+        }
         u64 menu_program_id;
         UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::MenuTakeoverProgramId, menu_program_id));
         am::LibraryAppletSetMenuAppletId(am::LibraryAppletGetAppletIdForProgramId(menu_program_id));
@@ -522,6 +705,7 @@ namespace {
             UL_RC_ASSERT(LaunchUsbViewerThread());
         }
 
+        ipc::InitializeMenuMessageQueue();
         UL_RC_ASSERT(ipc::Initialize());
     }
 
@@ -531,8 +715,9 @@ namespace {
             if(g_UsbViewerMode == UsbMode::Jpeg) {
                 capsscExit();
             }
-            __libnx_free(g_UsbViewerBuffer);
+            mem::Free(g_UsbViewerBuffer);
             g_UsbViewerBuffer = nullptr;
+            g_UsbViewerRgbaEncoder.Finalize();
         }
 
         nsExit();
@@ -570,6 +755,7 @@ namespace ams {
         void Startup() {
             // Initialize the global malloc-free/new-delete allocator
             init::InitializeAllocator(g_HeapBuffer, HeapSize);
+            ::mem::Initialize(HeapSize);
 
             os::SetThreadNamePointer(os::GetCurrentThread(), "ul.daemon.Main");
         }
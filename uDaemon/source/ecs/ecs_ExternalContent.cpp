@@ -1,5 +1,6 @@
 #include <ecs/ecs_ExternalContent.hpp>
 #include <ipc/ipc_Manager.hpp>
+#include <mem/mem_Heap.hpp>
 #include <stratosphere/fssrv/fssrv_interface_adapters.hpp>
 
 namespace {
@@ -21,8 +22,8 @@ namespace ecs {
 
         FsFileSystem sd_fs;
         UL_RC_TRY(fsOpenSdCardFileSystem(&sd_fs));
-        std::shared_ptr<ams::fs::fsa::IFileSystem> remote_sd_fs = std::make_shared<ams::fs::RemoteFileSystem>(sd_fs);
-        auto subdir_fs = std::make_shared<ams::fssystem::SubDirectoryFileSystem>(std::move(remote_sd_fs));
+        std::shared_ptr<ams::fs::fsa::IFileSystem> remote_sd_fs = std::allocate_shared<ams::fs::RemoteFileSystem>(mem::TaggedAllocator<ams::fs::RemoteFileSystem, mem::Tag::Ecs>(), sd_fs);
+        auto subdir_fs = std::allocate_shared<ams::fssystem::SubDirectoryFileSystem>(mem::TaggedAllocator<ams::fssystem::SubDirectoryFileSystem, mem::Tag::Ecs>(), std::move(remote_sd_fs));
         ams::fs::Path exefs_fs_path;
         UL_RC_TRY(exefs_fs_path.Initialize(exefs_path.c_str(), exefs_path.length()));
         UL_RC_TRY(exefs_fs_path.Normalize(ams::fs::PathFlags{}));
@@ -1,9 +1,8 @@
 #include <ipc/ipc_IPrivateService.hpp>
+#include <ipc/ipc_MenuMessageQueue.hpp>
 #include <dmi/dmi_DaemonMenuInteraction.hpp>
 #include <am/am_LibraryApplet.hpp>
-
-extern ams::os::Mutex g_LastMenuMessageLock;
-extern dmi::MenuMessage g_LastMenuMessage;
+#include <mem/mem_Heap.hpp>
 
 namespace ipc {
 
@@ -19,6 +18,8 @@ namespace ipc {
                 return ipc::ResultInvalidProcess;
             }
 
+            // Messages queued for a previous menu instance are no longer relevant
+            ClearMenuMessages();
             this->initialized = true;
         }
         
@@ -30,9 +31,52 @@ namespace ipc {
             return ipc::ResultInvalidProcess;
         }
 
-        std::scoped_lock lk(g_LastMenuMessageLock);
-        out_msg.SetValue(g_LastMenuMessage);
-        g_LastMenuMessage = dmi::MenuMessage::Invalid;
+        dmi::MenuMessageContext msg_ctx = {};
+        if(PopMenuMessages(&msg_ctx, 1) == 0) {
+            msg_ctx.msg = dmi::MenuMessage::Invalid;
+        }
+        out_msg.SetValue(msg_ctx.msg);
+        return ResultSuccess;
+    }
+
+    ams::Result PrivateService::GetMessageEvent(ams::sf::OutCopyHandle out_event_h) {
+        if(!this->initialized) {
+            return ipc::ResultInvalidProcess;
+        }
+
+        out_event_h.SetValue(GetMenuMessageEventHandle(), false);
+        return ResultSuccess;
+    }
+
+    ams::Result PrivateService::GetMessages(const ams::sf::OutMapAliasArray<dmi::MenuMessageContext> &out_msg_ctxs, ams::sf::Out<u32> out_count) {
+        if(!this->initialized) {
+            return ipc::ResultInvalidProcess;
+        }
+
+        const auto count = PopMenuMessages(out_msg_ctxs.GetPointer(), out_msg_ctxs.GetSize());
+        out_count.SetValue(static_cast<u32>(count));
+        return ResultSuccess;
+    }
+
+    ams::Result PrivateService::GetHeapStats(ams::sf::Out<dmi::DaemonHeapStats> out_stats) {
+        if(!this->initialized) {
+            return ipc::ResultInvalidProcess;
+        }
+
+        dmi::DaemonHeapStats stats = {};
+        mem::GetHeapStats(stats);
+        out_stats.SetValue(stats);
+        return ResultSuccess;
+    }
+
+    ams::Result PrivateService::GetMenuMessageStats(ams::sf::Out<dmi::MenuMessageStats> out_stats) {
+        if(!this->initialized) {
+            return ipc::ResultInvalidProcess;
+        }
+
+        dmi::MenuMessageStats stats = {};
+        ipc::GetMenuMessageStats(stats);
+        out_stats.SetValue(stats);
         return ResultSuccess;
     }
 
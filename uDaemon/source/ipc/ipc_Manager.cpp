@@ -1,5 +1,6 @@
 #include <ipc/ipc_Manager.hpp>
 #include <ipc/ipc_IPrivateService.hpp>
+#include <mem/mem_Heap.hpp>
 
 namespace {
 
@@ -11,8 +12,9 @@ namespace {
     
     ams::os::Mutex g_ManagerAllocatorLock(false);
 
+    // Taken from the main heap, so that it's accounted as IPC memory
     constexpr size_t ServerAllocatorHeapSize = 32_KB;
-    alignas(0x40) constinit u8 g_ManagerAllocatorHeap[ServerAllocatorHeapSize];
+    u8 *g_ManagerAllocatorHeap = nullptr;
     ams::lmem::HeapHandle g_ManagerAllocatorHeapHandle;
     ipc::Allocator g_ManagerAllocator;
 
@@ -26,7 +28,9 @@ namespace {
     }
 
     void InitializeHeap() {
-        g_ManagerAllocatorHeapHandle = ams::lmem::CreateExpHeap(g_ManagerAllocatorHeap, sizeof(g_ManagerAllocatorHeap), ams::lmem::CreateOption_None);
+        g_ManagerAllocatorHeap = reinterpret_cast<u8*>(mem::AllocateAligned(mem::Tag::Ipc, 0x40, ServerAllocatorHeapSize));
+        UL_ASSERT_TRUE(g_ManagerAllocatorHeap != nullptr);
+        g_ManagerAllocatorHeapHandle = ams::lmem::CreateExpHeap(g_ManagerAllocatorHeap, ServerAllocatorHeapSize, ams::lmem::CreateOption_None);
         g_ManagerAllocator.Attach(g_ManagerAllocatorHeapHandle);
     }
 
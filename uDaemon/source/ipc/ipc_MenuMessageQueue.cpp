@@ -0,0 +1,52 @@
+#include <ipc/ipc_MenuMessageQueue.hpp>
+
+namespace ipc {
+
+    namespace {
+
+        // Pushed from the main thread, popped from the IPC manager thread
+        util::SpscRing<dmi::MenuMessageContext, MenuMessageQueueCapacity> g_Queue;
+        u32 g_NextSequence = 1;
+
+        // Inter-process, since its readable handle is sent to uMenu
+        ams::util::TypedStorage<ams::os::SystemEvent> g_MessageEvent;
+
+    }
+
+    void InitializeMenuMessageQueue() {
+        ams::util::ConstructAt(g_MessageEvent, ams::os::EventClearMode_AutoClear, true);
+    }
+
+    void PushMenuMessage(const dmi::MenuMessage msg) {
+        dmi::MenuMessageContext msg_ctx = {
+            .msg = msg
+        };
+        PushMenuMessage(msg_ctx);
+    }
+
+    void PushMenuMessage(const dmi::MenuMessageContext &msg_ctx) {
+        auto queued_msg_ctx = msg_ctx;
+        queued_msg_ctx.seq = g_NextSequence++;
+        if(g_Queue.TryPush(queued_msg_ctx)) {
+            ams::util::GetReference(g_MessageEvent).Signal();
+        }
+    }
+
+    size_t PopMenuMessages(dmi::MenuMessageContext *out_msg_ctxs, const size_t max_count) {
+        return g_Queue.PopMany(out_msg_ctxs, max_count);
+    }
+
+    void ClearMenuMessages() {
+        g_Queue.Clear();
+    }
+
+    ams::os::NativeHandle GetMenuMessageEventHandle() {
+        return ams::util::GetReference(g_MessageEvent).GetReadableHandle();
+    }
+
+    void GetMenuMessageStats(dmi::MenuMessageStats &out_stats) {
+        out_stats.dropped_count = g_Queue.GetOverflowCount();
+        out_stats.queued_count = static_cast<u32>(g_Queue.GetCount());
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <launch/launch_Queue.hpp>
+
+namespace launch {
+
+    namespace {
+
+        inline Request MakeRequest(const RequestKind kind) {
+            Request req = {};
+            req.kind = kind;
+            req.state = RequestState::Queued;
+            return req;
+        }
+
+    }
+
+    Request MakeApplicationRequest(const u64 app_id) {
+        auto req = MakeRequest(RequestKind::Application);
+        req.app_id = app_id;
+        return req;
+    }
+
+    Request MakeHomebrewApplicationRequest(const u64 app_id, const hb::HbTargetParams &params) {
+        auto req = MakeRequest(RequestKind::HomebrewApplication);
+        req.app_id = app_id;
+        req.hb_params = params;
+        return req;
+    }
+
+    Request MakeHomebrewAppletRequest(const hb::HbTargetParams &params) {
+        auto req = MakeRequest(RequestKind::HomebrewApplet);
+        req.hb_params = params;
+        return req;
+    }
+
+    Request MakeWebAppletRequest(const char *url) {
+        auto req = MakeRequest(RequestKind::WebApplet);
+        // Always NUL-terminated, the request is zeroed
+        strncpy(req.web_url, url, sizeof(req.web_url) - 1);
+        return req;
+    }
+
+    Request MakeAlbumAppletRequest() {
+        return MakeRequest(RequestKind::AlbumApplet);
+    }
+
+    Request MakeMenuRestartRequest() {
+        return MakeRequest(RequestKind::MenuRestart);
+    }
+
+    void LaunchQueue::SetState(Request &req, const RequestState state) {
+        req.state = state;
+        req.state_ticks[static_cast<size_t>(state)] = this->backend.get_tick();
+    }
+
+    bool LaunchQueue::IsTargetActive(const Request &req) {
+        if(req.IsApplication()) {
+            return this->backend.is_application_active();
+        }
+        else {
+            return (this->backend.get_applet_instance_id() == req.applet_instance_id) && this->backend.is_applet_active();
+        }
+    }
+
+    bool LaunchQueue::IsTargetReplaced(const Request &req) {
+        // Applications aren't replaced by anything else while active
+        return !req.IsApplication() && (this->backend.get_applet_instance_id() != req.applet_instance_id);
+    }
+
+    void LaunchQueue::Track(const Request &req) {
+        if(this->tracked_count == MaxTrackedRequestCount) {
+            // Evict the oldest one
+            for(size_t i = 1; i < this->tracked_count; i++) {
+                this->tracked_reqs[i - 1] = this->tracked_reqs[i];
+            }
+            this->tracked_count--;
+        }
+        this->tracked_reqs[this->tracked_count++] = req;
+    }
+
+    void LaunchQueue::PopFront() {
+        for(size_t i = 1; i < this->pending_count; i++) {
+            this->pending_reqs[i - 1] = this->pending_reqs[i];
+        }
+        this->pending_count--;
+    }
+
+    Result LaunchQueue::Enqueue(const Request &req, u32 *out_id) {
+        if(req.IsApplication() && this->HasPendingApplication()) {
+            return dmn::ResultAlreadyQueued;
+        }
+        if(this->pending_count == MaxPendingRequestCount) {
+            return dmn::ResultLaunchQueueFull;
+        }
+
+        auto &queued_req = this->pending_reqs[this->pending_count++];
+        queued_req = req;
+        queued_req.id = this->next_id++;
+        queued_req.target_seen_active = false;
+        queued_req.target_active_tick = 0;
+        queued_req.applet_instance_id = 0;
+        queued_req.launch_rc = ResultSuccess;
+        memset(queued_req.state_ticks, 0, sizeof(queued_req.state_ticks));
+        this->SetState(queued_req, RequestState::Queued);
+
+        if(out_id != nullptr) {
+            *out_id = queued_req.id;
+        }
+        return ResultSuccess;
+    }
+
+    bool LaunchQueue::Update(Request *out_launched_req) {
+        // Launched requests: running until their target is gone
+        for(size_t i = 0; i < this->tracked_count; i++) {
+            auto &req = this->tracked_reqs[i];
+            if(req.state == RequestState::Running) {
+                if(this->IsTargetActive(req)) {
+                    if(!req.target_seen_active) {
+                        req.target_seen_active = true;
+                        req.target_active_tick = this->backend.get_tick();
+                        if(this->backend.on_target_active != nullptr) {
+                            this->backend.on_target_active(req);
+                        }
+                    }
+                }
+                else if(req.target_seen_active || this->IsTargetReplaced(req)) {
+                    this->SetState(req, RequestState::Exited);
+                }
+            }
+        }
+
+        if(this->pending_count == 0) {
+            return false;
+        }
+
+        // Requests get launched in order, one per update
+        auto &req = this->pending_reqs[0];
+        if(req.state == RequestState::Queued) {
+            if(this->backend.is_applet_active()) {
+                this->SetState(req, RequestState::WaitingForAppletExit);
+                return false;
+            }
+        }
+        else if(req.state == RequestState::WaitingForAppletExit) {
+            if(this->backend.is_applet_active()) {
+                return false;
+            }
+        }
+
+        this->SetState(req, RequestState::Launching);
+        req.launch_rc = this->backend.launch(req);
+        if(R_SUCCEEDED(req.launch_rc)) {
+            if(!req.IsApplication()) {
+                req.applet_instance_id = this->backend.get_applet_instance_id();
+            }
+            this->SetState(req, RequestState::Running);
+        }
+        else {
+            this->SetState(req, RequestState::Failed);
+        }
+
+        if(out_launched_req != nullptr) {
+            *out_launched_req = req;
+        }
+        this->Track(req);
+        this->PopFront();
+        return true;
+    }
+
+    bool LaunchQueue::HasPendingApplication() const {
+        for(size_t i = 0; i < this->pending_count; i++) {
+            if(this->pending_reqs[i].IsApplication()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool LaunchQueue::FindRequest(const u32 id, Request &out_req) const {
+        for(size_t i = 0; i < this->pending_count; i++) {
+            if(this->pending_reqs[i].id == id) {
+                out_req = this->pending_reqs[i];
+                return true;
+            }
+        }
+        for(size_t i = 0; i < this->tracked_count; i++) {
+            if(this->tracked_reqs[i].id == id) {
+                out_req = this->tracked_reqs[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
\ No newline at end of file
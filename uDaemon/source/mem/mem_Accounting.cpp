@@ -0,0 +1,54 @@
+#include <mem/mem_Accounting.hpp>
+
+namespace mem {
+
+    void HeapAccounting::UpdatePeak(std::atomic<u64> &peak, const u64 value) {
+        auto cur_peak = peak.load(std::memory_order_relaxed);
+        while((value > cur_peak) && !peak.compare_exchange_weak(cur_peak, value, std::memory_order_relaxed));
+    }
+
+    void HeapAccounting::OnAllocate(const Tag tag, const size_t size) {
+        auto &counters = this->tag_counters[static_cast<size_t>(tag)];
+        const auto new_size = counters.cur_size.fetch_add(size, std::memory_order_relaxed) + size;
+        UpdatePeak(counters.peak_size, new_size);
+        counters.alloc_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void HeapAccounting::OnFree(const Tag tag, const size_t size) {
+        auto &counters = this->tag_counters[static_cast<size_t>(tag)];
+        counters.cur_size.fetch_sub(size, std::memory_order_relaxed);
+        counters.free_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void HeapAccounting::OnExternalUsage(const Tag tag, const s64 size_delta) {
+        auto &counters = this->tag_counters[static_cast<size_t>(tag)];
+        if(size_delta >= 0) {
+            const auto new_size = counters.cur_size.fetch_add(static_cast<u64>(size_delta), std::memory_order_relaxed) + static_cast<u64>(size_delta);
+            UpdatePeak(counters.peak_size, new_size);
+        }
+        else {
+            counters.cur_size.fetch_sub(static_cast<u64>(-size_delta), std::memory_order_relaxed);
+        }
+    }
+
+    u64 HeapAccounting::GetTotalSize() const {
+        u64 total_size = 0;
+        for(const auto &counters : this->tag_counters) {
+            total_size += counters.cur_size.load(std::memory_order_relaxed);
+        }
+        return total_size;
+    }
+
+    void HeapAccounting::GetTagStats(dmi::DaemonHeapTagStats (&out_stats)[dmi::DaemonHeapTagCount]) const {
+        for(size_t i = 0; i < dmi::DaemonHeapTagCount; i++) {
+            const auto &counters = this->tag_counters[i];
+            out_stats[i] = {
+                .cur_size = counters.cur_size.load(std::memory_order_relaxed),
+                .peak_size = counters.peak_size.load(std::memory_order_relaxed),
+                .alloc_count = counters.alloc_count.load(std::memory_order_relaxed),
+                .free_count = counters.free_count.load(std::memory_order_relaxed)
+            };
+        }
+    }
+
+}
\ No newline at end of file
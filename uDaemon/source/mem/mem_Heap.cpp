@@ -0,0 +1,147 @@
+#include <mem/mem_Heap.hpp>
+#include <mem/mem_Pool.hpp>
+#include <stratosphere.hpp>
+
+namespace mem {
+
+    namespace {
+
+        size_t g_HeapSize = 0;
+        // Sampled from the allocator (which locks it, hence not done on every allocation)
+        std::atomic<u64> g_PeakHeapUsedSize = 0;
+        // Tracked heap allocations (headers included) kept up to date on every allocation, so that peaks between samples aren't missed
+        std::atomic<u64> g_TrackedHeapSize = 0;
+        std::atomic<u64> g_PeakTrackedHeapSize = 0;
+        HeapAccounting g_Accounting;
+
+        ams::os::Mutex g_SmallPoolLock(false);
+        FixedPool<SmallBlockSize, SmallBlockCount> g_SmallPool;
+        Tag g_SmallPoolBlockTags[SmallBlockCount];
+
+        ScopedHeapAttribution *g_CurrentAttribution = nullptr;
+
+        inline void UpdatePeak(std::atomic<u64> &peak, const u64 value) {
+            auto cur_peak = peak.load(std::memory_order_relaxed);
+            while((value > cur_peak) && !peak.compare_exchange_weak(cur_peak, value, std::memory_order_relaxed));
+        }
+
+        inline u64 GetHeapUsedSize() {
+            // Not initialized yet
+            if(g_HeapSize == 0) {
+                return 0;
+            }
+
+            return g_HeapSize - ams::init::GetAllocator()->GetTotalFreeSize();
+        }
+
+        void *AllocateFromSmallPool(const Tag tag) {
+            std::scoped_lock lk(g_SmallPoolLock);
+            auto ptr = g_SmallPool.Allocate();
+            if(ptr != nullptr) {
+                g_SmallPoolBlockTags[g_SmallPool.GetBlockIndex(ptr)] = tag;
+            }
+            return ptr;
+        }
+
+    }
+
+    void Initialize(const size_t heap_size) {
+        g_HeapSize = heap_size;
+        UpdateHeapUsage();
+    }
+
+    void *Allocate(const Tag tag, const size_t size) {
+        return AllocateAligned(tag, alignof(std::max_align_t), size);
+    }
+
+    void *AllocateAligned(const Tag tag, const size_t align, const size_t size) {
+        if((size <= SmallBlockSize) && (align <= alignof(std::max_align_t))) {
+            auto ptr = AllocateFromSmallPool(tag);
+            if(ptr != nullptr) {
+                g_Accounting.OnAllocate(tag, SmallBlockSize);
+                return ptr;
+            }
+            // Pool exhausted, fall back to the heap
+        }
+
+        const auto header_align = std::max(align, sizeof(AllocationHeader));
+        auto base_ptr = reinterpret_cast<u8*>(aligned_alloc(header_align, header_align + size));
+        if(base_ptr == nullptr) {
+            return nullptr;
+        }
+
+        auto ptr = base_ptr + header_align;
+        *(reinterpret_cast<AllocationHeader*>(ptr) - 1) = {
+            .size = static_cast<u32>(size),
+            .offset = static_cast<u32>(header_align),
+            .magic = AllocationHeader::Magic,
+            .tag = static_cast<u16>(tag)
+        };
+        g_Accounting.OnAllocate(tag, header_align + size);
+        const auto tracked_size = g_TrackedHeapSize.fetch_add(header_align + size, std::memory_order_relaxed) + header_align + size;
+        UpdatePeak(g_PeakTrackedHeapSize, tracked_size);
+        return ptr;
+    }
+
+    void Free(void *ptr) {
+        if(ptr == nullptr) {
+            return;
+        }
+
+        if(g_SmallPool.Contains(ptr)) {
+            std::scoped_lock lk(g_SmallPoolLock);
+            g_Accounting.OnFree(g_SmallPoolBlockTags[g_SmallPool.GetBlockIndex(ptr)], SmallBlockSize);
+            g_SmallPool.Free(ptr);
+            return;
+        }
+
+        const auto header = *(reinterpret_cast<AllocationHeader*>(ptr) - 1);
+        UL_ASSERT_TRUE(header.magic == AllocationHeader::Magic);
+        g_Accounting.OnFree(static_cast<Tag>(header.tag), header.offset + header.size);
+        g_TrackedHeapSize.fetch_sub(header.offset + header.size, std::memory_order_relaxed);
+        free(reinterpret_cast<u8*>(ptr) - header.offset);
+    }
+
+    void UpdateHeapUsage() {
+        UpdatePeak(g_PeakHeapUsedSize, GetHeapUsedSize());
+    }
+
+    void GetHeapStats(dmi::DaemonHeapStats &out_stats) {
+        UpdateHeapUsage();
+        out_stats.heap_size = g_HeapSize;
+        out_stats.used_size = GetHeapUsedSize();
+        out_stats.peak_used_size = std::max(g_PeakHeapUsedSize.load(std::memory_order_relaxed), g_PeakTrackedHeapSize.load(std::memory_order_relaxed));
+
+        {
+            std::scoped_lock lk(g_SmallPoolLock);
+            out_stats.pool_used_block_count = static_cast<u32>(g_SmallPool.GetUsedCount());
+            out_stats.pool_peak_used_block_count = static_cast<u32>(g_SmallPool.GetPeakUsedCount());
+        }
+
+        g_Accounting.GetTagStats(out_stats.tags);
+
+        // The rest of the heap (plain new/malloc calls, allocator overhead) counts as untagged usage
+        const auto tagged_heap_size = g_Accounting.GetTotalSize() - (out_stats.pool_used_block_count * SmallBlockSize);
+        if(out_stats.used_size > tagged_heap_size) {
+            out_stats.tags[static_cast<size_t>(Tag::Other)].cur_size += out_stats.used_size - tagged_heap_size;
+        }
+    }
+
+    ScopedHeapAttribution::ScopedHeapAttribution(const Tag tag) : tag(tag), start_used_size(GetHeapUsedSize()), start_tracked_size(g_TrackedHeapSize.load(std::memory_order_relaxed)), nested_size_delta(0), parent(g_CurrentAttribution) {
+        g_CurrentAttribution = this;
+    }
+
+    ScopedHeapAttribution::~ScopedHeapAttribution() {
+        const auto used_size_delta = static_cast<s64>(GetHeapUsedSize()) - static_cast<s64>(this->start_used_size);
+        const auto tracked_size_delta = static_cast<s64>(g_TrackedHeapSize.load(std::memory_order_relaxed)) - static_cast<s64>(this->start_tracked_size);
+        const auto untracked_size_delta = used_size_delta - tracked_size_delta;
+        g_Accounting.OnExternalUsage(this->tag, untracked_size_delta - this->nested_size_delta);
+
+        g_CurrentAttribution = this->parent;
+        if(this->parent != nullptr) {
+            this->parent->nested_size_delta += untracked_size_delta;
+        }
+        UpdateHeapUsage();
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <usb/usb_ViewerChannel.hpp>
+
+namespace usb {
+
+    namespace {
+
+        // Standard reflected CRC32 (same as zlib's), the viewer computes the same one
+        constexpr u32 Crc32Polynomial = 0xEDB88320;
+
+        struct Crc32Table {
+            u32 entries[0x100];
+
+            constexpr Crc32Table() : entries() {
+                for(u32 i = 0; i < 0x100; i++) {
+                    auto crc = i;
+                    for(u32 j = 0; j < 8; j++) {
+                        crc = (crc & 1) ? ((crc >> 1) ^ Crc32Polynomial) : (crc >> 1);
+                    }
+                    this->entries[i] = crc;
+                }
+            }
+        };
+
+        constexpr Crc32Table g_Crc32Table;
+
+    }
+
+    u32 ComputeCrc32(const void *data, const size_t size, const u32 crc) {
+        auto data_u8 = reinterpret_cast<const u8*>(data);
+        auto cur_crc = ~crc;
+        for(size_t i = 0; i < size; i++) {
+            cur_crc = g_Crc32Table.entries[(cur_crc ^ data_u8[i]) & 0xFF] ^ (cur_crc >> 8);
+        }
+        return ~cur_crc;
+    }
+
+    bool ViewerChannel::Send(const ViewerStreamId stream_id, const u16 type, const void *payload, const size_t payload_size) {
+        const auto stream_idx = static_cast<size_t>(stream_id);
+        if(stream_idx >= ViewerStreamCount) {
+            return false;
+        }
+
+        ViewerPacketHeader header = {
+            .magic = ViewerPacketHeader::Magic,
+            .version = static_cast<u8>(ViewerMuxProtocolVersion),
+            .stream_id = static_cast<u8>(stream_id),
+            .type = type,
+            .seq = this->next_seqs[stream_idx]++,
+            .payload_size = static_cast<u32>(payload_size),
+            .payload_crc = ComputeCrc32(payload, payload_size)
+        };
+        header.header_crc = ComputeViewerHeaderCrc32(header);
+
+        if(!this->transport.write(this->transport.user_data, &header, sizeof(header))) {
+            return false;
+        }
+        if(payload_size > 0) {
+            return this->transport.write(this->transport.user_data, payload, payload_size);
+        }
+        return true;
+    }
+
+}
\ No newline at end of file
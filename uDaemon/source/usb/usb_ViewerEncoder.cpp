@@ -0,0 +1,353 @@
+#include <usb/usb_ViewerEncoder.hpp>
+#include <mem/mem_Heap.hpp>
+
+namespace usb {
+
+    namespace {
+
+        typedef u32 u32x4 __attribute__((vector_size(16)));
+
+        constexpr u32 ByteLaneMask = 0xFEFEFEFE;
+        constexpr size_t MaxRleChunkLength = 0x80;
+        constexpr u8 RleRunFlag = 0x80;
+
+        // Per-channel (byte lane) average of two pixels, rounding down
+        inline constexpr u32 AverageBytes(const u32 a, const u32 b) {
+            return (a & b) + (((a ^ b) & ByteLaneMask) >> 1);
+        }
+
+        inline u32x4 AverageBytes(const u32x4 a, const u32x4 b) {
+            return (a & b) + (((a ^ b) & ByteLaneMask) >> 1);
+        }
+
+        inline u32x4 LoadU32x4(const u32 *ptr) {
+            u32x4 v;
+            __builtin_memcpy(&v, ptr, sizeof(v));
+            return v;
+        }
+
+        inline void StoreU32x4(u32 *ptr, const u32x4 v) {
+            __builtin_memcpy(ptr, &v, sizeof(v));
+        }
+
+        inline size_t GetMaxRleSize(const size_t count) {
+            return count * sizeof(u32) + (count + MaxRleChunkLength - 1) / MaxRleChunkLength;
+        }
+
+        inline u32 GetTileCount(const u32 size) {
+            return (size + ViewerRgbaTileSize - 1) / ViewerRgbaTileSize;
+        }
+
+        size_t GetMaxEncodedSize(const u32 width, const u32 height) {
+            const size_t pixel_count = width * height;
+            const auto tile_count = GetTileCount(width) * GetTileCount(height);
+            constexpr size_t MaxTilePixelCount = ViewerRgbaTileSize * ViewerRgbaTileSize;
+            // Worst case: every tile included, RLE adding a control byte every 0x80 literal pixels
+            return sizeof(ViewerEncodedRgbaHeader) + (tile_count + 7) / 8 + pixel_count * sizeof(u32) + tile_count * (GetMaxRleSize(MaxTilePixelCount) - MaxTilePixelCount * sizeof(u32));
+        }
+
+    }
+
+    void DownscaleHalfScalar(u32 *pixels, const u32 width, const u32 height) {
+        const auto dst_width = width / 2;
+        const auto dst_height = height / 2;
+        // Destination pixels never overtake the source ones still to be read, so this can be done in place
+        for(u32 y = 0; y < dst_height; y++) {
+            const auto row_0 = pixels + (2 * y) * width;
+            const auto row_1 = row_0 + width;
+            auto dst_row = pixels + y * dst_width;
+            for(u32 x = 0; x < dst_width; x++) {
+                const auto top = AverageBytes(row_0[2 * x], row_0[2 * x + 1]);
+                const auto bottom = AverageBytes(row_1[2 * x], row_1[2 * x + 1]);
+                dst_row[x] = AverageBytes(top, bottom);
+            }
+        }
+    }
+
+    void DownscaleHalfVector(u32 *pixels, const u32 width, const u32 height) {
+        const auto dst_width = width / 2;
+        const auto dst_height = height / 2;
+        constexpr u32x4 EvenMask = { 0, 2, 4, 6 };
+        constexpr u32x4 OddMask = { 1, 3, 5, 7 };
+        for(u32 y = 0; y < dst_height; y++) {
+            const auto row_0 = pixels + (2 * y) * width;
+            const auto row_1 = row_0 + width;
+            auto dst_row = pixels + y * dst_width;
+
+            u32 x = 0;
+            for(; (x + 4) <= dst_width; x += 4) {
+                const auto a_0 = LoadU32x4(row_0 + 2 * x);
+                const auto a_1 = LoadU32x4(row_0 + 2 * x + 4);
+                const auto b_0 = LoadU32x4(row_1 + 2 * x);
+                const auto b_1 = LoadU32x4(row_1 + 2 * x + 4);
+
+                const auto top = AverageBytes(__builtin_shuffle(a_0, a_1, EvenMask), __builtin_shuffle(a_0, a_1, OddMask));
+                const auto bottom = AverageBytes(__builtin_shuffle(b_0, b_1, EvenMask), __builtin_shuffle(b_0, b_1, OddMask));
+                StoreU32x4(dst_row + x, AverageBytes(top, bottom));
+            }
+
+            // Leftover pixels
+            for(; x < dst_width; x++) {
+                const auto top = AverageBytes(row_0[2 * x], row_0[2 * x + 1]);
+                const auto bottom = AverageBytes(row_1[2 * x], row_1[2 * x + 1]);
+                dst_row[x] = AverageBytes(top, bottom);
+            }
+        }
+    }
+
+    bool TileRowEqualsScalar(const u32 *a, const u32 *b, const u32 count) {
+        return memcmp(a, b, count * sizeof(u32)) == 0;
+    }
+
+    bool TileRowEqualsVector(const u32 *a, const u32 *b, const u32 count) {
+        u32x4 diff = {};
+        u32 i = 0;
+        for(; (i + 4) <= count; i += 4) {
+            diff |= LoadU32x4(a + i) ^ LoadU32x4(b + i);
+        }
+        auto diff_scalar = diff[0] | diff[1] | diff[2] | diff[3];
+        for(; i < count; i++) {
+            diff_scalar |= a[i] ^ b[i];
+        }
+        return diff_scalar == 0;
+    }
+
+    size_t EncodeRle(const u32 *pixels, const size_t count, u8 *out) {
+        auto out_ptr = out;
+        size_t i = 0;
+        while(i < count) {
+            // Runs are worth it from two equal pixels onwards
+            size_t run_len = 1;
+            while(((i + run_len) < count) && (run_len < MaxRleChunkLength) && (pixels[i + run_len] == pixels[i])) {
+                run_len++;
+            }
+
+            if(run_len >= 2) {
+                *out_ptr++ = RleRunFlag | static_cast<u8>(run_len - 1);
+                __builtin_memcpy(out_ptr, pixels + i, sizeof(u32));
+                out_ptr += sizeof(u32);
+                i += run_len;
+            }
+            else {
+                // Literals until the next run starts
+                size_t literal_len = 1;
+                while(((i + literal_len) < count) && (literal_len < MaxRleChunkLength)) {
+                    const auto next_idx = i + literal_len;
+                    if(((next_idx + 1) < count) && (pixels[next_idx] == pixels[next_idx + 1])) {
+                        break;
+                    }
+                    literal_len++;
+                }
+
+                *out_ptr++ = static_cast<u8>(literal_len - 1);
+                __builtin_memcpy(out_ptr, pixels + i, literal_len * sizeof(u32));
+                out_ptr += literal_len * sizeof(u32);
+                i += literal_len;
+            }
+        }
+        return out_ptr - out;
+    }
+
+    size_t DecodeRle(const u8 *data, const size_t data_size, u32 *out_pixels, const size_t max_count) {
+        size_t offset = 0;
+        size_t count = 0;
+        while(offset < data_size) {
+            const auto ctrl = data[offset++];
+            const size_t len = (ctrl & ~RleRunFlag) + 1;
+            if((count + len) > max_count) {
+                return 0;
+            }
+
+            if(ctrl & RleRunFlag) {
+                if((offset + sizeof(u32)) > data_size) {
+                    return 0;
+                }
+                u32 px;
+                __builtin_memcpy(&px, data + offset, sizeof(u32));
+                offset += sizeof(u32);
+                for(size_t i = 0; i < len; i++) {
+                    out_pixels[count++] = px;
+                }
+            }
+            else {
+                if((offset + len * sizeof(u32)) > data_size) {
+                    return 0;
+                }
+                __builtin_memcpy(out_pixels + count, data + offset, len * sizeof(u32));
+                offset += len * sizeof(u32);
+                count += len;
+            }
+        }
+        return count;
+    }
+
+    bool ViewerRgbaEncoder::IsTileChanged(const u32 *frame, const u32 tile_x, const u32 tile_y) const {
+        const auto x = tile_x * ViewerRgbaTileSize;
+        const auto y = tile_y * ViewerRgbaTileSize;
+        const auto tile_width = std::min(ViewerRgbaTileSize, this->width - x);
+        const auto tile_height = std::min(ViewerRgbaTileSize, this->height - y);
+        for(u32 row = 0; row < tile_height; row++) {
+            const auto offset = (y + row) * this->width + x;
+            const auto equal = (this->cfg.kernel == ViewerRgbaKernel::Vector) ? TileRowEqualsVector(frame + offset, this->prev_frame + offset, tile_width) : TileRowEqualsScalar(frame + offset, this->prev_frame + offset, tile_width);
+            if(!equal) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    u32 ViewerRgbaEncoder::GatherTile(const u32 *frame, const u32 tile_x, const u32 tile_y) {
+        const auto x = tile_x * ViewerRgbaTileSize;
+        const auto y = tile_y * ViewerRgbaTileSize;
+        const auto tile_width = std::min(ViewerRgbaTileSize, this->width - x);
+        const auto tile_height = std::min(ViewerRgbaTileSize, this->height - y);
+        for(u32 row = 0; row < tile_height; row++) {
+            __builtin_memcpy(this->tile_scratch + row * tile_width, frame + (y + row) * this->width + x, tile_width * sizeof(u32));
+        }
+        return tile_width * tile_height;
+    }
+
+    void ViewerRgbaEncoder::StoreTile(const u32 *frame, const u32 tile_x, const u32 tile_y) {
+        const auto x = tile_x * ViewerRgbaTileSize;
+        const auto y = tile_y * ViewerRgbaTileSize;
+        const auto tile_width = std::min(ViewerRgbaTileSize, this->width - x);
+        const auto tile_height = std::min(ViewerRgbaTileSize, this->height - y);
+        for(u32 row = 0; row < tile_height; row++) {
+            const auto offset = (y + row) * this->width + x;
+            __builtin_memcpy(this->prev_frame + offset, frame + offset, tile_width * sizeof(u32));
+        }
+    }
+
+    size_t ViewerRgbaEncoder::GetRequiredMemorySize(const ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height) {
+        const auto downscale_shift = std::min(cfg.downscale_shift, ViewerRgbaMaxDownscaleShift);
+        const auto width = src_width >> downscale_shift;
+        const auto height = src_height >> downscale_shift;
+
+        auto size = GetMaxEncodedSize(width, height);
+        if(cfg.delta_enabled) {
+            size += width * height * sizeof(u32);
+        }
+        return size;
+    }
+
+    ViewerRgbaEncoderFallback ViewerRgbaEncoder::FitConfigToMemory(ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height, const size_t available_size) {
+        auto fallback = ViewerRgbaEncoderFallback::None;
+        while(GetRequiredMemorySize(cfg, src_width, src_height) > available_size) {
+            if(cfg.downscale_shift < ViewerRgbaMaxDownscaleShift) {
+                cfg.downscale_shift++;
+                fallback = ViewerRgbaEncoderFallback::Downscaled;
+            }
+            else if(cfg.delta_enabled) {
+                cfg.delta_enabled = false;
+                fallback = ViewerRgbaEncoderFallback::DeltaDisabled;
+            }
+            else {
+                return ViewerRgbaEncoderFallback::PlainFrames;
+            }
+        }
+        return fallback;
+    }
+
+    bool ViewerRgbaEncoder::Initialize(const ViewerRgbaEncoderConfig &cfg, const u32 src_width, const u32 src_height) {
+        this->Finalize();
+
+        this->cfg = cfg;
+        this->cfg.downscale_shift = std::min(cfg.downscale_shift, ViewerRgbaMaxDownscaleShift);
+        this->width = src_width >> this->cfg.downscale_shift;
+        this->height = src_height >> this->cfg.downscale_shift;
+        this->tiles_x = GetTileCount(this->width);
+        this->tiles_y = GetTileCount(this->height);
+
+        const size_t pixel_count = this->width * this->height;
+        this->out_buf_size = GetMaxEncodedSize(this->width, this->height);
+        this->out_buf = reinterpret_cast<u8*>(mem::Allocate(mem::Tag::Usb, this->out_buf_size));
+        if(this->out_buf == nullptr) {
+            this->Finalize();
+            return false;
+        }
+
+        if(this->cfg.delta_enabled) {
+            this->prev_frame = reinterpret_cast<u32*>(mem::Allocate(mem::Tag::Usb, pixel_count * sizeof(u32)));
+            if(this->prev_frame == nullptr) {
+                this->Finalize();
+                return false;
+            }
+        }
+
+        this->has_prev_frame = false;
+        return true;
+    }
+
+    void ViewerRgbaEncoder::Finalize() {
+        if(this->out_buf != nullptr) {
+            mem::Free(this->out_buf);
+            this->out_buf = nullptr;
+        }
+        if(this->prev_frame != nullptr) {
+            mem::Free(this->prev_frame);
+            this->prev_frame = nullptr;
+        }
+        this->out_buf_size = 0;
+        this->has_prev_frame = false;
+    }
+
+    size_t ViewerRgbaEncoder::Encode(u32 *frame) {
+        auto cur_width = this->width << this->cfg.downscale_shift;
+        auto cur_height = this->height << this->cfg.downscale_shift;
+        for(u32 i = 0; i < this->cfg.downscale_shift; i++) {
+            if(this->cfg.kernel == ViewerRgbaKernel::Vector) {
+                DownscaleHalfVector(frame, cur_width, cur_height);
+            }
+            else {
+                DownscaleHalfScalar(frame, cur_width, cur_height);
+            }
+            cur_width /= 2;
+            cur_height /= 2;
+        }
+
+        const auto is_keyframe = !this->cfg.delta_enabled || !this->has_prev_frame;
+        auto header = reinterpret_cast<ViewerEncodedRgbaHeader*>(this->out_buf);
+        *header = {
+            .width = static_cast<u16>(this->width),
+            .height = static_cast<u16>(this->height),
+            .tile_size = static_cast<u16>(ViewerRgbaTileSize),
+            .flags = static_cast<u8>((is_keyframe ? ViewerEncodedRgbaFlags_Keyframe : 0) | (this->cfg.rle_enabled ? ViewerEncodedRgbaFlags_Rle : 0))
+        };
+
+        auto tile_bitmap = this->out_buf + sizeof(ViewerEncodedRgbaHeader);
+        const auto tile_bitmap_size = (this->tiles_x * this->tiles_y + 7) / 8;
+        memset(tile_bitmap, 0, tile_bitmap_size);
+
+        auto tile_data = tile_bitmap + tile_bitmap_size;
+        size_t tile_data_size = 0;
+        u32 tile_idx = 0;
+        for(u32 tile_y = 0; tile_y < this->tiles_y; tile_y++) {
+            for(u32 tile_x = 0; tile_x < this->tiles_x; tile_x++, tile_idx++) {
+                if(!is_keyframe && !this->IsTileChanged(frame, tile_x, tile_y)) {
+                    continue;
+                }
+
+                tile_bitmap[tile_idx / 8] |= BIT(tile_idx % 8);
+                header->included_tile_count++;
+
+                const auto tile_pixel_count = this->GatherTile(frame, tile_x, tile_y);
+                if(this->cfg.rle_enabled) {
+                    tile_data_size += EncodeRle(this->tile_scratch, tile_pixel_count, tile_data + tile_data_size);
+                }
+                else {
+                    __builtin_memcpy(tile_data + tile_data_size, this->tile_scratch, tile_pixel_count * sizeof(u32));
+                    tile_data_size += tile_pixel_count * sizeof(u32);
+                }
+
+                if(this->cfg.delta_enabled) {
+                    this->StoreTile(frame, tile_x, tile_y);
+                }
+            }
+        }
+
+        header->tile_data_size = tile_data_size;
+        this->has_prev_frame = this->cfg.delta_enabled;
+        return sizeof(ViewerEncodedRgbaHeader) + tile_bitmap_size + tile_data_size;
+    }
+
+}
\ No newline at end of file
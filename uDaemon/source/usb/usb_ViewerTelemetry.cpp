@@ -0,0 +1,110 @@
+#include <usb/usb_ViewerTelemetry.hpp>
+#include <util/util_SpscRing.hpp>
+#include <mem/mem_Heap.hpp>
+
+namespace usb {
+
+    namespace {
+
+        // Written by the main thread, read by the viewer thread
+        std::atomic<u32> g_MainLoopWakeupCount = 0;
+        util::SpscRing<ViewerTelemetryLaunchLatency, 16> g_LaunchLatencyRing;
+
+        // Written before the viewer thread exists
+        ViewerRgbaEncoderFallback g_RgbaEncoderFallback = ViewerRgbaEncoderFallback::None;
+        u32 g_RgbaDownscaleShift = 0;
+
+        // Only accessed by the viewer thread
+        u64 g_LastSnapshotTick = 0;
+        u64 g_LastDroppedLaunchLatencyCount = 0;
+        u32 g_FrameCount = 0;
+        u64 g_FrameBytes = 0;
+        u64 g_TotalCaptureNs = 0;
+        u64 g_MaxCaptureNs = 0;
+        u64 g_TotalEncodeNs = 0;
+        u64 g_MaxEncodeNs = 0;
+
+        inline u32 ToUs(const u64 ns) {
+            return static_cast<u32>(ns / 1'000);
+        }
+
+        void SendSnapshot(ViewerChannel &channel, const u64 interval_ns) {
+            const auto dropped_count = g_LaunchLatencyRing.GetOverflowCount();
+            dmi::DaemonHeapStats heap_stats = {};
+            mem::GetHeapStats(heap_stats);
+            ViewerTelemetrySnapshot snapshot = {
+                .interval_ms = static_cast<u32>(interval_ns / 1'000'000),
+                .main_loop_wakeup_count = g_MainLoopWakeupCount.exchange(0),
+                .heap_used_size = heap_stats.used_size,
+                .heap_peak_used_size = heap_stats.peak_used_size,
+                .frame_count = g_FrameCount,
+                .frame_bytes = static_cast<u32>(g_FrameBytes),
+                .max_capture_us = ToUs(g_MaxCaptureNs),
+                .max_encode_us = ToUs(g_MaxEncodeNs),
+                .dropped_launch_latency_count = static_cast<u32>(dropped_count - g_LastDroppedLaunchLatencyCount),
+                .rgba_encoder_fallback = g_RgbaEncoderFallback,
+                .rgba_downscale_shift = static_cast<u8>(g_RgbaDownscaleShift)
+            };
+            if(g_FrameCount > 0) {
+                snapshot.avg_capture_us = ToUs(g_TotalCaptureNs / g_FrameCount);
+                snapshot.avg_encode_us = ToUs(g_TotalEncodeNs / g_FrameCount);
+            }
+            channel.Send(ViewerStreamId::Telemetry, static_cast<u16>(ViewerTelemetryType::Snapshot), &snapshot, sizeof(snapshot));
+
+            g_LastDroppedLaunchLatencyCount = dropped_count;
+            g_FrameCount = 0;
+            g_FrameBytes = 0;
+            g_TotalCaptureNs = 0;
+            g_MaxCaptureNs = 0;
+            g_TotalEncodeNs = 0;
+            g_MaxEncodeNs = 0;
+        }
+
+    }
+
+    void NotifyMainLoopWakeup() {
+        g_MainLoopWakeupCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void NotifyLaunchLatency(const os::LaunchTitleType type, const os::LaunchLatencySample &sample) {
+        // If no viewer drains them they just get dropped
+        g_LaunchLatencyRing.TryPush({ type, sample });
+    }
+
+    void NotifyRgbaEncoderFallback(const ViewerRgbaEncoderFallback fallback, const u32 downscale_shift) {
+        g_RgbaEncoderFallback = fallback;
+        g_RgbaDownscaleShift = downscale_shift;
+    }
+
+    void NotifyFrameTimings(const u64 capture_ticks, const u64 encode_ticks, const size_t frame_size) {
+        const auto capture_ns = armTicksToNs(capture_ticks);
+        const auto encode_ns = armTicksToNs(encode_ticks);
+        g_FrameCount++;
+        g_FrameBytes += frame_size;
+        g_TotalCaptureNs += capture_ns;
+        g_MaxCaptureNs = std::max(g_MaxCaptureNs, capture_ns);
+        g_TotalEncodeNs += encode_ns;
+        g_MaxEncodeNs = std::max(g_MaxEncodeNs, encode_ns);
+        mem::UpdateHeapUsage();
+    }
+
+    void FlushTelemetry(ViewerChannel &channel) {
+        ViewerTelemetryLaunchLatency latency;
+        while(g_LaunchLatencyRing.TryPop(latency)) {
+            channel.Send(ViewerStreamId::Telemetry, static_cast<u16>(ViewerTelemetryType::LaunchLatency), &latency, sizeof(latency));
+        }
+
+        const auto cur_tick = armGetSystemTick();
+        if(g_LastSnapshotTick == 0) {
+            g_LastSnapshotTick = cur_tick;
+            return;
+        }
+
+        const auto interval_ns = armTicksToNs(cur_tick - g_LastSnapshotTick);
+        if(interval_ns >= ViewerTelemetryIntervalMs * 1'000'000) {
+            SendSnapshot(channel, interval_ns);
+            g_LastSnapshotTick = cur_tick;
+        }
+    }
+
+}
\ No newline at end of file
@@ -20,6 +20,8 @@ namespace am {
     AppletId LibraryAppletGetAppletIdForProgramId(const u64 id);
 
     AppletId LibraryAppletGetId();
+    // Increases with every successfully started applet (0 if none was started yet)
+    u32 LibraryAppletGetInstanceId();
 
     bool LibraryAppletIsMenu();
     void LibraryAppletSetMenuAppletId(const AppletId id);
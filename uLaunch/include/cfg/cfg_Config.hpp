@@ -4,6 +4,7 @@
 #include <hb/hb_Target.hpp>
 #include <fs/fs_Stdio.hpp>
 #include <util/util_Convert.hpp>
+#include <cfg/cfg_ThemePack.hpp>
 
 namespace cfg {
 
@@ -71,6 +72,10 @@ namespace cfg {
         inline bool IsDefault() {
             return this->base_name.empty();
         }
+
+        inline bool IsPack() {
+            return IsThemePackName(this->base_name);
+        }
     };
 
     struct RecordStrings {
@@ -89,7 +94,12 @@ namespace cfg {
         HomebrewAppletTakeoverProgramId,
         HomebrewApplicationTakeoverApplicationId,
         ViewerUsbEnabled,
-        ActiveThemeName
+        ActiveThemeName,
+        ViewerUsbRgbaDownscaleShift,
+        ViewerUsbRgbaDeltaEnabled,
+        ViewerUsbRgbaRleEnabled,
+        ViewerUsbVectorKernelsEnabled,
+        MenuJumpsEnabled
     };
 
     enum class ConfigEntryType : u8 {
@@ -207,7 +217,8 @@ namespace cfg {
             switch(id) {
                 case ConfigEntryId::MenuTakeoverProgramId:
                 case ConfigEntryId::HomebrewAppletTakeoverProgramId:
-                case ConfigEntryId::HomebrewApplicationTakeoverApplicationId: {
+                case ConfigEntryId::HomebrewApplicationTakeoverApplicationId:
+                case ConfigEntryId::ViewerUsbRgbaDownscaleShift: {
                     if constexpr(std::is_same_v<T, u64>) {
                         new_entry.header.type = ConfigEntryType::U64;
                         new_entry.header.size = sizeof(t);
@@ -218,7 +229,11 @@ namespace cfg {
                         return false;
                     }
                 }
-                case ConfigEntryId::ViewerUsbEnabled: {
+                case ConfigEntryId::ViewerUsbEnabled:
+                case ConfigEntryId::ViewerUsbRgbaDeltaEnabled:
+                case ConfigEntryId::ViewerUsbRgbaRleEnabled:
+                case ConfigEntryId::ViewerUsbVectorKernelsEnabled:
+                case ConfigEntryId::MenuJumpsEnabled: {
                     if constexpr(std::is_same_v<T, bool>) {
                         new_entry.header.type = ConfigEntryType::Bool;
                         new_entry.header.size = sizeof(t);
@@ -305,6 +320,46 @@ namespace cfg {
                         return false;
                     }
                 }
+                case ConfigEntryId::ViewerUsbRgbaDownscaleShift: {
+                    if constexpr(std::is_same_v<T, u64>) {
+                        // Full resolution by default
+                        out_t = 0;
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                case ConfigEntryId::ViewerUsbRgbaDeltaEnabled:
+                case ConfigEntryId::ViewerUsbRgbaRleEnabled: {
+                    if constexpr(std::is_same_v<T, bool>) {
+                        // Plain frames by default
+                        out_t = false;
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                case ConfigEntryId::ViewerUsbVectorKernelsEnabled: {
+                    if constexpr(std::is_same_v<T, bool>) {
+                        out_t = true;
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                case ConfigEntryId::MenuJumpsEnabled: {
+                    if constexpr(std::is_same_v<T, bool>) {
+                        // L/R/ZL/ZR open the quick menu by default
+                        out_t = false;
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                }
             }
             return false;
         }
@@ -323,10 +378,14 @@ namespace cfg {
     std::string GetRecordIconPath(const TitleRecord &record);
     std::string GetRecordJsonPath(const TitleRecord &record);
     RecordInformation GetRecordInformation(const TitleRecord &record);
+    // Custom name if present, otherwise the one cached by CacheEverything (empty if unknown), without reading the NACP again
+    std::string GetRecordName(const TitleRecord &record);
 
     Theme LoadTheme(const std::string &base_name);
     std::vector<Theme> LoadThemes();
     std::string GetAssetByTheme(const Theme &base, const std::string &resource_base);
+    // Files directly inside the given directory of the theme or of the default theme, since assets fall back to it
+    std::vector<std::string> ListAssetsByTheme(const Theme &base, const std::string &resource_dir);
 
     inline std::string GetLanguageJSONPath(const std::string &lang) {
         return UL_BASE_SD_DIR "/lang/" + lang + ".json";
@@ -339,13 +398,13 @@ namespace cfg {
 
     void SaveConfig(const Config &cfg);
 
+    // Records get written in the background, cfg::FlushRecords waits for them (see cfg_RecordStore.hpp)
     void SaveRecord(const TitleRecord &record);
-    
-    inline void RemoveRecord(const TitleRecord &record) {
-        fs::DeleteFile(cfg::GetRecordJsonPath(record));
-    }
+    void RemoveRecord(const TitleRecord &record);
 
     bool MoveRecordTo(TitleList &list, const TitleRecord &record, const std::string &folder);
+    // Moves the given root titles (by index) to a folder in a single pass and batched write, returns how many got moved
+    u32 MoveRootRecordsTo(TitleList &list, const std::vector<u32> &root_title_idxs, const std::string &folder);
     TitleFolder &FindFolderByName(TitleList &list, const std::string &name);
     void RenameFolder(TitleList &list, const std::string &old_name, const std::string &new_name);
     bool ExistsRecord(const TitleList &list, const TitleRecord &record);
@@ -0,0 +1,79 @@
+
+#pragma once
+#include <cfg/cfg_Config.hpp>
+#include <map>
+
+namespace cfg {
+
+    // Record mutations get collected (only the last one per record is kept) and written in a single pass on commit
+    // Every commit is first written as a journal with a single write, so that an interrupted commit gets replayed on the next load instead of leaving some records updated (or truncated) and others not
+
+    // Deferred commits get merged (per record) into a single pending transaction, written by a worker thread once no mutation came for a while or at most after a deadline since the oldest pending one
+    // Whatever is pending must be flushed before uMenu goes away (launching a title, restarting the menu...) since it only lives in memory until then
+
+    #define CFG_RECORD_JOURNAL_FILE UL_BASE_SD_DIR "/entries.journal"
+
+    constexpr u32 RecordJournalMagic = 0x4A524C55; // "ULRJ"
+
+    constexpr u64 RecordWriteIdleDelayNs = 500'000'000ul;
+    constexpr u64 RecordWriteDeadlineNs = 3'000'000'000ul;
+
+    enum class RecordOperationType : u32 {
+        Save = 0,
+        Remove = 1
+    };
+
+    struct RecordOperation {
+        RecordOperationType type;
+        std::string json_data;
+    };
+
+    // Everything the record store needs from the system (files, clock, timed waits) goes through here, so that commits and the writer thread can be driven by fake backends outside of the console
+    struct RecordStoreBackend {
+        bool (*write_file)(const std::string &path, const void *data, const size_t size);
+        bool (*read_file)(const std::string &path, std::string &out_data);
+        void (*delete_file)(const std::string &path);
+        bool (*exists_file)(const std::string &path);
+        u64 (*get_current_ns)();
+        // Waits until woken or until the timeout expires, like condvarWaitTimeout
+        void (*wait_timeout)(CondVar *condvar, Mutex *lock, const u64 timeout_ns);
+    };
+
+    // Defaults to the SD card and the system clock, only meant to be replaced before anything else gets done
+    void SetRecordStoreBackend(const RecordStoreBackend &backend);
+
+    std::string SerializeRecord(const TitleRecord &record);
+
+    class RecordTransaction {
+        private:
+            std::map<std::string, RecordOperation> ops; // Keyed by record JSON path
+
+        public:
+            void Save(const TitleRecord &record);
+            void Remove(const TitleRecord &record);
+            // Later mutations of the same record replace the ones in this transaction, the other one is left empty
+            void Merge(RecordTransaction &&other);
+
+            inline size_t GetOperationCount() const {
+                return this->ops.size();
+            }
+
+            inline bool IsEmpty() const {
+                return this->ops.empty();
+            }
+
+            // Nothing is applied if the journal can't be written; on failure the mutations are kept in this transaction, so that they can be retried
+            bool Commit();
+            // Queues the mutations for the worker to write them, leaving this transaction empty
+            void CommitDeferred();
+    };
+
+    // Barrier: returns once everything queued so far got written
+    void FlushRecords();
+    // Writes anything still pending before stopping the worker
+    void ExitRecordWriter();
+
+    // Replays a journal left by an interrupted commit (discarded if it was not fully written), must be done before reading the entries
+    void RecoverRecordJournal();
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace cfg {
+
+    // Single-file themes: "<name>.ultheme" files placed in the themes directory, next to regular theme directories
+    // Layout: header, asset table (sorted by path), manifest JSON, then every asset blob aligned to ThemePackAlignment
+    // Assets of opened packs are reachable by path as "ultheme:/<name>.ultheme/<asset>", so path-based UI code works unchanged
+
+    #define CFG_THEME_PACK_EXTENSION ".ultheme"
+    #define CFG_THEME_PACK_DEVICE "ultheme"
+
+    constexpr u32 ThemePackMagic = 0x50544C55; // "ULTP"
+    constexpr u32 CurrentThemePackVersion = 1;
+    constexpr size_t ThemePackAlignment = 0x1000;
+    constexpr size_t ThemePackAssetPathLength = 0x40;
+    // Hot assets: the small ones inside "ui/" (icons and such, read again whenever a menu reloads its items)
+    constexpr size_t MaxHotThemePackAssetSize = 0x10000;
+
+    struct ThemePackHeader {
+        u32 magic;
+        u32 version;
+        u32 asset_count;
+        u32 asset_table_offset;
+        u32 manifest_offset;
+        u32 manifest_size;
+        u32 file_size;
+        u32 reserved;
+    };
+    static_assert(sizeof(ThemePackHeader) == 0x20);
+
+    struct ThemePackAsset {
+        char path[ThemePackAssetPathLength];
+        u32 offset;
+        u32 size;
+        u8 reserved[8];
+    };
+    static_assert(sizeof(ThemePackAsset) == 0x50);
+
+    inline bool IsThemePackHotAsset(const ThemePackAsset &asset) {
+        return (strncmp(asset.path, "ui/", 3) == 0) && (asset.size <= MaxHotThemePackAssetSize);
+    }
+
+    inline bool IsThemePackName(const std::string &base_name) {
+        constexpr size_t ext_len = __builtin_strlen(CFG_THEME_PACK_EXTENSION);
+        return (base_name.length() > ext_len) && (base_name.compare(base_name.length() - ext_len, ext_len, CFG_THEME_PACK_EXTENSION) == 0);
+    }
+
+    inline std::string GetThemePackMountPath(const std::string &base_name) {
+        return CFG_THEME_PACK_DEVICE ":/" + base_name;
+    }
+
+    // Reads the pack's header, asset table and manifest (assets are read from the file on demand) and makes it reachable through the device
+    bool OpenThemePack(const std::string &base_name, std::string &out_manifest);
+
+    // Keeps the pack's hot assets in memory, everything else (backgrounds, sounds, the BGM while it streams...) keeps being read from the file on demand
+    bool LoadThemePackHotAssets(const std::string &base_name);
+
+    void CloseThemePack(const std::string &base_name);
+    bool IsThemePackOpen(const std::string &base_name);
+
+    // Names of the assets directly inside the given directory
+    bool ListThemePackAssets(const std::string &base_name, const std::string &asset_dir, std::vector<std::string> &out_names);
+
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+
+#pragma once
+#include <cfg/cfg_Config.hpp>
+#include <unordered_map>
+
+namespace cfg {
+
+    // Case-insensitive substring search over record names (see GetRecordName), through a trigram index
+    // Queries of at least 3 characters only verify the entries holding their rarest trigram, shorter ones scan every name
+    // Names are compared as UTF-8 bytes, only ASCII letters are case-folded
+
+    // Application ID or NRO path, stable across moves between folders
+    std::string GetRecordKey(const TitleRecord &record);
+
+    class TitleIndex {
+        private:
+            struct Entry {
+                std::string key;
+                std::string name;
+                bool removed;
+            };
+
+            std::vector<Entry> entries;
+            std::unordered_map<std::string, u32> key_table;
+            std::unordered_map<u32, std::vector<u32>> trigram_table; // Entry indexes, increasing
+
+        public:
+            // Replaces any previous entry of the same record
+            void Add(const TitleRecord &record);
+            void Remove(const TitleRecord &record);
+            void Clear();
+
+            inline size_t GetCount() const {
+                return this->key_table.size();
+            }
+
+            // Keys of the matching records, in no particular order
+            std::vector<std::string> Find(const std::string &query) const;
+    };
+
+    // Root titles and every folder's titles
+    void BuildTitleIndex(const TitleList &list, TitleIndex &out_index);
+
+}
\ No newline at end of file
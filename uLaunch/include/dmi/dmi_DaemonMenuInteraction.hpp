@@ -18,9 +18,74 @@ namespace dmi {
 
     enum class MenuMessage : u32 {
         Invalid,
-        HomeRequest
+        HomeRequest,
+        SdCardEjected,
+        ApplicationExited
     };
 
+    // Messages are queued by the daemon, each one tagged with an increasing sequence number (gaps mean that messages were dropped)
+
+    struct MenuMessageContext {
+        MenuMessage msg;
+        u32 seq;
+        union {
+            struct {
+                u64 app_id;
+            } app_exited;
+            u8 data[0x18];
+        };
+    };
+    static_assert(sizeof(MenuMessageContext) == 0x20);
+
+    constexpr size_t MaxMenuMessageBatchCount = 16;
+
+    // Messages missed between the last received one and this one (none before the first one received)
+    inline constexpr u32 GetMissedMenuMessageCount(const u32 last_seq, const u32 seq) {
+        if((last_seq == 0) || (seq <= (last_seq + 1))) {
+            return 0;
+        }
+        return seq - last_seq - 1;
+    }
+
+    // Counted by the daemon since it started
+    struct MenuMessageStats {
+        u64 dropped_count;
+        u32 queued_count;
+        u32 reserved;
+    };
+    static_assert(sizeof(MenuMessageStats) == 0x10);
+
+    // uDaemon's heap usage, as a whole and per subsystem (tag)
+
+    enum class DaemonHeapTag : u32 {
+        Other,
+        Ipc,
+        Usb,
+        Config,
+        Ecs,
+
+        Count
+    };
+
+    constexpr size_t DaemonHeapTagCount = static_cast<size_t>(DaemonHeapTag::Count);
+
+    struct DaemonHeapTagStats {
+        u64 cur_size;
+        u64 peak_size;
+        u32 alloc_count;
+        u32 free_count;
+    };
+
+    struct DaemonHeapStats {
+        u64 heap_size;
+        u64 used_size;
+        u64 peak_used_size;
+        u32 pool_used_block_count;
+        u32 pool_peak_used_block_count;
+        DaemonHeapTagStats tags[DaemonHeapTagCount];
+    };
+    static_assert(sizeof(DaemonHeapStats) == 0x20 + DaemonHeapTagCount * sizeof(DaemonHeapTagStats));
+
     enum class DaemonMessage : u32 {
         Invalid,
         SetSelectedUser,
@@ -41,35 +106,125 @@ namespace dmi {
         char fw_version[0x18]; // System version (sent by uDaemon so that it contains Atmosphere/EmuMMC info)
     };
 
+    // Request/response layouts of each message, pushed/popped as a whole
+    // They're packed, so that the wire format is byte-identical to pushing each field one after another
+
+    struct EmptyCommandData {};
+
+    struct SetSelectedUserRequest {
+        AccountUid user_id;
+    } __attribute__((packed));
+    static_assert(sizeof(SetSelectedUserRequest) == 0x10);
+
+    // Sent along with launch commands, so that uDaemon can match the launch with uMenu's checkpoints (system ticks)
+    struct LaunchTrace {
+        u32 correlation_id;
+        u32 reserved;
+        u64 input_tick;
+        u64 send_tick;
+    } __attribute__((packed));
+    static_assert(sizeof(LaunchTrace) == 0x18);
+
+    struct LaunchApplicationRequest {
+        u64 app_id;
+        LaunchTrace trace;
+    } __attribute__((packed));
+    static_assert(sizeof(LaunchApplicationRequest) == 0x20);
+
+    struct LaunchHomebrewLibraryAppletRequest {
+        hb::HbTargetParams params;
+        LaunchTrace trace;
+    } __attribute__((packed));
+    static_assert(sizeof(LaunchHomebrewLibraryAppletRequest) == 0x620);
+
+    struct LaunchHomebrewApplicationRequest {
+        u64 app_id;
+        hb::HbTargetParams params;
+        LaunchTrace trace;
+    } __attribute__((packed));
+    static_assert(sizeof(LaunchHomebrewApplicationRequest) == 0x628);
+
+    constexpr size_t MaxWebPageUrlLength = 500;
+
+    struct OpenWebPageRequest {
+        char url[MaxWebPageUrlLength];
+    } __attribute__((packed));
+    static_assert(sizeof(OpenWebPageRequest) == 0x1F4);
+
+    template<DaemonMessage Msg>
+    struct DaemonCommand {
+        using Request = EmptyCommandData;
+        using Response = EmptyCommandData;
+    };
+
+    #define UL_DMI_DEFINE_DAEMON_COMMAND(msg, req, resp) \
+    template<> \
+    struct DaemonCommand<DaemonMessage::msg> { \
+        using Request = req; \
+        using Response = resp; \
+    }
+
+    UL_DMI_DEFINE_DAEMON_COMMAND(SetSelectedUser, SetSelectedUserRequest, EmptyCommandData);
+    UL_DMI_DEFINE_DAEMON_COMMAND(LaunchApplication, LaunchApplicationRequest, EmptyCommandData);
+    UL_DMI_DEFINE_DAEMON_COMMAND(LaunchHomebrewLibraryApplet, LaunchHomebrewLibraryAppletRequest, EmptyCommandData);
+    UL_DMI_DEFINE_DAEMON_COMMAND(LaunchHomebrewApplication, LaunchHomebrewApplicationRequest, EmptyCommandData);
+    UL_DMI_DEFINE_DAEMON_COMMAND(OpenWebPage, OpenWebPageRequest, EmptyCommandData);
+
+    #undef UL_DMI_DEFINE_DAEMON_COMMAND
+
     using CommandFunction = Result(*)(void*, const size_t, const bool);
 
     struct CommandCommonHeader {
         u32 magic;
         u32 val;
     };
+    static_assert(sizeof(CommandCommonHeader) == 0x8);
 
     constexpr u32 CommandMagic = 0x444D4930;
     constexpr size_t CommandStorageSize = 0x800;
 
+    // Batched frames start with this header (in place of a CommandCommonHeader), followed by each message as:
+    // CommandCommonHeader + u32 payload size + payload
+    // The reply follows the same layout, with each header value being the result of the corresponding message
+
+    struct CommandBatchHeader {
+        u32 magic;
+        u32 count;
+    };
+    static_assert(sizeof(CommandBatchHeader) == sizeof(CommandCommonHeader));
+
+    constexpr u32 CommandBatchMagic = 0x444D4931;
+    constexpr u32 MaxBatchCommandCount = 16;
+
     namespace impl {
 
         using PopStorageFunction = Result(*)(AppletStorage*, const bool);
         using PushStorageFunction = Result(*)(AppletStorage*);
 
+        // Data is pushed/popped to/from a local buffer, the storage itself is only written/read once
+
         template<PushStorageFunction PushStorageFn>
         class ScopedStorageWriterBase {
             protected:
                 AppletStorage st;
                 size_t cur_offset;
+                u8 data_buf[CommandStorageSize];
 
             public:
                 ScopedStorageWriterBase() : st(), cur_offset(0) {}
 
                 ~ScopedStorageWriterBase() {
-                    UL_RC_ASSERT(PushStorage(&this->st));
                     appletStorageClose(&this->st);
                 }
 
+                // Nothing is sent until this is called: everything pushed so far is written with a single storage write, then the storage is pushed
+                inline Result Commit() {
+                    if(this->cur_offset > 0) {
+                        UL_RC_TRY(appletStorageWrite(&this->st, 0, this->data_buf, this->cur_offset));
+                    }
+                    return PushStorage(&this->st);
+                }
+
                 static inline Result PushStorage(AppletStorage *st) {
                     return PushStorageFn(st);
                 }
@@ -80,7 +235,7 @@ namespace dmi {
 
                 inline Result PushData(const void *data, const size_t size) {
                     if((cur_offset + size) <= CommandStorageSize) {
-                        UL_RC_TRY(appletStorageWrite(&this->st, this->cur_offset, data, size));
+                        memcpy(this->data_buf + this->cur_offset, data, size);
                         this->cur_offset += size;
                         return ResultSuccess;
                     }
@@ -90,8 +245,25 @@ namespace dmi {
                 }
 
                 template<typename T>
-                inline Result Push(const T t) {
-                    return this->PushData(&t, sizeof(T));
+                inline Result Push(const T &t) {
+                    static_assert(std::is_trivially_copyable_v<T>);
+                    static_assert(sizeof(T) <= CommandStorageSize);
+                    return this->PushData(std::addressof(t), sizeof(T));
+                }
+
+                inline size_t GetOffset() {
+                    return this->cur_offset;
+                }
+
+                // Overwrites already pushed data, used to fill in sizes once the payload is known
+                inline Result PushDataAt(const size_t offset, const void *data, const size_t size) {
+                    if((offset + size) <= this->cur_offset) {
+                        memcpy(this->data_buf + offset, data, size);
+                        return ResultSuccess;
+                    }
+                    else {
+                        return ResultOutOfPushSpace;
+                    }
                 }
         };
 
@@ -100,6 +272,7 @@ namespace dmi {
             protected:
                 AppletStorage st;
                 size_t cur_offset;
+                u8 data_buf[CommandStorageSize];
 
             public:
                 ScopedStorageReaderBase() : st(), cur_offset(0) {}
@@ -112,13 +285,20 @@ namespace dmi {
                     return PopStorageFn(st, wait);
                 }
 
-                inline void Initialize(const AppletStorage &st) {
+                inline Result Initialize(const AppletStorage &st) {
                     this->st = st;
+
+                    s64 st_size = 0;
+                    UL_RC_TRY(appletStorageGetSize(&this->st, &st_size));
+                    const auto read_size = std::min(static_cast<size_t>(st_size), CommandStorageSize);
+                    UL_RC_TRY(appletStorageRead(&this->st, 0, this->data_buf, read_size));
+                    memset(this->data_buf + read_size, 0, CommandStorageSize - read_size);
+                    return ResultSuccess;
                 }
 
                 inline Result PopData(void *out_data, const size_t size) {
                     if((cur_offset + size) <= CommandStorageSize) {
-                        UL_RC_TRY(appletStorageRead(&this->st, this->cur_offset, out_data, size));
+                        memcpy(out_data, this->data_buf + this->cur_offset, size);
                         this->cur_offset += size;
                         return ResultSuccess;
                     }
@@ -129,8 +309,24 @@ namespace dmi {
                 
                 template<typename T>
                 inline Result Pop(T &out_t) {
+                    static_assert(std::is_trivially_copyable_v<T>);
+                    static_assert(sizeof(T) <= CommandStorageSize);
                     return this->PopData(std::addressof(out_t), sizeof(T));
                 }
+
+                inline size_t GetOffset() {
+                    return this->cur_offset;
+                }
+
+                inline Result SetOffset(const size_t offset) {
+                    if(offset <= CommandStorageSize) {
+                        this->cur_offset = offset;
+                        return ResultSuccess;
+                    }
+                    else {
+                        return ResultOutOfPopSpace;
+                    }
+                }
         };
 
         template<typename StorageReader>
@@ -138,8 +334,7 @@ namespace dmi {
             AppletStorage st = {};
             UL_RC_TRY(StorageReader::PopStorage(&st, wait));
 
-            reader.Initialize(st);
-            return ResultSuccess;
+            return reader.Initialize(st);
         }
 
         template<typename StorageWriter>
@@ -151,8 +346,28 @@ namespace dmi {
             return ResultSuccess;
         }
 
-        template<typename StorageWriter, typename StorageReader, typename MessageType>
-        inline Result SendCommandImpl(const MessageType msg_type, std::function<Result(StorageWriter&)> push_fn, std::function<Result(StorageReader&)> pop_fn) {
+        template<typename StorageWriter, typename T>
+        inline Result PushCommandData(StorageWriter &writer, const T &t) {
+            if constexpr(std::is_empty_v<T>) {
+                return ResultSuccess;
+            }
+            else {
+                return writer.Push(t);
+            }
+        }
+
+        template<typename StorageReader, typename T>
+        inline Result PopCommandData(StorageReader &reader, T &out_t) {
+            if constexpr(std::is_empty_v<T>) {
+                return ResultSuccess;
+            }
+            else {
+                return reader.Pop(out_t);
+            }
+        }
+
+        template<typename StorageWriter, typename StorageReader, typename MessageType, typename PushFn, typename PopFn>
+        inline Result SendCommandImpl(const MessageType msg_type, PushFn &&push_fn, PopFn &&pop_fn) {
             {
                 const CommandCommonHeader in_header = {
                     .magic = CommandMagic,
@@ -164,6 +379,7 @@ namespace dmi {
                 UL_RC_TRY(writer.Push(in_header));
 
                 UL_RC_TRY(push_fn(writer));
+                UL_RC_TRY(writer.Commit());
             }
 
             {
@@ -184,8 +400,172 @@ namespace dmi {
             return ResultSuccess;
         }
 
+        // Request/response data isn't copied: both must stay alive until the batch is sent (empty data has zero size and might be null)
+
+        template<typename MessageType>
+        struct BatchCommand {
+            MessageType msg_type;
+            const void *req;
+            size_t req_size;
+            void *resp;
+            size_t resp_size;
+            Result rc;
+        };
+
+        template<typename T>
+        constexpr size_t CommandDataSize = std::is_empty_v<T> ? 0 : sizeof(T);
+
+        // Size taken by a single message inside a batch frame
+        template<typename T>
+        constexpr size_t BatchCommandDataSize = sizeof(CommandBatchHeader) + sizeof(CommandCommonHeader) + sizeof(u32) + CommandDataSize<T>;
+
+        template<typename StorageWriter, typename PushFn>
+        inline Result PushBatchPayload(StorageWriter &writer, PushFn &&push_fn) {
+            const auto size_offset = writer.GetOffset();
+            UL_RC_TRY(writer.Push(static_cast<u32>(0)));
+
+            UL_RC_TRY(push_fn(writer));
+
+            const u32 payload_size = writer.GetOffset() - size_offset - sizeof(u32);
+            return writer.PushDataAt(size_offset, &payload_size, sizeof(payload_size));
+        }
+
+        template<typename StorageReader>
+        inline Result PopBatchPayloadSize(StorageReader &reader, size_t &out_payload_end_offset) {
+            u32 payload_size = 0;
+            UL_RC_TRY(reader.Pop(payload_size));
+
+            out_payload_end_offset = reader.GetOffset() + payload_size;
+            if(out_payload_end_offset > CommandStorageSize) {
+                return ResultInvalidBatchPayloadSize;
+            }
+            return ResultSuccess;
+        }
+
         template<typename StorageWriter, typename StorageReader, typename MessageType>
-        inline Result ReceiveCommandImpl(std::function<Result(const MessageType, StorageReader&)> pop_fn, std::function<Result(const MessageType, StorageWriter&)> push_fn) {
+        inline Result SendCommandBatchImpl(BatchCommand<MessageType> *cmds, const size_t count) {
+            if((count == 0) || (count > MaxBatchCommandCount)) {
+                return ResultInvalidBatchCount;
+            }
+
+            {
+                const CommandBatchHeader in_header = {
+                    .magic = CommandBatchMagic,
+                    .count = static_cast<u32>(count)
+                };
+
+                StorageWriter writer;
+                UL_RC_TRY(OpenStorageWriter(writer));
+                UL_RC_TRY(writer.Push(in_header));
+
+                for(size_t i = 0; i < count; i++) {
+                    const auto &cmd = cmds[i];
+                    const CommandCommonHeader cmd_header = {
+                        .magic = CommandMagic,
+                        .val = static_cast<u32>(cmd.msg_type)
+                    };
+                    UL_RC_TRY(writer.Push(cmd_header));
+                    UL_RC_TRY(PushBatchPayload(writer, [&](StorageWriter &payload_writer) {
+                        return (cmd.req_size > 0) ? payload_writer.PushData(cmd.req, cmd.req_size) : ResultSuccess;
+                    }));
+                }
+                UL_RC_TRY(writer.Commit());
+            }
+
+            {
+                CommandBatchHeader out_header = {};
+
+                StorageReader reader;
+                UL_RC_TRY(OpenStorageReader(reader, true));
+                UL_RC_TRY(reader.Pop(out_header));
+                if(out_header.magic != CommandBatchMagic) {
+                    return ResultInvalidOutHeaderMagic;
+                }
+                if(out_header.count != count) {
+                    return ResultBatchCountMismatch;
+                }
+
+                for(size_t i = 0; i < count; i++) {
+                    auto &cmd = cmds[i];
+                    CommandCommonHeader cmd_header = {};
+                    UL_RC_TRY(reader.Pop(cmd_header));
+                    if(cmd_header.magic != CommandMagic) {
+                        return ResultInvalidOutHeaderMagic;
+                    }
+
+                    size_t payload_end_offset;
+                    UL_RC_TRY(PopBatchPayloadSize(reader, payload_end_offset));
+
+                    cmd.rc = cmd_header.val;
+                    if(R_SUCCEEDED(cmd.rc) && (cmd.resp_size > 0)) {
+                        cmd.rc = reader.PopData(cmd.resp, cmd.resp_size);
+                    }
+                    UL_RC_TRY(reader.SetOffset(payload_end_offset));
+                }
+            }
+
+            return ResultSuccess;
+        }
+
+        template<typename StorageWriter, typename StorageReader, typename MessageType, typename PopFn, typename PushFn>
+        inline Result ReceiveCommandBatchMessages(StorageReader &reader, StorageWriter &writer, const u32 count, PopFn &&pop_fn, PushFn &&push_fn) {
+            // Each message is fully handled (popped, then its reply pushed) before the next one, since handlers might share state between both steps
+            for(u32 i = 0; i < count; i++) {
+                CommandCommonHeader cmd_header = {};
+                UL_RC_TRY(reader.Pop(cmd_header));
+                if(cmd_header.magic != CommandMagic) {
+                    return ResultInvalidInHeaderMagic;
+                }
+
+                size_t payload_end_offset;
+                UL_RC_TRY(PopBatchPayloadSize(reader, payload_end_offset));
+
+                const auto msg_type = static_cast<MessageType>(cmd_header.val);
+                cmd_header.val = pop_fn(msg_type, reader);
+                UL_RC_TRY(reader.SetOffset(payload_end_offset));
+
+                const auto cmd_header_offset = writer.GetOffset();
+                UL_RC_TRY(writer.Push(cmd_header));
+                if(R_SUCCEEDED(cmd_header.val)) {
+                    const auto rc = PushBatchPayload(writer, [&](StorageWriter &payload_writer) {
+                        return push_fn(msg_type, payload_writer);
+                    });
+                    if(R_FAILED(rc)) {
+                        cmd_header.val = rc;
+                        UL_RC_TRY(writer.PushDataAt(cmd_header_offset, &cmd_header, sizeof(cmd_header)));
+                    }
+                }
+                else {
+                    UL_RC_TRY(writer.Push(static_cast<u32>(0)));
+                }
+            }
+
+            return ResultSuccess;
+        }
+
+        template<typename StorageWriter, typename StorageReader, typename MessageType, typename PopFn, typename PushFn>
+        inline Result ReceiveCommandBatchImpl(StorageReader &reader, const u32 count, PopFn &&pop_fn, PushFn &&push_fn) {
+            if((count == 0) || (count > MaxBatchCommandCount)) {
+                return ResultInvalidBatchCount;
+            }
+
+            const CommandBatchHeader out_header = {
+                .magic = CommandBatchMagic,
+                .count = count
+            };
+
+            StorageWriter writer;
+            UL_RC_TRY(OpenStorageWriter(writer));
+            UL_RC_TRY(writer.Push(out_header));
+
+            // The sender is waiting for the reply, thus it's sent even if some message was malformed (the sender will fail to parse what's missing)
+            const auto rc = ReceiveCommandBatchMessages<StorageWriter, StorageReader, MessageType>(reader, writer, count, pop_fn, push_fn);
+            UL_RC_TRY(writer.Commit());
+            return rc;
+        }
+
+        template<typename StorageWriter, typename StorageReader, typename MessageType, typename PopFn, typename PushFn>
+        inline Result ReceiveCommandImpl(PopFn &&pop_fn, PushFn &&push_fn) {
             CommandCommonHeader in_out_header = {};
             auto msg_type = MessageType();
 
@@ -193,6 +573,9 @@ namespace dmi {
                 StorageReader reader;
                 UL_RC_TRY(OpenStorageReader(reader, false));
                 UL_RC_TRY(reader.Pop(in_out_header));
+                if(in_out_header.magic == CommandBatchMagic) {
+                    return ReceiveCommandBatchImpl<StorageWriter, StorageReader, MessageType>(reader, in_out_header.val, pop_fn, push_fn);
+                }
                 if(in_out_header.magic != CommandMagic) {
                     return dmi::ResultInvalidInHeaderMagic;
                 }
@@ -206,9 +589,13 @@ namespace dmi {
                 UL_RC_TRY(OpenStorageWriter(writer));
                 UL_RC_TRY(writer.Push(in_out_header));
 
+                // Same as above, the reply is sent even if pushing its data failed
+                auto rc = ResultSuccess;
                 if(R_SUCCEEDED(in_out_header.val)) {
-                    UL_RC_TRY(push_fn(msg_type, writer));
+                    rc = push_fn(msg_type, writer);
                 }
+                UL_RC_TRY(writer.Commit());
+                UL_RC_TRY(rc);
             }
 
             return ResultSuccess;
@@ -226,8 +613,14 @@ namespace dmi {
 
         // Daemon only receives commands from Menu
 
-        inline Result ReceiveCommand(std::function<Result(const DaemonMessage, DaemonScopedStorageReader&)> pop_fn, std::function<Result(const DaemonMessage, DaemonScopedStorageWriter&)> push_fn) {
-            return impl::ReceiveCommandImpl(pop_fn, push_fn);
+        template<typename PopFn, typename PushFn>
+        inline Result ReceiveCommand(PopFn &&pop_fn, PushFn &&push_fn) {
+            return impl::ReceiveCommandImpl<DaemonScopedStorageWriter, DaemonScopedStorageReader, DaemonMessage>(pop_fn, push_fn);
+        }
+
+        template<DaemonMessage Msg>
+        inline Result PopRequest(DaemonScopedStorageReader &reader, typename DaemonCommand<Msg>::Request &out_req) {
+            return impl::PopCommandData(reader, out_req);
         }
 
     }
@@ -242,8 +635,80 @@ namespace dmi {
 
         // Menu only sends commands to Daemon
 
-        inline Result SendCommand(const DaemonMessage msg, std::function<Result(MenuScopedStorageWriter&)> push_fn, std::function<Result(MenuScopedStorageReader&)> pop_fn) {
-            return impl::SendCommandImpl(msg, push_fn, pop_fn);
+        inline LaunchTrace CreateLaunchTrace(const u64 input_tick) {
+            LaunchTrace trace = {
+                .input_tick = input_tick
+            };
+            randomGet(&trace.correlation_id, sizeof(trace.correlation_id));
+            trace.send_tick = armGetSystemTick();
+            return trace;
+        }
+
+        template<typename PushFn, typename PopFn>
+        inline Result SendCommand(const DaemonMessage msg, PushFn &&push_fn, PopFn &&pop_fn) {
+            return impl::SendCommandImpl<MenuScopedStorageWriter, MenuScopedStorageReader>(msg, push_fn, pop_fn);
+        }
+
+        template<DaemonMessage Msg>
+        inline Result SendCommand(const typename DaemonCommand<Msg>::Request &req, typename DaemonCommand<Msg>::Response &out_resp) {
+            static_assert(sizeof(CommandCommonHeader) + sizeof(typename DaemonCommand<Msg>::Request) <= CommandStorageSize);
+            static_assert(sizeof(CommandCommonHeader) + sizeof(typename DaemonCommand<Msg>::Response) <= CommandStorageSize);
+
+            return impl::SendCommandImpl<MenuScopedStorageWriter, MenuScopedStorageReader>(Msg, [&](MenuScopedStorageWriter &writer) {
+                return impl::PushCommandData(writer, req);
+            },
+            [&](MenuScopedStorageReader &reader) {
+                return impl::PopCommandData(reader, out_resp);
+            });
+        }
+
+        template<DaemonMessage Msg>
+        inline Result SendCommand(const typename DaemonCommand<Msg>::Request &req = {}) {
+            typename DaemonCommand<Msg>::Response resp = {};
+            return SendCommand<Msg>(req, resp);
+        }
+
+        using MenuBatchCommand = impl::BatchCommand<DaemonMessage>;
+
+        template<DaemonMessage Msg>
+        inline MenuBatchCommand MakeBatchCommand(const typename DaemonCommand<Msg>::Request &req, typename DaemonCommand<Msg>::Response &out_resp) {
+            static_assert(impl::BatchCommandDataSize<typename DaemonCommand<Msg>::Request> <= CommandStorageSize);
+            static_assert(impl::BatchCommandDataSize<typename DaemonCommand<Msg>::Response> <= CommandStorageSize);
+
+            return {
+                .msg_type = Msg,
+                .req = std::addressof(req),
+                .req_size = impl::CommandDataSize<typename DaemonCommand<Msg>::Request>,
+                .resp = std::addressof(out_resp),
+                .resp_size = impl::CommandDataSize<typename DaemonCommand<Msg>::Response>,
+                .rc = ResultSuccess
+            };
+        }
+
+        template<DaemonMessage Msg>
+        inline MenuBatchCommand MakeBatchCommand(const typename DaemonCommand<Msg>::Request &req) {
+            static_assert(std::is_empty_v<typename DaemonCommand<Msg>::Response>, "Commands with response data need somewhere to store it");
+            static_assert(impl::BatchCommandDataSize<typename DaemonCommand<Msg>::Request> <= CommandStorageSize);
+
+            return {
+                .msg_type = Msg,
+                .req = std::addressof(req),
+                .req_size = impl::CommandDataSize<typename DaemonCommand<Msg>::Request>,
+                .resp = nullptr,
+                .resp_size = 0,
+                .rc = ResultSuccess
+            };
+        }
+
+        // Sends several commands in a single storage round-trip, each command's result is stored in its rc field
+        inline Result SendCommandBatch(MenuBatchCommand *cmds, const size_t count) {
+            return impl::SendCommandBatchImpl<MenuScopedStorageWriter, MenuScopedStorageReader>(cmds, count);
+        }
+
+        template<size_t N>
+        inline Result SendCommandBatch(MenuBatchCommand (&cmds)[N]) {
+            static_assert((N > 0) && (N <= MaxBatchCommandCount));
+            return SendCommandBatch(cmds, N);
         }
 
     }
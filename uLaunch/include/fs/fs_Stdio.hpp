@@ -52,12 +52,12 @@ namespace fs {
         CreateDirectory(path);
     }
 
+    // Only succeeds if everything got written (and flushed on close)
     inline bool WriteFile(const std::string &path, const void *data, const size_t size, const bool overwrite) {
         auto f = fopen(path.c_str(), overwrite ? "wb" : "ab+");
         if(f) {
-            fwrite(data, 1, size, f);
-            fclose(f);
-            return true;
+            const auto ok = fwrite(data, 1, size, f) == size;
+            return (fclose(f) == 0) && ok;
         }
         else {
             return false;
@@ -76,6 +76,27 @@ namespace fs {
         }
     }
 
+    // Reads the whole file with a single read call (no need to stat it beforehand)
+    inline bool ReadWholeFile(const std::string &path, std::string &out_data) {
+        auto f = fopen(path.c_str(), "rb");
+        if(f) {
+            fseek(f, 0, SEEK_END);
+            const auto size = ftell(f);
+            rewind(f);
+
+            auto ok = size >= 0;
+            if(ok) {
+                out_data.resize(size);
+                ok = fread(out_data.data(), 1, size, f) == static_cast<size_t>(size);
+            }
+            fclose(f);
+            return ok;
+        }
+        else {
+            return false;
+        }
+    }
+
     inline size_t GetFileSize(const std::string &path) {
         struct stat st;
         if(stat(path.c_str(), &st) == 0) {
@@ -86,6 +107,19 @@ namespace fs {
         }
     }
 
+    // Modification time and size, enough to tell whether a file changed
+    inline bool GetFileVersion(const std::string &path, u64 &out_mtime, u64 &out_size) {
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0) {
+            out_mtime = st.st_mtime;
+            out_size = st.st_size;
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
     #define UL_FS_FOR(dir, name_var, path_var, ...) ({ \
         const std::string dir_str = dir; \
         auto dp = opendir(dir_str.c_str()); \
@@ -4,8 +4,19 @@
 
 namespace os {
 
+    // Stored next to each cached icon, used to avoid reloading/rewriting profile images which didn't change
+    struct AccountIconCacheInfo {
+        u64 last_edit_timestamp;
+        u32 img_size;
+        u8 img_digest[SHA256_HASH_SIZE];
+    };
+
     std::string GetIconCacheImagePath(const AccountUid user_id);
+    std::string GetIconCacheInfoPath(const AccountUid user_id);
     Result QuerySystemAccounts(const bool dump_icon, std::vector<AccountUid> &out_accounts);
     Result GetAccountName(const AccountUid user_id, std::string &out_name);
 
+    // Forces names to be reloaded from the profiles next time they are requested
+    void InvalidateAccountCache();
+
 }
\ No newline at end of file
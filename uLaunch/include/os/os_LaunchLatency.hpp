@@ -0,0 +1,76 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace os {
+
+    enum class LaunchTitleType : u32 {
+        Installed,
+        HomebrewApplet,
+        HomebrewApplication,
+
+        Count
+    };
+
+    constexpr size_t LaunchTitleTypeCount = static_cast<size_t>(LaunchTitleType::Count);
+
+    // Timestamps (system ticks, shared by all processes) of every checkpoint of a launch
+    struct LaunchCheckpoints {
+        u64 input_tick; // uMenu: launch input (once confirmed, after any dialog)
+        u64 send_tick; // uMenu: command sent to uDaemon
+        u64 pickup_tick; // uDaemon: command received and queued
+        u64 launch_tick; // uDaemon: uMenu exited, launch started
+        u64 start_tick; // uDaemon: launch call returned
+        u64 active_tick; // uDaemon: the title is actually active
+    };
+
+    struct LaunchLatencySample {
+        u32 correlation_id;
+        u32 input_to_send_ms;
+        u32 send_to_pickup_ms;
+        u32 pickup_to_launch_ms; // Mostly uMenu's fade-out and exit
+        u32 launch_ms;
+        u32 start_to_active_ms;
+        u32 total_ms;
+    };
+
+    constexpr size_t LaunchLatencyWindowSize = 32;
+
+    // Histogram bucket limits (the last bucket holds anything above the last limit)
+    constexpr u32 LaunchLatencyBucketLimitsMs[] = { 250, 500, 1000, 2000, 4000, 8000 };
+    constexpr size_t LaunchLatencyBucketCount = std::size(LaunchLatencyBucketLimitsMs) + 1;
+
+    // Rolling window, only the last samples are kept
+    struct LaunchLatencyWindow {
+        LaunchLatencySample samples[LaunchLatencyWindowSize];
+        u32 next_idx;
+        u32 count;
+    };
+
+    struct LaunchLatencyHistory {
+        static constexpr u32 Magic = 0x4C544C55; // "ULTL"
+        static constexpr u32 CurrentVersion = 1;
+
+        u32 magic;
+        u32 version;
+        LaunchLatencyWindow windows[LaunchTitleTypeCount];
+    };
+
+    struct LaunchLatencyHistogram {
+        u32 bucket_counts[LaunchLatencyBucketCount];
+        u32 sample_count;
+        u32 median_ms;
+        u32 p90_ms;
+        u32 max_ms;
+    };
+
+    LaunchLatencySample CreateLaunchLatencySample(const u32 correlation_id, const LaunchCheckpoints &checkpoints);
+
+    bool LoadLaunchLatencyHistory(LaunchLatencyHistory &out_history);
+
+    // Appends the sample to its window and saves the history to the SD card
+    void RecordLaunchLatency(const LaunchTitleType type, const LaunchLatencySample &sample);
+
+    LaunchLatencyHistogram ComputeLaunchLatencyHistogram(const LaunchLatencyWindow &window);
+
+}
\ No newline at end of file
@@ -5,8 +5,9 @@
 
 namespace os {
 
-    constexpr u32 MaxTitleCount = 64000;
+    constexpr u32 ApplicationRecordPageCount = 128;
 
+    // Enumerated once per process, re-enumerated only after ns signals that the application records changed
     std::vector<cfg::TitleRecord> QueryInstalledTitles();
 
 }
\ No newline at end of file
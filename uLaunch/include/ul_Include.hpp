@@ -34,6 +34,7 @@ using JSON = nlohmann::json;
 #define UL_NRO_CACHE_PATH UL_BASE_SD_DIR "/nro"
 #define UL_TITLE_CACHE_PATH UL_BASE_SD_DIR "/titles"
 #define UL_ASSERTION_LOG_FILE UL_BASE_SD_DIR "/err.log"
+#define UL_LAUNCH_LATENCY_FILE UL_BASE_SD_DIR "/launch_latency.bin"
 
 #ifndef UL_VERSION
 #error uLaunch's build version isn't defined
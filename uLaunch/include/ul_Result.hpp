@@ -33,6 +33,7 @@ namespace dmn {
     UL_RC_DEFINE(InvalidSelectedUser, 2);
     UL_RC_DEFINE(AlreadyQueued, 3);
     UL_RC_DEFINE(ApplicationNotActive, 4);
+    UL_RC_DEFINE(LaunchQueueFull, 5);
 
 }
 
@@ -40,6 +41,7 @@ namespace menu {
 
     UL_RC_DEFINE_SUBMODULE(2);
     UL_RC_DEFINE(RomfsFileNotFound, 1);
+    UL_RC_DEFINE(DaemonServiceNotInitialized, 2);
 
 }
 
@@ -58,6 +60,9 @@ namespace dmi {
     UL_RC_DEFINE(InvalidInHeaderMagic, 3);
     UL_RC_DEFINE(InvalidOutHeaderMagic, 4);
     UL_RC_DEFINE(WaitTimeout, 5);
+    UL_RC_DEFINE(InvalidBatchCount, 6);
+    UL_RC_DEFINE(BatchCountMismatch, 7);
+    UL_RC_DEFINE(InvalidBatchPayloadSize, 8);
 
 }
 
@@ -0,0 +1,50 @@
+
+#pragma once
+#include <ul_Include.hpp>
+
+namespace util {
+
+    // Picks only the given top-level keys of a JSON object, straight into their destinations, without building a whole JSON object
+    // Other keys and nested values are skipped, and so are values of an unexpected type (destinations keep their defaults)
+
+    enum class JsonFieldType : u32 {
+        String,
+        U32,
+        U64,
+        Bool
+    };
+
+    struct JsonField {
+        const char *key;
+        JsonFieldType type;
+        void *dest;
+    };
+
+    constexpr size_t MaxJsonFieldCount = 64;
+
+    inline JsonField MakeJsonField(const char *key, std::string &dest) {
+        return { key, JsonFieldType::String, std::addressof(dest) };
+    }
+
+    inline JsonField MakeJsonField(const char *key, u32 &dest) {
+        return { key, JsonFieldType::U32, std::addressof(dest) };
+    }
+
+    inline JsonField MakeJsonField(const char *key, u64 &dest) {
+        return { key, JsonFieldType::U64, std::addressof(dest) };
+    }
+
+    inline JsonField MakeJsonField(const char *key, bool &dest) {
+        return { key, JsonFieldType::Bool, std::addressof(dest) };
+    }
+
+    Result LoadJSONFieldsFromBuffer(const char *data, const size_t data_size, const JsonField *fields, const size_t field_count);
+    Result LoadJSONFieldsFromFile(const std::string &path, const JsonField *fields, const size_t field_count);
+
+    template<size_t N>
+    inline Result LoadJSONFieldsFromFile(const std::string &path, const JsonField (&fields)[N]) {
+        static_assert(N <= MaxJsonFieldCount);
+        return LoadJSONFieldsFromFile(path, fields, N);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+
+#pragma once
+#include <ul_Include.hpp>
+#include <atomic>
+
+namespace util {
+
+    // Fixed-size single-producer/single-consumer ring buffer: lock-free and allocation-free
+    // Only one thread may push and only one (other) thread may pop/clear
+    // When full, pushes fail and are accounted as overflows (the queued elements are kept)
+
+    template<typename T, size_t Capacity>
+    class SpscRing {
+        static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        private:
+            static constexpr size_t CacheLineSize = 0x40;
+            static constexpr size_t IndexMask = Capacity - 1;
+
+            // Indexes increase freely, only masked when accessing the buffer
+            alignas(CacheLineSize) std::atomic<size_t> head;
+            alignas(CacheLineSize) std::atomic<size_t> tail;
+            alignas(CacheLineSize) std::atomic<u64> overflow_count;
+            T buf[Capacity];
+
+        public:
+            constexpr SpscRing() : head(0), tail(0), overflow_count(0), buf() {}
+
+            // Producer side
+
+            bool TryPush(const T &t) {
+                const auto cur_tail = this->tail.load(std::memory_order_relaxed);
+                if((cur_tail - this->head.load(std::memory_order_acquire)) == Capacity) {
+                    this->overflow_count.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                this->buf[cur_tail & IndexMask] = t;
+                this->tail.store(cur_tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer side
+
+            bool TryPop(T &out_t) {
+                return this->PopMany(std::addressof(out_t), 1) == 1;
+            }
+
+            size_t PopMany(T *out_ts, const size_t max_count) {
+                const auto cur_head = this->head.load(std::memory_order_relaxed);
+                const auto count = std::min(max_count, this->tail.load(std::memory_order_acquire) - cur_head);
+                for(size_t i = 0; i < count; i++) {
+                    out_ts[i] = this->buf[(cur_head + i) & IndexMask];
+                }
+
+                this->head.store(cur_head + count, std::memory_order_release);
+                return count;
+            }
+
+            void Clear() {
+                this->head.store(this->tail.load(std::memory_order_acquire), std::memory_order_release);
+            }
+
+            // Safe from any thread (approximate while the other side is active)
+
+            inline size_t GetCount() const {
+                return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+            }
+
+            inline u64 GetOverflowCount() const {
+                return this->overflow_count.load(std::memory_order_relaxed);
+            }
+
+            static constexpr size_t GetCapacity() {
+                return Capacity;
+            }
+    };
+
+}
\ No newline at end of file
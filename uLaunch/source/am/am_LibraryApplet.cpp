@@ -7,6 +7,7 @@ namespace am {
         AppletHolder g_AppletHolder;
         AppletId g_MenuAppletId = AppletId_None;
         AppletId g_LastAppletId = AppletId_None;
+        u32 g_AppletInstanceId = 0;
 
         struct AppletInfo {
             u64 program_id;
@@ -66,6 +67,7 @@ namespace am {
         }
         UL_RC_TRY(appletHolderStart(&g_AppletHolder));
         g_LastAppletId = id;
+        g_AppletInstanceId++;
         return ResultSuccess;
     }
 
@@ -115,6 +117,10 @@ namespace am {
         return last_id_copy;
     }
 
+    u32 LibraryAppletGetInstanceId() {
+        return g_AppletInstanceId;
+    }
+
     bool LibraryAppletIsMenu() {
         return LibraryAppletIsActive() && (g_MenuAppletId != AppletId_None) && (LibraryAppletGetId() == g_MenuAppletId);
     }
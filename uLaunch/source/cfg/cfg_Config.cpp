@@ -1,13 +1,32 @@
 #include <cfg/cfg_Config.hpp>
+#include <cfg/cfg_RecordStore.hpp>
 #include <os/os_Titles.hpp>
-#include <util/util_Misc.hpp>
+#include <util/util_JsonFields.hpp>
 #include <util/util_String.hpp>
 #include <db/db_Save.hpp>
+#include <unordered_map>
 
 namespace cfg {
 
     namespace {
 
+        // Manifests of the themes directory, keyed by the manifest (or pack) modification time and size
+        // Directory mtimes aren't used since they don't change when a file inside is modified
+        struct CachedTheme {
+            u64 mtime;
+            u64 size;
+            Theme theme;
+        };
+
+        Mutex g_ThemeCacheLock = {};
+        std::unordered_map<std::string, CachedTheme> g_ThemeCache;
+
+        // NACP names read while caching, so that looking names up doesn't need to read every NACP again
+        std::unordered_map<u64, std::string> g_ApplicationNameTable;
+        std::unordered_map<std::string, std::string> g_HomebrewNameTable;
+
+        void ProcessStringsFromNacp(RecordStrings &strs, NacpStruct *nacp);
+
         void DoCacheHomebrew(const std::string &nro_path) {
             const auto cache_nro_icon_path = GetNroCacheIconPath(nro_path);
             auto f = fopen(nro_path.c_str(), "rb");
@@ -28,6 +47,16 @@ namespace cfg {
                                         }
                                         delete[] icon_buf;
                                     }
+                                    if(asset_header.nacp.size > 0) {
+                                        NacpStruct nacp = {};
+                                        if(fseek(f, header.size + asset_header.nacp.offset, SEEK_SET) == 0) {
+                                            if(fread(&nacp, std::min(static_cast<size_t>(asset_header.nacp.size), sizeof(nacp)), 1, f) == 1) {
+                                                RecordStrings strs = {};
+                                                ProcessStringsFromNacp(strs, &nacp);
+                                                g_HomebrewNameTable[nro_path] = strs.name;
+                                            }
+                                        }
+                                    }
                                 }
                             }
                         }
@@ -56,6 +85,10 @@ namespace cfg {
                 const auto cache_icon_path = cfg::GetTitleCacheIconPath(title.app_id);
                 if(R_SUCCEEDED(nsGetApplicationControlData(NsApplicationControlSource_Storage, title.app_id, control_data, sizeof(NsApplicationControlData), nullptr))) {
                     fs::WriteFile(cache_icon_path, control_data->icon, sizeof(control_data->icon), true);
+
+                    RecordStrings strs = {};
+                    ProcessStringsFromNacp(strs, &control_data->nacp);
+                    g_ApplicationNameTable[title.app_id] = strs.name;
                 }
             }
             delete control_data;
@@ -81,6 +114,50 @@ namespace cfg {
             }
         }
 
+        // Unlike LoadTheme, doesn't fall back to the default theme
+        bool TryLoadTheme(const std::string &base_name, Theme &out_theme) {
+            out_theme = {
+                .base_name = base_name,
+                .manifest = {
+                    .name = "'" + base_name + "'"
+                }
+            };
+            const util::JsonField manifest_fields[] = {
+                util::MakeJsonField("name", out_theme.manifest.name),
+                util::MakeJsonField("format_version", out_theme.manifest.format_version),
+                util::MakeJsonField("release", out_theme.manifest.release),
+                util::MakeJsonField("description", out_theme.manifest.description),
+                util::MakeJsonField("author", out_theme.manifest.author)
+            };
+
+            // The default theme is always there, even if its manifest were broken
+            if(base_name.empty()) {
+                util::LoadJSONFieldsFromFile(CFG_THEME_DEFAULT "/theme/Manifest.json", manifest_fields);
+                out_theme.path = CFG_THEME_DEFAULT;
+                return true;
+            }
+
+            // Packs only get their index and manifest read here
+            if(out_theme.IsPack()) {
+                std::string manifest;
+                if(OpenThemePack(base_name, manifest)) {
+                    if(R_SUCCEEDED(util::LoadJSONFieldsFromBuffer(manifest.data(), manifest.size(), manifest_fields, std::size(manifest_fields)))) {
+                        out_theme.path = GetThemePackMountPath(base_name);
+                        return true;
+                    }
+                    CloseThemePack(base_name);
+                }
+                return false;
+            }
+
+            const auto theme_dir = UL_THEMES_PATH "/" + base_name;
+            if(R_SUCCEEDED(util::LoadJSONFieldsFromFile(theme_dir + "/theme/Manifest.json", manifest_fields))) {
+                out_theme.path = theme_dir;
+                return true;
+            }
+            return false;
+        }
+
     }
 
     std::vector<TitleRecord> QueryAllHomebrew(const std::string &base) {
@@ -120,6 +197,9 @@ namespace cfg {
     }
 
     void CacheEverything(const std::string &hb_base_path) {
+        g_ApplicationNameTable.clear();
+        g_HomebrewNameTable.clear();
+
         fs::CleanDirectory(UL_TITLE_CACHE_PATH);
         CacheInstalledTitles();
 
@@ -154,6 +234,26 @@ namespace cfg {
         return UL_ENTRIES_PATH "/" + json_name;
     }
 
+    std::string GetRecordName(const TitleRecord &record) {
+        if(!record.name.empty()) {
+            return record.name;
+        }
+
+        if(record.title_type == TitleType::Homebrew) {
+            const auto find_name = g_HomebrewNameTable.find(record.nro_target.nro_path);
+            if(find_name != g_HomebrewNameTable.end()) {
+                return find_name->second;
+            }
+        }
+        else if(record.title_type == TitleType::Installed) {
+            const auto find_name = g_ApplicationNameTable.find(record.app_id);
+            if(find_name != g_ApplicationNameTable.end()) {
+                return find_name->second;
+            }
+        }
+        return "";
+    }
+
     RecordInformation GetRecordInformation(const TitleRecord &record) {
         RecordInformation info = {};
         info.icon_path = GetRecordIconPath(record);
@@ -198,38 +298,43 @@ namespace cfg {
     }
 
     Theme LoadTheme(const std::string &base_name) {
-        Theme theme = {
-            .base_name = base_name
-        };
-        auto theme_dir = UL_THEMES_PATH "/" + base_name;
-        auto manifest_path = theme_dir + "/theme/Manifest.json";
-        if(base_name.empty() || !fs::ExistsFile(manifest_path)) {
-            theme_dir = CFG_THEME_DEFAULT;
-        }
-        manifest_path = theme_dir + "/theme/Manifest.json";
-
-        JSON manifest_json;
-        if(R_SUCCEEDED(util::LoadJSONFromFile(manifest_json, manifest_path))) {
-            theme.manifest.name = manifest_json.value("name", "'" + base_name + "'");
-            theme.manifest.format_version = manifest_json.value("format_version", 0);
-            theme.manifest.release = manifest_json.value("release", "");
-            theme.manifest.description = manifest_json.value("description", "");
-            theme.manifest.author = manifest_json.value("author", "");
-            theme.path = theme_dir;
-            return theme;
+        Theme theme = {};
+        if(!TryLoadTheme(base_name, theme)) {
+            TryLoadTheme("", theme);
         }
-
-        return LoadTheme("");
+        return theme;
     }
 
     std::vector<Theme> LoadThemes() {
         std::vector<Theme> themes;
+        std::unordered_map<std::string, CachedTheme> new_theme_cache;
+
+        ScopedLock lk(g_ThemeCacheLock);
         UL_FS_FOR(UL_THEMES_PATH, name, path, {
-            const auto theme = LoadTheme(name);
-            if(!theme.path.empty()) {
+            const auto is_pack = IsThemePackName(name);
+            u64 mtime;
+            u64 size;
+            if(!fs::GetFileVersion(is_pack ? path : (path + "/theme/Manifest.json"), mtime, size)) {
+                continue;
+            }
+
+            // Closed packs need to be opened again for their assets to be reachable
+            const auto find_cached = g_ThemeCache.find(name);
+            if((find_cached != g_ThemeCache.end()) && (find_cached->second.mtime == mtime) && (find_cached->second.size == size) && (!is_pack || IsThemePackOpen(name))) {
+                themes.push_back(find_cached->second.theme);
+                new_theme_cache.emplace(name, std::move(find_cached->second));
+                continue;
+            }
+
+            Theme theme = {};
+            if(TryLoadTheme(name, theme)) {
                 themes.push_back(theme);
+                new_theme_cache.emplace(name, CachedTheme { mtime, size, std::move(theme) });
             }
         });
+
+        // Removed themes get dropped from the cache
+        g_ThemeCache = std::move(new_theme_cache);
         return themes;
     }
 
@@ -247,6 +352,26 @@ namespace cfg {
         return "";
     }
 
+    std::vector<std::string> ListAssetsByTheme(const Theme &base, const std::string &resource_dir) {
+        std::vector<std::string> names;
+        const auto push_dir_names = [&](const std::string &dir) {
+            UL_FS_FOR(dir, name, path, {
+                if(!(dt->d_type & DT_DIR) && (std::find(names.begin(), names.end(), name) == names.end())) {
+                    names.push_back(name);
+                }
+            });
+        };
+
+        if(IsThemePackName(base.base_name)) {
+            ListThemePackAssets(base.base_name, resource_dir, names);
+        }
+        else if(!base.path.empty() && (base.path != CFG_THEME_DEFAULT)) {
+            push_dir_names(base.path + "/" + resource_dir);
+        }
+        push_dir_names(CFG_THEME_DEFAULT "/" + resource_dir);
+        return names;
+    }
+
     std::string GetLanguageString(const JSON &lang, const JSON &def, const std::string &name) {
         auto str = lang.value(name, "");
         if(str.empty()) {
@@ -344,189 +469,47 @@ namespace cfg {
         }
     }
 
-    void SaveRecord(const TitleRecord &record) {
-        auto entry = JSON::object();
-        entry["type"] = static_cast<u32>(record.title_type);
-        entry["folder"] = record.sub_folder;
-
-        if(!record.name.empty()) {
-            entry["name"] = record.name;
-        }
-        if(!record.author.empty()) {
-            entry["author"] = record.author;
-        }
-        if(!record.version.empty()) {
-            entry["version"] = record.version;
-        }
-        if(!record.icon.empty()) {
-            entry["icon"] = record.icon;
-        }
-
-        if(record.title_type == TitleType::Homebrew) {
-            entry["nro_path"] = record.nro_target.nro_path;
-            if(strlen(record.nro_target.nro_argv)) {
-                if(strcasecmp(record.nro_target.nro_path, record.nro_target.nro_argv) != 0) {
-                    entry["nro_argv"] = record.nro_target.nro_argv;
-                }
-            }
-        }
-        else if(record.title_type == TitleType::Installed) {
-            entry["application_id"] = util::FormatApplicationId(record.app_id);
-        }
-        
-        const auto json_path = GetRecordJsonPath(record);
-        if(fs::ExistsFile(json_path)) {
-            fs::DeleteFile(json_path);
-        }
-
-        std::ofstream ofs(json_path);
-        ofs << std::setw(4) << entry;
-        ofs.close();
-    }
-
-    bool MoveRecordTo(TitleList &list, const TitleRecord &record, const std::string &folder_name) {
-        bool title_found = false;
-        TitleRecord record_copy = {};
-        std::string record_json_name;
-
-        // Search in root first
-        const auto find_in_root = STL_FIND_IF(list.root.titles, title_item, record.Equals(title_item));
-        if(STL_FOUND(list.root.titles, find_in_root)) {
-            // It is already on root...?
-            if(folder_name.empty()) {
-                return true;
-            }
-            record_json_name = STL_UNWRAP(find_in_root).json_name;
-
-            list.root.titles.erase(find_in_root);
-            title_found = true;
-        }
-
-        // If not found yet, search on all dirs if the title is present
-        if(!title_found) {
-            for(auto &folder: list.folders) {
-                const auto find_in_folder = STL_FIND_IF(folder.titles, title_item, record.Equals(title_item));
-                if(STL_FOUND(folder.titles, find_in_folder)) {
-                    // It is already on that folder...?
-                    if(folder.name == folder_name) {
-                        return true;
-                    }
-                    record_json_name = STL_UNWRAP(find_in_folder).json_name;
-
-                    folder.titles.erase(find_in_folder);
-                    title_found = true;
-                    break;
-                }
-            }
-        }
-
-        if(title_found) {
-            TitleRecord title = record;
-            title.json_name = record_json_name;
-            title.sub_folder = folder_name;
-
-            // Add (move) it to root again
-            if(folder_name.empty()) {
-                list.root.titles.push_back(title);
-            }
-            // Add it to the new folder
-            else {
-                const auto find_folder = STL_FIND_IF(list.folders, folder_item, (folder_item.name == folder_name));
-                if(STL_FOUND(list.folders, find_folder)) {
-                    STL_UNWRAP(find_folder).titles.push_back(title);
-                }
-                else {
-                    TitleFolder folder = {};
-                    folder.name = folder_name;
-                    folder.titles.push_back(title);
-                    list.folders.push_back(folder);
-                }
-            }
-
-            SaveRecord(title);
-        }
-
-        return title_found;
-    }
-
-    TitleFolder &FindFolderByName(TitleList &list, const std::string &name) {
-        if(!name.empty()) {
-            auto f = STL_FIND_IF(list.folders, fld, (fld.name == name));
-            if(STL_FOUND(list.folders, f)) {
-                return STL_UNWRAP(f);
-            }
-        }
-        return list.root;
-    }
-
-    void RenameFolder(TitleList &list, const std::string &old_name, const std::string &new_name) {
-        auto &folder = FindFolderByName(list, old_name);
-        if(!folder.name.empty()) {
-            folder.name = new_name;
-            for(auto &entry: folder.titles) {
-                entry.sub_folder = new_name;
-                SaveRecord(entry);
-            }
-        }
-    }
-
-    bool ExistsRecord(const TitleList &list, const TitleRecord &record) {
-        auto title_found = false;
-        TitleRecord record_copy = {};
-        std::string record_json_name;
-
-        // Search in root first
-        const auto find_in_root = STL_FIND_IF(list.root.titles, title_item, record.Equals(title_item));
-        if(STL_FOUND(list.root.titles, find_in_root)) {
-            if(!STL_UNWRAP(find_in_root).json_name.empty()) {
-                title_found = true;
-            }
-        }
-
-        // If not found yet, search on all dirs if the title is present
-        if(!title_found) {
-            for(auto &folder: list.folders) {
-                const auto find_in_folder = STL_FIND_IF(folder.titles, title_item, record.Equals(title_item));
-                if(STL_FOUND(folder.titles, find_in_folder)) {
-                    if(!STL_UNWRAP(find_in_folder).json_name.empty()) {
-                        title_found = true;
-                        break;
-                    }
-                }
-            }
-        }
-
-        return title_found;
-    }
-
     TitleList LoadTitleList() {
         TitleList list = {};
+
+        // Pending record writes go first, then finish any batch of them that got interrupted
+        FlushRecords();
+        RecoverRecordJournal();
         
         // Installed titles first
         auto titles = os::QueryInstalledTitles();
 
         UL_FS_FOR(UL_ENTRIES_PATH, name, path, {
-            JSON entry;
-            const auto rc = util::LoadJSONFromFile(entry, path);
+            // Entry fields go straight into the record, only the ones needing a conversion go through temporaries
+            TitleRecord rec = {
+                .json_name = name
+            };
+            auto type_val = static_cast<u32>(TitleType::Invalid);
+            std::string app_id_str;
+            std::string nro_path;
+            std::string argv;
+            const util::JsonField entry_fields[] = {
+                util::MakeJsonField("type", type_val),
+                util::MakeJsonField("folder", rec.sub_folder),
+                util::MakeJsonField("icon", rec.icon),
+                util::MakeJsonField("application_id", app_id_str),
+                util::MakeJsonField("nro_path", nro_path),
+                util::MakeJsonField("nro_argv", argv),
+                util::MakeJsonField("name", rec.name),
+                util::MakeJsonField("author", rec.author),
+                util::MakeJsonField("version", rec.version)
+            };
+            const auto rc = util::LoadJSONFieldsFromFile(path, entry_fields);
             if(R_SUCCEEDED(rc)) {
-                const auto type = static_cast<TitleType>(entry.value("type", static_cast<u32>(TitleType::Invalid)));
+                const auto type = static_cast<TitleType>(type_val);
+                rec.title_type = type;
                 if(type == TitleType::Installed) {
-                    const std::string app_id_str = entry.value("application_id", "");
                     if(!app_id_str.empty()) {
-                        const std::string folder = entry.value("folder", "");
+                        const auto &folder = rec.sub_folder;
                         const auto app_id = util::Get64FromString(app_id_str);
                         if(app_id > 0) {
                             if(!folder.empty()) {
-                                TitleRecord rec = {
-                                    .json_name = name,
-                                    .title_type = type,
-                                    .sub_folder = folder,
-                                    .icon = entry.value("icon", ""),
-                                    .app_id = app_id,
-                                    .name = entry.value("name", ""),
-                                    .author = entry.value("author", ""),
-                                    .version = entry.value("version", "")
-                                };
+                                rec.app_id = app_id;
 
                                 const auto find_title = STL_FIND_IF(titles, title_item, title_item.app_id == app_id);
                                 if(STL_FOUND(titles, find_title)) {
@@ -550,19 +533,8 @@ namespace cfg {
                     }
                 }
                 else if(type == TitleType::Homebrew) {
-                    const std::string nro_path = entry.value("nro_path", "");
                     if(fs::ExistsFile(nro_path)) {
-                        const std::string folder = entry.value("folder", "");
-                        TitleRecord rec = {
-                            .json_name = name,
-                            .title_type = type,
-                            .sub_folder = folder,
-                            .icon = entry.value("icon", ""),
-                            .name = entry.value("name", ""),
-                            .author = entry.value("author", ""),
-                            .version = entry.value("version", "")
-                        };
-                        const std::string argv = entry.value("nro_argv", "");
+                        const auto &folder = rec.sub_folder;
                         strcpy(rec.nro_target.nro_path, nro_path.c_str());
                         if(!argv.empty()) {
                             strcpy(rec.nro_target.nro_argv, argv.c_str());
@@ -599,20 +571,4 @@ namespace cfg {
         return list;
     }
 
-    std::string GetNroCacheIconPath(const std::string &path) {
-        char path_copy[FS_MAX_PATH] = {};
-        strcpy(path_copy, path.c_str());
-        u8 hash[0x20] = {0};
-        sha256CalculateHash(hash, path_copy, FS_MAX_PATH);
-
-        std::stringstream strm;
-        strm << UL_NRO_CACHE_PATH "/";
-        // Use the first half of the hash, like N does with NCAs.
-        for(u32 i = 0; i < sizeof(hash) / 2; i++) {
-            strm << std::setw(2) << std::setfill('0') << std::hex << std::nouppercase << static_cast<u32>(hash[i]);
-        }
-        strm << ".jpg";
-        return strm.str();
-    }
-
 }
\ No newline at end of file
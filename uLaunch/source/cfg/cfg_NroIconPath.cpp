@@ -0,0 +1,46 @@
+#include <cfg/cfg_Config.hpp>
+#include <unordered_map>
+
+namespace cfg {
+
+    namespace {
+
+        constexpr size_t MaxNroCacheIconPathCount = 1024;
+
+        Mutex g_NroCacheIconPathLock = {};
+        std::unordered_map<std::string, std::string> g_NroCacheIconPathTable;
+
+    }
+
+    std::string GetNroCacheIconPath(const std::string &path) {
+        ScopedLock lk(g_NroCacheIconPathLock);
+        auto it = g_NroCacheIconPathTable.find(path);
+        if(it != g_NroCacheIconPathTable.end()) {
+            return it->second;
+        }
+
+        // Note: the whole zero-padded path buffer is hashed, cached icons already on the SD card depend on this
+        char path_copy[FS_MAX_PATH] = {};
+        memcpy(path_copy, path.c_str(), std::min(path.length(), sizeof(path_copy) - 1));
+        u8 hash[SHA256_HASH_SIZE] = {};
+        sha256CalculateHash(hash, path_copy, sizeof(path_copy));
+
+        constexpr char HexDigits[] = "0123456789abcdef";
+        constexpr auto NroCacheDirLength = sizeof(UL_NRO_CACHE_PATH "/") - 1;
+        // Use the first half of the hash, like N does with NCAs.
+        constexpr auto HashStringLength = sizeof(hash) / 2 * 2;
+        char cache_path[NroCacheDirLength + HashStringLength + sizeof(".jpg")] = UL_NRO_CACHE_PATH "/";
+        auto hash_str = cache_path + NroCacheDirLength;
+        for(u32 i = 0; i < sizeof(hash) / 2; i++) {
+            hash_str[i * 2] = HexDigits[hash[i] >> 4];
+            hash_str[i * 2 + 1] = HexDigits[hash[i] & 0xF];
+        }
+        memcpy(hash_str + HashStringLength, ".jpg", sizeof(".jpg"));
+
+        if(g_NroCacheIconPathTable.size() >= MaxNroCacheIconPathCount) {
+            g_NroCacheIconPathTable.clear();
+        }
+        return g_NroCacheIconPathTable.emplace(path, cache_path).first->second;
+    }
+
+}
@@ -0,0 +1,344 @@
+#include <cfg/cfg_RecordStore.hpp>
+
+namespace cfg {
+
+    namespace {
+
+        struct RecordJournalHeader {
+            u32 magic;
+            u32 op_count;
+            u32 body_size;
+            u32 body_checksum;
+        };
+        static_assert(sizeof(RecordJournalHeader) == 0x10);
+
+        struct RecordJournalOperationHeader {
+            RecordOperationType type;
+            u32 path_size;
+            u32 data_size;
+        };
+        static_assert(sizeof(RecordJournalOperationHeader) == 0xC);
+
+        // FNV-1a, only meant to detect a journal which didn't get fully written
+        u32 ComputeJournalChecksum(const u8 *data, const size_t size) {
+            u32 hash = 0x811C9DC5;
+            for(size_t i = 0; i < size; i++) {
+                hash ^= data[i];
+                hash *= 0x01000193;
+            }
+            return hash;
+        }
+
+        inline void AppendJournalData(std::string &journal, const void *data, const size_t size) {
+            journal.append(reinterpret_cast<const char*>(data), size);
+        }
+
+        RecordStoreBackend g_RecordStoreBackend = {
+            .write_file = [](const std::string &path, const void *data, const size_t size) {
+                return fs::WriteFile(path, data, size, true);
+            },
+            .read_file = fs::ReadWholeFile,
+            .delete_file = fs::DeleteFile,
+            .exists_file = fs::ExistsFile,
+            .get_current_ns = []() {
+                return armTicksToNs(armGetSystemTick());
+            },
+            .wait_timeout = [](CondVar *condvar, Mutex *lock, const u64 timeout_ns) {
+                condvarWaitTimeout(condvar, lock, timeout_ns);
+            }
+        };
+
+        bool ApplyRecordOperation(const std::string &path, const RecordOperationType type, const void *data, const size_t size) {
+            switch(type) {
+                case RecordOperationType::Save: {
+                    // Truncate and write at once, no need to delete it beforehand (an interrupted write is what the journal is for)
+                    return g_RecordStoreBackend.write_file(path, data, size);
+                }
+                case RecordOperationType::Remove: {
+                    g_RecordStoreBackend.delete_file(path);
+                    return !g_RecordStoreBackend.exists_file(path);
+                }
+                default: {
+                    return false;
+                }
+            }
+        }
+
+        Mutex g_RecordWriterLock = {};
+        CondVar g_RecordWriterCondVar = {};
+        CondVar g_RecordFlushCondVar = {};
+        RecordTransaction g_PendingRecordTransaction;
+        u64 g_FirstRecordQueueNs = 0;
+        u64 g_LastRecordQueueNs = 0;
+
+        // Every deferred commit bumps the queued generation, the worker reports the generation it has written up to
+        u64 g_QueuedRecordGeneration = 0;
+        u64 g_WrittenRecordGeneration = 0;
+        bool g_RecordFlushRequested = false;
+
+        Thread g_RecordWriterThread;
+        bool g_RecordWriterRunning = false;
+        bool g_RecordWriterShouldExit = false;
+
+        inline u64 GetCurrentNs() {
+            return g_RecordStoreBackend.get_current_ns();
+        }
+
+        void RecordWriterThread(void*) {
+            while(true) {
+                RecordTransaction tx;
+                u64 tx_gen;
+                {
+                    ScopedLock lk(g_RecordWriterLock);
+                    while(!g_RecordWriterShouldExit && g_PendingRecordTransaction.IsEmpty()) {
+                        condvarWait(&g_RecordWriterCondVar, &g_RecordWriterLock);
+                    }
+
+                    // Wait for the menu to be idle, unless someone is waiting for the records to be written
+                    while(!g_RecordWriterShouldExit && !g_RecordFlushRequested) {
+                        const auto cur_ns = GetCurrentNs();
+                        const auto write_ns = std::min(g_LastRecordQueueNs + RecordWriteIdleDelayNs, g_FirstRecordQueueNs + RecordWriteDeadlineNs);
+                        if(cur_ns >= write_ns) {
+                            break;
+                        }
+                        g_RecordStoreBackend.wait_timeout(&g_RecordWriterCondVar, &g_RecordWriterLock, write_ns - cur_ns);
+                    }
+
+                    if(g_PendingRecordTransaction.IsEmpty()) {
+                        if(g_RecordWriterShouldExit) {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    tx.Merge(std::move(g_PendingRecordTransaction));
+                    tx_gen = g_QueuedRecordGeneration;
+                    g_RecordFlushRequested = false;
+                }
+
+                const auto committed = tx.Commit();
+
+                ScopedLock lk(g_RecordWriterLock);
+                if(!committed && !g_RecordWriterShouldExit) {
+                    // Retried once the menu is idle again, mutations queued meanwhile take precedence over the failed ones
+                    tx.Merge(std::move(g_PendingRecordTransaction));
+                    g_PendingRecordTransaction.Merge(std::move(tx));
+                    g_FirstRecordQueueNs = GetCurrentNs();
+                    g_LastRecordQueueNs = g_FirstRecordQueueNs;
+                }
+                // Flushes wait for the attempt, not for its success: a failing SD card mustn't block launches forever
+                g_WrittenRecordGeneration = tx_gen;
+                condvarWakeAll(&g_RecordFlushCondVar);
+            }
+        }
+
+    }
+
+    void SetRecordStoreBackend(const RecordStoreBackend &backend) {
+        g_RecordStoreBackend = backend;
+    }
+
+    std::string SerializeRecord(const TitleRecord &record) {
+        auto entry = JSON::object();
+        entry["type"] = static_cast<u32>(record.title_type);
+        entry["folder"] = record.sub_folder;
+
+        if(!record.name.empty()) {
+            entry["name"] = record.name;
+        }
+        if(!record.author.empty()) {
+            entry["author"] = record.author;
+        }
+        if(!record.version.empty()) {
+            entry["version"] = record.version;
+        }
+        if(!record.icon.empty()) {
+            entry["icon"] = record.icon;
+        }
+
+        if(record.title_type == TitleType::Homebrew) {
+            entry["nro_path"] = record.nro_target.nro_path;
+            if(strlen(record.nro_target.nro_argv)) {
+                if(strcasecmp(record.nro_target.nro_path, record.nro_target.nro_argv) != 0) {
+                    entry["nro_argv"] = record.nro_target.nro_argv;
+                }
+            }
+        }
+        else if(record.title_type == TitleType::Installed) {
+            entry["application_id"] = util::FormatApplicationId(record.app_id);
+        }
+
+        return entry.dump(4);
+    }
+
+    void RecordTransaction::Save(const TitleRecord &record) {
+        this->ops[GetRecordJsonPath(record)] = {
+            .type = RecordOperationType::Save,
+            .json_data = SerializeRecord(record)
+        };
+    }
+
+    void RecordTransaction::Remove(const TitleRecord &record) {
+        this->ops[GetRecordJsonPath(record)] = {
+            .type = RecordOperationType::Remove
+        };
+    }
+
+    void RecordTransaction::Merge(RecordTransaction &&other) {
+        for(auto &[path, op]: other.ops) {
+            this->ops[path] = std::move(op);
+        }
+        other.ops.clear();
+    }
+
+    bool RecordTransaction::Commit() {
+        if(this->ops.empty()) {
+            return true;
+        }
+
+        // Even single operations go through the journal: record writes truncate the file first, so an interrupted one would lose the previous record
+        std::string journal(sizeof(RecordJournalHeader), '\0');
+        for(const auto &[path, op]: this->ops) {
+            const RecordJournalOperationHeader op_header = {
+                .type = op.type,
+                .path_size = static_cast<u32>(path.length()),
+                .data_size = static_cast<u32>(op.json_data.length())
+            };
+            AppendJournalData(journal, &op_header, sizeof(op_header));
+            AppendJournalData(journal, path.data(), path.length());
+            AppendJournalData(journal, op.json_data.data(), op.json_data.length());
+        }
+
+        const auto body = reinterpret_cast<const u8*>(journal.data()) + sizeof(RecordJournalHeader);
+        const auto body_size = journal.length() - sizeof(RecordJournalHeader);
+        const RecordJournalHeader header = {
+            .magic = RecordJournalMagic,
+            .op_count = static_cast<u32>(this->ops.size()),
+            .body_size = static_cast<u32>(body_size),
+            .body_checksum = ComputeJournalChecksum(body, body_size)
+        };
+        memcpy(journal.data(), &header, sizeof(header));
+        if(!g_RecordStoreBackend.write_file(CFG_RECORD_JOURNAL_FILE, journal.data(), journal.length())) {
+            // Nothing got applied, and a partially written journal is discarded on recovery anyway
+            g_RecordStoreBackend.delete_file(CFG_RECORD_JOURNAL_FILE);
+            return false;
+        }
+
+        auto ok = true;
+        for(const auto &[path, op]: this->ops) {
+            ok &= ApplyRecordOperation(path, op.type, op.json_data.data(), op.json_data.length());
+        }
+        if(!ok) {
+            // The journal stays, so that the next load replays it even if the retry never happens
+            return false;
+        }
+
+        g_RecordStoreBackend.delete_file(CFG_RECORD_JOURNAL_FILE);
+        this->ops.clear();
+        return true;
+    }
+
+    void RecordTransaction::CommitDeferred() {
+        if(this->ops.empty()) {
+            return;
+        }
+
+        ScopedLock lk(g_RecordWriterLock);
+        if(!g_RecordWriterRunning) {
+            condvarInit(&g_RecordWriterCondVar);
+            condvarInit(&g_RecordFlushCondVar);
+            g_RecordWriterShouldExit = false;
+            UL_RC_ASSERT(threadCreate(&g_RecordWriterThread, &RecordWriterThread, nullptr, nullptr, 0x8000, 0x3B, -2));
+            UL_RC_ASSERT(threadStart(&g_RecordWriterThread));
+            g_RecordWriterRunning = true;
+        }
+
+        const auto cur_ns = GetCurrentNs();
+        if(g_PendingRecordTransaction.IsEmpty()) {
+            g_FirstRecordQueueNs = cur_ns;
+        }
+        g_LastRecordQueueNs = cur_ns;
+        g_PendingRecordTransaction.Merge(std::move(*this));
+        g_QueuedRecordGeneration++;
+        condvarWakeOne(&g_RecordWriterCondVar);
+    }
+
+    void FlushRecords() {
+        ScopedLock lk(g_RecordWriterLock);
+        if(!g_RecordWriterRunning) {
+            return;
+        }
+
+        const auto target_gen = g_QueuedRecordGeneration;
+        while(g_WrittenRecordGeneration < target_gen) {
+            g_RecordFlushRequested = true;
+            condvarWakeOne(&g_RecordWriterCondVar);
+            condvarWait(&g_RecordFlushCondVar, &g_RecordWriterLock);
+        }
+        // The worker only clears it when taking a batch, which never happens if the batch it was already writing covered the target
+        // Left set, the next batches would skip the idle delay
+        g_RecordFlushRequested = false;
+    }
+
+    void ExitRecordWriter() {
+        {
+            ScopedLock lk(g_RecordWriterLock);
+            if(!g_RecordWriterRunning) {
+                return;
+            }
+            g_RecordWriterShouldExit = true;
+            condvarWakeAll(&g_RecordWriterCondVar);
+        }
+
+        threadWaitForExit(&g_RecordWriterThread);
+        threadClose(&g_RecordWriterThread);
+
+        ScopedLock lk(g_RecordWriterLock);
+        g_RecordWriterRunning = false;
+        g_WrittenRecordGeneration = g_QueuedRecordGeneration;
+        condvarWakeAll(&g_RecordFlushCondVar);
+    }
+
+    void RecoverRecordJournal() {
+        std::string journal;
+        if(!g_RecordStoreBackend.read_file(CFG_RECORD_JOURNAL_FILE, journal)) {
+            return;
+        }
+
+        // Only replay it if it was entirely written, otherwise none of its operations got applied
+        RecordJournalHeader header = {};
+        auto ok = journal.length() >= sizeof(header);
+        if(ok) {
+            memcpy(&header, journal.data(), sizeof(header));
+            const auto body = reinterpret_cast<const u8*>(journal.data()) + sizeof(header);
+            ok = (header.magic == RecordJournalMagic) && (header.body_size == (journal.length() - sizeof(header))) && (header.body_checksum == ComputeJournalChecksum(body, header.body_size));
+        }
+
+        auto replayed = true;
+        if(ok) {
+            size_t offset = sizeof(header);
+            for(u32 i = 0; i < header.op_count; i++) {
+                RecordJournalOperationHeader op_header = {};
+                if((offset + sizeof(op_header)) > journal.length()) {
+                    break;
+                }
+                memcpy(&op_header, journal.data() + offset, sizeof(op_header));
+                offset += sizeof(op_header);
+
+                if((offset + op_header.path_size + op_header.data_size) > journal.length()) {
+                    break;
+                }
+                const auto path = journal.substr(offset, op_header.path_size);
+                offset += op_header.path_size;
+                replayed &= ApplyRecordOperation(path, op_header.type, journal.data() + offset, op_header.data_size);
+                offset += op_header.data_size;
+            }
+        }
+
+        // Kept if the replay itself failed, so that it gets replayed again next time
+        if(replayed) {
+            g_RecordStoreBackend.delete_file(CFG_RECORD_JOURNAL_FILE);
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include <cfg/cfg_ThemePack.hpp>
+#include <sys/iosupport.h>
+#include <unordered_map>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace cfg {
+
+    namespace {
+
+        // Immutable once created: loading a pack's hot assets replaces the registered instance, files opened before keep the old one
+        struct ThemePack {
+            std::string file_path;
+            std::vector<ThemePackAsset> assets;
+            // Indexed like the assets, only hot assets have data here (and only once loaded)
+            std::vector<std::unique_ptr<u8[]>> hot_asset_data;
+
+            inline bool HasHotAssetsLoaded() const {
+                return !this->hot_asset_data.empty();
+            }
+
+            const ThemePackAsset *FindAsset(const char *asset_path) const {
+                // Sorted by path (without duplicates)
+                auto it = std::lower_bound(this->assets.begin(), this->assets.end(), asset_path, [](const ThemePackAsset &asset, const char *path) {
+                    return strncmp(asset.path, path, ThemePackAssetPathLength) < 0;
+                });
+                if((it != this->assets.end()) && (strncmp(it->path, asset_path, ThemePackAssetPathLength) == 0)) {
+                    return std::addressof(*it);
+                }
+                return nullptr;
+            }
+        };
+
+        struct ThemePackFile {
+            std::shared_ptr<const ThemePack> pack;
+            const ThemePackAsset *asset;
+            const u8 *data; // Only for loaded hot assets
+            FILE *f; // Otherwise
+            size_t pos;
+        };
+
+        Mutex g_ThemePackLock = {};
+        std::unordered_map<std::string, std::shared_ptr<const ThemePack>> g_ThemePackTable;
+        bool g_ThemePackDeviceAdded = false;
+
+        inline std::string GetThemePackFilePath(const std::string &base_name) {
+            return UL_THEMES_PATH "/" + base_name;
+        }
+
+        inline bool ReadAt(FILE *f, const size_t offset, void *buf, const size_t size) {
+            if(fseek(f, offset, SEEK_SET) != 0) {
+                return false;
+            }
+            return fread(buf, 1, size, f) == size;
+        }
+
+        bool ValidateHeader(const ThemePackHeader &header, const size_t file_size) {
+            if((header.magic != ThemePackMagic) || (header.version != CurrentThemePackVersion) || (header.file_size != file_size)) {
+                return false;
+            }
+            if((static_cast<u64>(header.asset_table_offset) + static_cast<u64>(header.asset_count) * sizeof(ThemePackAsset)) > file_size) {
+                return false;
+            }
+            return (static_cast<u64>(header.manifest_offset) + header.manifest_size) <= file_size;
+        }
+
+        bool ValidateAssets(const std::vector<ThemePackAsset> &assets, const size_t file_size) {
+            for(const auto &asset: assets) {
+                if(asset.path[ThemePackAssetPathLength - 1] != '\0') {
+                    return false;
+                }
+                if((static_cast<u64>(asset.offset) + asset.size) > file_size) {
+                    return false;
+                }
+            }
+            // Lookups are binary searches, paths must be strictly sorted (hence unique too)
+            return std::adjacent_find(assets.begin(), assets.end(), [](const ThemePackAsset &a, const ThemePackAsset &b) {
+                return strncmp(a.path, b.path, ThemePackAssetPathLength) >= 0;
+            }) == assets.end();
+        }
+
+        std::shared_ptr<const ThemePack> ReadThemePack(const std::string &base_name, const bool load_hot_assets, std::string &out_manifest) {
+            auto f = fopen(GetThemePackFilePath(base_name).c_str(), "rb");
+            if(f == nullptr) {
+                return nullptr;
+            }
+
+            auto pack = std::make_shared<ThemePack>();
+            pack->file_path = GetThemePackFilePath(base_name);
+            auto ok = fseek(f, 0, SEEK_END) == 0;
+            const auto file_size = ok ? ftell(f) : -1;
+            ok = file_size >= static_cast<long>(sizeof(ThemePackHeader));
+
+            ThemePackHeader header = {};
+            ok = ok && ReadAt(f, 0, &header, sizeof(header)) && ValidateHeader(header, file_size);
+            if(ok) {
+                pack->assets.resize(header.asset_count);
+                out_manifest.resize(header.manifest_size);
+                ok = ReadAt(f, header.asset_table_offset, pack->assets.data(), header.asset_count * sizeof(ThemePackAsset)) && ReadAt(f, header.manifest_offset, out_manifest.data(), header.manifest_size);
+            }
+            ok = ok && ValidateAssets(pack->assets, file_size);
+
+            if(ok && load_hot_assets) {
+                pack->hot_asset_data.resize(pack->assets.size());
+                for(size_t i = 0; ok && (i < pack->assets.size()); i++) {
+                    const auto &asset = pack->assets.at(i);
+                    if(IsThemePackHotAsset(asset)) {
+                        pack->hot_asset_data.at(i) = std::make_unique<u8[]>(asset.size);
+                        ok = ReadAt(f, asset.offset, pack->hot_asset_data.at(i).get(), asset.size);
+                    }
+                }
+            }
+            fclose(f);
+
+            if(ok) {
+                return pack;
+            }
+            return nullptr;
+        }
+
+        // "ultheme:/<pack>/<asset>"
+        bool FindDeviceAsset(const char *path, std::shared_ptr<const ThemePack> &out_pack, const ThemePackAsset *&out_asset) {
+            const auto colon = strchr(path, ':');
+            if(colon != nullptr) {
+                path = colon + 1;
+            }
+            while(*path == '/') {
+                path++;
+            }
+
+            const auto sep = strchr(path, '/');
+            if(sep == nullptr) {
+                return false;
+            }
+
+            {
+                const std::string base_name(path, sep - path);
+                ScopedLock lk(g_ThemePackLock);
+                const auto find_pack = g_ThemePackTable.find(base_name);
+                if(find_pack == g_ThemePackTable.end()) {
+                    return false;
+                }
+                out_pack = find_pack->second;
+            }
+
+            out_asset = out_pack->FindAsset(sep + 1);
+            return out_asset != nullptr;
+        }
+
+        void FillStat(const ThemePackAsset &asset, struct stat *st) {
+            memset(st, 0, sizeof(*st));
+            st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+            st->st_size = asset.size;
+            st->st_nlink = 1;
+        }
+
+        int ThemePackDeviceOpen(struct _reent *r, void *file_struct, const char *path, int flags, int mode) {
+            if((flags & O_ACCMODE) != O_RDONLY) {
+                r->_errno = EROFS;
+                return -1;
+            }
+
+            std::shared_ptr<const ThemePack> pack;
+            const ThemePackAsset *asset;
+            if(!FindDeviceAsset(path, pack, asset)) {
+                r->_errno = ENOENT;
+                return -1;
+            }
+
+            const u8 *data = nullptr;
+            const size_t asset_idx = asset - pack->assets.data();
+            if(asset_idx < pack->hot_asset_data.size()) {
+                data = pack->hot_asset_data.at(asset_idx).get();
+            }
+
+            FILE *f = nullptr;
+            if(data == nullptr) {
+                f = fopen(pack->file_path.c_str(), "rb");
+                if(f == nullptr) {
+                    r->_errno = EIO;
+                    return -1;
+                }
+            }
+
+            new(file_struct) ThemePackFile { std::move(pack), asset, data, f, 0 };
+            return 0;
+        }
+
+        int ThemePackDeviceClose(struct _reent *r, void *fd) {
+            auto file = reinterpret_cast<ThemePackFile*>(fd);
+            if(file->f != nullptr) {
+                fclose(file->f);
+            }
+            file->~ThemePackFile();
+            return 0;
+        }
+
+        ssize_t ThemePackDeviceRead(struct _reent *r, void *fd, char *ptr, size_t len) {
+            auto file = reinterpret_cast<ThemePackFile*>(fd);
+            len = std::min(len, file->asset->size - file->pos);
+            if(len == 0) {
+                return 0;
+            }
+
+            if(file->data != nullptr) {
+                memcpy(ptr, file->data + file->pos, len);
+            }
+            else if(!ReadAt(file->f, file->asset->offset + file->pos, ptr, len)) {
+                r->_errno = EIO;
+                return -1;
+            }
+            file->pos += len;
+            return len;
+        }
+
+        off_t ThemePackDeviceSeek(struct _reent *r, void *fd, off_t pos, int dir) {
+            auto file = reinterpret_cast<ThemePackFile*>(fd);
+            off_t base = 0;
+            switch(dir) {
+                case SEEK_SET: {
+                    base = 0;
+                    break;
+                }
+                case SEEK_CUR: {
+                    base = file->pos;
+                    break;
+                }
+                case SEEK_END: {
+                    base = file->asset->size;
+                    break;
+                }
+                default: {
+                    r->_errno = EINVAL;
+                    return -1;
+                }
+            }
+
+            const auto new_pos = base + pos;
+            if((new_pos < 0) || (new_pos > static_cast<off_t>(file->asset->size))) {
+                r->_errno = EINVAL;
+                return -1;
+            }
+            file->pos = new_pos;
+            return new_pos;
+        }
+
+        int ThemePackDeviceFstat(struct _reent *r, void *fd, struct stat *st) {
+            FillStat(*reinterpret_cast<ThemePackFile*>(fd)->asset, st);
+            return 0;
+        }
+
+        int ThemePackDeviceStat(struct _reent *r, const char *file, struct stat *st) {
+            std::shared_ptr<const ThemePack> pack;
+            const ThemePackAsset *asset;
+            if(!FindDeviceAsset(file, pack, asset)) {
+                r->_errno = ENOENT;
+                return -1;
+            }
+
+            FillStat(*asset, st);
+            return 0;
+        }
+
+        constexpr devoptab_t ThemePackDevice = {
+            .name = CFG_THEME_PACK_DEVICE,
+            .structSize = sizeof(ThemePackFile),
+            .open_r = ThemePackDeviceOpen,
+            .close_r = ThemePackDeviceClose,
+            .read_r = ThemePackDeviceRead,
+            .seek_r = ThemePackDeviceSeek,
+            .fstat_r = ThemePackDeviceFstat,
+            .stat_r = ThemePackDeviceStat
+        };
+
+        void RegisterThemePack(const std::string &base_name, std::shared_ptr<const ThemePack> pack) {
+            ScopedLock lk(g_ThemePackLock);
+            if(!g_ThemePackDeviceAdded) {
+                g_ThemePackDeviceAdded = AddDevice(&ThemePackDevice) >= 0;
+            }
+            // Reopening a pack (listing themes again) mustn't drop hot assets already loaded
+            auto &cur_pack = g_ThemePackTable[base_name];
+            if(!cur_pack || !cur_pack->HasHotAssetsLoaded() || pack->HasHotAssetsLoaded()) {
+                cur_pack = std::move(pack);
+            }
+        }
+
+    }
+
+    bool OpenThemePack(const std::string &base_name, std::string &out_manifest) {
+        auto pack = ReadThemePack(base_name, false, out_manifest);
+        if(!pack) {
+            return false;
+        }
+
+        RegisterThemePack(base_name, std::move(pack));
+        return true;
+    }
+
+    bool LoadThemePackHotAssets(const std::string &base_name) {
+        {
+            ScopedLock lk(g_ThemePackLock);
+            const auto find_pack = g_ThemePackTable.find(base_name);
+            if((find_pack != g_ThemePackTable.end()) && find_pack->second->HasHotAssetsLoaded()) {
+                return true;
+            }
+        }
+
+        std::string manifest;
+        auto pack = ReadThemePack(base_name, true, manifest);
+        if(!pack) {
+            return false;
+        }
+
+        RegisterThemePack(base_name, std::move(pack));
+        return true;
+    }
+
+    void CloseThemePack(const std::string &base_name) {
+        ScopedLock lk(g_ThemePackLock);
+        g_ThemePackTable.erase(base_name);
+    }
+
+    bool IsThemePackOpen(const std::string &base_name) {
+        ScopedLock lk(g_ThemePackLock);
+        return g_ThemePackTable.find(base_name) != g_ThemePackTable.end();
+    }
+
+    bool ListThemePackAssets(const std::string &base_name, const std::string &asset_dir, std::vector<std::string> &out_names) {
+        std::shared_ptr<const ThemePack> pack;
+        {
+            ScopedLock lk(g_ThemePackLock);
+            const auto find_pack = g_ThemePackTable.find(base_name);
+            if(find_pack == g_ThemePackTable.end()) {
+                return false;
+            }
+            pack = find_pack->second;
+        }
+
+        const auto prefix = asset_dir + "/";
+        for(const auto &asset: pack->assets) {
+            const std::string asset_path = asset.path;
+            if((asset_path.compare(0, prefix.length(), prefix) == 0) && (asset_path.find('/', prefix.length()) == std::string::npos)) {
+                out_names.push_back(asset_path.substr(prefix.length()));
+            }
+        }
+        return true;
+    }
+
+}
\ No newline at end of file
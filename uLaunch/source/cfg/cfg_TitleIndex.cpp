@@ -0,0 +1,119 @@
+#include <cfg/cfg_TitleIndex.hpp>
+
+namespace cfg {
+
+    namespace {
+
+        constexpr size_t TrigramLength = 3;
+
+        std::string NormalizeName(const std::string &name) {
+            auto norm_name = name;
+            for(auto &ch: norm_name) {
+                if((ch >= 'A') && (ch <= 'Z')) {
+                    ch += 'a' - 'A';
+                }
+            }
+            return norm_name;
+        }
+
+        inline u32 MakeTrigram(const char *str) {
+            return (static_cast<u32>(static_cast<u8>(str[0])) << 16) | (static_cast<u32>(static_cast<u8>(str[1])) << 8) | static_cast<u32>(static_cast<u8>(str[2]));
+        }
+
+    }
+
+    std::string GetRecordKey(const TitleRecord &record) {
+        if(record.title_type == TitleType::Installed) {
+            return util::FormatApplicationId(record.app_id);
+        }
+        return record.nro_target.nro_path;
+    }
+
+    void TitleIndex::Add(const TitleRecord &record) {
+        this->Remove(record);
+
+        const auto entry_idx = static_cast<u32>(this->entries.size());
+        const auto key = GetRecordKey(record);
+        this->entries.push_back({
+            .key = key,
+            .name = NormalizeName(GetRecordName(record)),
+            .removed = false
+        });
+        this->key_table[key] = entry_idx;
+
+        const auto &name = this->entries.back().name;
+        for(size_t i = 0; (i + TrigramLength) <= name.length(); i++) {
+            auto &trigram_entries = this->trigram_table[MakeTrigram(name.c_str() + i)];
+            // Repeated trigrams in the same name
+            if(trigram_entries.empty() || (trigram_entries.back() != entry_idx)) {
+                trigram_entries.push_back(entry_idx);
+            }
+        }
+    }
+
+    void TitleIndex::Remove(const TitleRecord &record) {
+        // Trigram lists keep pointing to it, they just skip removed entries
+        const auto find_key = this->key_table.find(GetRecordKey(record));
+        if(find_key != this->key_table.end()) {
+            this->entries.at(find_key->second).removed = true;
+            this->key_table.erase(find_key);
+        }
+    }
+
+    void TitleIndex::Clear() {
+        this->entries.clear();
+        this->key_table.clear();
+        this->trigram_table.clear();
+    }
+
+    std::vector<std::string> TitleIndex::Find(const std::string &query) const {
+        std::vector<std::string> keys;
+        const auto norm_query = NormalizeName(query);
+        if(norm_query.empty()) {
+            return keys;
+        }
+
+        const auto check_entry = [&](const Entry &entry) {
+            if(!entry.removed && (entry.name.find(norm_query) != std::string::npos)) {
+                keys.push_back(entry.key);
+            }
+        };
+
+        if(norm_query.length() < TrigramLength) {
+            for(const auto &entry: this->entries) {
+                check_entry(entry);
+            }
+            return keys;
+        }
+
+        // Every match holds all the query's trigrams, thus only the shortest list needs to be checked
+        const std::vector<u32> *candidates = nullptr;
+        for(size_t i = 0; (i + TrigramLength) <= norm_query.length(); i++) {
+            const auto find_trigram = this->trigram_table.find(MakeTrigram(norm_query.c_str() + i));
+            if(find_trigram == this->trigram_table.end()) {
+                return keys;
+            }
+            if((candidates == nullptr) || (find_trigram->second.size() < candidates->size())) {
+                candidates = std::addressof(find_trigram->second);
+            }
+        }
+
+        for(const auto entry_idx: *candidates) {
+            check_entry(this->entries.at(entry_idx));
+        }
+        return keys;
+    }
+
+    void BuildTitleIndex(const TitleList &list, TitleIndex &out_index) {
+        out_index.Clear();
+        for(const auto &title: list.root.titles) {
+            out_index.Add(title);
+        }
+        for(const auto &folder: list.folders) {
+            for(const auto &title: folder.titles) {
+                out_index.Add(title);
+            }
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <cfg/cfg_RecordStore.hpp>
+
+namespace cfg {
+
+    void SaveRecord(const TitleRecord &record) {
+        RecordTransaction tx;
+        tx.Save(record);
+        tx.CommitDeferred();
+    }
+
+    void RemoveRecord(const TitleRecord &record) {
+        RecordTransaction tx;
+        tx.Remove(record);
+        tx.CommitDeferred();
+    }
+
+    bool MoveRecordTo(TitleList &list, const TitleRecord &record, const std::string &folder_name) {
+        bool title_found = false;
+        TitleRecord record_copy = {};
+        std::string record_json_name;
+
+        // Search in root first
+        const auto find_in_root = STL_FIND_IF(list.root.titles, title_item, record.Equals(title_item));
+        if(STL_FOUND(list.root.titles, find_in_root)) {
+            // It is already on root...?
+            if(folder_name.empty()) {
+                return true;
+            }
+            record_json_name = STL_UNWRAP(find_in_root).json_name;
+
+            list.root.titles.erase(find_in_root);
+            title_found = true;
+        }
+
+        // If not found yet, search on all dirs if the title is present
+        if(!title_found) {
+            for(auto &folder: list.folders) {
+                const auto find_in_folder = STL_FIND_IF(folder.titles, title_item, record.Equals(title_item));
+                if(STL_FOUND(folder.titles, find_in_folder)) {
+                    // It is already on that folder...?
+                    if(folder.name == folder_name) {
+                        return true;
+                    }
+                    record_json_name = STL_UNWRAP(find_in_folder).json_name;
+
+                    folder.titles.erase(find_in_folder);
+                    title_found = true;
+                    break;
+                }
+            }
+        }
+
+        if(title_found) {
+            TitleRecord title = record;
+            title.json_name = record_json_name;
+            title.sub_folder = folder_name;
+
+            // Add (move) it to root again
+            if(folder_name.empty()) {
+                list.root.titles.push_back(title);
+            }
+            // Add it to the new folder
+            else {
+                const auto find_folder = STL_FIND_IF(list.folders, folder_item, (folder_item.name == folder_name));
+                if(STL_FOUND(list.folders, find_folder)) {
+                    STL_UNWRAP(find_folder).titles.push_back(title);
+                }
+                else {
+                    TitleFolder folder = {};
+                    folder.name = folder_name;
+                    folder.titles.push_back(title);
+                    list.folders.push_back(folder);
+                }
+            }
+
+            SaveRecord(title);
+        }
+
+        return title_found;
+    }
+
+    u32 MoveRootRecordsTo(TitleList &list, const std::vector<u32> &root_title_idxs, const std::string &folder_name) {
+        // They are already on root
+        if(folder_name.empty() || root_title_idxs.empty()) {
+            return 0;
+        }
+
+        std::vector<bool> title_moved(list.root.titles.size(), false);
+        for(const auto idx: root_title_idxs) {
+            if(idx < title_moved.size()) {
+                title_moved.at(idx) = true;
+            }
+        }
+
+        auto find_folder = STL_FIND_IF(list.folders, folder_item, (folder_item.name == folder_name));
+        if(!STL_FOUND(list.folders, find_folder)) {
+            list.folders.push_back({ .name = folder_name });
+            find_folder = list.folders.end() - 1;
+        }
+        auto &folder = STL_UNWRAP(find_folder);
+
+        // Single pass over root, every record gets written in the same transaction
+        RecordTransaction tx;
+        u32 moved_count = 0;
+        std::vector<TitleRecord> kept_titles;
+        kept_titles.reserve(list.root.titles.size());
+        for(u32 i = 0; i < list.root.titles.size(); i++) {
+            auto &title = list.root.titles.at(i);
+            if(title_moved.at(i)) {
+                title.sub_folder = folder_name;
+                tx.Save(title);
+                folder.titles.push_back(std::move(title));
+                moved_count++;
+            }
+            else {
+                kept_titles.push_back(std::move(title));
+            }
+        }
+        list.root.titles = std::move(kept_titles);
+
+        tx.CommitDeferred();
+        return moved_count;
+    }
+
+    TitleFolder &FindFolderByName(TitleList &list, const std::string &name) {
+        if(!name.empty()) {
+            auto f = STL_FIND_IF(list.folders, fld, (fld.name == name));
+            if(STL_FOUND(list.folders, f)) {
+                return STL_UNWRAP(f);
+            }
+        }
+        return list.root;
+    }
+
+    void RenameFolder(TitleList &list, const std::string &old_name, const std::string &new_name) {
+        auto &folder = FindFolderByName(list, old_name);
+        if(!folder.name.empty()) {
+            folder.name = new_name;
+            RecordTransaction tx;
+            for(auto &entry: folder.titles) {
+                entry.sub_folder = new_name;
+                tx.Save(entry);
+            }
+            tx.CommitDeferred();
+        }
+    }
+
+    bool ExistsRecord(const TitleList &list, const TitleRecord &record) {
+        auto title_found = false;
+        TitleRecord record_copy = {};
+        std::string record_json_name;
+
+        // Search in root first
+        const auto find_in_root = STL_FIND_IF(list.root.titles, title_item, record.Equals(title_item));
+        if(STL_FOUND(list.root.titles, find_in_root)) {
+            if(!STL_UNWRAP(find_in_root).json_name.empty()) {
+                title_found = true;
+            }
+        }
+
+        // If not found yet, search on all dirs if the title is present
+        if(!title_found) {
+            for(auto &folder: list.folders) {
+                const auto find_in_folder = STL_FIND_IF(folder.titles, title_item, record.Equals(title_item));
+                if(STL_FOUND(folder.titles, find_in_folder)) {
+                    if(!STL_UNWRAP(find_in_folder).json_name.empty()) {
+                        title_found = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return title_found;
+    }
+
+}
\ No newline at end of file
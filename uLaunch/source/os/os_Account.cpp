@@ -5,40 +5,122 @@
 
 namespace os {
 
+    namespace {
+
+        struct CachedAccount {
+            AccountUid uid;
+            std::string name;
+        };
+
+        Mutex g_AccountCacheLock = {};
+        std::vector<CachedAccount> g_AccountCache;
+        std::vector<u8> g_IconBuffer;
+
+        inline bool ReadIconCacheInfo(const AccountUid user_id, AccountIconCacheInfo &out_info) {
+            const auto info_path = GetIconCacheInfoPath(user_id);
+            if(fs::GetFileSize(info_path) != sizeof(AccountIconCacheInfo)) {
+                return false;
+            }
+            return fs::ReadFile(info_path, std::addressof(out_info), sizeof(out_info));
+        }
+
+        void UpdateCachedAccountName(const AccountUid user_id, const std::string &name) {
+            for(auto &account: g_AccountCache) {
+                if(accountUidIsEqual(&account.uid, &user_id)) {
+                    account.name = name;
+                    return;
+                }
+            }
+            g_AccountCache.push_back({ user_id, name });
+        }
+
+        void DumpAccountIcon(const AccountUid user_id, AccountProfile &prof, const AccountProfileBase &pbase) {
+            u32 img_size = 0;
+            accountProfileGetImageSize(&prof, &img_size);
+            if(img_size == 0) {
+                return;
+            }
+
+            const auto cache_icon_path = GetIconCacheImagePath(user_id);
+            const auto icon_exists = fs::GetFileSize(cache_icon_path) == img_size;
+            AccountIconCacheInfo cur_info = {};
+            const auto has_info = ReadIconCacheInfo(user_id, cur_info);
+            if(icon_exists && has_info && (cur_info.last_edit_timestamp == pbase.last_edit_timestamp) && (cur_info.img_size == img_size)) {
+                // Profile wasn't edited since the icon was dumped
+                return;
+            }
+
+            if(g_IconBuffer.size() < img_size) {
+                g_IconBuffer.resize(img_size);
+            }
+            u32 tmp_size;
+            if(R_FAILED(accountProfileLoadImage(&prof, g_IconBuffer.data(), img_size, &tmp_size))) {
+                return;
+            }
+
+            AccountIconCacheInfo new_info = {
+                .last_edit_timestamp = pbase.last_edit_timestamp,
+                .img_size = img_size
+            };
+            sha256CalculateHash(new_info.img_digest, g_IconBuffer.data(), img_size);
+
+            // The profile might have been edited without changing the image (nickname...), only the info needs to be updated then
+            const auto same_img = icon_exists && has_info && (cur_info.img_size == img_size) && (memcmp(cur_info.img_digest, new_info.img_digest, sizeof(new_info.img_digest)) == 0);
+            if(!same_img) {
+                fs::WriteFile(cache_icon_path, g_IconBuffer.data(), img_size, true);
+            }
+            fs::WriteFile(GetIconCacheInfoPath(user_id), std::addressof(new_info), sizeof(new_info), true);
+        }
+
+    }
+
     std::string GetIconCacheImagePath(const AccountUid user_id) {
         const auto uid_str = util::Format128NintendoStyle(user_id);
         return UL_BASE_SD_DIR "/user/" + uid_str + ".jpg";
     }
 
+    std::string GetIconCacheInfoPath(const AccountUid user_id) {
+        const auto uid_str = util::Format128NintendoStyle(user_id);
+        return UL_BASE_SD_DIR "/user/" + uid_str + ".info";
+    }
+
     Result QuerySystemAccounts(const bool dump_icon, std::vector<AccountUid> &out_accounts) {
         AccountUid uids[ACC_USER_LIST_SIZE] = {};
         s32 acc_count = 0;
         UL_RC_TRY(accountListAllUsers(uids, ACC_USER_LIST_SIZE, &acc_count));
+
+        ScopedLock lk(g_AccountCacheLock);
+        // The account list might have changed (new/deleted users), rebuild the cache from scratch
+        g_AccountCache.clear();
         for(s32 i = 0; i < acc_count; i++) {
             const auto uid = uids[i];
             out_accounts.push_back(uid);
-            if(dump_icon) {
-                AccountProfile prof;
-                if(R_SUCCEEDED(accountGetProfile(&prof, uid))) {
-                    u32 img_size = 0;
-                    accountProfileGetImageSize(&prof, &img_size);
-                    if(img_size > 0) {
-                        auto img_buf = new u8[img_size]();
-                        u32 tmp_size;
-                        if(R_SUCCEEDED(accountProfileLoadImage(&prof, img_buf, img_size, &tmp_size))) {
-                            const auto cache_icon_path = GetIconCacheImagePath(uid);
-                            fs::WriteFile(cache_icon_path, img_buf, img_size, true);
-                        }
-                        delete[] img_buf;
+
+            AccountProfile prof;
+            if(R_SUCCEEDED(accountGetProfile(&prof, uid))) {
+                AccountProfileBase pbase = {};
+                AccountUserData udata = {};
+                if(R_SUCCEEDED(accountProfileGet(&prof, &udata, &pbase))) {
+                    UpdateCachedAccountName(uid, pbase.nickname);
+                    if(dump_icon) {
+                        DumpAccountIcon(uid, prof, pbase);
                     }
-                    accountProfileClose(&prof);
                 }
+                accountProfileClose(&prof);
             }
         }
         return ResultSuccess;
     }
 
     Result GetAccountName(const AccountUid user_id, std::string &out_name) {
+        ScopedLock lk(g_AccountCacheLock);
+        for(const auto &account: g_AccountCache) {
+            if(accountUidIsEqual(&account.uid, &user_id)) {
+                out_name = account.name;
+                return ResultSuccess;
+            }
+        }
+
         AccountProfile prof;
         UL_RC_TRY(accountGetProfile(&prof, user_id));
         UL_ON_SCOPE_EXIT({ accountProfileClose(&prof); });
@@ -48,6 +130,13 @@ namespace os {
         UL_RC_TRY(accountProfileGet(&prof, &udata, &pbase));
 
         out_name = pbase.nickname;
+        UpdateCachedAccountName(user_id, out_name);
         return ResultSuccess;
     }
+
+    void InvalidateAccountCache() {
+        ScopedLock lk(g_AccountCacheLock);
+        g_AccountCache.clear();
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <os/os_LaunchLatency.hpp>
+#include <fs/fs_Stdio.hpp>
+
+namespace os {
+
+    namespace {
+
+        LaunchLatencyHistory g_History = {};
+        bool g_HistoryLoaded = false;
+
+        inline u32 GetElapsedMs(const u64 start_tick, const u64 end_tick) {
+            // Checkpoints which weren't reached (or are out of order) count as zero
+            if((start_tick == 0) || (end_tick <= start_tick)) {
+                return 0;
+            }
+            return static_cast<u32>(armTicksToNs(end_tick - start_tick) / 1'000'000ul);
+        }
+
+        inline void EnsureHistoryLoaded() {
+            if(!g_HistoryLoaded) {
+                if(!LoadLaunchLatencyHistory(g_History)) {
+                    g_History = {
+                        .magic = LaunchLatencyHistory::Magic,
+                        .version = LaunchLatencyHistory::CurrentVersion
+                    };
+                }
+                g_HistoryLoaded = true;
+            }
+        }
+
+    }
+
+    LaunchLatencySample CreateLaunchLatencySample(const u32 correlation_id, const LaunchCheckpoints &checkpoints) {
+        const auto first_tick = (checkpoints.input_tick != 0) ? checkpoints.input_tick : checkpoints.send_tick;
+        return {
+            .correlation_id = correlation_id,
+            .input_to_send_ms = GetElapsedMs(checkpoints.input_tick, checkpoints.send_tick),
+            .send_to_pickup_ms = GetElapsedMs(checkpoints.send_tick, checkpoints.pickup_tick),
+            .pickup_to_launch_ms = GetElapsedMs(checkpoints.pickup_tick, checkpoints.launch_tick),
+            .launch_ms = GetElapsedMs(checkpoints.launch_tick, checkpoints.start_tick),
+            .start_to_active_ms = GetElapsedMs(checkpoints.start_tick, checkpoints.active_tick),
+            .total_ms = GetElapsedMs(first_tick, checkpoints.active_tick)
+        };
+    }
+
+    bool LoadLaunchLatencyHistory(LaunchLatencyHistory &out_history) {
+        if(fs::GetFileSize(UL_LAUNCH_LATENCY_FILE) != sizeof(LaunchLatencyHistory)) {
+            return false;
+        }
+        if(!fs::ReadFile(UL_LAUNCH_LATENCY_FILE, std::addressof(out_history), sizeof(out_history))) {
+            return false;
+        }
+        if((out_history.magic != LaunchLatencyHistory::Magic) || (out_history.version != LaunchLatencyHistory::CurrentVersion)) {
+            out_history = {};
+            return false;
+        }
+        return true;
+    }
+
+    void RecordLaunchLatency(const LaunchTitleType type, const LaunchLatencySample &sample) {
+        if(type >= LaunchTitleType::Count) {
+            return;
+        }
+
+        EnsureHistoryLoaded();
+        auto &window = g_History.windows[static_cast<size_t>(type)];
+        window.samples[window.next_idx] = sample;
+        window.next_idx = (window.next_idx + 1) % LaunchLatencyWindowSize;
+        if(window.count < LaunchLatencyWindowSize) {
+            window.count++;
+        }
+
+        fs::WriteFile(UL_LAUNCH_LATENCY_FILE, std::addressof(g_History), sizeof(g_History), true);
+    }
+
+    LaunchLatencyHistogram ComputeLaunchLatencyHistogram(const LaunchLatencyWindow &window) {
+        LaunchLatencyHistogram histogram = {};
+        const auto count = std::min<size_t>(window.count, LaunchLatencyWindowSize);
+        if(count == 0) {
+            return histogram;
+        }
+
+        u32 sorted_total_ms[LaunchLatencyWindowSize];
+        for(size_t i = 0; i < count; i++) {
+            const auto total_ms = window.samples[i].total_ms;
+            sorted_total_ms[i] = total_ms;
+
+            auto bucket_idx = std::size(LaunchLatencyBucketLimitsMs);
+            for(size_t j = 0; j < std::size(LaunchLatencyBucketLimitsMs); j++) {
+                if(total_ms < LaunchLatencyBucketLimitsMs[j]) {
+                    bucket_idx = j;
+                    break;
+                }
+            }
+            histogram.bucket_counts[bucket_idx]++;
+        }
+        std::sort(sorted_total_ms, sorted_total_ms + count);
+
+        histogram.sample_count = count;
+        histogram.median_ms = sorted_total_ms[count / 2];
+        histogram.p90_ms = sorted_total_ms[(count * 9) / 10];
+        histogram.max_ms = sorted_total_ms[count - 1];
+        return histogram;
+    }
+
+}
\ No newline at end of file
@@ -2,24 +2,71 @@
 
 namespace os {
 
-    std::vector<cfg::TitleRecord> QueryInstalledTitles() {
-        std::vector<cfg::TitleRecord> titles;
-        auto records_buf = new NsApplicationRecord[MaxTitleCount]();
-        s32 record_count;
-        UL_RC_ASSERT(nsListApplicationRecord(records_buf, MaxTitleCount, 0, &record_count));
-        for(s32 i = 0; i < record_count; i++) {
-            const auto &record = records_buf[i];
-            if(record.application_id == 0) {
-                continue;
+    namespace {
+
+        Mutex g_InstalledTitlesLock = {};
+        std::vector<cfg::TitleRecord> g_InstalledTitles;
+        bool g_InstalledTitlesValid = false;
+        Event g_RecordUpdateEvent = {};
+        bool g_RecordUpdateEventAvailable = false;
+        bool g_RecordUpdateEventInitialized = false;
+
+        void CheckRecordUpdates() {
+            if(!g_RecordUpdateEventInitialized) {
+                g_RecordUpdateEventAvailable = R_SUCCEEDED(nsGetApplicationRecordUpdateSystemEvent(&g_RecordUpdateEvent));
+                g_RecordUpdateEventInitialized = true;
+            }
+
+            if(g_RecordUpdateEventAvailable) {
+                if(R_SUCCEEDED(eventWait(&g_RecordUpdateEvent, 0))) {
+                    eventClear(&g_RecordUpdateEvent);
+                    g_InstalledTitlesValid = false;
+                }
             }
-            const cfg::TitleRecord rec = {
-                .title_type = cfg::TitleType::Installed,
-                .app_id = record.application_id
-            };
-            titles.push_back(std::move(rec));
+            else {
+                // Without the event we can't tell when records change, so don't memoize anything
+                g_InstalledTitlesValid = false;
+            }
+        }
+
+        void EnumerateInstalledTitles() {
+            g_InstalledTitles.clear();
+
+            NsApplicationRecord records_page[ApplicationRecordPageCount] = {};
+            s32 offset = 0;
+            while(true) {
+                s32 record_count = 0;
+                UL_RC_ASSERT(nsListApplicationRecord(records_page, ApplicationRecordPageCount, offset, &record_count));
+                for(s32 i = 0; i < record_count; i++) {
+                    const auto &record = records_page[i];
+                    if(record.application_id == 0) {
+                        continue;
+                    }
+                    const cfg::TitleRecord rec = {
+                        .title_type = cfg::TitleType::Installed,
+                        .app_id = record.application_id
+                    };
+                    g_InstalledTitles.push_back(std::move(rec));
+                }
+
+                if(record_count < static_cast<s32>(ApplicationRecordPageCount)) {
+                    break;
+                }
+                offset += record_count;
+            }
+
+            g_InstalledTitlesValid = true;
+        }
+
+    }
+
+    std::vector<cfg::TitleRecord> QueryInstalledTitles() {
+        ScopedLock lk(g_InstalledTitlesLock);
+        CheckRecordUpdates();
+        if(!g_InstalledTitlesValid) {
+            EnumerateInstalledTitles();
         }
-        delete[] records_buf;
-        return titles;
+        return g_InstalledTitles;
     }
 
 }
\ No newline at end of file
@@ -21,8 +21,10 @@ namespace res {
             _UL_RC_INFO_DEFINE(dmn, InvalidSelectedUser),
             _UL_RC_INFO_DEFINE(dmn, AlreadyQueued),
             _UL_RC_INFO_DEFINE(dmn, ApplicationNotActive),
+            _UL_RC_INFO_DEFINE(dmn, LaunchQueueFull),
 
             _UL_RC_INFO_DEFINE(menu, RomfsFileNotFound),
+            _UL_RC_INFO_DEFINE(menu, DaemonServiceNotInitialized),
 
             _UL_RC_INFO_DEFINE(ipc, InvalidProcess),
 
@@ -30,6 +32,9 @@ namespace res {
             _UL_RC_INFO_DEFINE(dmi, OutOfPopSpace),
             _UL_RC_INFO_DEFINE(dmi, InvalidInHeaderMagic),
             _UL_RC_INFO_DEFINE(dmi, InvalidOutHeaderMagic),
+            _UL_RC_INFO_DEFINE(dmi, InvalidBatchCount),
+            _UL_RC_INFO_DEFINE(dmi, BatchCountMismatch),
+            _UL_RC_INFO_DEFINE(dmi, InvalidBatchPayloadSize),
         };
         #undef _UL_RC_INFO_DEFINE
         constexpr size_t ResultInfoTableImplCount = sizeof(g_ResultInfoTableImpl) / sizeof(ResultInfoImpl);
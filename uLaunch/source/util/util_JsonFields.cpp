@@ -0,0 +1,185 @@
+#include <util/util_JsonFields.hpp>
+#include <fs/fs_Stdio.hpp>
+
+namespace util {
+
+    namespace {
+
+        // SAX handler for nlohmann's parser: only keys directly inside the root object are looked at
+        class JsonFieldHandler {
+            private:
+                const JsonField *fields;
+                size_t field_count;
+                u64 found_mask;
+                u32 depth;
+                const JsonField *cur_field;
+                bool root_seen;
+
+                // Returning false stops the parse: once every field has been found, the rest of the document is irrelevant
+                bool OnValueDone() {
+                    this->cur_field = nullptr;
+                    return !this->IsDone();
+                }
+
+                bool OnScalar() {
+                    // A root which isn't an object
+                    if(this->depth == 0) {
+                        return false;
+                    }
+
+                    return this->OnValueDone();
+                }
+
+                void SetFound() {
+                    this->found_mask |= 1ul << static_cast<u64>(this->cur_field - this->fields);
+                }
+
+                template<typename T>
+                bool OnNumber(const T val) {
+                    auto is_negative = false;
+                    if constexpr(std::is_signed_v<T>) {
+                        is_negative = val < 0;
+                    }
+
+                    if((this->cur_field != nullptr) && !is_negative) {
+                        if(this->cur_field->type == JsonFieldType::U32) {
+                            if(static_cast<u64>(val) <= UINT32_MAX) {
+                                *reinterpret_cast<u32*>(this->cur_field->dest) = static_cast<u32>(val);
+                                this->SetFound();
+                            }
+                        }
+                        else if(this->cur_field->type == JsonFieldType::U64) {
+                            *reinterpret_cast<u64*>(this->cur_field->dest) = static_cast<u64>(val);
+                            this->SetFound();
+                        }
+                    }
+                    return this->OnScalar();
+                }
+
+            public:
+                JsonFieldHandler(const JsonField *fields, const size_t field_count) : fields(fields), field_count(field_count), found_mask(0), depth(0), cur_field(nullptr), root_seen(false) {}
+
+                inline bool IsDone() const {
+                    return this->found_mask == ((this->field_count == 64) ? UINT64_MAX : ((1ul << this->field_count) - 1));
+                }
+
+                inline bool IsRootSeen() const {
+                    return this->root_seen;
+                }
+
+                bool null() {
+                    return this->OnScalar();
+                }
+
+                bool boolean(const bool val) {
+                    if((this->cur_field != nullptr) && (this->cur_field->type == JsonFieldType::Bool)) {
+                        *reinterpret_cast<bool*>(this->cur_field->dest) = val;
+                        this->SetFound();
+                    }
+                    return this->OnScalar();
+                }
+
+                bool number_integer(const JSON::number_integer_t val) {
+                    return this->OnNumber(val);
+                }
+
+                bool number_unsigned(const JSON::number_unsigned_t val) {
+                    return this->OnNumber(val);
+                }
+
+                bool number_float(const JSON::number_float_t, const JSON::string_t&) {
+                    return this->OnScalar();
+                }
+
+                bool string(JSON::string_t &val) {
+                    if((this->cur_field != nullptr) && (this->cur_field->type == JsonFieldType::String)) {
+                        *reinterpret_cast<std::string*>(this->cur_field->dest) = std::move(val);
+                        this->SetFound();
+                    }
+                    return this->OnScalar();
+                }
+
+                bool binary(JSON::binary_t&) {
+                    return this->OnScalar();
+                }
+
+                bool start_object(const size_t) {
+                    if(this->depth == 0) {
+                        this->root_seen = true;
+                    }
+                    this->depth++;
+                    this->cur_field = nullptr;
+                    return true;
+                }
+
+                bool end_object() {
+                    this->depth--;
+                    return true;
+                }
+
+                bool start_array(const size_t) {
+                    // A root which isn't an object
+                    if(this->depth == 0) {
+                        return false;
+                    }
+
+                    this->depth++;
+                    this->cur_field = nullptr;
+                    return true;
+                }
+
+                bool end_array() {
+                    this->depth--;
+                    return true;
+                }
+
+                bool key(JSON::string_t &val) {
+                    this->cur_field = nullptr;
+                    if(this->depth == 1) {
+                        for(size_t i = 0; i < this->field_count; i++) {
+                            if(val == this->fields[i].key) {
+                                this->cur_field = &this->fields[i];
+                                break;
+                            }
+                        }
+                    }
+                    return true;
+                }
+
+                bool parse_error(const size_t, const std::string&, const nlohmann::detail::exception&) {
+                    return false;
+                }
+        };
+
+    }
+
+    Result LoadJSONFieldsFromBuffer(const char *data, const size_t data_size, const JsonField *fields, const size_t field_count) {
+        if(field_count > MaxJsonFieldCount) {
+            return misc::ResultInvalidJsonFile;
+        }
+
+        JsonFieldHandler handler(fields, field_count);
+        try {
+            if(JSON::sax_parse(data, data + data_size, &handler)) {
+                return ResultSuccess;
+            }
+        }
+        catch(...) {}
+
+        // The parse was stopped early since everything was already found
+        if(handler.IsRootSeen() && handler.IsDone()) {
+            return ResultSuccess;
+        }
+        return misc::ResultInvalidJsonFile;
+    }
+
+    Result LoadJSONFieldsFromFile(const std::string &path, const JsonField *fields, const size_t field_count) {
+        std::string data;
+        if(!fs::ReadWholeFile(path, data)) {
+            return misc::ResultInvalidJsonFile;
+        }
+
+        return LoadJSONFieldsFromBuffer(data.data(), data.size(), fields, field_count);
+    }
+
+}
\ No newline at end of file
@@ -4,10 +4,10 @@
 namespace util {
 
     Result LoadJSONFromFile(JSON &out_json, const std::string &path) {
-        if(fs::ExistsFile(path)) {
+        std::string data;
+        if(fs::ReadWholeFile(path, data)) {
             try {
-                std::ifstream ifs(path);
-                out_json = JSON::parse(ifs);
+                out_json = JSON::parse(data);
                 return ResultSuccess;
             }
             catch(...) {}
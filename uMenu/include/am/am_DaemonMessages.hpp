@@ -6,9 +6,18 @@
 namespace am {
 
     using OnMessageCallback = std::function<void()>;
+    using OnMessageContextCallback = std::function<void(const dmi::MenuMessageContext&)>;
 
     Result InitializeDaemonMessageHandler();
     void ExitDaemonMessageHandler();
     void RegisterOnMessageDetect(OnMessageCallback callback, const dmi::MenuMessage desired_msg);
+    void RegisterOnMessageDetect(OnMessageContextCallback callback, const dmi::MenuMessage desired_msg);
+
+    // Messages the daemon had to drop since its queue was full, detected by gaps in the sequence numbers
+    u32 GetMissedDaemonMessageCount();
+
+    Result GetDaemonHeapStats(dmi::DaemonHeapStats &out_stats);
+    // Messages the daemon dropped, whichever menu instance they were meant for
+    Result GetDaemonMenuMessageStats(dmi::MenuMessageStats &out_stats);
 
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+
+#pragma once
+#include <ul_Include.hpp>
+#include <ui/ui_TextAtlas.hpp>
+#include <ui/ui_FramePacer.hpp>
+
+namespace ui {
+
+    // Text label drawn from the shared glyph atlas, unlike pu::ui::elm::TextBlock this doesn't re-render a texture on every text change
+
+    class CachedTextBlock : public pu::ui::elm::Element {
+        private:
+            s32 x;
+            s32 y;
+            std::string text;
+            std::string font_name;
+            pu::ui::Color clr;
+            u8 alpha;
+            TextRunRef run;
+
+            inline void UpdateRun() {
+                this->run = GetTextRun(this->font_name, this->text, this->clr);
+                MarkFrameDirty();
+            }
+
+        public:
+            CachedTextBlock(const s32 x, const s32 y, const std::string &text);
+            PU_SMART_CTOR(CachedTextBlock)
+
+            inline s32 GetX() override {
+                return this->x;
+            }
+
+            inline void SetX(const s32 x) {
+                this->x = x;
+            }
+
+            inline s32 GetY() override {
+                return this->y;
+            }
+
+            inline void SetY(const s32 y) {
+                this->y = y;
+            }
+
+            inline s32 GetWidth() override {
+                return IsTextRunValid(this->run) ? this->run->width : 0;
+            }
+
+            inline s32 GetHeight() override {
+                return IsTextRunValid(this->run) ? this->run->height : 0;
+            }
+
+            inline std::string GetText() {
+                return this->text;
+            }
+
+            void SetText(const std::string &text);
+            void SetFont(const std::string &font_name);
+            void SetColor(const pu::ui::Color clr);
+
+            inline u8 GetAlpha() {
+                return this->alpha;
+            }
+
+            // Applied on top of the color's own alpha
+            inline void SetAlpha(const u8 alpha) {
+                if(this->alpha != alpha) {
+                    this->alpha = alpha;
+                    MarkFrameDirty();
+                }
+            }
+
+            void OnRender(pu::ui::render::Renderer::Ref &drawer, const s32 x, const s32 y) override;
+            void OnInput(const u64 keys_down, const u64 keys_up, const u64 keys_held, const pu::ui::TouchPoint touch_pos) override {}
+    };
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <ul_Include.hpp>
+
+namespace ui {
+
+    // Elements mark the frame as dirty whenever something visible changes (animations in progress, text changes, loaded images...)
+    // The menu's frame loop (see MenuApplication::Show) only renders and presents dirty frames, otherwise it waits until input arrives, something gets marked dirty or the keep-alive interval expires
+    // Waiting happens between frames, never inside Plutonium's frame (input handling included), so nothing Plutonium does within a frame gets delayed by it
+    // Controllers and touches have no wake-up event, so they're checked once per frame interval while waiting (the same latency as a rendered frame)
+    // Anything else Plutonium handles on its own (for instance, applet messages) is only seen on the next keep-alive frame, up to KeepAliveIntervalNs later
+
+    constexpr u64 FrameIntervalNs = 16'666'667;
+    constexpr u64 KeepAliveIntervalNs = 100'000'000;
+
+    struct FrameStats {
+        u64 rendered_frames;
+        u64 keep_alive_frames;
+        // Frames with nothing dirty, which waited instead of being rendered right away
+        u64 idle_frames;
+        u64 idle_ns;
+    };
+
+    // Must be called before anything gets marked dirty, also makes daemon messages (HOME button presses, exited applications...) wake waiting frames right away
+    void InitializeFramePacer();
+
+    void MarkFrameDirty();
+    // For animations which can only be tracked by their length, every frame until then gets rendered
+    void MarkFrameDirtyFor(const u64 ms);
+
+    // Called by the frame loop before each frame, returns once the frame has to be rendered
+    void WaitForFrame();
+
+    FrameStats GetFrameStats();
+
+}
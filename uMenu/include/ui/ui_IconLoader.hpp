@@ -0,0 +1,29 @@
+
+#pragma once
+#include <ul_Include.hpp>
+#include <pu/Plutonium>
+
+namespace ui {
+
+    // Icons get decoded and downscaled on a worker thread into small BMPs kept in memory, reachable as "ulicon:/<id>.bmp"
+    // Plutonium's path-based image loading then reads them without touching the SD card nor decoding PNGs on the UI thread
+
+    #define UL_ICON_LOADER_DEVICE "ulicon"
+
+    constexpr s32 LoadedIconSize = 80;
+    // Decoded icons kept in memory, the least recently used ones get evicted past this
+    constexpr size_t MaxLoadedIconCount = 128;
+
+    // Shown until the actual icon is ready
+    constexpr const char IconPlaceholderPath[] = "romfs:/Logo.png";
+
+    // Replaces any pending request, icons get reported back by their index in the given list
+    void RequestIcons(const std::vector<std::string> &icon_paths);
+
+    // Icons of the current request which got ready since the last call, every new one marks the frame dirty
+    // Their loaded paths stay valid for the whole session, even if the decoded icon gets evicted meanwhile (it's decoded again when opened)
+    bool PopLoadedIcon(u32 &out_idx, std::string &out_path);
+
+    void ExitIconLoader();
+
+}
\ No newline at end of file
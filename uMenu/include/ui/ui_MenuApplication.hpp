@@ -1,11 +1,13 @@
 
 #pragma once
 #include <ui/ui_TransitionGuard.hpp>
+#include <ui/ui_SfxPool.hpp>
 #include <ui/ui_StartupLayout.hpp>
 #include <ui/ui_MenuLayout.hpp>
 #include <ui/ui_ThemeMenuLayout.hpp>
 #include <ui/ui_SettingsMenuLayout.hpp>
 #include <ui/ui_LanguagesMenuLayout.hpp>
+#include <ui/ui_PacedElements.hpp>
 #include <am/am_DaemonMessages.hpp>
 
 namespace ui {
@@ -23,6 +25,19 @@ namespace ui {
 
     void UiOnHomeButtonDetection();
 
+    // Everything a theme needs besides its layouts, none of it touches the renderer so it can be prepared on another thread
+    struct ThemeResources {
+        bool bgm_loop;
+        u32 bgm_fade_in_ms;
+        u32 bgm_fade_out_ms;
+        pu::audio::Music bgm;
+        pu::ui::Color text_clr;
+        pu::ui::Color menu_focus_clr;
+        pu::ui::Color menu_bg_clr;
+        pu::ui::Color toast_text_clr;
+        pu::ui::Color toast_base_clr;
+    };
+
     class MenuApplication : public pu::ui::Application {
         private:
             dmi::MenuStartMode start_mode;
@@ -31,11 +46,10 @@ namespace ui {
             ThemeMenuLayout::Ref theme_menu_lyt;
             SettingsMenuLayout::Ref settings_menu_lyt;
             LanguagesMenuLayout::Ref languages_menu_lyt;
-            pu::ui::extras::Toast::Ref notif_toast;
+            NotificationToast::Ref notif_toast;
             dmi::DaemonStatus daemon_status;
             MenuType loaded_menu;
             JSON ui_json;
-            JSON bgm_json;
             bool bgm_loop;
             u32 bgm_fade_in_ms;
             u32 bgm_fade_out_ms;
@@ -43,12 +57,18 @@ namespace ui {
             pu::ui::Color text_clr;
             pu::ui::Color menu_focus_clr;
             pu::ui::Color menu_bg_clr;
+            std::vector<pu::ui::Layout::Ref> retired_lyts;
+            bool switching_theme;
+
+            void ApplyThemeResources(const ThemeResources &res);
+            void CreateLayouts();
 
         public:
             using Application::Application;
 
             ~MenuApplication() {
                 pu::audio::DestroyMusic(this->bgm);
+                ClearTextAtlas();
             }
             
             PU_SMART_CTOR(MenuApplication)
@@ -59,6 +79,25 @@ namespace ui {
 
             void OnLoad() override;
 
+            // Plutonium's fades render every frame in their own loop, only the first frame after them needs to be marked
+            inline void FadeIn() {
+                Application::FadeIn();
+                MarkFrameDirty();
+            }
+
+            inline void FadeOut() {
+                Application::FadeOut();
+                MarkFrameDirty();
+            }
+
+            // Like Plutonium's, but frames with nothing dirty are neither rendered nor presented
+            void Show();
+
+            inline void ShowWithFadeIn() {
+                this->FadeIn();
+                this->Show();
+            }
+
             inline void SetInformation(const dmi::MenuStartMode start_mode, const dmi::DaemonStatus daemon_status, const JSON ui_json) {
                 this->start_mode = start_mode;
                 this->daemon_status = daemon_status;
@@ -179,6 +218,17 @@ namespace ui {
             void StartPlayBGM();
             void StopPlayBGM();
 
+            // Applies the theme in place (layouts, sounds, BGM, UI.json, menu font size), returns false if uMenu needs to be restarted for it (different font file)
+            bool SwitchTheme(const std::string &theme_name);
+
+            // Layouts replaced while one of their callbacks was running get destroyed later, from the new layout's input handling
+            inline void DisposeRetiredLayouts() {
+                // Fades run render loops, the callback which started the switch is still on the stack
+                if(!this->switching_theme) {
+                    this->retired_lyts.clear();
+                }
+            }
+
             inline StartupLayout::Ref &GetStartupLayout() {
                 return this->startup_lyt;
             }
@@ -4,9 +4,11 @@
 #include <ui/ui_IMenuLayout.hpp>
 #include <ui/ui_SideMenu.hpp>
 #include <ui/ui_RawRgbaImage.hpp>
+#include <ui/ui_CachedTextBlock.hpp>
 #include <ui/ui_ClickableImage.hpp>
 #include <ui/ui_QuickMenu.hpp>
 #include <ui/ui_Actions.hpp>
+#include <ui/ui_SfxPool.hpp>
 #include <cfg/cfg_Config.hpp>
 
 namespace ui {
@@ -36,14 +38,16 @@ namespace ui {
             pu::ui::elm::TextBlock::Ref fw_text;
             SideMenu::Ref items_menu;
             RawRgbaImage::Ref suspended_screen_img;
-            pu::ui::elm::TextBlock::Ref selected_item_name_text;
-            pu::ui::elm::TextBlock::Ref selected_item_author_text;
-            pu::ui::elm::TextBlock::Ref selected_item_version_text;
+            CachedTextBlock::Ref selected_item_name_text;
+            CachedTextBlock::Ref selected_item_author_text;
+            CachedTextBlock::Ref selected_item_version_text;
             pu::ui::elm::Image::Ref banner_img;
             pu::ui::elm::Image::Ref guide_buttons_img;
             ClickableImage::Ref menu_totggle_img;
             QuickMenu::Ref quick_menu;
             std::string cur_folder;
+            bool shown_homebrew_mode;
+            std::string shown_folder;
             std::chrono::steady_clock::time_point startup_tp;
             bool launch_fail_warn_shown;
             bool homebrew_mode;
@@ -52,14 +56,17 @@ namespace ui {
             u8 min_alpha;
             u32 mode;
             s32 suspended_screen_alpha;
-            pu::audio::Sfx title_launch_sfx;
-            pu::audio::Sfx menu_toggle_sfx;
+            LazySfx title_launch_sfx;
+            LazySfx menu_toggle_sfx;
+            std::string search_query;
 
             void DoMoveFolder(const std::string &name);
 
             void menu_Click(const u64 keys_down, const u32 idx);
             void menu_OnSelected(const u32 idx);
             void menuToggle_Click();
+            void HandleSearch();
+            void HandleLetterJump(const bool next);
 
             inline void ApplySuspendedRatio(const bool increase) {
                 auto susp_w = this->suspended_screen_img->GetWidth();
@@ -84,7 +91,6 @@ namespace ui {
 
         public:
             MenuLayout(const u8 *captured_screen_buf, const u8 min_alpha);
-            ~MenuLayout();
             PU_SMART_CTOR(MenuLayout)
 
             void OnMenuInput(const u64 keys_down, const u64 keys_up, const u64 keys_held, const pu::ui::TouchPoint touch_pos) override;
@@ -97,6 +103,10 @@ namespace ui {
             void HandleMultiselectMoveToFolder(const std::string &folder);
             void StopMultiselect();
             void DoTerminateApplication();
+
+            inline SideMenuUpdateStats GetItemsMenuUpdateStats() {
+                return this->items_menu->GetUpdateStats();
+            }
     };
 
 }
\ No newline at end of file
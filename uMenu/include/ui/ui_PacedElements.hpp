@@ -0,0 +1,45 @@
+#pragma once
+#include <ui/ui_FramePacer.hpp>
+#include <pu/Plutonium>
+
+namespace ui {
+
+    // Plutonium elements which animate on their own, wrapped so that their animations mark frames dirty (see ui_FramePacer.hpp)
+
+    class PacedMenu : public pu::ui::elm::Menu {
+        public:
+            // Plutonium fades the focus between the previous and the new selection over a fixed amount of frames (~6)
+            static constexpr u64 FocusFadeTimeMs = 150;
+
+        private:
+            s32 last_selected_idx = -1;
+
+        public:
+            using Menu::Menu;
+            PU_SMART_CTOR(PacedMenu)
+
+            void OnRender(pu::ui::render::Renderer::Ref &drawer, const s32 x, const s32 y) override {
+                Menu::OnRender(drawer, x, y);
+
+                // The selection also changes from code (reloads, resets...), not only from input
+                const auto selected_idx = this->GetSelectedIndex();
+                if(selected_idx != this->last_selected_idx) {
+                    this->last_selected_idx = selected_idx;
+                    MarkFrameDirtyFor(FocusFadeTimeMs);
+                }
+            }
+    };
+
+    class NotificationToast : public pu::ui::extras::Toast {
+        public:
+            using Toast::Toast;
+            PU_SMART_CTOR(NotificationToast)
+
+            // Only rendered while shown (fading in/out included), thus this keeps frames dirty exactly until it's gone
+            void OnPostRender(pu::ui::render::Renderer::Ref &drawer) override {
+                Toast::OnPostRender(drawer);
+                MarkFrameDirty();
+            }
+    };
+
+}
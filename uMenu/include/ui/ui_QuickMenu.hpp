@@ -1,6 +1,7 @@
 
 #pragma once
 #include <am/am_DaemonMessages.hpp>
+#include <ui/ui_FramePacer.hpp>
 #include <pu/Plutonium>
 
 namespace ui {
@@ -57,6 +58,7 @@ namespace ui {
             
             inline void Toggle() {
                 this->on = !this->on;
+                MarkFrameDirty();
             }
 
             inline constexpr bool IsOn() {
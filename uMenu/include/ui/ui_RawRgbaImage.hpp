@@ -2,6 +2,7 @@
 #pragma once
 #include <ul_Include.hpp>
 #include <pu/Plutonium>
+#include <ui/ui_FramePacer.hpp>
 
 namespace ui {
 
@@ -24,7 +25,10 @@ namespace ui {
             }
 
             inline void SetX(const s32 x) {
-                this->x = x;
+                if(this->x != x) {
+                    this->x = x;
+                    MarkFrameDirty();
+                }
             }
 
             inline s32 GetY() override {
@@ -32,7 +36,10 @@ namespace ui {
             }
 
             inline void SetY(const s32 y) {
-                this->y = y;
+                if(this->y != y) {
+                    this->y = y;
+                    MarkFrameDirty();
+                }
             }
 
             inline s32 GetWidth() override {
@@ -40,7 +47,10 @@ namespace ui {
             }
 
             inline void SetWidth(const s32 w) {
-                this->w = w;
+                if(this->w != w) {
+                    this->w = w;
+                    MarkFrameDirty();
+                }
             }
 
             inline s32 GetHeight() override {
@@ -48,11 +58,17 @@ namespace ui {
             }
 
             inline void SetHeight(const s32 h) {
-                this->h = h;
+                if(this->h != h) {
+                    this->h = h;
+                    MarkFrameDirty();
+                }
             }
 
             inline void SetAlpha(const u8 alpha) {
-                this->alpha = alpha;
+                if(this->alpha != alpha) {
+                    this->alpha = alpha;
+                    MarkFrameDirty();
+                }
             }
             
             void OnRender(pu::ui::render::Renderer::Ref &drawer, const s32 x, const s32 y) override;
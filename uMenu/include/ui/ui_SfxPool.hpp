@@ -0,0 +1,50 @@
+
+#pragma once
+#include <ul_Include.hpp>
+#include <cfg/cfg_Config.hpp>
+#include <pu/Plutonium>
+
+namespace ui {
+
+    // Every "sound/*.wav" of the current theme, decoded once into PCM chunks (on a worker thread) and shared by name (the file name without extension)
+    // Loading another theme replaces the pool, chunks still referenced by someone stay alive until released
+
+    using SharedSfx = std::shared_ptr<Mix_Chunk>;
+
+    struct SfxPoolStats {
+        u32 sfx_count;
+        u64 decoded_size;
+    };
+
+    void LoadSfxPool(const cfg::Theme &theme);
+
+    // Waits for the pool to be loaded if needed, null if the theme has no such sound
+    SharedSfx GetSfx(const std::string &name);
+
+    void PlaySfx(const SharedSfx &sfx);
+
+    SfxPoolStats GetSfxPoolStats();
+
+    void ExitSfxPool();
+
+    // Resolved on first use, so that holders don't wait for the pool to be loaded when created
+    class LazySfx {
+        private:
+            std::string name;
+            SharedSfx sfx;
+            bool resolved;
+
+        public:
+            LazySfx() : resolved(true) {}
+            LazySfx(const std::string &name) : name(name), resolved(false) {}
+
+            inline void Play() {
+                if(!this->resolved) {
+                    this->sfx = GetSfx(this->name);
+                    this->resolved = true;
+                }
+                PlaySfx(this->sfx);
+            }
+    };
+
+}
\ No newline at end of file
@@ -1,9 +1,25 @@
 
 #pragma once
-#include <pu/Plutonium>
+#include <ui/ui_TextAtlas.hpp>
+#include <ui/ui_FramePacer.hpp>
 
 namespace ui {
 
+    struct SideMenuItem {
+        std::string key; // Stable across updates, tells which items are still there
+        std::string icon_path;
+        std::string text;
+    };
+
+    struct SideMenuUpdateStats {
+        u64 update_count;
+        u64 last_update_ns;
+        u64 max_update_ns;
+        u64 total_update_ns;
+        u32 last_reused_icon_count;
+        u32 last_loaded_icon_count;
+    };
+
     class SideMenu : public pu::ui::elm::Element {
         public:
             static constexpr u32 BaseX = 98;
@@ -35,11 +51,12 @@ namespace ui {
             pu::ui::Color text_clr;
             std::vector<std::string> items_icon_paths;
             std::vector<std::string> items_icon_texts;
+            std::vector<std::string> items_keys;
             std::vector<bool> items_multiselected;
             OnSelectCallback on_select_cb;
             OnSelectionChangedCallback on_selection_changed_cb;
             std::vector<pu::sdl2::Texture> rendered_icons;
-            std::vector<pu::sdl2::Texture> rendered_texts;
+            std::vector<TextRunRef> rendered_texts;
             pu::sdl2::Texture cursor_icon;
             pu::sdl2::Texture suspended_icon;
             pu::sdl2::Texture left_border_icon;
@@ -52,6 +69,7 @@ namespace ui {
             u32 scroll_flag;
             u32 scroll_tp_value;
             u32 scroll_count;
+            SideMenuUpdateStats update_stats;
 
             inline void DoOnItemSelected(const u64 keys) {
                 if(this->on_select_cb) {
@@ -60,6 +78,7 @@ namespace ui {
             }
 
             inline void DoOnSelectionChanged() {
+                MarkFrameDirty();
                 if(this->on_selection_changed_cb) {
                     (this->on_selection_changed_cb)(this->selected_item_idx);
                 }
@@ -75,10 +94,6 @@ namespace ui {
                     pu::ui::render::DeleteTexture(icon_tex);
                 }
                 this->rendered_icons.clear();
-
-                for(auto &text_tex: this->rendered_texts) {
-                    pu::ui::render::DeleteTexture(text_tex);
-                }
                 this->rendered_texts.clear();
 
                 this->ClearBorderIcons();
@@ -87,6 +102,22 @@ namespace ui {
             bool IsLeftFirst();
             bool IsRightLast();
             void MoveReloadIcons(const bool moving_right);
+            void DoSeek(const u32 idx, const u32 base_idx);
+
+            inline u32 GetMaxBaseIconIndex() {
+                if(this->items_icon_paths.size() > ItemCount) {
+                    return this->items_icon_paths.size() - ItemCount;
+                }
+                return 0;
+            }
+
+            inline TextRunRef GetItemTextRun(const u32 idx) {
+                const auto &text = this->items_icon_texts.at(idx);
+                if(text.empty()) {
+                    return nullptr;
+                }
+                return GetTextRun(this->text_font, text, this->text_clr);
+            }
 
         public:
             SideMenu(const pu::ui::Color suspended_clr, const std::string &cursor_path, const std::string &suspended_img_path, const std::string &multiselect_img_path, const s32 txt_x, const s32 txt_y, const std::string &font_name, const pu::ui::Color txt_clr, const s32 y);
@@ -105,7 +136,10 @@ namespace ui {
             inline void SetX(const s32 x) {}
 
             inline void SetY(const s32 y) {
-                this->y = y;
+                if(this->y != y) {
+                    this->y = y;
+                    MarkFrameDirty();
+                }
             }
 
             inline constexpr s32 GetWidth() override {
@@ -128,16 +162,24 @@ namespace ui {
             }
             
             void ClearItems();
-            void AddItem(const std::string &icon, const std::string &txt = "");
+            // Icon textures of the previous window are reused by the new one (matched by item key and icon path) instead of being reloaded, only the new icons get loaded
+            // Unless told to keep it (by item key), the selection goes back to the first item
+            void UpdateItems(const std::vector<SideMenuItem> &items, const bool keep_selection);
+
+            inline SideMenuUpdateStats GetUpdateStats() {
+                return this->update_stats;
+            }
             
             inline void SetSuspendedItem(const u32 idx) {
                 if(idx < this->items_icon_paths.size()) {
                     this->suspended_item_idx = idx;
+                    MarkFrameDirty();
                 }
             }
 
             inline void ResetSuspendedItem() {
                 this->suspended_item_idx = -1;
+                MarkFrameDirty();
             }
 
             inline void Rewind() {
@@ -146,10 +188,18 @@ namespace ui {
                 this->selected_item_idx = 0;
                 this->scroll_count = 0;
                 this->base_icon_idx = 0;
+                MarkFrameDirty();
             }
 
             void HandleMoveLeft();
             void HandleMoveRight();
+            // Only the final window gets loaded (on the next render, if it has to change), no matter how far it is
+            void SeekTo(const u32 idx);
+            void MovePage(const bool moving_right);
+
+            inline u32 GetItemCount() {
+                return this->items_icon_paths.size();
+            }
 
             inline u32 GetSelectedItem() {
                 return this->selected_item_idx;
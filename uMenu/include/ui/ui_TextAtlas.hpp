@@ -0,0 +1,19 @@
+#pragma once
+#include <ui/ui_TextRunCache.hpp>
+#include <pu/Plutonium>
+
+namespace ui {
+
+    // Glyphs are rasterized once per font (font names already encode the font size) into shared atlas pages
+    // Strings are then laid out once into runs (cached by font, text and color) and drawn as quads from the atlas, instead of creating a texture per string
+
+    TextRunRef GetTextRun(const std::string &font_name, const std::string &text, const pu::ui::Color clr);
+    void RenderTextRun(const TextRunRef &run, const s32 x, const s32 y, const u8 alpha = 0xFF);
+
+    // Any run obtained before a clear is no longer valid (its generation won't match)
+    bool IsTextRunValid(const TextRunRef &run);
+    void ClearTextAtlas();
+
+    TextAtlasStats GetTextAtlasStats();
+
+}
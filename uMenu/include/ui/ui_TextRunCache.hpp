@@ -0,0 +1,151 @@
+#pragma once
+#include <ul_Include.hpp>
+#include <unordered_map>
+#include <list>
+#include <memory>
+
+namespace ui {
+
+    // Layout, glyph packing and run caching behind the glyph atlas (see ui_TextAtlas.hpp)
+    // Rasterizing and uploading glyphs goes through a backend, so that everything else can be driven outside of the console
+
+    constexpr s32 TextAtlasPageSize = 1024;
+    constexpr size_t MaxCachedTextRunCount = 512;
+
+    // Opaque to the cache (SDL textures on the console)
+    using TextAtlasPage = void*;
+    using TextGlyphImage = void*;
+
+    struct TextRect {
+        s32 x;
+        s32 y;
+        s32 w;
+        s32 h;
+    };
+
+    struct TextColor {
+        u8 r;
+        u8 g;
+        u8 b;
+        u8 a;
+    };
+
+    struct TextRunGlyph {
+        TextAtlasPage page;
+        TextRect src_rect;
+        s32 x;
+        s32 y;
+    };
+
+    struct TextRun {
+        std::vector<TextRunGlyph> glyphs;
+        TextColor clr;
+        s32 width;
+        s32 height;
+        u32 generation;
+    };
+
+    using TextRunRef = std::shared_ptr<TextRun>;
+
+    struct TextAtlasStats {
+        u64 run_hits;
+        u64 run_misses;
+        u64 rasterized_glyphs;
+        u32 page_count;
+    };
+
+    struct TextAtlasBackend {
+        // Renders a single glyph (one UTF-8 codepoint) in white, the run color is applied when drawing
+        TextGlyphImage (*render_glyph)(const std::string &font_name, const std::string &glyph_str, s32 &out_width, s32 &out_height);
+        void (*delete_glyph)(TextGlyphImage glyph);
+        // New pages start fully transparent
+        TextAtlasPage (*create_page)();
+        void (*delete_page)(TextAtlasPage page);
+        void (*copy_glyph)(TextGlyphImage glyph, TextAtlasPage page, const TextRect &dst_rect);
+        // Horizontal distance to the next glyph's origin, false if the font can't tell (the rendered width is used then)
+        bool (*get_glyph_advance)(const std::string &font_name, const u32 cp, s32 &out_advance);
+        // Adjustment between two consecutive glyphs (usually negative, zero if none)
+        s32 (*get_kerning)(const std::string &font_name, const u32 prev_cp, const u32 cp);
+    };
+
+    // Decodes the next UTF-8 codepoint, returning its byte length (invalid sequences are consumed byte by byte)
+    size_t DecodeUtf8Codepoint(const std::string &text, const size_t offset, u32 &out_cp);
+
+    // Simple shelf packing: glyphs are placed left to right in rows, moving to the next row (or to a new page) when they don't fit
+    class TextAtlasPacker {
+        private:
+            s32 cur_x;
+            s32 cur_y;
+            s32 cur_row_height;
+            bool has_page;
+
+        public:
+            TextAtlasPacker() : cur_x(0), cur_y(0), cur_row_height(0), has_page(false) {}
+
+            // Fails if the glyph can't fit in a page at all, otherwise out_new_page tells whether a new page has to be started for it
+            bool Pack(const s32 width, const s32 height, TextRect &out_rect, bool &out_new_page);
+
+            // Next glyph goes to a new page (for instance, if creating the last one failed)
+            inline void Reset() {
+                this->cur_x = 0;
+                this->cur_y = 0;
+                this->cur_row_height = 0;
+                this->has_page = false;
+            }
+    };
+
+    // Strings are laid out once into runs (following the font's advances and kerning), cached by font, text and color with LRU eviction
+    // Evicted runs stay usable by whoever still holds them, only a clear invalidates runs (their generation won't match)
+    class TextRunCache {
+        private:
+            struct AtlasGlyph {
+                TextAtlasPage page;
+                TextRect src_rect;
+                s32 advance;
+            };
+
+            struct FontAtlas {
+                std::vector<TextAtlasPage> pages;
+                TextAtlasPacker packer;
+                s32 line_height;
+                std::unordered_map<u32, AtlasGlyph> glyphs;
+            };
+
+            struct CachedTextRun {
+                std::string key;
+                TextRunRef run;
+            };
+
+            TextAtlasBackend backend;
+            std::unordered_map<std::string, FontAtlas> font_atlases;
+            std::list<CachedTextRun> run_list;
+            std::unordered_map<std::string, std::list<CachedTextRun>::iterator> run_table;
+            u32 generation;
+            TextAtlasStats stats;
+
+            bool RasterizeGlyph(const std::string &font_name, FontAtlas &atlas, const u32 cp, const std::string &glyph_str, AtlasGlyph &out_glyph);
+            const AtlasGlyph *FindOrRasterizeGlyph(const std::string &font_name, FontAtlas &atlas, const u32 cp, const std::string &glyph_str);
+            TextRunRef LayoutRun(const std::string &font_name, const std::string &text, const TextColor clr);
+
+        public:
+            // Pages aren't deleted on destruction (the renderer might be gone by then), Clear() must be called while the backend is still usable
+            TextRunCache(const TextAtlasBackend &backend) : backend(backend), font_atlases(), run_list(), run_table(), generation(0), stats() {}
+
+            TextRunRef GetRun(const std::string &font_name, const std::string &text, const TextColor clr);
+
+            inline bool IsRunValid(const TextRunRef &run) {
+                return (run != nullptr) && (run->generation == this->generation);
+            }
+
+            void Clear();
+
+            inline TextAtlasStats GetStats() {
+                return this->stats;
+            }
+
+            inline size_t GetCachedRunCount() {
+                return this->run_list.size();
+            }
+    };
+
+}
@@ -15,7 +15,9 @@ namespace ui {
             pu::ui::elm::Image::Ref cur_theme_icon;
             pu::ui::elm::Image::Ref cur_theme_banner;
             std::vector<cfg::Theme> loaded_themes;
+            std::vector<pu::ui::elm::MenuItem::Ref> theme_items;
 
+            void UpdateLoadedIcons();
             void theme_DefaultKey();
 
         public:
@@ -1,9 +1,12 @@
 #include <db/db_Save.hpp>
 #include <fs/fs_Stdio.hpp>
 #include <cfg/cfg_Config.hpp>
+#include <cfg/cfg_RecordStore.hpp>
+#include <cfg/cfg_TitleIndex.hpp>
 #include <net/net_Service.hpp>
 #include <util/util_Misc.hpp>
 #include <ui/ui_MenuApplication.hpp>
+#include <ui/ui_IconLoader.hpp>
 #include <os/os_HomeMenu.hpp>
 #include <util/util_Convert.hpp>
 #include <am/am_LibraryApplet.hpp>
@@ -26,6 +29,7 @@ ui::MenuApplication::Ref g_MenuApplication;
 ui::TransitionGuard g_TransitionGuard;
 
 cfg::TitleList g_EntryList;
+cfg::TitleIndex g_TitleIndex;
 std::vector<cfg::TitleRecord> g_HomebrewRecordList;
 
 cfg::Config g_Config;
@@ -53,9 +57,17 @@ namespace {
         std::string theme_name;
         UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::ActiveThemeName, theme_name));
         g_Theme = cfg::LoadTheme(theme_name);
+
+        // Packed themes keep their hot assets in memory, the rest (the BGM included) is read on demand
+        if(g_Theme.IsPack()) {
+            cfg::LoadThemePackHotAssets(g_Theme.base_name);
+        }
     }
 
     void Exit() {
+        cfg::ExitRecordWriter();
+        ui::ExitIconLoader();
+        ui::ExitSfxPool();
         am::ExitDaemonMessageHandler();
 
         setExit();
@@ -95,6 +107,7 @@ int main() {
     cfg::CacheEverything();
 
     g_EntryList = cfg::LoadTitleList();
+    cfg::BuildTitleIndex(g_EntryList, g_TitleIndex);
 
     // Get system language and load translations (default one if not present)
     u64 lang_code = 0;
@@ -120,6 +133,7 @@ int main() {
     renderer_opts.UseAudio(pu::ui::render::MixerAllFlags);
     renderer_opts.SetExtraDefaultFontSize(menu_folder_text_size);
     auto renderer = pu::ui::render::Renderer::New(renderer_opts);
+    ui::InitializeFramePacer();
     g_MenuApplication = ui::MenuApplication::New(renderer);
 
     g_MenuApplication->SetInformation(start_mode, status, ui_json);
@@ -9,11 +9,34 @@ namespace {
         );
     }
 
-    Result daemonPrivateGetMessage(Service *srv, dmi::MenuMessage *out_msg) {
-        return serviceDispatchOut(srv, 1, *out_msg);
+    Result daemonPrivateGetMessageEvent(Service *srv, Event *out_event) {
+        Handle event_h;
+        UL_RC_TRY(serviceDispatch(srv, 2,
+            .out_handle_attrs = { SfOutHandleAttr_HipcCopy },
+            .out_handles = &event_h
+        ));
+
+        eventLoadRemote(out_event, event_h, true);
+        return ResultSuccess;
+    }
+
+    Result daemonPrivateGetMessages(Service *srv, dmi::MenuMessageContext *out_msg_ctxs, const size_t max_count, u32 *out_count) {
+        return serviceDispatchOut(srv, 3, *out_count,
+            .buffer_attrs = { SfBufferAttr_HipcMapAlias | SfBufferAttr_Out },
+            .buffers = { { out_msg_ctxs, max_count * sizeof(dmi::MenuMessageContext) } }
+        );
+    }
+
+    Result daemonPrivateGetHeapStats(Service *srv, dmi::DaemonHeapStats *out_stats) {
+        return serviceDispatchOut(srv, 4, *out_stats);
+    }
+
+    Result daemonPrivateGetMenuMessageStats(Service *srv, dmi::MenuMessageStats *out_stats) {
+        return serviceDispatchOut(srv, 5, *out_stats);
     }
 
     Service g_DaemonPrivateService;
+    Event g_DaemonMessageEvent;
 
     Result daemonInitializePrivateService() {
         if(serviceIsActive(&g_DaemonPrivateService)) {
@@ -22,18 +45,20 @@ namespace {
 
         UL_RC_TRY(smGetService(&g_DaemonPrivateService, PrivateServiceName));
         UL_RC_TRY(daemonPrivateInitialize(&g_DaemonPrivateService));
+        UL_RC_TRY(daemonPrivateGetMessageEvent(&g_DaemonPrivateService, &g_DaemonMessageEvent));
 
         return ResultSuccess;
     }
 
     void daemonFinalizePrivateService() {
+        eventClose(&g_DaemonMessageEvent);
         serviceClose(&g_DaemonPrivateService);
     }
 
-    dmi::MenuMessage daemonPrivateServiceGetMessage() {
-        auto msg = dmi::MenuMessage::Invalid;
-        UL_RC_ASSERT(daemonPrivateGetMessage(&g_DaemonPrivateService, &msg));
-        return msg;
+    u32 daemonPrivateServiceGetMessages(dmi::MenuMessageContext *out_msg_ctxs, const size_t max_count) {
+        u32 count = 0;
+        UL_RC_ASSERT(daemonPrivateGetMessages(&g_DaemonPrivateService, out_msg_ctxs, max_count, &count));
+        return count;
     }
 
 }
@@ -42,11 +67,28 @@ namespace am {
 
     namespace {
 
+        // Only needed to periodically check whether the thread should exit
+        constexpr u64 MessageEventWaitTimeoutNs = 100'000'000ul;
+
         bool g_Initialized = false;
         std::atomic_bool g_ReceiveThreadShouldStop = false;
         Thread g_ReceiverThread;
-        std::vector<std::pair<OnMessageCallback, dmi::MenuMessage>> g_MessageCallbackTable;
+        std::vector<std::pair<OnMessageContextCallback, dmi::MenuMessage>> g_MessageCallbackTable;
         Mutex g_CallbackTableLock = {};
+        u32 g_LastMessageSequence = 0;
+        std::atomic<u32> g_MissedMessageCount = 0;
+
+        void DispatchMessage(const dmi::MenuMessageContext &msg_ctx) {
+            g_MissedMessageCount += dmi::GetMissedMenuMessageCount(g_LastMessageSequence, msg_ctx.seq);
+            g_LastMessageSequence = msg_ctx.seq;
+
+            ScopedLock lk(g_CallbackTableLock);
+            for(const auto &[cb, msg] : g_MessageCallbackTable) {
+                if(msg == msg_ctx.msg) {
+                    cb(msg_ctx);
+                }
+            }
+        }
 
         void DaemonMessageReceiverThread(void*) {
             while(true) {
@@ -54,18 +96,19 @@ namespace am {
                     break;
                 }
 
-                {
-                    const auto last_msg = daemonPrivateServiceGetMessage();
-                    ScopedLock lk(g_CallbackTableLock);
+                if(R_SUCCEEDED(eventWait(&g_DaemonMessageEvent, MessageEventWaitTimeoutNs))) {
+                    dmi::MenuMessageContext msg_ctxs[dmi::MaxMenuMessageBatchCount];
+                    while(true) {
+                        const auto count = daemonPrivateServiceGetMessages(msg_ctxs, dmi::MaxMenuMessageBatchCount);
+                        for(u32 i = 0; i < count; i++) {
+                            DispatchMessage(msg_ctxs[i]);
+                        }
 
-                    for(const auto &[cb, msg] : g_MessageCallbackTable) {
-                        if(msg == last_msg) {
-                            cb();
+                        if(count < dmi::MaxMenuMessageBatchCount) {
+                            break;
                         }
                     }
                 }
-
-                svcSleepThread(10'000'000ul);
             }
         }
 
@@ -78,7 +121,7 @@ namespace am {
         UL_RC_TRY(daemonInitializePrivateService());
 
         g_ReceiveThreadShouldStop = false;
-        UL_RC_TRY(threadCreate(&g_ReceiverThread, &DaemonMessageReceiverThread, nullptr, nullptr, 0x1000, 49, -2));
+        UL_RC_TRY(threadCreate(&g_ReceiverThread, &DaemonMessageReceiverThread, nullptr, nullptr, 0x2000, 49, -2));
         UL_RC_TRY(threadStart(&g_ReceiverThread));
 
         g_Initialized = true;
@@ -99,9 +142,35 @@ namespace am {
     }
 
     void RegisterOnMessageDetect(OnMessageCallback callback, const dmi::MenuMessage desired_msg) {
+        RegisterOnMessageDetect([callback](const dmi::MenuMessageContext&) {
+            callback();
+        }, desired_msg);
+    }
+
+    void RegisterOnMessageDetect(OnMessageContextCallback callback, const dmi::MenuMessage desired_msg) {
         ScopedLock lk(g_CallbackTableLock);
 
         g_MessageCallbackTable.push_back({ callback, desired_msg });
     }
 
+    u32 GetMissedDaemonMessageCount() {
+        return g_MissedMessageCount;
+    }
+
+    Result GetDaemonHeapStats(dmi::DaemonHeapStats &out_stats) {
+        if(!g_Initialized) {
+            return menu::ResultDaemonServiceNotInitialized;
+        }
+
+        return daemonPrivateGetHeapStats(&g_DaemonPrivateService, &out_stats);
+    }
+
+    Result GetDaemonMenuMessageStats(dmi::MenuMessageStats &out_stats) {
+        if(!g_Initialized) {
+            return menu::ResultDaemonServiceNotInitialized;
+        }
+
+        return daemonPrivateGetMenuMessageStats(&g_DaemonPrivateService, &out_stats);
+    }
+
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <ui/ui_Actions.hpp>
 #include <ui/ui_MenuApplication.hpp>
 #include <ui/ui_MenuLayout.hpp>
+#include <cfg/cfg_RecordStore.hpp>
 #include <os/os_Titles.hpp>
 #include <os/os_Account.hpp>
 #include <util/util_Convert.hpp>
@@ -45,6 +46,8 @@ namespace ui::actions {
         const auto option = g_MenuApplication->CreateShowDialog(GetLanguageString("user_settings"), GetLanguageString("user_selected") + ": " + name + "\n" + GetLanguageString("user_option"), { GetLanguageString("user_view_page"), GetLanguageString("user_logoff"), GetLanguageString("cancel") }, true, os::GetIconCacheImagePath(uid));
         if(option == 0) {
             friendsLaShowMyProfileForHomeMenu(uid);
+            // The profile might have been edited from there
+            os::InvalidateAccountCache();
         }
         else if(option == 1) {
             auto log_off = false;
@@ -93,17 +96,11 @@ namespace ui::actions {
         
         swkbdConfigSetGuideText(&swkbd, GetLanguageString("swkbd_webpage_guide").c_str());
         
-        char url[500] = {0};
-        swkbdShow(&swkbd, url, 500);
-
-        UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::OpenWebPage, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-            UL_RC_TRY(writer.PushData(url, sizeof(url)));
-            return ResultSuccess;
-        },
-        [&](dmi::menu::MenuScopedStorageReader &reader) {
-            // ...
-            return ResultSuccess;
-        }));
+        dmi::OpenWebPageRequest req = {};
+        swkbdShow(&swkbd, req.url, sizeof(req.url));
+
+        cfg::FlushRecords();
+        UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::OpenWebPage>(req));
 
         g_MenuApplication->StopPlayBGM();
         g_MenuApplication->CloseWithFadeOut();
@@ -114,23 +111,19 @@ namespace ui::actions {
         msg += " - " + GetLanguageString("help_launch") + "\n";
         msg += " - " + GetLanguageString("help_close") + "\n";
         msg += " - " + GetLanguageString("help_quick") + "\n";
+        msg += " - " + GetLanguageString("help_page") + "\n";
         msg += " - " + GetLanguageString("help_multiselect") + "\n";
         msg += " - " + GetLanguageString("help_back") + "\n";
         msg += " - " + GetLanguageString("help_minus") + "\n";
         msg += " - " + GetLanguageString("help_plus") + "\n";
+        msg += " - " + GetLanguageString("help_search") + "\n";
 
         g_MenuApplication->CreateShowDialog(GetLanguageString("help_title"), msg, { GetLanguageString("ok") }, true);
     }
 
     void ShowAlbumApplet() {
-        UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::OpenAlbum, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-            // ...
-            return ResultSuccess;
-        },
-        [&](dmi::menu::MenuScopedStorageReader &reader) {
-            // ...
-            return ResultSuccess;
-        }));
+        cfg::FlushRecords();
+        UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::OpenAlbum>());
 
         g_MenuApplication->StopPlayBGM();
         g_MenuApplication->CloseWithFadeOut();
@@ -155,6 +148,7 @@ namespace ui::actions {
             g_MenuApplication->FadeOut();
             
             auto smsg = os::SystemAppletMessage::Create(msg);
+            cfg::FlushRecords();
             os::PushSystemAppletMessage(smsg);
             svcSleepThread(1'500'000'000ul);
 
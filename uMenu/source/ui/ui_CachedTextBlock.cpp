@@ -0,0 +1,36 @@
+#include <ui/ui_CachedTextBlock.hpp>
+
+namespace ui {
+
+    CachedTextBlock::CachedTextBlock(const s32 x, const s32 y, const std::string &text) : x(x), y(y), text(text), font_name(pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::MediumLarge)), clr(0, 0, 0, 0xFF), alpha(0xFF) {
+        this->UpdateRun();
+    }
+
+    void CachedTextBlock::SetText(const std::string &text) {
+        if(this->text != text) {
+            this->text = text;
+            this->UpdateRun();
+        }
+    }
+
+    void CachedTextBlock::SetFont(const std::string &font_name) {
+        if(this->font_name != font_name) {
+            this->font_name = font_name;
+            this->UpdateRun();
+        }
+    }
+
+    void CachedTextBlock::SetColor(const pu::ui::Color clr) {
+        this->clr = clr;
+        this->UpdateRun();
+    }
+
+    void CachedTextBlock::OnRender(pu::ui::render::Renderer::Ref &drawer, const s32 x, const s32 y) {
+        // The atlas might have been cleared since the run was obtained
+        if(!IsTextRunValid(this->run)) {
+            this->UpdateRun();
+        }
+        RenderTextRun(this->run, x, y, this->alpha);
+    }
+
+}
@@ -0,0 +1,139 @@
+#include <ui/ui_FramePacer.hpp>
+#include <am/am_DaemonMessages.hpp>
+#include <atomic>
+
+namespace ui {
+
+    namespace {
+
+        std::atomic_bool g_FrameDirty = true;
+        std::atomic<u64> g_DirtyDeadlineNs = 0;
+        // Signaled on every invalidation, so that waiting frames wake up right away
+        UEvent g_FrameDirtyEvent;
+        FrameStats g_Stats = {};
+
+        constexpr HidNpadIdType NpadIds[] = {
+            HidNpadIdType_No1, HidNpadIdType_No2, HidNpadIdType_No3, HidNpadIdType_No4,
+            HidNpadIdType_No5, HidNpadIdType_No6, HidNpadIdType_No7, HidNpadIdType_No8,
+            HidNpadIdType_Handheld
+        };
+
+        inline u64 GetCurrentTimeNs() {
+            return armTicksToNs(armGetSystemTick());
+        }
+
+        bool IsNpadInputActive(const HidNpadIdType id) {
+            const auto style_set = hidGetNpadStyleSet(id);
+            HidNpadCommonState state = {};
+            size_t state_count = 0;
+            if(style_set & HidNpadStyleTag_NpadFullKey) {
+                state_count = hidGetNpadStatesFullKey(id, &state, 1);
+            }
+            else if(style_set & HidNpadStyleTag_NpadHandheld) {
+                state_count = hidGetNpadStatesHandheld(id, &state, 1);
+            }
+            else if(style_set & HidNpadStyleTag_NpadJoyDual) {
+                state_count = hidGetNpadStatesJoyDual(id, &state, 1);
+            }
+            else if(style_set & HidNpadStyleTag_NpadJoyLeft) {
+                state_count = hidGetNpadStatesJoyLeft(id, &state, 1);
+            }
+            else if(style_set & HidNpadStyleTag_NpadJoyRight) {
+                state_count = hidGetNpadStatesJoyRight(id, &state, 1);
+            }
+            return (state_count > 0) && (state.buttons != 0);
+        }
+
+        bool IsRawInputActive() {
+            // Controller states are only read here, without reconfiguring input (Plutonium already chose which players/styles are supported)
+            for(const auto id: NpadIds) {
+                if(IsNpadInputActive(id)) {
+                    return true;
+                }
+            }
+
+            HidTouchScreenState touch_state = {};
+            if(hidGetTouchScreenStates(&touch_state, 1) > 0) {
+                if(touch_state.count > 0) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void OnDaemonMessage() {
+            MarkFrameDirty();
+        }
+
+        inline bool ConsumeFrameDirty() {
+            if(g_FrameDirty.exchange(false)) {
+                return true;
+            }
+            return GetCurrentTimeNs() < g_DirtyDeadlineNs;
+        }
+
+    }
+
+    void InitializeFramePacer() {
+        ueventCreate(&g_FrameDirtyEvent, true);
+
+        am::RegisterOnMessageDetect(&OnDaemonMessage, dmi::MenuMessage::HomeRequest);
+        am::RegisterOnMessageDetect(&OnDaemonMessage, dmi::MenuMessage::SdCardEjected);
+        am::RegisterOnMessageDetect(&OnDaemonMessage, dmi::MenuMessage::ApplicationExited);
+    }
+
+    void MarkFrameDirty() {
+        g_FrameDirty = true;
+        ueventSignal(&g_FrameDirtyEvent);
+    }
+
+    void MarkFrameDirtyFor(const u64 ms) {
+        // Only ever extended, no matter which caller (or thread) gets here first
+        const auto deadline_ns = GetCurrentTimeNs() + ms * 1'000'000ul;
+        auto cur_deadline_ns = g_DirtyDeadlineNs.load();
+        while((deadline_ns > cur_deadline_ns) && !g_DirtyDeadlineNs.compare_exchange_weak(cur_deadline_ns, deadline_ns));
+
+        MarkFrameDirty();
+    }
+
+    void WaitForFrame() {
+        if(ConsumeFrameDirty()) {
+            g_Stats.rendered_frames++;
+            return;
+        }
+
+        // Nothing changed since the last frame: wait instead of presenting an identical frame
+        const auto start_ns = GetCurrentTimeNs();
+        auto cur_ns = start_ns;
+        auto input_active = false;
+        while((cur_ns - start_ns) < KeepAliveIntervalNs) {
+            if(IsRawInputActive()) {
+                input_active = true;
+                break;
+            }
+
+            const auto timeout_ns = std::min(FrameIntervalNs, KeepAliveIntervalNs - (cur_ns - start_ns));
+            if(R_SUCCEEDED(waitSingle(waiterForUEvent(&g_FrameDirtyEvent), timeout_ns))) {
+                break;
+            }
+            cur_ns = GetCurrentTimeNs();
+        }
+        cur_ns = GetCurrentTimeNs();
+
+        g_Stats.idle_frames++;
+        g_Stats.idle_ns += cur_ns - start_ns;
+        // Input is handled within the frame about to be rendered
+        if(g_FrameDirty.exchange(false) || input_active) {
+            g_Stats.rendered_frames++;
+        }
+        else {
+            g_Stats.keep_alive_frames++;
+        }
+    }
+
+    FrameStats GetFrameStats() {
+        return g_Stats;
+    }
+
+}
@@ -1,5 +1,9 @@
 #include <ui/ui_IMenuLayout.hpp>
 #include <ui/ui_Actions.hpp>
+#include <ui/ui_FramePacer.hpp>
+#include <ui/ui_MenuApplication.hpp>
+
+extern ui::MenuApplication::Ref g_MenuApplication;
 
 namespace ui {
 
@@ -8,6 +12,8 @@ namespace ui {
     }
 
     void IMenuLayout::OnInput(const u64 keys_down, const u64 keys_up, const u64 keys_held, const pu::ui::TouchPoint touch_pos) {
+        g_MenuApplication->DisposeRetiredLayouts();
+
         if(this->home_pressed) {
             if(this->OnHomeButtonPress()) {
                 // Input consumed
@@ -21,11 +27,17 @@ namespace ui {
         }
         */
 
+        // Whatever the input causes gets drawn within this same frame, elements animating afterwards keep marking the following ones
+        if((keys_down != 0) || (keys_up != 0) || (keys_held != 0) || !touch_pos.IsEmpty()) {
+            MarkFrameDirty();
+        }
+
         this->OnMenuInput(keys_down, keys_up, keys_held, touch_pos);
     }
 
     void IMenuLayout::DoOnHomeButtonPress() {
         this->home_pressed = true;
+        MarkFrameDirty();
     }
 
 }
\ No newline at end of file
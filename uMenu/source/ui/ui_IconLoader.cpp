@@ -0,0 +1,386 @@
+#include <ui/ui_IconLoader.hpp>
+#include <ui/ui_FramePacer.hpp>
+#include <fs/fs_Stdio.hpp>
+#include <sys/iosupport.h>
+#include <unordered_map>
+#include <deque>
+#include <list>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace ui {
+
+    namespace {
+
+        using IconData = std::shared_ptr<const std::vector<u8>>;
+
+        struct IconRequest {
+            u32 idx;
+            std::string path;
+        };
+
+        struct LoadedIcon {
+            u32 idx;
+            std::string path;
+        };
+
+        struct CachedIcon {
+            u64 mtime;
+            u64 size;
+            u32 id;
+        };
+
+        struct ResidentIcon {
+            IconData data;
+            std::list<u32>::iterator lru_it;
+        };
+
+        struct IconFile {
+            IconData data;
+            size_t pos;
+        };
+
+        Mutex g_IconLock = {};
+        CondVar g_IconCondVar = {};
+        std::deque<IconRequest> g_PendingIcons;
+        std::deque<LoadedIcon> g_LoadedIcons;
+        u32 g_IconRequestGeneration = 0;
+
+        // Every icon file gets an ID (hence a loaded path) for the whole session, but at most MaxLoadedIconCount of them stay decoded
+        // The least recently used ones get evicted, and decoded again if their loaded path is opened later on
+        std::unordered_map<std::string, CachedIcon> g_IconCache;
+        std::unordered_map<u32, std::string> g_IconSourcePaths;
+        std::unordered_map<u32, ResidentIcon> g_IconDataTable;
+        std::list<u32> g_IconLru; // Most recently used first
+        u32 g_NextIconId = 0;
+
+        Thread g_IconLoaderThread;
+        bool g_IconLoaderRunning = false;
+        bool g_IconLoaderShouldExit = false;
+
+        inline std::string MakeLoadedIconPath(const u32 id) {
+            return UL_ICON_LOADER_DEVICE ":/" + std::to_string(id) + ".bmp";
+        }
+
+        IconData DecodeIcon(const std::string &path);
+
+        // The following ones expect the icon lock to be held
+
+        void TouchIconData(ResidentIcon &icon) {
+            g_IconLru.splice(g_IconLru.begin(), g_IconLru, icon.lru_it);
+        }
+
+        void SetIconData(const u32 id, IconData data) {
+            const auto find_data = g_IconDataTable.find(id);
+            if(find_data != g_IconDataTable.end()) {
+                // Outdated icon, files already opened keep their data alive
+                find_data->second.data = std::move(data);
+                TouchIconData(find_data->second);
+                return;
+            }
+
+            g_IconLru.push_front(id);
+            g_IconDataTable[id] = { std::move(data), g_IconLru.begin() };
+            while(g_IconDataTable.size() > MaxLoadedIconCount) {
+                g_IconDataTable.erase(g_IconLru.back());
+                g_IconLru.pop_back();
+            }
+        }
+
+        bool FindIconData(const char *path, IconData &out_data) {
+            const auto colon = strchr(path, ':');
+            if(colon != nullptr) {
+                path = colon + 1;
+            }
+            while(*path == '/') {
+                path++;
+            }
+
+            const auto id = static_cast<u32>(strtoul(path, nullptr, 10));
+            std::string src_path;
+            {
+                ScopedLock lk(g_IconLock);
+                const auto find_data = g_IconDataTable.find(id);
+                if(find_data != g_IconDataTable.end()) {
+                    TouchIconData(find_data->second);
+                    out_data = find_data->second.data;
+                    return true;
+                }
+
+                const auto find_src = g_IconSourcePaths.find(id);
+                if(find_src == g_IconSourcePaths.end()) {
+                    return false;
+                }
+                src_path = find_src->second;
+            }
+
+            // Evicted meanwhile (only with lots of icons around), decode it again right away
+            auto data = DecodeIcon(src_path);
+            if(!data) {
+                return false;
+            }
+
+            ScopedLock lk(g_IconLock);
+            SetIconData(id, data);
+            out_data = std::move(data);
+            return true;
+        }
+
+        void FillStat(const IconData &data, struct stat *st) {
+            memset(st, 0, sizeof(*st));
+            st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+            st->st_size = data->size();
+            st->st_nlink = 1;
+        }
+
+        int IconDeviceOpen(struct _reent *r, void *file_struct, const char *path, int flags, int mode) {
+            if((flags & O_ACCMODE) != O_RDONLY) {
+                r->_errno = EROFS;
+                return -1;
+            }
+
+            IconData data;
+            if(!FindIconData(path, data)) {
+                r->_errno = ENOENT;
+                return -1;
+            }
+
+            new(file_struct) IconFile { std::move(data), 0 };
+            return 0;
+        }
+
+        int IconDeviceClose(struct _reent *r, void *fd) {
+            reinterpret_cast<IconFile*>(fd)->~IconFile();
+            return 0;
+        }
+
+        ssize_t IconDeviceRead(struct _reent *r, void *fd, char *ptr, size_t len) {
+            auto file = reinterpret_cast<IconFile*>(fd);
+            len = std::min(len, file->data->size() - file->pos);
+            memcpy(ptr, file->data->data() + file->pos, len);
+            file->pos += len;
+            return len;
+        }
+
+        off_t IconDeviceSeek(struct _reent *r, void *fd, off_t pos, int dir) {
+            auto file = reinterpret_cast<IconFile*>(fd);
+            off_t base = 0;
+            switch(dir) {
+                case SEEK_SET: {
+                    base = 0;
+                    break;
+                }
+                case SEEK_CUR: {
+                    base = file->pos;
+                    break;
+                }
+                case SEEK_END: {
+                    base = file->data->size();
+                    break;
+                }
+                default: {
+                    r->_errno = EINVAL;
+                    return -1;
+                }
+            }
+
+            const auto new_pos = base + pos;
+            if((new_pos < 0) || (new_pos > static_cast<off_t>(file->data->size()))) {
+                r->_errno = EINVAL;
+                return -1;
+            }
+            file->pos = new_pos;
+            return new_pos;
+        }
+
+        int IconDeviceFstat(struct _reent *r, void *fd, struct stat *st) {
+            FillStat(reinterpret_cast<IconFile*>(fd)->data, st);
+            return 0;
+        }
+
+        int IconDeviceStat(struct _reent *r, const char *file, struct stat *st) {
+            IconData data;
+            if(!FindIconData(file, data)) {
+                r->_errno = ENOENT;
+                return -1;
+            }
+
+            FillStat(data, st);
+            return 0;
+        }
+
+        constexpr devoptab_t IconDevice = {
+            .name = UL_ICON_LOADER_DEVICE,
+            .structSize = sizeof(IconFile),
+            .open_r = IconDeviceOpen,
+            .close_r = IconDeviceClose,
+            .read_r = IconDeviceRead,
+            .seek_r = IconDeviceSeek,
+            .fstat_r = IconDeviceFstat,
+            .stat_r = IconDeviceStat
+        };
+
+        IconData DecodeIcon(const std::string &path) {
+            auto src_srf = IMG_Load(path.c_str());
+            if(src_srf == nullptr) {
+                return nullptr;
+            }
+
+            auto icon_srf = SDL_CreateRGBSurfaceWithFormat(0, LoadedIconSize, LoadedIconSize, 32, SDL_PIXELFORMAT_ABGR8888);
+            auto ok = icon_srf != nullptr;
+            if(ok) {
+                SDL_SetSurfaceBlendMode(src_srf, SDL_BLENDMODE_NONE);
+                ok = SDL_BlitScaled(src_srf, nullptr, icon_srf, nullptr) == 0;
+            }
+            SDL_FreeSurface(src_srf);
+
+            // BMP headers plus the raw pixels
+            auto bmp = std::make_shared<std::vector<u8>>(0x100 + LoadedIconSize * LoadedIconSize * 4);
+            if(ok) {
+                auto rw = SDL_RWFromMem(bmp->data(), bmp->size());
+                ok = (rw != nullptr) && (SDL_SaveBMP_RW(icon_srf, rw, 0) == 0);
+                if(ok) {
+                    bmp->resize(SDL_RWtell(rw));
+                }
+                if(rw != nullptr) {
+                    SDL_RWclose(rw);
+                }
+            }
+            if(icon_srf != nullptr) {
+                SDL_FreeSurface(icon_srf);
+            }
+
+            if(ok) {
+                return bmp;
+            }
+            return nullptr;
+        }
+
+        // Returns the loaded path, empty if the icon couldn't be loaded
+        std::string LoadIcon(const std::string &path) {
+            u64 mtime;
+            u64 size;
+            if(!fs::GetFileVersion(path, mtime, size)) {
+                return "";
+            }
+
+            {
+                ScopedLock lk(g_IconLock);
+                const auto find_cached = g_IconCache.find(path);
+                if((find_cached != g_IconCache.end()) && (find_cached->second.mtime == mtime) && (find_cached->second.size == size)) {
+                    const auto find_data = g_IconDataTable.find(find_cached->second.id);
+                    if(find_data != g_IconDataTable.end()) {
+                        TouchIconData(find_data->second);
+                        return MakeLoadedIconPath(find_cached->second.id);
+                    }
+                }
+            }
+
+            auto data = DecodeIcon(path);
+            if(!data) {
+                return "";
+            }
+
+            ScopedLock lk(g_IconLock);
+            auto find_cached = g_IconCache.find(path);
+            if(find_cached == g_IconCache.end()) {
+                // First time this file is seen
+                const auto id = g_NextIconId++;
+                g_IconSourcePaths[id] = path;
+                find_cached = g_IconCache.insert({ path, { 0, 0, id } }).first;
+            }
+            auto &cached = find_cached->second;
+            cached.mtime = mtime;
+            cached.size = size;
+            SetIconData(cached.id, std::move(data));
+            return MakeLoadedIconPath(cached.id);
+        }
+
+        void IconLoaderThread(void*) {
+            while(true) {
+                IconRequest req;
+                u32 req_gen;
+                {
+                    ScopedLock lk(g_IconLock);
+                    while(!g_IconLoaderShouldExit && g_PendingIcons.empty()) {
+                        condvarWait(&g_IconCondVar, &g_IconLock);
+                    }
+                    if(g_IconLoaderShouldExit) {
+                        break;
+                    }
+
+                    req = std::move(g_PendingIcons.front());
+                    g_PendingIcons.pop_front();
+                    req_gen = g_IconRequestGeneration;
+                }
+
+                auto loaded_path = LoadIcon(req.path);
+
+                ScopedLock lk(g_IconLock);
+                if((req_gen == g_IconRequestGeneration) && !loaded_path.empty()) {
+                    g_LoadedIcons.push_back({ req.idx, std::move(loaded_path) });
+                    // Wakes the frame loop, so that the icon gets picked up (see PopLoadedIcon) without waiting for input
+                    MarkFrameDirty();
+                }
+            }
+        }
+
+    }
+
+    void RequestIcons(const std::vector<std::string> &icon_paths) {
+        ScopedLock lk(g_IconLock);
+        if(!g_IconLoaderRunning) {
+            AddDevice(&IconDevice);
+            condvarInit(&g_IconCondVar);
+            g_IconLoaderShouldExit = false;
+            UL_RC_ASSERT(threadCreate(&g_IconLoaderThread, &IconLoaderThread, nullptr, nullptr, 0x8000, 0x3B, -2));
+            UL_RC_ASSERT(threadStart(&g_IconLoaderThread));
+            g_IconLoaderRunning = true;
+        }
+
+        g_IconRequestGeneration++;
+        g_PendingIcons.clear();
+        g_LoadedIcons.clear();
+        for(u32 i = 0; i < icon_paths.size(); i++) {
+            g_PendingIcons.push_back({ i, icon_paths.at(i) });
+        }
+        condvarWakeOne(&g_IconCondVar);
+    }
+
+    bool PopLoadedIcon(u32 &out_idx, std::string &out_path) {
+        ScopedLock lk(g_IconLock);
+        if(g_LoadedIcons.empty()) {
+            return false;
+        }
+
+        out_idx = g_LoadedIcons.front().idx;
+        out_path = std::move(g_LoadedIcons.front().path);
+        g_LoadedIcons.pop_front();
+        return true;
+    }
+
+    void ExitIconLoader() {
+        {
+            ScopedLock lk(g_IconLock);
+            if(!g_IconLoaderRunning) {
+                return;
+            }
+            g_IconLoaderShouldExit = true;
+            condvarWakeAll(&g_IconCondVar);
+        }
+
+        threadWaitForExit(&g_IconLoaderThread);
+        threadClose(&g_IconLoaderThread);
+        RemoveDevice(UL_ICON_LOADER_DEVICE ":");
+
+        ScopedLock lk(g_IconLock);
+        g_IconLoaderRunning = false;
+        g_PendingIcons.clear();
+        g_LoadedIcons.clear();
+        g_IconCache.clear();
+        g_IconSourcePaths.clear();
+        g_IconDataTable.clear();
+        g_IconLru.clear();
+    }
+
+}
\ No newline at end of file
@@ -24,7 +24,7 @@ namespace ui {
         g_MenuApplication->ApplyConfigForElement("languages_menu", "info_text", this->info_text);
         this->Add(this->info_text);
 
-        this->langs_menu = pu::ui::elm::Menu::New(200, 160, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 4);
+        this->langs_menu = PacedMenu::New(200, 160, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 4);
         g_MenuApplication->ApplyConfigForElement("languages_menu", "languages_menu_item", this->langs_menu);
         this->Add(this->langs_menu);
     }
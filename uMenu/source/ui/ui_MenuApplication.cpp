@@ -1,4 +1,5 @@
 #include <ui/ui_MenuApplication.hpp>
+#include <util/util_JsonFields.hpp>
 #include <util/util_Misc.hpp>
 
 extern ui::MenuApplication::Ref g_MenuApplication;
@@ -19,7 +20,71 @@ namespace ui {
         g_MenuApplication->GetLayout<IMenuLayout>()->DoOnHomeButtonPress();
     }
 
-    void MenuApplication::OnLoad() {
+    namespace {
+
+        ThemeResources PrepareThemeResources(const cfg::Theme &theme, const JSON &ui_json) {
+            ThemeResources res = {
+                .bgm_loop = true,
+                .bgm_fade_in_ms = 1500,
+                .bgm_fade_out_ms = 500
+            };
+            const util::JsonField bgm_fields[] = {
+                util::MakeJsonField("loop", res.bgm_loop),
+                util::MakeJsonField("fade_in_ms", res.bgm_fade_in_ms),
+                util::MakeJsonField("fade_out_ms", res.bgm_fade_out_ms)
+            };
+            util::LoadJSONFieldsFromFile(cfg::GetAssetByTheme(theme, "sound/BGM.json"), bgm_fields);
+            // Only opened here, the music gets streamed while it plays
+            res.bgm = pu::audio::OpenMusic(cfg::GetAssetByTheme(theme, "sound/BGM.mp3"));
+
+            res.text_clr = pu::ui::Color::FromHex(ui_json.value<std::string>("text_color", "#e1e1e1ff"));
+            res.menu_focus_clr = pu::ui::Color::FromHex(ui_json.value<std::string>("menu_focus_color", "#5ebcffff"));
+            res.menu_bg_clr = pu::ui::Color::FromHex(ui_json.value<std::string>("menu_bg_color", "#0094ffff"));
+            res.toast_text_clr = pu::ui::Color::FromHex(ui_json.value<std::string>("toast_text_color", "#e1e1e1ff"));
+            res.toast_base_clr = pu::ui::Color::FromHex(ui_json.value<std::string>("toast_base_color", "#282828ff"));
+            return res;
+        }
+
+        struct ThemeLoadContext {
+            std::string theme_name;
+            cfg::Theme theme;
+            JSON ui_json;
+            bool ui_json_ok;
+            ThemeResources res;
+        };
+
+        // Everything not touching the renderer, so that it gets ready while the screen fades out
+        void ThemeLoadThread(void *ctx_ptr) {
+            auto ctx = reinterpret_cast<ThemeLoadContext*>(ctx_ptr);
+            ctx->theme = cfg::LoadTheme(ctx->theme_name);
+            if(ctx->theme.IsPack()) {
+                cfg::LoadThemePackHotAssets(ctx->theme.base_name);
+            }
+            ctx->ui_json = JSON::object();
+            ctx->ui_json_ok = R_SUCCEEDED(util::LoadJSONFromFile(ctx->ui_json, cfg::GetAssetByTheme(ctx->theme, "ui/UI.json")));
+            if(ctx->ui_json_ok) {
+                ctx->res = PrepareThemeResources(ctx->theme, ctx->ui_json);
+            }
+        }
+
+    }
+
+    void MenuApplication::ApplyThemeResources(const ThemeResources &res) {
+        this->bgm_loop = res.bgm_loop;
+        this->bgm_fade_in_ms = res.bgm_fade_in_ms;
+        this->bgm_fade_out_ms = res.bgm_fade_out_ms;
+        this->bgm = res.bgm;
+        this->text_clr = res.text_clr;
+        this->menu_focus_clr = res.menu_focus_clr;
+        this->menu_bg_clr = res.menu_bg_clr;
+
+        this->notif_toast = NotificationToast::New("...", pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::Medium), res.toast_text_clr, res.toast_base_clr);
+
+        // Sound effects get decoded meanwhile the layouts are created
+        LoadSfxPool(g_Theme);
+    }
+
+    void MenuApplication::CreateLayouts() {
         u8 *screen_capture_buf = nullptr;
         if(this->IsSuspended()) {
             screen_capture_buf = new u8[PlainRgbaScreenBufferSize]();
@@ -27,22 +92,6 @@ namespace ui {
             appletGetLastApplicationCaptureImageEx(screen_capture_buf, PlainRgbaScreenBufferSize, &flag);
         }
 
-        this->bgm_json = JSON::object();
-        util::LoadJSONFromFile(this->bgm_json, cfg::GetAssetByTheme(g_Theme, "sound/BGM.json"));
-        this->bgm_loop = this->bgm_json.value("loop", true);
-        this->bgm_fade_in_ms = this->bgm_json.value("fade_in_ms", 1500);
-        this->bgm_fade_out_ms = this->bgm_json.value("fade_out_ms", 500);
-
-        const auto toast_text_clr = pu::ui::Color::FromHex(GetUIConfigValue<std::string>("toast_text_color", "#e1e1e1ff"));
-        const auto toast_base_clr = pu::ui::Color::FromHex(GetUIConfigValue<std::string>("toast_base_color", "#282828ff"));
-        this->notif_toast = pu::ui::extras::Toast::New("...", pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::Medium), toast_text_clr, toast_base_clr);
-
-        this->bgm = pu::audio::OpenMusic(cfg::GetAssetByTheme(g_Theme, "sound/BGM.mp3"));
-
-        this->text_clr = pu::ui::Color::FromHex(this->GetUIConfigValue<std::string>("text_color", "#e1e1e1ff"));
-        this->menu_focus_clr = pu::ui::Color::FromHex(this->GetUIConfigValue<std::string>("menu_focus_color", "#5ebcffff"));
-        this->menu_bg_clr = pu::ui::Color::FromHex(this->GetUIConfigValue<std::string>("menu_bg_color", "#0094ffff"));
-
         const u8 suspended_final_alpha = this->ui_json.value("suspended_final_alpha", 80);
         this->startup_lyt = StartupLayout::New();
         this->menu_lyt = MenuLayout::New(screen_capture_buf, suspended_final_alpha);
@@ -50,6 +99,15 @@ namespace ui {
         this->settings_menu_lyt = SettingsMenuLayout::New();
         this->languages_menu_lyt = LanguagesMenuLayout::New();
 
+        // The suspended screen image already copied it into its texture
+        delete[] screen_capture_buf;
+    }
+
+    void MenuApplication::OnLoad() {
+        this->switching_theme = false;
+        this->ApplyThemeResources(PrepareThemeResources(g_Theme, this->ui_json));
+        this->CreateLayouts();
+
         switch(this->start_mode) {
             case dmi::MenuStartMode::StartupScreen: {
                 this->LoadStartupMenu();
@@ -67,6 +125,13 @@ namespace ui {
         this->EndOverlay();
         this->notif_toast->SetText(text);
         this->StartOverlayWithTimeout(this->notif_toast, timeout);
+        MarkFrameDirty();
+    }
+
+    void MenuApplication::Show() {
+        do {
+            WaitForFrame();
+        } while(this->CallForRender());
     }
 
     void MenuApplication::StartPlayBGM() {
@@ -90,17 +155,76 @@ namespace ui {
         }
     }
     
+    bool MenuApplication::SwitchTheme(const std::string &theme_name) {
+        ThemeLoadContext ctx = {
+            .theme_name = theme_name
+        };
+        Thread load_thread;
+        UL_RC_ASSERT(threadCreate(&load_thread, &ThemeLoadThread, &ctx, nullptr, 0x10000, 49, -2));
+        UL_RC_ASSERT(threadStart(&load_thread));
+
+        this->switching_theme = true;
+        this->StopPlayBGM();
+        this->FadeOut();
+
+        threadWaitForExit(&load_thread);
+        threadClose(&load_thread);
+
+        // Plutonium's default fonts can't be replaced once loaded (only new sizes can be added), so a different font file still needs a restart
+        const auto cur_font_path = cfg::GetAssetByTheme(g_Theme, "ui/Font.ttf");
+        const auto new_font_path = cfg::GetAssetByTheme(ctx.theme, "ui/Font.ttf");
+        if(!ctx.ui_json_ok || (cur_font_path != new_font_path)) {
+            if(ctx.ui_json_ok) {
+                pu::audio::DestroyMusic(ctx.res.bgm);
+            }
+            if(ctx.theme.IsPack() && (ctx.theme.base_name != g_Theme.base_name)) {
+                cfg::CloseThemePack(ctx.theme.base_name);
+            }
+            this->switching_theme = false;
+            return false;
+        }
+
+        // The caller is most likely a callback of one of the current layouts, so they can't be destroyed yet
+        this->retired_lyts = { this->startup_lyt, this->menu_lyt, this->theme_menu_lyt, this->settings_menu_lyt, this->languages_menu_lyt };
+
+        pu::audio::StopMusic();
+        pu::audio::DestroyMusic(this->bgm);
+        this->bgm = nullptr;
+        // Glyphs get rasterized again on demand, from the new font size if it changed
+        ClearTextAtlas();
+
+        // Same font file, the menu folder text might just need another size of it (already loaded sizes are kept as they are)
+        const auto new_font_size = ctx.ui_json.value<u32>("menu_folder_text_size", 25);
+        if(new_font_size != this->GetUIConfigValue<u32>("menu_folder_text_size", 25)) {
+            pu::ui::render::AddDefaultFontFromFile(new_font_size, new_font_path);
+        }
+
+        if(g_Theme.IsPack() && (g_Theme.base_name != ctx.theme.base_name)) {
+            cfg::CloseThemePack(g_Theme.base_name);
+        }
+        g_Theme = ctx.theme;
+        this->ui_json = std::move(ctx.ui_json);
+
+        // The previous main menu already showed the launch failure warning
+        if(this->LaunchFailed()) {
+            this->start_mode = dmi::MenuStartMode::Menu;
+        }
+
+        // Only what needs the renderer is left for this thread: the toast, the layouts and their textures
+        this->ApplyThemeResources(ctx.res);
+        this->CreateLayouts();
+        this->LoadThemeMenu();
+
+        this->FadeIn();
+        this->StartPlayBGM();
+        this->switching_theme = false;
+        return true;
+    }
+
     void MenuApplication::SetSelectedUser(const AccountUid user_id) {
         this->daemon_status.selected_user = user_id;
 
-        UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::SetSelectedUser, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-            writer.Push(user_id);
-            return ResultSuccess;
-        },
-        [&](dmi::menu::MenuScopedStorageReader &reader) {
-            // ...
-            return ResultSuccess;
-        }));
+        UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::SetSelectedUser>({ user_id }));
     }
 
 }
\ No newline at end of file
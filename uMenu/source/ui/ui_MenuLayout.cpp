@@ -1,4 +1,6 @@
 #include <ui/ui_MenuLayout.hpp>
+#include <cfg/cfg_RecordStore.hpp>
+#include <cfg/cfg_TitleIndex.hpp>
 #include <os/os_Titles.hpp>
 #include <os/os_Account.hpp>
 #include <util/util_Convert.hpp>
@@ -9,10 +11,12 @@
 #include <os/os_HomeMenu.hpp>
 #include <fs/fs_Stdio.hpp>
 #include <net/net_Service.hpp>
+#include <unordered_set>
 
 extern ui::MenuApplication::Ref g_MenuApplication;
 extern ui::TransitionGuard g_TransitionGuard;
 extern cfg::TitleList g_EntryList;
+extern cfg::TitleIndex g_TitleIndex;
 extern std::vector<cfg::TitleRecord> g_HomebrewRecordList;
 extern cfg::Config g_Config;
 extern cfg::Theme g_Theme;
@@ -52,21 +56,36 @@ namespace ui {
             item_list = folder.titles;
         }
 
-        this->items_menu->ClearItems();
+        // Refreshing the view already shown keeps the selection and any icon still visible
+        const auto same_view = (this->homebrew_mode == this->shown_homebrew_mode) && (this->homebrew_mode || (name == this->shown_folder));
+        this->shown_homebrew_mode = this->homebrew_mode;
+        this->shown_folder = name;
+        if(!this->homebrew_mode) {
+            this->cur_folder = name;
+        }
+
+        std::vector<SideMenuItem> items;
         if(this->homebrew_mode) {
-            this->items_menu->AddItem(cfg::GetAssetByTheme(g_Theme, "ui/Hbmenu.png"));
+            items.push_back({
+                .key = MENU_HBMENU_NRO,
+                .icon_path = cfg::GetAssetByTheme(g_Theme, "ui/Hbmenu.png")
+            });
         }
         else {
             if(name.empty()) {
                 // Remove empty folders
                 STL_REMOVE_IF(g_EntryList.folders, folder, folder.titles.empty());
                 for(const auto &folder: g_EntryList.folders) {
-                    this->items_menu->AddItem(cfg::GetAssetByTheme(g_Theme, "ui/Folder.png"), folder.name);
+                    items.push_back({
+                        .key = "folder:" + folder.name,
+                        .icon_path = cfg::GetAssetByTheme(g_Theme, "ui/Folder.png"),
+                        .text = folder.name
+                    });
                 }
             }
         }
 
-        u32 tmp_idx = 0;
+        s32 susp_idx = -1;
         for(const auto &item: item_list) {
             auto set_susp = false;
             if(item.title_type == cfg::TitleType::Installed) {
@@ -83,25 +102,18 @@ namespace ui {
                     }
                 }
             }
-            this->items_menu->AddItem(cfg::GetRecordIconPath(item));
             if(set_susp) {
-                u32 susp_idx = tmp_idx;
-                // Skip initial item if homebrew mode
-                if(this->homebrew_mode) {
-                    susp_idx++;
-                }
-                // Ignore front folders from main menu
-                else if(name.empty()) {
-                    susp_idx += g_EntryList.folders.size();
-                }
-                this->items_menu->SetSuspendedItem(susp_idx);
+                susp_idx = items.size();
             }
-            tmp_idx++;
+            items.push_back({
+                .key = cfg::GetRecordKey(item),
+                .icon_path = cfg::GetRecordIconPath(item)
+            });
         }
 
-        this->items_menu->UpdateBorderIcons();
-        if(!this->homebrew_mode) {
-            this->cur_folder = name;
+        this->items_menu->UpdateItems(items, same_view);
+        if(susp_idx >= 0) {
+            this->items_menu->SetSuspendedItem(susp_idx);
         }
     }
 
@@ -176,6 +188,7 @@ namespace ui {
                                 if(this->items_menu->IsItemMultiselected(idx)) {
                                     if(!cfg::ExistsRecord(g_EntryList, hb)) {
                                         cfg::SaveRecord(hb);
+                                        g_TitleIndex.Add(hb);
                                         g_EntryList.root.titles.insert(g_EntryList.root.titles.begin() + hb_idx, hb);
                                         hb_idx++;
                                     }
@@ -243,21 +256,17 @@ namespace ui {
         else {
             if((idx == 0) && this->homebrew_mode) {
                 if(keys_down & HidNpadButton_A) {
-                    pu::audio::PlaySfx(this->title_launch_sfx);
+                    // First checkpoint of launch latency traces, taken once the launch is confirmed (time spent in dialogs doesn't count)
+                    const auto input_tick = armGetSystemTick();
+                    this->title_launch_sfx.Play();
                     
                     // Launch normal hbmenu
                     hb::HbTargetParams hbmenu_params = {};
                     strcpy(hbmenu_params.nro_path, MENU_HBMENU_NRO);
                     strcpy(hbmenu_params.nro_argv, MENU_HBMENU_NRO);
 
-                    UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::LaunchHomebrewLibraryApplet, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                        writer.Push(hbmenu_params);
-                        return ResultSuccess;
-                    },
-                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                        // ...
-                        return ResultSuccess;
-                    }));
+                    cfg::FlushRecords();
+                    UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::LaunchHomebrewLibraryApplet>({ hbmenu_params, dmi::menu::CreateLaunchTrace(input_tick) }));
 
                     g_MenuApplication->StopPlayBGM();
                     g_MenuApplication->CloseWithFadeOut();
@@ -366,16 +375,12 @@ namespace ui {
                                     this->HandleHomebrewLaunch(title);
                                 }
                                 else {
-                                    pu::audio::PlaySfx(this->title_launch_sfx);
+                                    // Past the suspended title closing dialog, if it was shown
+                                    const auto input_tick = armGetSystemTick();
+                                    this->title_launch_sfx.Play();
 
-                                    const auto rc = dmi::menu::SendCommand(dmi::DaemonMessage::LaunchApplication, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                                        writer.Push(title.app_id);
-                                        return ResultSuccess;
-                                    },
-                                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                                        // ...
-                                        return ResultSuccess;
-                                    });
+                                    cfg::FlushRecords();
+                                    const auto rc = dmi::menu::SendCommand<dmi::DaemonMessage::LaunchApplication>({ title.app_id, dmi::menu::CreateLaunchTrace(input_tick) });
 
                                     if(R_SUCCEEDED(rc)) {
                                         g_MenuApplication->StopPlayBGM();
@@ -415,6 +420,7 @@ namespace ui {
                                     const auto option_2 = g_MenuApplication->CreateShowDialog(GetLanguageString("entry_remove"), GetLanguageString("entry_remove_conf"), { GetLanguageString("yes"), GetLanguageString("no") }, true);
                                     if(option_2 == 0) {
                                         cfg::RemoveRecord(title);
+                                        g_TitleIndex.Remove(title);
                                         folder.titles.erase(folder.titles.begin() + title_idx);
                                         g_MenuApplication->ShowNotification(GetLanguageString("entry_remove_ok"));
                                         this->MoveFolder(this->cur_folder, true);
@@ -538,7 +544,7 @@ namespace ui {
         }
     }
 
-    MenuLayout::MenuLayout(const u8 *captured_screen_buf, const u8 min_alpha) : last_has_connection(false), last_battery_lvl(0), last_is_charging(false), launch_fail_warn_shown(false), homebrew_mode(false), select_on(false), select_dir(false), min_alpha(min_alpha), mode(0), suspended_screen_alpha(0xFF) {
+    MenuLayout::MenuLayout(const u8 *captured_screen_buf, const u8 min_alpha) : last_has_connection(false), last_battery_lvl(0), last_is_charging(false), shown_homebrew_mode(false), launch_fail_warn_shown(false), homebrew_mode(false), select_on(false), select_dir(false), min_alpha(min_alpha), mode(0), suspended_screen_alpha(0xFF) {
         const auto menu_text_x = g_MenuApplication->GetUIConfigValue<u32>("menu_folder_text_x", 30);
         const auto menu_text_y = g_MenuApplication->GetUIConfigValue<u32>("menu_folder_text_y", 200);
         const auto menu_text_size = g_MenuApplication->GetUIConfigValue<u32>("menu_folder_text_size", 25);
@@ -621,19 +627,19 @@ namespace ui {
         g_MenuApplication->ApplyConfigForElement("main_menu", "menu_toggle_button", this->menu_totggle_img);
         this->Add(this->menu_totggle_img);
 
-        this->selected_item_name_text = pu::ui::elm::TextBlock::New(40, 610, "...");
+        this->selected_item_name_text = CachedTextBlock::New(40, 610, "...");
         this->selected_item_name_text->SetFont(pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::Large));
         this->selected_item_name_text->SetColor(g_MenuApplication->GetTextColor());
         g_MenuApplication->ApplyConfigForElement("main_menu", "banner_name_text", this->selected_item_name_text);
         this->Add(this->selected_item_name_text);
 
-        this->selected_item_author_text = pu::ui::elm::TextBlock::New(45, 650, "...");
+        this->selected_item_author_text = CachedTextBlock::New(45, 650, "...");
         this->selected_item_author_text->SetFont(pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::Medium));
         this->selected_item_author_text->SetColor(g_MenuApplication->GetTextColor());
         g_MenuApplication->ApplyConfigForElement("main_menu", "banner_author_text", this->selected_item_author_text);
         this->Add(this->selected_item_author_text);
 
-        this->selected_item_version_text = pu::ui::elm::TextBlock::New(45, 675, "...");
+        this->selected_item_version_text = CachedTextBlock::New(45, 675, "...");
         this->selected_item_version_text->SetFont(pu::ui::GetDefaultFont(pu::ui::DefaultFontSize::Medium));
         this->selected_item_version_text->SetColor(g_MenuApplication->GetTextColor());
         g_MenuApplication->ApplyConfigForElement("main_menu", "banner_version_text", this->selected_item_version_text);
@@ -651,17 +657,12 @@ namespace ui {
 
         this->startup_tp = std::chrono::steady_clock::now();
 
-        this->title_launch_sfx = pu::audio::LoadSfx(cfg::GetAssetByTheme(g_Theme, "sound/TitleLaunch.wav"));
-        this->menu_toggle_sfx = pu::audio::LoadSfx(cfg::GetAssetByTheme(g_Theme, "sound/MenuToggle.wav"));
+        this->title_launch_sfx = LazySfx("TitleLaunch");
+        this->menu_toggle_sfx = LazySfx("MenuToggle");
 
         this->SetBackgroundImage(cfg::GetAssetByTheme(g_Theme, "ui/Background.png"));
     }
 
-    MenuLayout::~MenuLayout() {
-        pu::audio::DestroySfx(this->title_launch_sfx);
-        pu::audio::DestroySfx(this->menu_toggle_sfx);
-    }
-
     void MenuLayout::OnMenuInput(const u64 keys_down, const u64 keys_up, const u64 keys_held, const pu::ui::TouchPoint touch_pos) {
         const auto quick_menu_on = this->quick_menu->IsOn();
         this->items_menu->SetEnabled(!quick_menu_on);
@@ -674,16 +675,21 @@ namespace ui {
             this->last_has_connection = has_conn;
             const auto conn_img = has_conn ? "ui/ConnectionIcon.png" : "ui/NoConnectionIcon.png";
             this->connection_icon->SetImage(cfg::GetAssetByTheme(g_Theme, conn_img));
+            MarkFrameDirty();
         }
 
         const auto cur_time = os::GetCurrentTime();
-        this->time_text->SetText(cur_time);
+        if(this->time_text->GetText() != cur_time) {
+            this->time_text->SetText(cur_time);
+            MarkFrameDirty();
+        }
 
         const auto battery_lvl = os::GetBatteryLevel();
         if(this->last_battery_lvl != battery_lvl) {
             this->last_battery_lvl = battery_lvl;
             const auto battery_str = std::to_string(battery_lvl) + "%";
             this->battery_text->SetText(battery_str);
+            MarkFrameDirty();
         }
 
         const auto is_charging = os::IsConsoleCharging();
@@ -691,6 +697,7 @@ namespace ui {
             this->last_is_charging = is_charging;
             const auto battery_img = is_charging ? "ui/BatteryChargingIcon.png" : "ui/BatteryNormalIcon.png";
             this->battery_icon->SetImage(cfg::GetAssetByTheme(g_Theme, battery_img));
+            MarkFrameDirty();
         }
 
         const auto now_tp = std::chrono::steady_clock::now();
@@ -724,14 +731,8 @@ namespace ui {
                 if(this->suspended_screen_alpha == 0xFF) {
                     this->suspended_screen_img->SetAlpha(this->suspended_screen_alpha);
 
-                    UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::ResumeApplication, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                        // ...
-                        return ResultSuccess;
-                    },
-                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                        // ...
-                        return ResultSuccess;
-                    }));
+                    cfg::FlushRecords();
+                    UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::ResumeApplication>());
                 }
                 else {
                     this->suspended_screen_img->SetAlpha(this->suspended_screen_alpha);
@@ -757,6 +758,30 @@ namespace ui {
         else if(keys_down & HidNpadButton_Minus) {
             this->menuToggle_Click();
         }
+        else if(keys_down & HidNpadButton_Down) {
+            if(!this->homebrew_mode && !this->select_on) {
+                this->HandleSearch();
+            }
+        }
+        else if(keys_down & (HidNpadButton_L | HidNpadButton_R | HidNpadButton_ZL | HidNpadButton_ZR)) {
+            // Otherwise these open the quick menu
+            auto menu_jumps_enabled = false;
+            UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::MenuJumpsEnabled, menu_jumps_enabled));
+            if(menu_jumps_enabled) {
+                if(keys_down & HidNpadButton_L) {
+                    this->items_menu->MovePage(false);
+                }
+                else if(keys_down & HidNpadButton_R) {
+                    this->items_menu->MovePage(true);
+                }
+                else if(keys_down & HidNpadButton_ZL) {
+                    this->HandleLetterJump(false);
+                }
+                else {
+                    this->HandleLetterJump(true);
+                }
+            }
+        }
     }
 
     bool MenuLayout::OnHomeButtonPress() {
@@ -772,8 +797,6 @@ namespace ui {
     }
 
     void MenuLayout::MoveFolder(const std::string &name, const bool fade) {
-        this->items_menu->Rewind();
-
         if(fade) {
             g_TransitionGuard.Run([&]() {
                 g_MenuApplication->FadeOut();
@@ -793,7 +816,7 @@ namespace ui {
     }
 
     void MenuLayout::menuToggle_Click() {
-        pu::audio::PlaySfx(this->menu_toggle_sfx);
+        this->menu_toggle_sfx.Play();
         this->homebrew_mode = !this->homebrew_mode;
         if(this->select_on) {
             g_MenuApplication->ShowNotification(GetLanguageString("menu_multiselect_cancel"));
@@ -802,6 +825,136 @@ namespace ui {
         this->MoveFolder("", true);
     }
 
+    void MenuLayout::HandleSearch() {
+        SwkbdConfig cfg;
+        swkbdCreate(&cfg, 0);
+        swkbdConfigSetGuideText(&cfg, GetLanguageString("swkbd_search_guide").c_str());
+        swkbdConfigSetInitialText(&cfg, this->search_query.c_str());
+        char query[500] = {};
+        const auto rc = swkbdShow(&cfg, query, sizeof(query));
+        swkbdClose(&cfg);
+        if(R_FAILED(rc) || (strlen(query) == 0)) {
+            return;
+        }
+        this->search_query = query;
+
+        const auto match_keys = g_TitleIndex.Find(this->search_query);
+        if(match_keys.empty()) {
+            g_MenuApplication->ShowNotification(GetLanguageString("menu_search_no_results"));
+            return;
+        }
+        const std::unordered_set<std::string> match_key_set(match_keys.begin(), match_keys.end());
+
+        // Go to the first match after the selected item (root titles first, then every folder in order), so that searching the same again cycles through them
+        const auto cur_folder_idx = this->cur_folder.empty() ? 0 : static_cast<u32>(std::distance(g_EntryList.folders.begin(), STL_FIND_IF(g_EntryList.folders, folder, (folder.name == this->cur_folder))) + 1);
+        const auto cur_title_idx = static_cast<s32>(this->items_menu->GetSelectedItem()) - (this->cur_folder.empty() ? static_cast<s32>(g_EntryList.folders.size()) : 0);
+        s32 first_folder_idx = -1;
+        u32 first_title_idx = 0;
+        s32 next_folder_idx = -1;
+        u32 next_title_idx = 0;
+        for(u32 folder_idx = 0; (folder_idx <= g_EntryList.folders.size()) && (next_folder_idx < 0); folder_idx++) {
+            const auto &titles = (folder_idx == 0) ? g_EntryList.root.titles : g_EntryList.folders.at(folder_idx - 1).titles;
+            for(u32 title_idx = 0; title_idx < titles.size(); title_idx++) {
+                if(match_key_set.count(cfg::GetRecordKey(titles.at(title_idx))) == 0) {
+                    continue;
+                }
+                if(first_folder_idx < 0) {
+                    first_folder_idx = folder_idx;
+                    first_title_idx = title_idx;
+                }
+                if((folder_idx > cur_folder_idx) || ((folder_idx == cur_folder_idx) && (static_cast<s32>(title_idx) > cur_title_idx))) {
+                    next_folder_idx = folder_idx;
+                    next_title_idx = title_idx;
+                    break;
+                }
+            }
+        }
+        if(next_folder_idx < 0) {
+            next_folder_idx = first_folder_idx;
+            next_title_idx = first_title_idx;
+        }
+        if(next_folder_idx < 0) {
+            g_MenuApplication->ShowNotification(GetLanguageString("menu_search_no_results"));
+            return;
+        }
+
+        const auto folder_name = (next_folder_idx == 0) ? std::string() : g_EntryList.folders.at(next_folder_idx - 1).name;
+        if(folder_name != this->cur_folder) {
+            this->MoveFolder(folder_name, true);
+        }
+
+        // Root titles come after the folders, which might have changed when moving to root
+        auto item_idx = next_title_idx;
+        if(folder_name.empty()) {
+            item_idx += g_EntryList.folders.size();
+        }
+        this->items_menu->SeekTo(item_idx);
+        g_MenuApplication->ShowNotification(std::to_string(match_keys.size()) + " " + GetLanguageString("menu_search_results"));
+    }
+
+    void MenuLayout::HandleLetterJump(const bool next) {
+        // Upper-cased first byte of every item's name, items without a name (or the hbmenu one) go together
+        const auto get_initial = [](const std::string &name) -> u8 {
+            if(name.empty()) {
+                return 0;
+            }
+            return static_cast<u8>(std::toupper(static_cast<u8>(name.front())));
+        };
+
+        std::vector<u8> initials;
+        initials.reserve(this->items_menu->GetItemCount());
+        if(this->homebrew_mode) {
+            initials.push_back(0);
+            for(const auto &hb: g_HomebrewRecordList) {
+                initials.push_back(get_initial(cfg::GetRecordName(hb)));
+            }
+        }
+        else {
+            if(this->cur_folder.empty()) {
+                for(const auto &folder: g_EntryList.folders) {
+                    initials.push_back(get_initial(folder.name));
+                }
+            }
+            for(const auto &title: cfg::FindFolderByName(g_EntryList, this->cur_folder).titles) {
+                initials.push_back(get_initial(cfg::GetRecordName(title)));
+            }
+        }
+
+        const auto cur_idx = this->items_menu->GetSelectedItem();
+        if(cur_idx >= initials.size()) {
+            return;
+        }
+
+        // Items aren't sorted by name, thus go to the first item of the closest initial (wrapping around)
+        const auto cur_initial = initials.at(cur_idx);
+        s32 closest_initial = -1;
+        s32 wrap_initial = -1;
+        for(const auto initial: initials) {
+            if(next) {
+                if((initial > cur_initial) && ((closest_initial < 0) || (initial < closest_initial))) {
+                    closest_initial = initial;
+                }
+                if((wrap_initial < 0) || (initial < wrap_initial)) {
+                    wrap_initial = initial;
+                }
+            }
+            else {
+                if((initial < cur_initial) && ((closest_initial < 0) || (initial > closest_initial))) {
+                    closest_initial = initial;
+                }
+                if((wrap_initial < 0) || (initial > wrap_initial)) {
+                    wrap_initial = initial;
+                }
+            }
+        }
+
+        const auto target_initial = (closest_initial >= 0) ? closest_initial : wrap_initial;
+        const auto find_target = STL_FIND_IF(initials, initial, (initial == target_initial));
+        if(STL_FOUND(initials, find_target)) {
+            this->items_menu->SeekTo(std::distance(initials.begin(), find_target));
+        }
+    }
+
     void MenuLayout::HandleCloseSuspended() {
         const auto option = g_MenuApplication->CreateShowDialog(GetLanguageString("suspended_app"), GetLanguageString("suspended_close"), { GetLanguageString("yes"), GetLanguageString("no") }, true);
         if(option == 0) {
@@ -814,17 +967,13 @@ namespace ui {
         UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::HomebrewApplicationTakeoverApplicationId, title_takeover_id));
         const auto option = g_MenuApplication->CreateShowDialog(GetLanguageString("hb_launch"), GetLanguageString("hb_launch_conf"), { GetLanguageString("hb_applet"), GetLanguageString("hb_app"), GetLanguageString("cancel") }, true);
         if(option == 0) {
-            pu::audio::PlaySfx(this->title_launch_sfx);
+            // Time spent choosing in the dialog doesn't count as launch latency
+            const auto input_tick = armGetSystemTick();
+            this->title_launch_sfx.Play();
             
             const auto ipt = CreateLaunchTargetParams(rec.nro_target);
-            UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::LaunchHomebrewLibraryApplet, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                writer.Push(ipt);
-                return ResultSuccess;
-            },
-            [&](dmi::menu::MenuScopedStorageReader &reader) {
-                // ...
-                return ResultSuccess;
-            }));
+            cfg::FlushRecords();
+            UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::LaunchHomebrewLibraryApplet>({ ipt, dmi::menu::CreateLaunchTrace(input_tick) }));
 
             g_MenuApplication->StopPlayBGM();
             g_MenuApplication->CloseWithFadeOut();
@@ -840,18 +989,13 @@ namespace ui {
                     }
                 }
                 if(launch) {
-                    pu::audio::PlaySfx(this->title_launch_sfx);
+                    // Neither does the suspended title closing dialog
+                    const auto input_tick = armGetSystemTick();
+                    this->title_launch_sfx.Play();
                     
                     const auto ipt = CreateLaunchTargetParams(rec.nro_target);
-                    const auto rc = dmi::menu::SendCommand(dmi::DaemonMessage::LaunchHomebrewApplication, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                        writer.Push(title_takeover_id);
-                        writer.Push(ipt);
-                        return ResultSuccess;
-                    },
-                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                        // ...
-                        return ResultSuccess;
-                    });
+                    cfg::FlushRecords();
+                    const auto rc = dmi::menu::SendCommand<dmi::DaemonMessage::LaunchHomebrewApplication>({ title_takeover_id, ipt, dmi::menu::CreateLaunchTrace(input_tick) });
 
                     if(R_SUCCEEDED(rc)) {
                         g_MenuApplication->StopPlayBGM();
@@ -871,17 +1015,15 @@ namespace ui {
 
     void MenuLayout::HandleMultiselectMoveToFolder(const std::string &folder) {
         if(this->select_on) {
-            u32 removed_idx = 0;
+            std::vector<u32> selected_title_idxs;
             const auto root_title_count = g_EntryList.root.titles.size();
             const auto folder_count = g_EntryList.folders.size();
             for(u32 i = 0; i < root_title_count; i++) {
-                auto &title = g_EntryList.root.titles.at(i - removed_idx);
                 if(this->items_menu->IsItemMultiselected(folder_count + i)) {
-                    if(cfg::MoveRecordTo(g_EntryList, title, folder)) {
-                        removed_idx++;
-                    }
+                    selected_title_idxs.push_back(i);
                 }
             }
+            cfg::MoveRootRecordsTo(g_EntryList, selected_title_idxs, folder);
             this->StopMultiselect();
             this->MoveFolder(this->cur_folder, true);
         }
@@ -901,14 +1043,7 @@ namespace ui {
             this->suspended_screen_img->SetAlpha(0);
         }
 
-        UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::TerminateApplication, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-            // ...
-            return ResultSuccess;
-        },
-        [&](dmi::menu::MenuScopedStorageReader &reader) {
-            // ...
-            return ResultSuccess;
-        }));
+        UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::TerminateApplication>());
     }
 
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <am/am_DaemonMessages.hpp>
 
 extern cfg::Theme g_Theme;
+extern cfg::Config g_Config;
 extern ui::MenuApplication::Ref g_MenuApplication;
 
 namespace ui {
@@ -16,13 +17,14 @@ namespace ui {
 
     void QuickMenu::OnHomeButtonDetection() {
         g_HomePressed = true;
+        MarkFrameDirty();
     }
 
     QuickMenu::QuickMenu(const std::string &main_icon) {
         this->on = false;
         this->bg_alpha = 0;
 
-        this->options_menu = pu::ui::elm::Menu::New(MenuX, MenuY, MenuWidth, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), MenuItemHeight, MenuItemsToShow);
+        this->options_menu = PacedMenu::New(MenuX, MenuY, MenuWidth, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), MenuItemHeight, MenuItemsToShow);
         g_MenuApplication->ApplyConfigForElement("quick_menu", "quick_menu_item", this->options_menu);
         
         auto help_item = pu::ui::elm::MenuItem::New("Help & information");
@@ -77,6 +79,7 @@ namespace ui {
     void QuickMenu::OnRender(pu::ui::render::Renderer::Ref &drawer, const s32 x, const s32 y) {
         if(!this->on) {
             if(this->bg_alpha > 0) {
+                MarkFrameDirty();
                 this->bg_alpha -= BackgroundAlphaIncrement;
                 if(this->bg_alpha < 0) {
                     this->bg_alpha = 0;
@@ -85,6 +88,7 @@ namespace ui {
         }
         else {
             if(this->bg_alpha < BackgroundAlphaMax) {
+                MarkFrameDirty();
                 this->bg_alpha += BackgroundAlphaIncrement;
                 if(this->bg_alpha > BackgroundAlphaMax) {
                     this->bg_alpha = BackgroundAlphaMax;
@@ -111,7 +115,11 @@ namespace ui {
             this->options_menu->OnInput(keys_down, keys_up, keys_held, touch_pos);
         }
 
-        if((keys_down & HidNpadButton_L) || (keys_down & HidNpadButton_R) || (keys_down & HidNpadButton_ZL) || (keys_down & HidNpadButton_ZR)) {
+        // With menu jumps enabled, L/R/ZL/ZR navigate the main menu instead
+        auto menu_jumps_enabled = false;
+        UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::MenuJumpsEnabled, menu_jumps_enabled));
+        const u64 toggle_keys = HidNpadButton_StickL | HidNpadButton_StickR | (menu_jumps_enabled ? 0 : (HidNpadButton_L | HidNpadButton_R | HidNpadButton_ZL | HidNpadButton_ZR));
+        if(keys_down & toggle_keys) {
             this->Toggle();
         }
         else if((keys_down & HidNpadButton_B) || (keys_down & HidNpadButton_A)) {
@@ -1,11 +1,13 @@
 #include <ui/ui_SettingsMenuLayout.hpp>
 #include <os/os_Account.hpp>
 #include <os/os_Misc.hpp>
+#include <os/os_LaunchLatency.hpp>
 #include <util/util_Convert.hpp>
 #include <ui/ui_MenuApplication.hpp>
 #include <fs/fs_Stdio.hpp>
 #include <net/net_Service.hpp>
 #include <am/am_LibraryApplet.hpp>
+#include <am/am_DaemonMessages.hpp>
 
 extern ui::MenuApplication::Ref g_MenuApplication;
 extern ui::TransitionGuard g_TransitionGuard;
@@ -34,6 +36,44 @@ namespace ui {
         return t ? GetLanguageString("set_true_value") : GetLanguageString("set_false_value");
     }
 
+    template<>
+    inline std::string EncodeForSettings<os::LaunchLatencyHistogram>(const os::LaunchLatencyHistogram &t) {
+        if(t.sample_count == 0) {
+            return GetLanguageString("set_launch_latency_none");
+        }
+        return std::to_string(t.median_ms) + " ms (p90 " + std::to_string(t.p90_ms) + " ms, max " + std::to_string(t.max_ms) + " ms, " + std::to_string(t.sample_count) + ")";
+    }
+
+    template<>
+    inline std::string EncodeForSettings<dmi::DaemonHeapStats>(const dmi::DaemonHeapStats &t) {
+        return std::to_string(t.used_size / 1_KB) + " / " + std::to_string(t.heap_size / 1_KB) + " KB (" + GetLanguageString("set_daemon_heap_peak") + " " + std::to_string(t.peak_used_size / 1_KB) + " KB)";
+    }
+
+    template<>
+    inline std::string EncodeForSettings<dmi::MenuMessageStats>(const dmi::MenuMessageStats &t) {
+        // Drops the daemon counted, and the ones this menu noticed through sequence gaps
+        return std::to_string(t.dropped_count) + " " + GetLanguageString("set_daemon_msgs_dropped") + ", " + std::to_string(am::GetMissedDaemonMessageCount()) + " " + GetLanguageString("set_daemon_msgs_missed");
+    }
+
+    template<>
+    inline std::string EncodeForSettings<SfxPoolStats>(const SfxPoolStats &t) {
+        return std::to_string(t.sfx_count) + " " + GetLanguageString("set_sfx_pool_count") + ", " + std::to_string(t.decoded_size / 1_KB) + " KB";
+    }
+
+    template<>
+    inline std::string EncodeForSettings<FrameStats>(const FrameStats &t) {
+        return std::to_string(t.rendered_frames) + " " + GetLanguageString("set_frame_stats_rendered") + ", " + std::to_string(t.keep_alive_frames) + " " + GetLanguageString("set_frame_stats_keep_alive") + ", " + std::to_string(t.idle_frames) + " " + GetLanguageString("set_frame_stats_idle") + " (" + std::to_string(t.idle_ns / 1'000'000'000ul) + " s)";
+    }
+
+    template<>
+    inline std::string EncodeForSettings<SideMenuUpdateStats>(const SideMenuUpdateStats &t) {
+        if(t.update_count == 0) {
+            return GetLanguageString("set_menu_updates_none");
+        }
+        const auto avg_us = (t.total_update_ns / t.update_count) / 1'000;
+        return std::to_string(avg_us) + " us (" + GetLanguageString("set_menu_updates_max") + " " + std::to_string(t.max_update_ns / 1'000) + " us, " + std::to_string(t.update_count) + "), " + std::to_string(t.last_reused_icon_count) + " " + GetLanguageString("set_menu_updates_reused") + ", " + std::to_string(t.last_loaded_icon_count) + " " + GetLanguageString("set_menu_updates_loaded");
+    }
+
     SettingsMenuLayout::SettingsMenuLayout() {
         this->SetBackgroundImage(cfg::GetAssetByTheme(g_Theme, "ui/Background.png"));
 
@@ -43,7 +83,7 @@ namespace ui {
         g_MenuApplication->ApplyConfigForElement("settings_menu", "info_text", this->info_text);
         this->Add(this->info_text);
 
-        this->settings_menu = pu::ui::elm::Menu::New(50, 80, 1180, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 6);
+        this->settings_menu = PacedMenu::New(50, 80, 1180, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 6);
         g_MenuApplication->ApplyConfigForElement("settings_menu", "settings_menu_item", this->settings_menu);
         this->Add(this->settings_menu);
     }
@@ -124,6 +164,10 @@ namespace ui {
         auto nfc = false;
         setsysGetNfcEnableFlag(&nfc);
         this->PushSettingItem(GetLanguageString("set_nfc"), EncodeForSettings(nfc), 10);
+
+        bool menu_jumps_enabled;
+        UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::MenuJumpsEnabled, menu_jumps_enabled));
+        this->PushSettingItem(GetLanguageString("set_menu_jumps"), EncodeForSettings(menu_jumps_enabled), 11);
         
         SetSysSerialNumber serial = {};
         setsysGetSerialNumber(&serial);
@@ -137,6 +181,29 @@ namespace ui {
         const auto ip_str = net::GetConsoleIpAddress();
         this->PushSettingItem("Console IP address", EncodeForSettings(ip_str), -1);
 
+        // Recorded by uDaemon, over the last launches of each kind
+        os::LaunchLatencyHistory launch_latency_history = {};
+        os::LoadLaunchLatencyHistory(launch_latency_history);
+        const char *launch_latency_names[os::LaunchTitleTypeCount] = { "set_launch_latency_installed", "set_launch_latency_hb_applet", "set_launch_latency_hb_app" };
+        for(u32 i = 0; i < os::LaunchTitleTypeCount; i++) {
+            const auto histogram = os::ComputeLaunchLatencyHistogram(launch_latency_history.windows[i]);
+            this->PushSettingItem(GetLanguageString(launch_latency_names[i]), EncodeForSettings(histogram), -1);
+        }
+
+        dmi::DaemonHeapStats daemon_heap_stats = {};
+        if(R_SUCCEEDED(am::GetDaemonHeapStats(daemon_heap_stats))) {
+            this->PushSettingItem(GetLanguageString("set_daemon_heap"), EncodeForSettings(daemon_heap_stats), -1);
+        }
+
+        dmi::MenuMessageStats daemon_msg_stats = {};
+        if(R_SUCCEEDED(am::GetDaemonMenuMessageStats(daemon_msg_stats))) {
+            this->PushSettingItem(GetLanguageString("set_daemon_msgs"), EncodeForSettings(daemon_msg_stats), -1);
+        }
+
+        this->PushSettingItem(GetLanguageString("set_sfx_pool"), EncodeForSettings(GetSfxPoolStats()), -1);
+        this->PushSettingItem(GetLanguageString("set_frame_stats"), EncodeForSettings(GetFrameStats()), -1);
+        this->PushSettingItem(GetLanguageString("set_menu_updates"), EncodeForSettings(g_MenuApplication->GetMenuLayout()->GetItemsMenuUpdateStats()), -1);
+
         if(reset_idx) {
             this->settings_menu->SetSelectedIndex(0);
         }
@@ -265,6 +332,14 @@ namespace ui {
                 setsysGetNfcEnableFlag(&nfc);
                 setsysSetNfcEnableFlag(!nfc);
 
+                reload_need = true;
+                break;
+            }
+            case 11: {
+                bool menu_jumps_enabled;
+                UL_ASSERT_TRUE(g_Config.GetEntry(cfg::ConfigEntryId::MenuJumpsEnabled, menu_jumps_enabled));
+                UL_ASSERT_TRUE(g_Config.SetEntry(cfg::ConfigEntryId::MenuJumpsEnabled, !menu_jumps_enabled));
+
                 reload_need = true;
                 break;
             }
@@ -0,0 +1,91 @@
+#include <ui/ui_SfxPool.hpp>
+#include <util/util_String.hpp>
+#include <unordered_map>
+
+namespace ui {
+
+    namespace {
+
+        Mutex g_SfxPoolLock = {};
+        std::unordered_map<std::string, SharedSfx> g_SfxTable;
+        u64 g_SfxDecodedSize = 0;
+
+        cfg::Theme g_SfxPoolTheme;
+        Thread g_SfxLoadThread;
+        bool g_SfxLoadThreadRunning = false;
+
+        void SfxLoadThread(void*) {
+            for(const auto &file_name: cfg::ListAssetsByTheme(g_SfxPoolTheme, "sound")) {
+                if(!util::StringEndsWith(file_name, ".wav")) {
+                    continue;
+                }
+
+                auto chunk = Mix_LoadWAV(cfg::GetAssetByTheme(g_SfxPoolTheme, "sound/" + file_name).c_str());
+                if(chunk == nullptr) {
+                    continue;
+                }
+
+                const auto name = file_name.substr(0, file_name.length() - __builtin_strlen(".wav"));
+                ScopedLock lk(g_SfxPoolLock);
+                g_SfxDecodedSize += chunk->alen;
+                g_SfxTable[name] = SharedSfx(chunk, Mix_FreeChunk);
+            }
+        }
+
+        void WaitForSfxLoad() {
+            if(g_SfxLoadThreadRunning) {
+                threadWaitForExit(&g_SfxLoadThread);
+                threadClose(&g_SfxLoadThread);
+                g_SfxLoadThreadRunning = false;
+            }
+        }
+
+        void ClearSfxTable() {
+            ScopedLock lk(g_SfxPoolLock);
+            g_SfxTable.clear();
+            g_SfxDecodedSize = 0;
+        }
+
+    }
+
+    void LoadSfxPool(const cfg::Theme &theme) {
+        WaitForSfxLoad();
+        ClearSfxTable();
+
+        g_SfxPoolTheme = theme;
+        UL_RC_ASSERT(threadCreate(&g_SfxLoadThread, &SfxLoadThread, nullptr, nullptr, 0x8000, 0x3B, -2));
+        UL_RC_ASSERT(threadStart(&g_SfxLoadThread));
+        g_SfxLoadThreadRunning = true;
+    }
+
+    SharedSfx GetSfx(const std::string &name) {
+        WaitForSfxLoad();
+
+        ScopedLock lk(g_SfxPoolLock);
+        const auto find_sfx = g_SfxTable.find(name);
+        if(find_sfx == g_SfxTable.end()) {
+            return nullptr;
+        }
+        return find_sfx->second;
+    }
+
+    void PlaySfx(const SharedSfx &sfx) {
+        if(sfx) {
+            Mix_PlayChannel(-1, sfx.get(), 0);
+        }
+    }
+
+    SfxPoolStats GetSfxPoolStats() {
+        ScopedLock lk(g_SfxPoolLock);
+        return {
+            .sfx_count = static_cast<u32>(g_SfxTable.size()),
+            .decoded_size = g_SfxDecodedSize
+        };
+    }
+
+    void ExitSfxPool() {
+        WaitForSfxLoad();
+        ClearSfxTable();
+    }
+
+}
\ No newline at end of file
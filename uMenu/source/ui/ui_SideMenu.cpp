@@ -1,4 +1,5 @@
 #include <ui/ui_SideMenu.hpp>
+#include <unordered_map>
 
 namespace ui {
 
@@ -37,13 +38,11 @@ namespace ui {
             auto icon_tex = pu::ui::render::LoadImage(this->items_icon_paths.at(this->selected_item_idx));
             this->rendered_icons.push_back(icon_tex);
             
-            auto text_tex = pu::ui::render::RenderText(this->text_font, this->items_icon_texts.at(this->selected_item_idx), this->text_clr);
-            this->rendered_texts.push_back(text_tex);
+            this->rendered_texts.push_back(this->GetItemTextRun(this->selected_item_idx));
 
             if(this->rendered_icons.size() > ItemCount) {
                 pu::ui::render::DeleteTexture(this->rendered_icons.front());
                 this->rendered_icons.erase(this->rendered_icons.begin());
-                pu::ui::render::DeleteTexture(this->rendered_texts.front());
                 this->rendered_texts.erase(this->rendered_texts.begin());
                 this->base_icon_idx++;
             }
@@ -51,25 +50,19 @@ namespace ui {
         else {
             auto icon_tex = pu::ui::render::LoadImage(this->items_icon_paths.at(this->selected_item_idx));
             this->rendered_icons.insert(this->rendered_icons.begin(), icon_tex);
-            const auto text = this->items_icon_texts.at(this->selected_item_idx);
-            pu::sdl2::Texture text_tex = nullptr;
-            if(!text.empty()) {
-                text_tex = pu::ui::render::RenderText(this->text_font, text, this->text_clr);
-            }
-            this->rendered_texts.insert(this->rendered_texts.begin(), text_tex);
+            this->rendered_texts.insert(this->rendered_texts.begin(), this->GetItemTextRun(this->selected_item_idx));
 
             this->base_icon_idx--;
             if(this->rendered_icons.size() > ItemCount) {
                 pu::ui::render::DeleteTexture(this->rendered_icons.back());
                 this->rendered_icons.pop_back();
-                pu::ui::render::DeleteTexture(this->rendered_texts.back());
                 this->rendered_texts.pop_back();
             }
         }
         this->UpdateBorderIcons();
     }
 
-    SideMenu::SideMenu(const pu::ui::Color suspended_clr, const std::string &cursor_path, const std::string &suspended_img_path, const std::string &multiselect_img_path, const s32 txt_x, const s32 txt_y, const std::string &font_name, const pu::ui::Color txt_clr, const s32 y) : selected_item_idx(0), suspended_item_idx(-1), base_icon_idx(0), move_alpha(0), text_x(txt_x), text_y(txt_y), enabled(true), text_clr(txt_clr), on_select_cb(), on_selection_changed_cb(), left_border_icon(nullptr), right_border_icon(nullptr), text_font(font_name), scroll_flag(0), scroll_tp_value(50), scroll_count(0) {
+    SideMenu::SideMenu(const pu::ui::Color suspended_clr, const std::string &cursor_path, const std::string &suspended_img_path, const std::string &multiselect_img_path, const s32 txt_x, const s32 txt_y, const std::string &font_name, const pu::ui::Color txt_clr, const s32 y) : selected_item_idx(0), suspended_item_idx(-1), base_icon_idx(0), move_alpha(0), text_x(txt_x), text_y(txt_y), enabled(true), text_clr(txt_clr), on_select_cb(), on_selection_changed_cb(), left_border_icon(nullptr), right_border_icon(nullptr), text_font(font_name), scroll_flag(0), scroll_tp_value(50), scroll_count(0), update_stats() {
         this->cursor_icon = pu::ui::render::LoadImage(cursor_path);
         this->suspended_icon = pu::ui::render::LoadImage(suspended_img_path);
         this->multiselect_icon = pu::ui::render::LoadImage(multiselect_img_path);
@@ -90,14 +83,8 @@ namespace ui {
         if(this->rendered_icons.empty()) {
             for(u32 i = 0; i < std::min(static_cast<size_t>(ItemCount), this->items_icon_paths.size() - this->base_icon_idx); i++) {
                 auto icon_tex = pu::ui::render::LoadImage(this->items_icon_paths.at(this->base_icon_idx + i));
-                const auto text = this->items_icon_texts.at(this->base_icon_idx + i);
                 this->rendered_icons.push_back(icon_tex);
-
-                pu::sdl2::Texture text_tex = nullptr;
-                if(!text.empty()) {
-                    text_tex = pu::ui::render::RenderText(this->text_font, text, this->text_clr);
-                }
-                this->rendered_texts.push_back(text_tex);
+                this->rendered_texts.push_back(this->GetItemTextRun(this->base_icon_idx + i));
             }
             this->UpdateBorderIcons();
             this->DoOnSelectionChanged();
@@ -108,9 +95,13 @@ namespace ui {
             auto icon_tex = this->rendered_icons.at(i);
             drawer->RenderTexture(icon_tex, base_x, y, pu::ui::render::TextureRenderOptions::WithCustomDimensions(ItemSize, ItemSize));
             
-            auto text_tex = this->rendered_texts.at(i);
-            if(text_tex != nullptr) {
-                drawer->RenderTexture(text_tex, base_x + this->text_x, y + this->text_y);
+            auto &text_run = this->rendered_texts.at(i);
+            if(text_run) {
+                // Folder names are drawn from the shared glyph atlas, thus scrolling them into view doesn't rasterize anything again
+                if(!IsTextRunValid(text_run)) {
+                    text_run = this->GetItemTextRun(this->base_icon_idx + i);
+                }
+                RenderTextRun(text_run, base_x + this->text_x, y + this->text_y);
             }
             if(this->IsItemMultiselected(this->base_icon_idx + i)) {
                 drawer->RenderTexture(this->multiselect_icon, base_x - Margin, y - Margin, pu::ui::render::TextureRenderOptions::WithCustomDimensions(ExtraIconSize, ExtraIconSize));
@@ -141,6 +132,8 @@ namespace ui {
         }
 
         if(move_alpha > 0) {
+            // Cursor fade still in progress, keep presenting frames
+            MarkFrameDirty();
             s32 tmp_alpha = move_alpha - MoveAlphaIncrement;
             if(tmp_alpha < 0) {
                 tmp_alpha = 0;
@@ -257,17 +250,125 @@ namespace ui {
 
         this->items_icon_paths.clear();
         this->items_icon_texts.clear();
+        this->items_keys.clear();
         this->items_multiselected.clear();
 
         this->selected_item_idx = 0;
         this->base_icon_idx = 0;
         this->suspended_item_idx = -1;
+        MarkFrameDirty();
     }
 
-    void SideMenu::AddItem(const std::string &icon, const std::string &txt) {
-        this->items_icon_paths.push_back(icon);
-        this->items_icon_texts.push_back(txt);
-        this->items_multiselected.push_back(false);
+    void SideMenu::UpdateItems(const std::vector<SideMenuItem> &items, const bool keep_selection) {
+        const auto start_tick = armGetSystemTick();
+
+        // Every texture currently loaded, borders included
+        // Keyed by item and icon path: an icon path alone may now belong to a different item (with a different icon behind it)
+        const auto make_icon_key = [&](const u32 item_idx) {
+            return this->items_keys.at(item_idx) + '\0' + this->items_icon_paths.at(item_idx);
+        };
+        std::unordered_map<std::string, pu::sdl2::Texture> prev_icons;
+        const auto add_prev_icon = [&](const u32 item_idx, pu::sdl2::Texture icon_tex) {
+            if(!prev_icons.emplace(make_icon_key(item_idx), icon_tex).second) {
+                pu::ui::render::DeleteTexture(icon_tex);
+            }
+        };
+        for(u32 i = 0; i < this->rendered_icons.size(); i++) {
+            add_prev_icon(this->base_icon_idx + i, this->rendered_icons.at(i));
+        }
+        if(this->left_border_icon != nullptr) {
+            add_prev_icon(this->base_icon_idx - 1, this->left_border_icon);
+        }
+        if(this->right_border_icon != nullptr) {
+            add_prev_icon(this->base_icon_idx + ItemCount, this->right_border_icon);
+        }
+        this->rendered_icons.clear();
+        this->rendered_texts.clear();
+        this->left_border_icon = nullptr;
+        this->right_border_icon = nullptr;
+
+        std::string selected_key;
+        if(this->selected_item_idx < this->items_keys.size()) {
+            selected_key = this->items_keys.at(this->selected_item_idx);
+        }
+
+        this->items_icon_paths.clear();
+        this->items_icon_texts.clear();
+        this->items_keys.clear();
+        for(const auto &item: items) {
+            this->items_icon_paths.push_back(item.icon_path);
+            this->items_icon_texts.push_back(item.text);
+            this->items_keys.push_back(item.key);
+        }
+        this->items_multiselected.assign(items.size(), false);
+        this->suspended_item_idx = -1;
+        this->move_alpha = 0;
+
+        // The selected item stays selected (the selected index if it's gone), and so does the window if it's still in it
+        u32 idx = 0;
+        auto base_idx = this->base_icon_idx;
+        if(keep_selection && !items.empty()) {
+            const auto find_selected = STL_FIND_IF(this->items_keys, key, (key == selected_key));
+            if(STL_FOUND(this->items_keys, find_selected)) {
+                idx = std::distance(this->items_keys.begin(), find_selected);
+            }
+            else {
+                idx = std::min(this->selected_item_idx, static_cast<u32>(items.size() - 1));
+            }
+        }
+        else {
+            base_idx = 0;
+        }
+        if((idx < base_idx) || (idx >= (base_idx + ItemCount))) {
+            base_idx = idx;
+        }
+        this->base_icon_idx = std::min(base_idx, this->GetMaxBaseIconIndex());
+        this->selected_item_idx = idx;
+        this->prev_selected_item_idx = idx;
+
+        u32 reused_icon_count = 0;
+        u32 loaded_icon_count = 0;
+        const auto take_icon = [&](const u32 item_idx) {
+            const auto find_icon = prev_icons.find(make_icon_key(item_idx));
+            if(find_icon != prev_icons.end()) {
+                const auto icon_tex = find_icon->second;
+                prev_icons.erase(find_icon);
+                reused_icon_count++;
+                return icon_tex;
+            }
+            loaded_icon_count++;
+            return pu::ui::render::LoadImage(this->items_icon_paths.at(item_idx));
+        };
+
+        if(!items.empty()) {
+            for(u32 i = 0; i < std::min(static_cast<size_t>(ItemCount), items.size() - this->base_icon_idx); i++) {
+                this->rendered_icons.push_back(take_icon(this->base_icon_idx + i));
+                this->rendered_texts.push_back(this->GetItemTextRun(this->base_icon_idx + i));
+            }
+            if(this->base_icon_idx > 0) {
+                this->left_border_icon = take_icon(this->base_icon_idx - 1);
+            }
+            if((this->base_icon_idx + ItemCount) < items.size()) {
+                this->right_border_icon = take_icon(this->base_icon_idx + ItemCount);
+            }
+        }
+
+        for(auto &[icon_key, icon_tex]: prev_icons) {
+            pu::ui::render::DeleteTexture(icon_tex);
+        }
+
+        const auto update_ns = armTicksToNs(armGetSystemTick() - start_tick);
+        this->update_stats.update_count++;
+        this->update_stats.last_update_ns = update_ns;
+        this->update_stats.max_update_ns = std::max(this->update_stats.max_update_ns, update_ns);
+        this->update_stats.total_update_ns += update_ns;
+        this->update_stats.last_reused_icon_count = reused_icon_count;
+        this->update_stats.last_loaded_icon_count = loaded_icon_count;
+
+        MarkFrameDirty();
+        if(!items.empty()) {
+            this->DoOnSelectionChanged();
+        }
     }
 
     void SideMenu::HandleMoveLeft() {
@@ -302,6 +403,59 @@ namespace ui {
         }
     }
 
+    void SideMenu::SeekTo(const u32 idx) {
+        if((idx >= this->items_icon_paths.size()) || (idx == this->selected_item_idx)) {
+            return;
+        }
+
+        // Keep the window if the item is already there, otherwise it goes first (unless that would leave the window partially empty)
+        auto base_idx = this->base_icon_idx;
+        if((idx < base_idx) || (idx >= (base_idx + ItemCount))) {
+            base_idx = std::min(idx, this->GetMaxBaseIconIndex());
+        }
+        this->DoSeek(idx, base_idx);
+    }
+
+    void SideMenu::MovePage(const bool moving_right) {
+        if(this->items_icon_paths.empty()) {
+            return;
+        }
+
+        u32 base_idx;
+        u32 idx;
+        if(moving_right) {
+            base_idx = std::min(this->base_icon_idx + ItemCount, this->GetMaxBaseIconIndex());
+            idx = std::min(this->selected_item_idx + ItemCount, static_cast<u32>(this->items_icon_paths.size() - 1));
+        }
+        else {
+            base_idx = (this->base_icon_idx > ItemCount) ? (this->base_icon_idx - ItemCount) : 0;
+            idx = (this->selected_item_idx > ItemCount) ? (this->selected_item_idx - ItemCount) : 0;
+        }
+
+        // Once on the first/last page, the selection goes to the first/last item
+        idx = std::clamp(idx, base_idx, base_idx + ItemCount - 1);
+        if(idx != this->selected_item_idx) {
+            this->DoSeek(idx, base_idx);
+        }
+    }
+
+    void SideMenu::DoSeek(const u32 idx, const u32 base_idx) {
+        this->prev_selected_item_idx = this->selected_item_idx;
+        this->selected_item_idx = idx;
+
+        if(!this->rendered_icons.empty() && (base_idx == this->base_icon_idx)) {
+            this->move_alpha = 0xFF;
+            this->DoOnSelectionChanged();
+        }
+        else {
+            // Reloaded (and selection change notified) on the next render
+            this->ClearRenderedItems();
+            this->base_icon_idx = base_idx;
+            this->move_alpha = 0;
+            MarkFrameDirty();
+        }
+    }
+
     void SideMenu::UpdateBorderIcons() {
         this->ClearBorderIcons();
 
@@ -318,11 +472,15 @@ namespace ui {
         for(u32 i = 0; i < this->items_icon_paths.size(); i++) {
             this->items_multiselected.push_back(false);
         }
+        MarkFrameDirty();
     }
 
     void SideMenu::SetItemMultiselected(const u32 idx, const bool selected) {
         if(idx < this->items_multiselected.size()) {
-            this->items_multiselected.at(idx) = selected;
+            if(this->items_multiselected.at(idx) != selected) {
+                this->items_multiselected.at(idx) = selected;
+                MarkFrameDirty();
+            }
         }
     }
 
@@ -35,7 +35,7 @@ namespace ui {
         g_MenuApplication->ApplyConfigForElement("startup_menu", "info_text", this->info_text);
         this->Add(this->info_text);
 
-        this->users_menu = pu::ui::elm::Menu::New(200, 60, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 5);
+        this->users_menu = PacedMenu::New(200, 60, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 5);
         g_MenuApplication->ApplyConfigForElement("startup_menu", "users_menu_item", this->users_menu);
         this->Add(this->users_menu);
     }
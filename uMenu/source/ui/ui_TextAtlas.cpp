@@ -0,0 +1,171 @@
+#include <ui/ui_TextAtlas.hpp>
+#include <cfg/cfg_Config.hpp>
+
+extern cfg::Theme g_Theme;
+
+namespace ui {
+
+    namespace {
+
+        // Plutonium doesn't expose its fonts, so metrics come from handles to the same font file and size, opened on demand
+        std::unordered_map<std::string, TTF_Font*> g_MetricsFonts;
+
+        TTF_Font *GetMetricsFont(const std::string &font_name) {
+            const auto find_font = g_MetricsFonts.find(font_name);
+            if(find_font != g_MetricsFonts.end()) {
+                return find_font->second;
+            }
+
+            TTF_Font *font = nullptr;
+            // Plutonium's font names end with their size ("<name>@<size>")
+            const auto size_sep = font_name.rfind('@');
+            const auto font_size = (size_sep != std::string::npos) ? strtoul(font_name.c_str() + size_sep + 1, nullptr, 10) : 0;
+            if(font_size > 0) {
+                const auto font_path = cfg::GetAssetByTheme(g_Theme, "ui/Font.ttf");
+                if(!font_path.empty()) {
+                    font = TTF_OpenFont(font_path.c_str(), font_size);
+                }
+                else {
+                    // Like Plutonium, the system's shared font is used if the theme has none
+                    PlFontData font_data;
+                    if(R_SUCCEEDED(plGetSharedFontByType(&font_data, PlSharedFontType_Standard))) {
+                        font = TTF_OpenFontRW(SDL_RWFromConstMem(font_data.address, font_data.size), 1, font_size);
+                    }
+                }
+            }
+
+            // Failures are kept too, so that nothing gets opened again for every glyph
+            g_MetricsFonts[font_name] = font;
+            return font;
+        }
+
+        void CloseMetricsFonts() {
+            for(auto &[font_name, font]: g_MetricsFonts) {
+                if(font != nullptr) {
+                    TTF_CloseFont(font);
+                }
+            }
+            g_MetricsFonts.clear();
+        }
+
+        // These only take 16-bit codepoints, glyphs the font lacks (Plutonium draws those from fallback fonts) keep their rendered width
+        inline bool IsMetricsGlyph(TTF_Font *font, const u32 cp) {
+            return (cp <= 0xFFFF) && (TTF_GlyphIsProvided(font, static_cast<Uint16>(cp)) != 0);
+        }
+
+        bool GetGlyphAdvance(const std::string &font_name, const u32 cp, s32 &out_advance) {
+            auto font = GetMetricsFont(font_name);
+            if((font == nullptr) || !IsMetricsGlyph(font, cp)) {
+                return false;
+            }
+
+            int min_x, max_x, min_y, max_y, advance;
+            if(TTF_GlyphMetrics(font, static_cast<Uint16>(cp), &min_x, &max_x, &min_y, &max_y, &advance) != 0) {
+                return false;
+            }
+            out_advance = advance;
+            return true;
+        }
+
+        s32 GetKerning(const std::string &font_name, const u32 prev_cp, const u32 cp) {
+            auto font = GetMetricsFont(font_name);
+            if((font == nullptr) || !IsMetricsGlyph(font, prev_cp) || !IsMetricsGlyph(font, cp)) {
+                return 0;
+            }
+            return TTF_GetFontKerningSizeGlyphs(font, static_cast<Uint16>(prev_cp), static_cast<Uint16>(cp));
+        }
+
+        TextGlyphImage RenderGlyph(const std::string &font_name, const std::string &glyph_str, s32 &out_width, s32 &out_height) {
+            auto glyph_tex = pu::ui::render::RenderText(font_name, glyph_str, pu::ui::Color(0xFF, 0xFF, 0xFF, 0xFF));
+            if(glyph_tex != nullptr) {
+                out_width = pu::ui::render::GetTextureWidth(glyph_tex);
+                out_height = pu::ui::render::GetTextureHeight(glyph_tex);
+            }
+            return glyph_tex;
+        }
+
+        void DeleteGlyph(TextGlyphImage glyph) {
+            pu::ui::render::DeleteTexture(static_cast<pu::sdl2::Texture>(glyph));
+        }
+
+        TextAtlasPage CreateAtlasPage() {
+            auto page = SDL_CreateTexture(pu::ui::render::GetMainRenderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, TextAtlasPageSize, TextAtlasPageSize);
+            if(page != nullptr) {
+                auto renderer = pu::ui::render::GetMainRenderer();
+                SDL_SetRenderTarget(renderer, page);
+                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+                SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0);
+                SDL_RenderClear(renderer);
+                SDL_SetRenderTarget(renderer, nullptr);
+                SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+            }
+            return page;
+        }
+
+        void DeleteAtlasPage(TextAtlasPage page) {
+            pu::ui::render::DeleteTexture(static_cast<pu::sdl2::Texture>(page));
+        }
+
+        void CopyGlyph(TextGlyphImage glyph, TextAtlasPage page, const TextRect &dst_rect) {
+            auto glyph_tex = static_cast<pu::sdl2::Texture>(glyph);
+            const SDL_Rect sdl_dst_rect = { dst_rect.x, dst_rect.y, dst_rect.w, dst_rect.h };
+            auto renderer = pu::ui::render::GetMainRenderer();
+            SDL_SetRenderTarget(renderer, static_cast<pu::sdl2::Texture>(page));
+            SDL_SetTextureBlendMode(glyph_tex, SDL_BLENDMODE_NONE);
+            SDL_RenderCopy(renderer, glyph_tex, nullptr, &sdl_dst_rect);
+            SDL_SetRenderTarget(renderer, nullptr);
+        }
+
+        TextRunCache g_TextRunCache({
+            .render_glyph = RenderGlyph,
+            .delete_glyph = DeleteGlyph,
+            .create_page = CreateAtlasPage,
+            .delete_page = DeleteAtlasPage,
+            .copy_glyph = CopyGlyph,
+            .get_glyph_advance = GetGlyphAdvance,
+            .get_kerning = GetKerning
+        });
+
+    }
+
+    TextRunRef GetTextRun(const std::string &font_name, const std::string &text, const pu::ui::Color clr) {
+        return g_TextRunCache.GetRun(font_name, text, { clr.r, clr.g, clr.b, clr.a });
+    }
+
+    void RenderTextRun(const TextRunRef &run, const s32 x, const s32 y, const u8 alpha) {
+        if(!IsTextRunValid(run)) {
+            return;
+        }
+
+        auto renderer = pu::ui::render::GetMainRenderer();
+        const auto run_alpha = static_cast<u8>((static_cast<u32>(run->clr.a) * alpha) / 0xFF);
+        pu::sdl2::Texture last_page = nullptr;
+        for(const auto &glyph: run->glyphs) {
+            auto page = static_cast<pu::sdl2::Texture>(glyph.page);
+            if(page != last_page) {
+                SDL_SetTextureColorMod(page, run->clr.r, run->clr.g, run->clr.b);
+                SDL_SetTextureAlphaMod(page, run_alpha);
+                last_page = page;
+            }
+
+            const SDL_Rect src_rect = { glyph.src_rect.x, glyph.src_rect.y, glyph.src_rect.w, glyph.src_rect.h };
+            const SDL_Rect dst_rect = { x + glyph.x, y + glyph.y, glyph.src_rect.w, glyph.src_rect.h };
+            SDL_RenderCopy(renderer, page, &src_rect, &dst_rect);
+        }
+    }
+
+    bool IsTextRunValid(const TextRunRef &run) {
+        return g_TextRunCache.IsRunValid(run);
+    }
+
+    void ClearTextAtlas() {
+        g_TextRunCache.Clear();
+        // The theme (thus the font) might change before glyphs get rasterized again
+        CloseMetricsFonts();
+    }
+
+    TextAtlasStats GetTextAtlasStats() {
+        return g_TextRunCache.GetStats();
+    }
+
+}
@@ -0,0 +1,239 @@
+#include <ui/ui_TextRunCache.hpp>
+
+namespace ui {
+
+    namespace {
+
+        constexpr u32 SpaceCodepoint = ' ';
+        constexpr u32 NewLineCodepoint = '\n';
+
+        inline std::string MakeTextRunKey(const std::string &font_name, const std::string &text, const TextColor clr) {
+            std::string key;
+            key.reserve(font_name.length() + text.length() + 6);
+            key += font_name;
+            key += '\0';
+            key += text;
+            key += '\0';
+            key += static_cast<char>(clr.r);
+            key += static_cast<char>(clr.g);
+            key += static_cast<char>(clr.b);
+            key += static_cast<char>(clr.a);
+            return key;
+        }
+
+    }
+
+    size_t DecodeUtf8Codepoint(const std::string &text, const size_t offset, u32 &out_cp) {
+        const auto c = static_cast<u8>(text[offset]);
+        size_t len = 1;
+        if(c < 0x80) {
+            out_cp = c;
+            return 1;
+        }
+        else if((c & 0xE0) == 0xC0) {
+            out_cp = c & 0x1F;
+            len = 2;
+        }
+        else if((c & 0xF0) == 0xE0) {
+            out_cp = c & 0x0F;
+            len = 3;
+        }
+        else if((c & 0xF8) == 0xF0) {
+            out_cp = c & 0x07;
+            len = 4;
+        }
+        else {
+            out_cp = c;
+            return 1;
+        }
+
+        if((offset + len) > text.length()) {
+            out_cp = c;
+            return 1;
+        }
+        for(size_t i = 1; i < len; i++) {
+            const auto cont = static_cast<u8>(text[offset + i]);
+            if((cont & 0xC0) != 0x80) {
+                out_cp = c;
+                return 1;
+            }
+            out_cp = (out_cp << 6) | (cont & 0x3F);
+        }
+        return len;
+    }
+
+    bool TextAtlasPacker::Pack(const s32 width, const s32 height, TextRect &out_rect, bool &out_new_page) {
+        if((width > TextAtlasPageSize) || (height > TextAtlasPageSize)) {
+            return false;
+        }
+
+        if((this->cur_x + width) > TextAtlasPageSize) {
+            this->cur_x = 0;
+            this->cur_y += this->cur_row_height;
+            this->cur_row_height = 0;
+        }
+        out_new_page = !this->has_page || ((this->cur_y + height) > TextAtlasPageSize);
+        if(out_new_page) {
+            this->cur_x = 0;
+            this->cur_y = 0;
+            this->cur_row_height = 0;
+            this->has_page = true;
+        }
+
+        out_rect = { this->cur_x, this->cur_y, width, height };
+        this->cur_x += width;
+        this->cur_row_height = std::max(this->cur_row_height, height);
+        return true;
+    }
+
+    bool TextRunCache::RasterizeGlyph(const std::string &font_name, FontAtlas &atlas, const u32 cp, const std::string &glyph_str, AtlasGlyph &out_glyph) {
+        s32 glyph_w = 0;
+        s32 glyph_h = 0;
+        auto glyph_img = this->backend.render_glyph(font_name, glyph_str, glyph_w, glyph_h);
+        if(glyph_img == nullptr) {
+            return false;
+        }
+        UL_ON_SCOPE_EXIT({ this->backend.delete_glyph(glyph_img); });
+
+        TextRect dst_rect;
+        bool new_page;
+        if(!atlas.packer.Pack(glyph_w, glyph_h, dst_rect, new_page)) {
+            return false;
+        }
+        if(new_page) {
+            auto page = this->backend.create_page();
+            if(page == nullptr) {
+                atlas.packer.Reset();
+                return false;
+            }
+            atlas.pages.push_back(page);
+            this->stats.page_count++;
+        }
+
+        auto page = atlas.pages.back();
+        this->backend.copy_glyph(glyph_img, page, dst_rect);
+        atlas.line_height = std::max(atlas.line_height, glyph_h);
+
+        s32 advance = 0;
+        if(!this->backend.get_glyph_advance(font_name, cp, advance)) {
+            advance = glyph_w;
+        }
+
+        out_glyph = {
+            .page = page,
+            .src_rect = dst_rect,
+            .advance = advance
+        };
+        this->stats.rasterized_glyphs++;
+        return true;
+    }
+
+    const TextRunCache::AtlasGlyph *TextRunCache::FindOrRasterizeGlyph(const std::string &font_name, FontAtlas &atlas, const u32 cp, const std::string &glyph_str) {
+        auto find_glyph = atlas.glyphs.find(cp);
+        if(find_glyph != atlas.glyphs.end()) {
+            return &find_glyph->second;
+        }
+
+        AtlasGlyph glyph = {};
+        if(!this->RasterizeGlyph(font_name, atlas, cp, glyph_str, glyph)) {
+            return nullptr;
+        }
+        return &atlas.glyphs.emplace(cp, glyph).first->second;
+    }
+
+    TextRunRef TextRunCache::LayoutRun(const std::string &font_name, const std::string &text, const TextColor clr) {
+        auto run = std::make_shared<TextRun>();
+        run->clr = clr;
+        run->generation = this->generation;
+
+        auto &atlas = this->font_atlases[font_name];
+        s32 cur_x = 0;
+        s32 cur_y = 0;
+        // Glyph images might reach past their advance (italics and such), the run is as wide as whatever ends further
+        s32 line_width = 0;
+        u32 prev_cp = 0;
+        auto has_prev_cp = false;
+        size_t offset = 0;
+        while(offset < text.length()) {
+            u32 cp = 0;
+            const auto cp_len = DecodeUtf8Codepoint(text, offset, cp);
+            const auto glyph_str = text.substr(offset, cp_len);
+            offset += cp_len;
+
+            if(cp == NewLineCodepoint) {
+                run->width = std::max(run->width, line_width);
+                cur_x = 0;
+                cur_y += atlas.line_height;
+                line_width = 0;
+                has_prev_cp = false;
+                continue;
+            }
+
+            const auto glyph = this->FindOrRasterizeGlyph(font_name, atlas, cp, glyph_str);
+            if(glyph == nullptr) {
+                continue;
+            }
+
+            if(has_prev_cp) {
+                cur_x += this->backend.get_kerning(font_name, prev_cp, cp);
+            }
+            prev_cp = cp;
+            has_prev_cp = true;
+
+            // Spaces only advance, nothing to draw
+            if(cp != SpaceCodepoint) {
+                run->glyphs.push_back({
+                    .page = glyph->page,
+                    .src_rect = glyph->src_rect,
+                    .x = cur_x,
+                    .y = cur_y
+                });
+                line_width = std::max(line_width, cur_x + glyph->src_rect.w);
+            }
+            cur_x += glyph->advance;
+            line_width = std::max(line_width, cur_x);
+        }
+
+        run->width = std::max(run->width, line_width);
+        run->height = text.empty() ? 0 : (cur_y + atlas.line_height);
+        return run;
+    }
+
+    TextRunRef TextRunCache::GetRun(const std::string &font_name, const std::string &text, const TextColor clr) {
+        const auto key = MakeTextRunKey(font_name, text, clr);
+        auto find_run = this->run_table.find(key);
+        if(find_run != this->run_table.end()) {
+            // Move it to the front, the least recently used runs are at the back
+            this->run_list.splice(this->run_list.begin(), this->run_list, find_run->second);
+            this->stats.run_hits++;
+            return find_run->second->run;
+        }
+
+        this->stats.run_misses++;
+        auto run = this->LayoutRun(font_name, text, clr);
+        this->run_list.push_front({ key, run });
+        this->run_table[key] = this->run_list.begin();
+
+        if(this->run_list.size() > MaxCachedTextRunCount) {
+            this->run_table.erase(this->run_list.back().key);
+            this->run_list.pop_back();
+        }
+        return run;
+    }
+
+    void TextRunCache::Clear() {
+        this->run_table.clear();
+        this->run_list.clear();
+
+        for(auto &[font_name, atlas]: this->font_atlases) {
+            for(auto &page: atlas.pages) {
+                this->backend.delete_page(page);
+            }
+        }
+        this->font_atlases.clear();
+
+        this->stats.page_count = 0;
+        this->generation++;
+    }
+
+}
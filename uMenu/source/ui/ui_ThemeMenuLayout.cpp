@@ -1,7 +1,9 @@
 #include <ui/ui_ThemeMenuLayout.hpp>
+#include <cfg/cfg_RecordStore.hpp>
 #include <os/os_Account.hpp>
 #include <util/util_Convert.hpp>
 #include <ui/ui_MenuApplication.hpp>
+#include <ui/ui_IconLoader.hpp>
 #include <fs/fs_Stdio.hpp>
 
 extern ui::MenuApplication::Ref g_MenuApplication;
@@ -11,6 +13,28 @@ extern cfg::Config g_Config;
 
 namespace ui {
 
+    namespace {
+
+        constexpr u32 ThemesMenuItemsToShow = 5;
+
+        void ApplyTheme(const std::string &theme_name) {
+            g_TransitionGuard.Run([&]() {
+                if(g_MenuApplication->SwitchTheme(theme_name)) {
+                    g_MenuApplication->ShowNotification(GetLanguageString("theme_changed"));
+                }
+                else {
+                    // The screen is already faded out at this point
+                    g_MenuApplication->CloseWithFadeOut();
+                    g_MenuApplication->ShowNotification(GetLanguageString("theme_changed"));
+
+                    cfg::FlushRecords();
+                    UL_RC_ASSERT(dmi::menu::SendCommand<dmi::DaemonMessage::RestartMenu>());
+                }
+            });
+        }
+
+    }
+
     ThemeMenuLayout::ThemeMenuLayout() {
         this->SetBackgroundImage(cfg::GetAssetByTheme(g_Theme, "ui/Background.png"));
 
@@ -18,7 +42,7 @@ namespace ui {
         g_MenuApplication->ApplyConfigForElement("themes_menu", "banner_image", this->cur_theme_banner);
         this->Add(this->cur_theme_banner);
 
-        this->themes_menu = pu::ui::elm::Menu::New(200, 60, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, 5);
+        this->themes_menu = PacedMenu::New(200, 60, 880, g_MenuApplication->GetMenuBackgroundColor(), g_MenuApplication->GetMenuFocusColor(), 100, ThemesMenuItemsToShow);
         g_MenuApplication->ApplyConfigForElement("themes_menu", "themes_menu_item", this->themes_menu);
         this->Add(this->themes_menu);
 
@@ -53,7 +77,35 @@ namespace ui {
         this->Add(this->cur_theme_icon);
     }
 
+    void ThemeMenuLayout::UpdateLoadedIcons() {
+        // The menu only loads the icons of the visible items (again whenever it scrolls), thus only those need their renders reloaded here
+        // The visible items always surround the selected one, so anything further away than a page is certainly not visible
+        const s32 selected_idx = this->themes_menu->GetSelectedIndex();
+        auto visible_icon_loaded = false;
+        u32 icon_idx;
+        std::string icon_path;
+        while(PopLoadedIcon(icon_idx, icon_path)) {
+            if(icon_idx < this->theme_items.size()) {
+                this->theme_items.at(icon_idx)->SetIcon(icon_path);
+
+                // The reset item comes first
+                const s32 item_idx = icon_idx + 1;
+                if(std::abs(item_idx - selected_idx) < static_cast<s32>(ThemesMenuItemsToShow)) {
+                    visible_icon_loaded = true;
+                }
+            }
+        }
+
+        if(visible_icon_loaded) {
+            // Unlike SetSelectedIndex, this keeps the menu's scroll and selection as they are
+            this->themes_menu->ForceReloadItems();
+            MarkFrameDirty();
+        }
+    }
+
     void ThemeMenuLayout::OnMenuInput(const u64 keys_down, const u64 keys_up, const u64 keys_held, const pu::ui::TouchPoint touch_pos) {
+        this->UpdateLoadedIcons();
+
         if(keys_down & HidNpadButton_B) {
             g_TransitionGuard.Run([]() {
                 g_MenuApplication->FadeOut();
@@ -95,6 +147,7 @@ namespace ui {
             this->cur_theme_icon->SetHeight(100);
         }
         this->themes_menu->ClearItems();
+        this->theme_items.clear();
         this->loaded_themes.clear();
         
         this->loaded_themes = cfg::LoadThemes();
@@ -105,13 +158,19 @@ namespace ui {
         theme_reset_item->SetIcon("romfs:/Logo.png");
         this->themes_menu->AddItem(theme_reset_item);
         
+        // Icons get loaded in the background, placeholders are shown meanwhile
+        std::vector<std::string> icon_paths;
         for(const auto &theme: this->loaded_themes) {
             auto theme_item = pu::ui::elm::MenuItem::New(theme.manifest.name + " (v" + theme.manifest.release + ", " + GetLanguageString("theme_by") + " " + theme.manifest.author + ")");
             theme_item->AddOnKey(std::bind(&ThemeMenuLayout::theme_DefaultKey, this));
             theme_item->SetColor(g_MenuApplication->GetTextColor());
-            theme_item->SetIcon(theme.path + "/theme/Icon.png");
+            theme_item->SetIcon(IconPlaceholderPath);
             this->themes_menu->AddItem(theme_item);
+            this->theme_items.push_back(theme_item);
+            icon_paths.push_back(theme.path + "/theme/Icon.png");
         }
+        // Nothing is waited for here, visible items get their icons in place as they're loaded (see UpdateLoadedIcons)
+        RequestIcons(icon_paths);
 
         this->themes_menu->SetSelectedIndex(0);
     }
@@ -127,19 +186,7 @@ namespace ui {
                 if(option == 0) {
                     UL_ASSERT_TRUE(g_Config.SetEntry(cfg::ConfigEntryId::ActiveThemeName, std::string()));
                     cfg::SaveConfig(g_Config);
-
-                    g_MenuApplication->StopPlayBGM();
-                    g_MenuApplication->CloseWithFadeOut();
-                    g_MenuApplication->ShowNotification(GetLanguageString("theme_changed"));
-
-                    UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::RestartMenu, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                        // ...
-                        return ResultSuccess;
-                    },
-                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                        // ...
-                        return ResultSuccess;
-                    }));
+                    ApplyTheme(std::string());
                 }
             }
         }
@@ -154,19 +201,7 @@ namespace ui {
                 if(option == 0) {
                     UL_ASSERT_TRUE(g_Config.SetEntry(cfg::ConfigEntryId::ActiveThemeName, selected_theme.base_name));
                     cfg::SaveConfig(g_Config);
-
-                    g_MenuApplication->StopPlayBGM();
-                    g_MenuApplication->CloseWithFadeOut();
-                    g_MenuApplication->ShowNotification(GetLanguageString("theme_changed"));
-
-                    UL_RC_ASSERT(dmi::menu::SendCommand(dmi::DaemonMessage::RestartMenu, [&](dmi::menu::MenuScopedStorageWriter &writer) {
-                        // ...
-                        return ResultSuccess;
-                    },
-                    [&](dmi::menu::MenuScopedStorageReader &reader) {
-                        // ...
-                        return ResultSuccess;
-                    }));
+                    ApplyTheme(selected_theme.base_name);
                 }
             }
         }
@@ -12,11 +12,27 @@ namespace uViewer
         /// Punto de entrada principal para la aplicación.
         /// </summary>
         [STAThread]
-        static void Main()
+        static int Main(string[] args)
         {
+            // uViewer.exe pack-theme <theme-dir> <out.ultheme>
+            if((args.Length >= 3) && (args[0] == "pack-theme"))
+            {
+                try
+                {
+                    ThemePacker.Pack(args[1], args[2]);
+                    return 0;
+                }
+                catch(Exception ex)
+                {
+                    Console.Error.WriteLine("Unable to pack theme: " + ex.Message);
+                    return 1;
+                }
+            }
+
             Application.EnableVisualStyles();
             Application.SetCompatibleTextRenderingDefault(false);
             Application.Run(new MainForm());
+            return 0;
         }
     }
 }
@@ -0,0 +1,97 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+namespace uViewer
+{
+    // Builds single-file themes (.ultheme) out of theme directories, check uLaunch's cfg_ThemePack.hpp for the format
+    public static class ThemePacker
+    {
+        public const uint Magic = 0x50544C55; // "ULTP"
+        public const uint Version = 1;
+        public const int Alignment = 0x1000;
+        public const int AssetPathLength = 0x40;
+        public const int HeaderSize = 0x20;
+        public const int AssetSize = 0x50;
+
+        private class PackAsset
+        {
+            public string Path;
+            public byte[] Data;
+        }
+
+        private static long Align(long value) => (value + Alignment - 1) & ~(long)(Alignment - 1);
+
+        public static void Pack(string theme_dir, string out_path)
+        {
+            var manifest_path = Path.Combine(theme_dir, "theme", "Manifest.json");
+            if (!File.Exists(manifest_path))
+            {
+                throw new FileNotFoundException("The theme has no manifest", manifest_path);
+            }
+            var manifest = File.ReadAllBytes(manifest_path);
+
+            var assets = new List<PackAsset>();
+            foreach (var file in Directory.GetFiles(theme_dir, "*", SearchOption.AllDirectories))
+            {
+                var asset_path = file.Substring(theme_dir.Length).TrimStart('\\', '/').Replace('\\', '/');
+                if (Encoding.UTF8.GetByteCount(asset_path) >= AssetPathLength)
+                {
+                    throw new InvalidDataException("Asset path too long: " + asset_path);
+                }
+                assets.Add(new PackAsset { Path = asset_path, Data = File.ReadAllBytes(file) });
+            }
+
+            // uMenu looks assets up with a binary search (byte-wise path order)
+            assets = assets.OrderBy(asset => asset.Path, StringComparer.Ordinal).ToList();
+
+            var asset_table_offset = HeaderSize;
+            var manifest_offset = asset_table_offset + assets.Count * AssetSize;
+            var offsets = new long[assets.Count];
+            var cur_offset = Align(manifest_offset + manifest.Length);
+            var file_size = (long)(manifest_offset + manifest.Length);
+            for (var i = 0; i < assets.Count; i++)
+            {
+                offsets[i] = cur_offset;
+                file_size = cur_offset + assets[i].Data.Length;
+                cur_offset = Align(file_size);
+            }
+            if (file_size > uint.MaxValue)
+            {
+                throw new InvalidDataException("The theme is too big to be packed");
+            }
+
+            using (var bw = new BinaryWriter(File.Create(out_path)))
+            {
+                bw.Write(Magic);
+                bw.Write(Version);
+                bw.Write((uint)assets.Count);
+                bw.Write((uint)asset_table_offset);
+                bw.Write((uint)manifest_offset);
+                bw.Write((uint)manifest.Length);
+                bw.Write((uint)file_size);
+                bw.Write(0u);
+
+                for (var i = 0; i < assets.Count; i++)
+                {
+                    var path_buf = new byte[AssetPathLength];
+                    Encoding.UTF8.GetBytes(assets[i].Path, 0, assets[i].Path.Length, path_buf, 0);
+                    bw.Write(path_buf);
+                    bw.Write((uint)offsets[i]);
+                    bw.Write((uint)assets[i].Data.Length);
+                    // Reserved
+                    bw.Write(0ul);
+                }
+                bw.Write(manifest);
+
+                for (var i = 0; i < assets.Count; i++)
+                {
+                    bw.Write(new byte[offsets[i] - bw.BaseStream.Position]);
+                    bw.Write(assets[i].Data);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
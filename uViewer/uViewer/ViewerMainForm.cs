@@ -14,6 +14,7 @@ namespace uViewer
         Invalid,
         RawRGBA,
         JPEG,
+        EncodedRGBA, // Downscaled and/or tile-delta + RLE encoded RGBA, decoded into a plain RGBA frame here
     }
 
     public partial class ViewerMainForm : Form
@@ -25,6 +26,32 @@ namespace uViewer
         private static MemoryStream BaseStream = new MemoryStream((int)PlainRgbaScreenBufferSize);
         private static USBMode Mode = USBMode.Invalid;
 
+        // Frames (protocol version 1 onwards) are sent as a header plus only the payload bytes
+        // Legacy uLaunch versions ignore the handshake and keep sending whole packets, which are still handled
+        public const uint HandshakeMagic = 0x57564C55; // "ULVW"
+        public const uint FrameHeaderMagic = 0x46564C55; // "ULVF"
+        public const uint ProtocolVersion = 2;
+        public const int FrameHeaderSize = 0x10;
+
+        // From protocol version 2 onwards, everything comes as packets of different streams, each one with its own sequence numbers and CRCs
+        public const uint PacketHeaderMagic = 0x584D4C55; // "ULMX"
+        public const int PacketHeaderSize = 0x18;
+        public const byte FrameStreamId = 0;
+        public const byte TelemetryStreamId = 1;
+        public const ushort TelemetrySnapshotType = 0;
+        public const ushort TelemetryLaunchLatencyType = 1;
+
+        private static readonly uint[] CRC32Table = CreateCRC32Table();
+        private uint[] LastStreamSequences = new uint[2];
+        public uint CorruptPacketCount = 0;
+
+        private byte[] FrameHeader = new byte[USBPacketSize];
+        private byte[] FramePayload = new byte[PlainRgbaScreenBufferSize];
+        private uint LastFrameSequence = 0;
+        private uint[] EncodedRGBAFrame = null;
+        private uint[] EncodedRGBATile = new uint[256];
+        public uint DroppedFrameCount = 0;
+
         public delegate void ApplyTypeImplDelegate(PictureBox Box, byte[] Data);
         public static ApplyTypeImplDelegate ApplyModeDelegate = null;
 
@@ -83,6 +110,9 @@ namespace uViewer
             Toolbox = new ToolboxForm(this);
             Toolbox.Show();
 
+            // Older uLaunch versions never read the handshake, so don't block on it
+            new Thread(new ThreadStart(SendHandshake)) { IsBackground = true }.Start();
+
             USBThread = new Thread(new ThreadStart(USBThreadMain));
             USBThread.Start();
         }
@@ -104,6 +134,341 @@ namespace uViewer
             base.OnShown(e);
         }
 
+        private void SendHandshake()
+        {
+            if(USB == null)
+            {
+                return;
+            }
+
+            var handshake = new byte[8];
+            BitConverter.GetBytes(HandshakeMagic).CopyTo(handshake, 0);
+            BitConverter.GetBytes(ProtocolVersion).CopyTo(handshake, 4);
+            USB.WritePipe(0x01, handshake, handshake.Length, out _, IntPtr.Zero);
+        }
+
+        private static uint[] CreateCRC32Table()
+        {
+            var table = new uint[0x100];
+            for(uint i = 0; i < 0x100; i++)
+            {
+                var crc = i;
+                for(var j = 0; j < 8; j++)
+                {
+                    crc = ((crc & 1) != 0) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+                }
+                table[i] = crc;
+            }
+            return table;
+        }
+
+        private static uint ComputeCRC32(byte[] data, int size)
+        {
+            var crc = 0xFFFFFFFF;
+            for(var i = 0; i < size; i++)
+            {
+                crc = CRC32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        private void SetMode(USBMode mode)
+        {
+            if(Mode == USBMode.Invalid)
+            {
+                Mode = mode;
+                switch(Mode)
+                {
+                    case USBMode.RawRGBA:
+                        ApplyModeDelegate = ApplyRGBA;
+                        break;
+                    case USBMode.JPEG:
+                        ApplyModeDelegate = ApplyJPEG;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        // Reads a whole frame into the given block, keeping the legacy layout (mode + payload) so that captures are handled the same way
+        private bool ReadFrame(byte[] block)
+        {
+            while(true)
+            {
+                // Any transfer fits here: either a packet header, a frame header or a whole legacy packet
+                if(!USB.ReadPipe(0x81, FrameHeader, (int)USBPacketSize, out int transferred, IntPtr.Zero))
+                {
+                    return false;
+                }
+
+                if((transferred == PacketHeaderSize) && (BitConverter.ToUInt32(FrameHeader, 0) == PacketHeaderMagic))
+                {
+                    var stream_id = FrameHeader[5];
+                    var type = BitConverter.ToUInt16(FrameHeader, 6);
+                    var seq = BitConverter.ToUInt32(FrameHeader, 8);
+                    var payload_size = BitConverter.ToUInt32(FrameHeader, 12);
+                    var payload_crc = BitConverter.ToUInt32(FrameHeader, 16);
+                    var header_crc = BitConverter.ToUInt32(FrameHeader, 20);
+                    if((header_crc != ComputeCRC32(FrameHeader, 20)) || (stream_id >= LastStreamSequences.Length) || (payload_size > PlainRgbaScreenBufferSize))
+                    {
+                        // We can't trust the payload size, just wait for the next header
+                        CorruptPacketCount++;
+                        continue;
+                    }
+
+                    if((payload_size > 0) && !USB.ReadPipe(0x81, FramePayload, (int)payload_size, out _, IntPtr.Zero))
+                    {
+                        return false;
+                    }
+                    if(payload_crc != ComputeCRC32(FramePayload, (int)payload_size))
+                    {
+                        CorruptPacketCount++;
+                        continue;
+                    }
+
+                    if((seq != 0) && (seq > LastStreamSequences[stream_id] + 1))
+                    {
+                        if(stream_id == FrameStreamId)
+                        {
+                            DroppedFrameCount += seq - LastStreamSequences[stream_id] - 1;
+                        }
+                    }
+                    LastStreamSequences[stream_id] = seq;
+
+                    if(stream_id == TelemetryStreamId)
+                    {
+                        HandleTelemetry(type, FramePayload, (int)payload_size);
+                        continue;
+                    }
+                    return HandleFramePayload((USBMode)type, FramePayload, (int)payload_size, block);
+                }
+                else if((transferred == FrameHeaderSize) && (BitConverter.ToUInt32(FrameHeader, 0) == FrameHeaderMagic))
+                {
+                    var mode = (USBMode)BitConverter.ToUInt16(FrameHeader, 6);
+                    var seq = BitConverter.ToUInt32(FrameHeader, 8);
+                    var payload_size = BitConverter.ToUInt32(FrameHeader, 12);
+                    if(payload_size > PlainRgbaScreenBufferSize)
+                    {
+                        return false;
+                    }
+
+                    if((LastFrameSequence != 0) && (seq > LastFrameSequence + 1))
+                    {
+                        DroppedFrameCount += seq - LastFrameSequence - 1;
+                    }
+                    LastFrameSequence = seq;
+
+                    if(!USB.ReadPipe(0x81, FramePayload, (int)payload_size, out _, IntPtr.Zero))
+                    {
+                        return false;
+                    }
+                    return HandleFramePayload(mode, FramePayload, (int)payload_size, block);
+                }
+                else
+                {
+                    Buffer.BlockCopy(FrameHeader, 0, block, 0, transferred);
+                    SetMode((USBMode)BitConverter.ToUInt32(block, 0));
+                    return true;
+                }
+            }
+        }
+
+        private bool HandleFramePayload(USBMode mode, byte[] payload, int payload_size, byte[] block)
+        {
+            if(mode == USBMode.EncodedRGBA)
+            {
+                if(!DecodeEncodedRGBA(payload, payload_size, block))
+                {
+                    return true;
+                }
+                mode = USBMode.RawRGBA;
+            }
+            else
+            {
+                Buffer.BlockCopy(payload, 0, block, 4, payload_size);
+            }
+            BitConverter.GetBytes((uint)mode).CopyTo(block, 0);
+            SetMode(mode);
+            return true;
+        }
+
+        // Matches uDaemon's ViewerRgbaEncoderFallback, shown when the configured RGBA encoding didn't fit in the daemon's memory
+        private static readonly string[] RgbaEncoderFallbackTexts = { "", ", RGBA encoder downscaled (shift {shift})", ", RGBA delta disabled", ", RGBA encoder unavailable" };
+
+        private string TelemetryText = "";
+        private string LastLaunchText = "";
+
+        private void HandleTelemetry(ushort type, byte[] data, int data_size)
+        {
+            if((type == TelemetrySnapshotType) && (data_size >= 0x38))
+            {
+                var interval_ms = BitConverter.ToUInt32(data, 0);
+                var wakeups = BitConverter.ToUInt32(data, 4);
+                var heap_used = BitConverter.ToUInt64(data, 8);
+                var heap_peak_used = BitConverter.ToUInt64(data, 16);
+                var frame_count = BitConverter.ToUInt32(data, 24);
+                var frame_bytes = BitConverter.ToUInt32(data, 28);
+                var avg_capture_us = BitConverter.ToUInt32(data, 32);
+                var avg_encode_us = BitConverter.ToUInt32(data, 40);
+                var fps = (interval_ms > 0) ? (frame_count * 1000.0 / interval_ms) : 0;
+                TelemetryText = $"{fps:0.0} FPS, {frame_bytes / 1024} KB, capture {avg_capture_us / 1000.0:0.0} ms, encode {avg_encode_us / 1000.0:0.0} ms, {wakeups} wakeups, heap {heap_used / 1024} KB (peak {heap_peak_used / 1024} KB)";
+                var rgba_encoder_fallback = data[0x34];
+                var rgba_downscale_shift = data[0x35];
+                if(rgba_encoder_fallback < RgbaEncoderFallbackTexts.Length)
+                {
+                    TelemetryText += RgbaEncoderFallbackTexts[rgba_encoder_fallback].Replace("{shift}", rgba_downscale_shift.ToString());
+                }
+            }
+            else if((type == TelemetryLaunchLatencyType) && (data_size >= 0x20))
+            {
+                var total_ms = BitConverter.ToUInt32(data, 28);
+                LastLaunchText = $", last launch {total_ms} ms";
+            }
+            else
+            {
+                return;
+            }
+            UpdateTitle($"uViewer - USB screen viewer - {TelemetryText}{LastLaunchText}");
+        }
+
+        private void UpdateTitle(string title)
+        {
+            if(InvokeRequired)
+            {
+                BeginInvoke(new Action<string>(UpdateTitle), title);
+            }
+            else
+            {
+                Text = title;
+            }
+        }
+
+        // Decodes into the last decoded frame (tiles not included didn't change), then scales it up into the block as a plain RGBA frame
+        private bool DecodeEncodedRGBA(byte[] data, int data_size, byte[] block)
+        {
+            const int HeaderSize = 0x10;
+            const byte KeyframeFlag = 1 << 0;
+            const byte RLEFlag = 1 << 1;
+
+            if(data_size < HeaderSize)
+            {
+                return false;
+            }
+
+            int width = BitConverter.ToUInt16(data, 0);
+            int height = BitConverter.ToUInt16(data, 2);
+            int tile_size = BitConverter.ToUInt16(data, 4);
+            var flags = data[6];
+            if((width == 0) || (height == 0) || (width > 1280) || (height > 720) || (tile_size == 0) || (tile_size * tile_size > EncodedRGBATile.Length))
+            {
+                return false;
+            }
+
+            var is_keyframe = (flags & KeyframeFlag) != 0;
+            if((EncodedRGBAFrame == null) || (EncodedRGBAFrame.Length != width * height))
+            {
+                // Deltas are useless without the frame they apply to
+                if(!is_keyframe)
+                {
+                    return false;
+                }
+                EncodedRGBAFrame = new uint[width * height];
+            }
+
+            var tiles_x = (width + tile_size - 1) / tile_size;
+            var tiles_y = (height + tile_size - 1) / tile_size;
+            var bitmap_offset = HeaderSize;
+            var offset = bitmap_offset + (tiles_x * tiles_y + 7) / 8;
+            var tile_idx = 0;
+            for(var tile_y = 0; tile_y < tiles_y; tile_y++)
+            {
+                for(var tile_x = 0; tile_x < tiles_x; tile_x++, tile_idx++)
+                {
+                    if((data[bitmap_offset + tile_idx / 8] & (1 << (tile_idx % 8))) == 0)
+                    {
+                        continue;
+                    }
+
+                    var tile_width = Math.Min(tile_size, width - tile_x * tile_size);
+                    var tile_height = Math.Min(tile_size, height - tile_y * tile_size);
+                    var pixel_count = tile_width * tile_height;
+                    if((flags & RLEFlag) != 0)
+                    {
+                        var count = 0;
+                        while(count < pixel_count)
+                        {
+                            if(offset >= data_size)
+                            {
+                                return false;
+                            }
+                            var ctrl = data[offset++];
+                            var len = (ctrl & 0x7F) + 1;
+                            if(count + len > pixel_count)
+                            {
+                                return false;
+                            }
+                            if((ctrl & 0x80) != 0)
+                            {
+                                if(offset + 4 > data_size)
+                                {
+                                    return false;
+                                }
+                                var px = BitConverter.ToUInt32(data, offset);
+                                offset += 4;
+                                for(var i = 0; i < len; i++)
+                                {
+                                    EncodedRGBATile[count++] = px;
+                                }
+                            }
+                            else
+                            {
+                                if(offset + len * 4 > data_size)
+                                {
+                                    return false;
+                                }
+                                Buffer.BlockCopy(data, offset, EncodedRGBATile, count * 4, len * 4);
+                                offset += len * 4;
+                                count += len;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        if(offset + pixel_count * 4 > data_size)
+                        {
+                            return false;
+                        }
+                        Buffer.BlockCopy(data, offset, EncodedRGBATile, 0, pixel_count * 4);
+                        offset += pixel_count * 4;
+                    }
+
+                    for(var row = 0; row < tile_height; row++)
+                    {
+                        Array.Copy(EncodedRGBATile, row * tile_width, EncodedRGBAFrame, (tile_y * tile_size + row) * width + tile_x * tile_size, tile_width);
+                    }
+                }
+            }
+
+            // Nearest-neighbour upscale to the full screen size
+            var scale_x = 1280 / width;
+            var scale_y = 720 / height;
+            for(var y = 0; y < 720; y++)
+            {
+                var src_row = Math.Min(y / scale_y, height - 1) * width;
+                for(var x = 0; x < 1280; x++)
+                {
+                    var px = EncodedRGBAFrame[src_row + Math.Min(x / scale_x, width - 1)];
+                    var dst_offset = 4 + (y * 1280 + x) * 4;
+                    block[dst_offset] = (byte)px;
+                    block[dst_offset + 1] = (byte)(px >> 8);
+                    block[dst_offset + 2] = (byte)(px >> 16);
+                    block[dst_offset + 3] = (byte)(px >> 24);
+                }
+            }
+            return true;
+        }
+
         public void USBThreadMain()
         {
             while(RefreshCapture());
@@ -113,22 +478,9 @@ namespace uViewer
         {
             try
             {
-                USB.ReadPipe(0x81, CaptureBlocks[0], (int)USBPacketSize, out _, IntPtr.Zero);
-                if(Mode == USBMode.Invalid)
+                if(!ReadFrame(CaptureBlocks[0]))
                 {
-                    var mode_raw = BitConverter.ToUInt32(CaptureBlocks[0], 0);
-                    Mode = (USBMode)mode_raw;
-                    switch(Mode)
-                    {
-                        case USBMode.RawRGBA:
-                            ApplyModeDelegate = ApplyRGBA;
-                            break;
-                        case USBMode.JPEG:
-                            ApplyModeDelegate = ApplyJPEG;
-                            break;
-                        default:
-                            break;
-                    }
+                    return false;
                 }
                 Buffer.BlockCopy(CaptureBlocks[4], 0, CaptureBlocks[5], 0, (int)USBPacketSize);
                 Buffer.BlockCopy(CaptureBlocks[3], 0, CaptureBlocks[4], 0, (int)USBPacketSize);